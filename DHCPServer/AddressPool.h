@@ -0,0 +1,113 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // A bitmap of the pool addresses that were never leased, searched next-fit a 64 bit word at a time.
+    // Addresses are plain host order numbers, so the lease benchmark can fill pools of its own.
+    class AddressPool {
+    private:
+        AddressPool(const AddressPool&) = delete;
+        AddressPool& operator=(const AddressPool&) = delete;
+
+    public:
+        AddressPool()
+            : _free()
+            , _minAddress(0)
+            , _maxAddress(0)
+            , _cursor(0)
+        {
+        }
+        ~AddressPool()
+        {
+        }
+
+    public:
+        // All addresses from minAddress up to and including maxAddress are unused.
+        void Define(const uint32_t minAddress, const uint32_t maxAddress)
+        {
+            _minAddress = minAddress;
+            _maxAddress = maxAddress;
+            _cursor = 0;
+            _free.clear();
+
+            if (_maxAddress >= _minAddress) {
+                const uint32_t size = _maxAddress - _minAddress + 1;
+
+                _free.assign((size + 63) / 64, ~static_cast<uint64_t>(0));
+
+                if ((size % 64) != 0) {
+                    _free.back() = (static_cast<uint64_t>(1) << (size % 64)) - 1;
+                }
+            }
+        }
+        inline bool Contains(const uint32_t address) const
+        {
+            return ((address >= _minAddress) && (address <= _maxAddress));
+        }
+        inline void Taken(const uint32_t address)
+        {
+            if ((Contains(address) == true) && (_free.empty() == false)) {
+                const uint32_t offset = address - _minAddress;
+                _free[offset / 64] &= ~(static_cast<uint64_t>(1) << (offset % 64));
+            }
+        }
+        // Returns the next address in the pool that was never leased, 0 if there is none left.
+        uint32_t Unused()
+        {
+            uint32_t result = 0;
+            const uint32_t words = static_cast<uint32_t>(_free.size());
+            const uint32_t start = _cursor / 64;
+
+            for (uint32_t loop = 0; (loop <= words) && (result == 0) && (words != 0); loop++) {
+                const uint32_t word = (start + loop) % words;
+                uint64_t bits = _free[word];
+
+                if (loop == 0) {
+                    bits &= (~static_cast<uint64_t>(0) << (_cursor % 64));
+                } else if (loop == words) {
+                    bits &= ~(~static_cast<uint64_t>(0) << (_cursor % 64));
+                }
+
+                if (bits != 0) {
+                    const uint32_t offset = (word * 64) + __builtin_ctzll(bits);
+
+                    result = _minAddress + offset;
+                    _cursor = (offset + 1) % (words * 64);
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        std::vector<uint64_t> _free; // Set bits are pool addresses never leased.
+        uint32_t _minAddress;
+        uint32_t _maxAddress;
+        uint32_t _cursor; // Pool offset the search for an unused address continues from.
+    };
+}
+}
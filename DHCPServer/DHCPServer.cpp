@@ -28,12 +28,18 @@ namespace Plugin {
     static Core::ProxyPoolType<Web::JSONBodyType<DHCPServer::Data>> jsonDataFactory(1);
     static Core::ProxyPoolType<Web::JSONBodyType<DHCPServer::Data::Server>> jsonServerDataFactory(1);
 
+    /* static */ constexpr uint32_t DHCPServer::Journal::Magic;
+    /* static */ constexpr uint16_t DHCPServer::Journal::Version;
+    /* static */ constexpr uint32_t DHCPServer::Journal::SyncDelay;
+    /* static */ constexpr uint32_t DHCPServer::Journal::CompactionThreshold;
+
 #ifdef __WINDOWS__
 #pragma warning(disable : 4355)
 #endif
     DHCPServer::DHCPServer()
         : _skipURL(0)
         , _servers()
+        , _journals()
     {
         RegisterAll();
     }
@@ -97,6 +103,7 @@ namespace Plugin {
             index++;
         }
 
+        _journals.clear();
         _servers.clear();
     }
 
@@ -186,53 +193,15 @@ namespace Plugin {
         return result;
     }
 
-    void DHCPServer::SaveLeases(const string& interface, const DHCPServerImplementation& dhcpServer) const
-    {
-
-        if (_persistentPath.empty() == false) {
-            Core::JSON::ArrayType<Data::Server::Lease> leasesList;
-
-            // Saving to file might take a while, and lifetime of DHCPServerImplementation::Iterator
-            // object must be deterministic and short (<10ms), so we scope it 
-            {
-                DHCPServerImplementation::Iterator leases = dhcpServer.Leases();
-                while(leases.Next() && (leases.IsValid() == true)) {
-                    leasesList.Add().Set(leases.Current());
-                }        
-            }
-
-            Core::File leasesFile(_persistentPath + interface + ".json");
-
-            if (leasesFile.Create() == true) {
-                leasesList.IElement::ToFile(leasesFile);
-                leasesFile.Close();
-            } else {
-                TRACE_L1("Could not save leases in pemranent storage area.\n");
-            }
-        }
-    }
-
     void DHCPServer::LoadLeases(const string& interface, DHCPServerImplementation& dhcpServer) 
     {
 
         if (_persistentPath.empty() == false) {
-            Core::File leasesFile(_persistentPath + interface + ".json");
+            auto journal = _journals.emplace(std::piecewise_construct,
+                std::forward_as_tuple(interface),
+                std::forward_as_tuple(_persistentPath + interface, dhcpServer));
 
-            if (leasesFile.Open(true) == true) {
-                Core::JSON::ArrayType<Data::Server::Lease> leases;
-
-                Core::OptionalType<Core::JSON::Error> error;
-                leases.IElement::FromFile(leasesFile, error);
-                if (error.IsSet() == true) {
-                    SYSLOG(Logging::ParsingError, (_T("Parsing failed with %s"), ErrorDisplayMessage(error.Value()).c_str()));
-                }
-                leasesFile.Close();
-
-                auto iterator = leases.Elements();
-                while ((iterator.Next() == true) && (iterator.IsValid() == true)) {
-                    dhcpServer.AddLease(iterator.Current().Get());
-                }
-            } 
+            journal.first->second.Load();
         }
     }
 
@@ -240,9 +209,9 @@ namespace Plugin {
     {
         TRACE(Trace::Information, ("DHCP server granted address %s on interface %s", lease->Address().HostAddress().c_str(), interface.c_str()));
 
-        auto dhcpServer = _servers.find(interface);
-        if (dhcpServer != _servers.end()) {
-            SaveLeases(interface, dhcpServer->second);
+        auto journal = _journals.find(interface);
+        if (journal != _journals.end()) {
+            journal->second.Append(*lease);
         }
     }
 
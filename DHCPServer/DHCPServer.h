@@ -22,6 +22,11 @@
 #include "DHCPServerImplementation.h"
 #include <interfaces/json/JsonData_DHCPServer.h>
 #include "Module.h"
+#include "../helpers/Hash.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace WPEFramework {
 namespace Plugin {
@@ -244,6 +249,319 @@ namespace Plugin {
             Core::JSON::ArrayType<Server> Servers;
         };
 
+    private:
+        // Persists the leases of one server as a JSON snapshot (<interface>.json, as before) and a binary
+        // journal of the leases granted since (<interface>.journal). Granting a lease costs one small
+        // append, the journal is synced in batches and, once grown, folded into a new snapshot.
+        class Journal {
+        private:
+            Journal() = delete;
+            Journal(const Journal&) = delete;
+            Journal& operator=(const Journal&) = delete;
+
+#pragma pack(push, 1)
+            struct Header {
+                uint32_t Magic;
+                uint16_t Version;
+                uint16_t Reserved;
+            };
+            // What follows the client identifier in a record.
+            struct Trailer {
+                uint32_t Address;
+                uint64_t Expiration;
+                uint32_t Checksum;
+            };
+#pragma pack(pop)
+
+            // A record, as it is on disk: a length byte, that many bytes of client identifier (RFC 4361
+            // ones are 19 bytes or more) and the Trailer. The checksum covers all that precedes it.
+            typedef std::vector<uint8_t> Record;
+
+            static constexpr uint32_t Magic = 0x4c4a4344; // "DCJL"
+            static constexpr uint16_t Version = 2;
+            static constexpr uint32_t SyncDelay = 1000; // ms, granted leases synced together
+            static constexpr uint32_t CompactionThreshold = 256; // minimum number of records before compaction
+
+        public:
+            Journal(const string& path, DHCPServerImplementation& server)
+                : _adminLock()
+                , _snapshot(path + _T(".json"))
+                , _journal(path + _T(".journal"))
+                , _server(server)
+                , _leases()
+                , _descriptor(-1)
+                , _records(0)
+                , _scheduled(false)
+                , _job(*this)
+            {
+            }
+            ~Journal()
+            {
+                _job.Revoke();
+
+                _adminLock.Lock();
+                if (_descriptor != -1) {
+                    Compact();
+                    ::close(_descriptor);
+                    _descriptor = -1;
+                }
+                _adminLock.Unlock();
+            }
+
+        public:
+            // Restores the snapshot, replays the journal(s) on top of it and hands the result to the server.
+            // A record torn by a crash fails its checksum and ends the replay of that journal.
+            void Load()
+            {
+                Core::File leasesFile(_snapshot);
+
+                if (leasesFile.Open(true) == true) {
+                    Core::JSON::ArrayType<Data::Server::Lease> leases;
+
+                    Core::OptionalType<Core::JSON::Error> error;
+                    leases.IElement::FromFile(leasesFile, error);
+                    if (error.IsSet() == true) {
+                        SYSLOG(Logging::ParsingError, (_T("Parsing failed with %s"), ErrorDisplayMessage(error.Value()).c_str()));
+                    }
+                    leasesFile.Close();
+
+                    auto iterator = leases.Elements();
+                    while ((iterator.Next() == true) && (iterator.IsValid() == true)) {
+                        Update(Convert(iterator.Current().Get()));
+                    }
+                }
+
+                Replay(_journal + _T(".old"));
+                Replay(_journal);
+
+                for (const std::pair<const uint32_t, Record>& entry : _leases) {
+                    _server.AddLease(Convert(entry.second));
+                }
+
+                // Start from a clean journal, so nothing gets appended after a torn record.
+                _adminLock.Lock();
+                Compact();
+                _adminLock.Unlock();
+            }
+            void Append(const DHCPServerImplementation::Lease& lease)
+            {
+                const Record record(Convert(lease));
+
+                _adminLock.Lock();
+
+                Update(record);
+
+                if (_descriptor != -1) {
+                    if (::write(_descriptor, record.data(), record.size()) != static_cast<ssize_t>(record.size())) {
+                        TRACE_L1("Could not append lease to journal %s", _journal.c_str());
+                    } else {
+                        _records++;
+
+                        if (_scheduled == false) {
+                            _scheduled = true;
+                            _job.Schedule(Core::Time::Now().Add(SyncDelay));
+                        }
+                    }
+                }
+
+                _adminLock.Unlock();
+            }
+
+        private:
+            friend Core::ThreadPool::JobType<Journal&>;
+
+            void Dispatch()
+            {
+                _adminLock.Lock();
+
+                _scheduled = false;
+
+                if (_descriptor != -1) {
+                    ::fdatasync(_descriptor);
+
+                    if (_records > std::max(CompactionThreshold, static_cast<uint32_t>(2 * _leases.size()))) {
+                        Compact();
+                    }
+                }
+
+                _adminLock.Unlock();
+            }
+            // Writes the current leases as the new snapshot and starts a new journal. The previous journal
+            // is kept as <journal>.old until the snapshot is safely in place. If an earlier snapshot did not
+            // make it, that .old is still needed: it is replaced by one with all current leases, which covers
+            // both journals, instead of renaming the journal over it.
+            void Compact()
+            {
+                if (_descriptor != -1) {
+                    ::fdatasync(_descriptor);
+                    ::close(_descriptor);
+                    _descriptor = -1;
+                }
+
+                const string old(_journal + _T(".old"));
+                bool rotated;
+
+                if (::access(old.c_str(), F_OK) == 0) {
+                    rotated = ((Dump(old) == true) && ((::unlink(_journal.c_str()) == 0) || (errno == ENOENT)));
+                } else {
+                    rotated = ((::rename(_journal.c_str(), old.c_str()) == 0) || (errno == ENOENT));
+                }
+
+                if (rotated == false) {
+                    // Keep appending, truncating would lose records that are nowhere else.
+                    TRACE_L1("Could not rotate lease journal %s", _journal.c_str());
+                    _descriptor = ::open(_journal.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+                } else {
+                    _descriptor = ::open(_journal.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+
+                    if (_descriptor != -1) {
+                        const Header header = { Magic, Version, 0 };
+
+                        if (::write(_descriptor, &header, sizeof(header)) != sizeof(header)) {
+                            TRACE_L1("Could not write lease journal %s", _journal.c_str());
+                        }
+                    }
+
+                    _records = 0;
+                }
+
+                if (_descriptor == -1) {
+                    TRACE_L1("Could not open lease journal %s", _journal.c_str());
+                }
+
+                Core::JSON::ArrayType<Data::Server::Lease> leasesList;
+                for (const std::pair<const uint32_t, Record>& entry : _leases) {
+                    leasesList.Add().Set(Convert(entry.second));
+                }
+
+                const string temporary(_snapshot + _T(".tmp"));
+                Core::File leasesFile(temporary);
+
+                if (leasesFile.Create() == true) {
+                    leasesList.IElement::ToFile(leasesFile);
+                    leasesFile.Close();
+
+                    int descriptor = ::open(temporary.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (descriptor != -1) {
+                        ::fsync(descriptor);
+                        ::close(descriptor);
+                    }
+
+                    if (::rename(temporary.c_str(), _snapshot.c_str()) == 0) {
+                        ::unlink(old.c_str());
+                    }
+                } else {
+                    TRACE_L1("Could not save leases in pemranent storage area.\n");
+                }
+            }
+            // Writes all leases as a journal, in place of the given one once it is on disk.
+            bool Dump(const string& fileName) const
+            {
+                const string temporary(fileName + _T(".tmp"));
+                int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                bool result = false;
+
+                if (descriptor != -1) {
+                    const Header header = { Magic, Version, 0 };
+
+                    result = (::write(descriptor, &header, sizeof(header)) == sizeof(header));
+
+                    for (std::map<uint32_t, Record>::const_iterator index(_leases.cbegin()); (result == true) && (index != _leases.cend()); index++) {
+                        result = (::write(descriptor, index->second.data(), index->second.size()) == static_cast<ssize_t>(index->second.size()));
+                    }
+
+                    result = result && (::fdatasync(descriptor) == 0);
+                    ::close(descriptor);
+
+                    result = result && (::rename(temporary.c_str(), fileName.c_str()) == 0);
+
+                    if (result == false) {
+                        TRACE_L1("Could not merge lease journal %s", fileName.c_str());
+                        ::unlink(temporary.c_str());
+                    }
+                }
+
+                return (result);
+            }
+            void Replay(const string& fileName)
+            {
+                int descriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+                if (descriptor != -1) {
+                    Header header;
+
+                    if ((::read(descriptor, &header, sizeof(header)) == sizeof(header)) && (header.Magic == Magic) && (header.Version == Version)) {
+                        Record record;
+                        uint8_t length;
+
+                        while (::read(descriptor, &length, sizeof(length)) == sizeof(length)) {
+                            record.resize(sizeof(length) + length + sizeof(Trailer));
+                            record[0] = length;
+
+                            const ssize_t size = static_cast<ssize_t>(record.size() - sizeof(length));
+
+                            if ((::read(descriptor, &(record[1]), size) != size) || (Stored(record).Checksum != Checksum(record))) {
+                                break;
+                            }
+
+                            Update(record);
+                        }
+                    }
+
+                    ::close(descriptor);
+                }
+            }
+            inline void Update(const Record& record)
+            {
+                _leases[Stored(record).Address] = record;
+            }
+            static Trailer Stored(const Record& record)
+            {
+                Trailer result;
+
+                ::memcpy(&result, &(record[sizeof(uint8_t) + record[0]]), sizeof(result));
+
+                return (result);
+            }
+            static uint32_t Checksum(const Record& record)
+            {
+                // Over everything but the checksum itself.
+                return (FNV1a32(record.data(), record.size() - sizeof(Trailer::Checksum)));
+            }
+            static Record Convert(const DHCPServerImplementation::Lease& lease)
+            {
+                const uint8_t length = lease.Id().Length();
+                Record result(sizeof(length) + length + sizeof(Trailer));
+                const Trailer trailer = { lease.Raw(), lease.Expiration(), 0 };
+
+                result[0] = length;
+                ::memcpy(&(result[1]), lease.Id().Id(), length);
+                ::memcpy(&(result[sizeof(length) + length]), &trailer, sizeof(trailer));
+
+                const uint32_t checksum = Checksum(result);
+                ::memcpy(&(result[result.size() - sizeof(checksum)]), &checksum, sizeof(checksum));
+
+                return (result);
+            }
+            static DHCPServerImplementation::Lease Convert(const Record& record)
+            {
+                const Trailer trailer(Stored(record));
+
+                return (DHCPServerImplementation::Lease(DHCPServerImplementation::Identifier(&(record[1]), record[0]), trailer.Address, trailer.Expiration));
+            }
+
+        private:
+            Core::CriticalSection _adminLock;
+            const string _snapshot;
+            const string _journal;
+            DHCPServerImplementation& _server;
+            std::map<uint32_t, Record> _leases; // Mirror of what is persisted, by address.
+            int _descriptor;
+            uint32_t _records; // In the current journal.
+            bool _scheduled;
+            Core::WorkerPool::JobType<Journal&> _job;
+        };
+
     private:
         DHCPServer(const DHCPServer&) = delete;
         DHCPServer& operator=(const DHCPServer&) = delete;
@@ -280,7 +598,6 @@ namespace Plugin {
 
         // Lease permanent storage
         // -------------------------------------------------------------------------------------------------------
-        void SaveLeases(const string& interface, const DHCPServerImplementation& dhcpServer) const;
         void LoadLeases(const string& interface, DHCPServerImplementation& dhcpServer);
 
         // Callbacks
@@ -288,6 +605,7 @@ namespace Plugin {
     private:
         uint16_t _skipURL;
         std::map<const string, DHCPServerImplementation> _servers;
+        std::map<const string, Journal> _journals;
         std::string _persistentPath;
     };
 
@@ -20,8 +20,13 @@
 #ifndef __DHCPSERVERIMPLEMENTATION_H__
 #define __DHCPSERVERIMPLEMENTATION_H__
 
+#include "LeaseIndex.h"
 #include "Module.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 namespace WPEFramework {
 
 namespace Plugin {
@@ -440,14 +445,18 @@ namespace Plugin {
             uint32_t _preferred;
             classifications _classification;
         };
-        class LeaseList : public std::list<Lease> {
+        // The leases with their indexes, see LeaseIndexType. The server handles its messages and the
+        // observers iterate the leases, so this adds the lock.
+        // NOTE: Apart from the Lock methods, all methods need to be executed within the lock.
+        class LeaseList : public LeaseIndexType<Lease, Identifier> {
         private:
             LeaseList(const LeaseList&) = delete;
             LeaseList& operator=(const LeaseList&) = delete;
 
         public:
             LeaseList()
-                : std::list<Lease>()
+                : LeaseIndexType<Lease, Identifier>()
+                , _adminLock()
             {
             }
             ~LeaseList()
@@ -678,7 +687,6 @@ namespace Plugin {
             , _poolSize(poolSize)
             , _minAddress(0)
             , _maxAddress(0)
-            , _nextFreeIp(0)
             , _server(0)
             , _router(router)
             , _dns(~0)
@@ -727,7 +735,7 @@ namespace Plugin {
         inline void AddLease(const Lease& lease)
         {
             _leases.Lock();
-            _leases.push_back(lease);
+            _leases.Add(lease);
             _leases.Unlock();
         }
 
@@ -748,26 +756,15 @@ namespace Plugin {
         // The next three methods, Find,Find and Create need to be executed within the lock.
         inline Lease* Find(const uint32_t address)
         {
-            LeaseList::iterator index(_leases.begin());
-            while ((index != _leases.end()) && (index->Raw() != address)) {
-                index++;
-            }
-
-            return (index != _leases.end() ? &(*index) : nullptr);
+            return (_leases.Find(address));
         }
         inline Lease* Find(const Identifier& id)
         {
-            LeaseList::iterator index(_leases.begin());
-            while ((index != _leases.end()) && (index->Id() != id)) {
-                index++;
-            }
-
-            return (index != _leases.end() ? &(*index) : nullptr);
+            return (_leases.Find(id));
         }
         inline Lease* Create(const Identifier& id, const uint32_t address)
         {
-            _leases.push_back(Lease(id, address));
-            return &(_leases.back());
+            return (_leases.Create(id, address));
         }
         void Discover(Response& response, const ScratchPad& scratchPad)
         {
@@ -784,7 +781,7 @@ namespace Plugin {
                         // Ip address has not been taken yet, time to "assign" it to this client.
                         result = Create(scratchPad.Id(), scratchPad.RequestedIP());
                     } else if (result->IsExpired() == true) {
-                        result->Update(scratchPad.Id());
+                        _leases.Update(*result, scratchPad.Id());
                     } else {
                         // IP address is taken
                         result = nullptr;
@@ -794,24 +791,16 @@ namespace Plugin {
 
             if (result == nullptr) {
                 // First look in previously unallocated IP slots
-                uint32_t ip;
-                for (ip = _nextFreeIp; ip <= _maxAddress; ip++) {
-                    if (Find(ip) == nullptr) {
-                        result = Create(scratchPad.Id(), ip);
-                        _nextFreeIp = (ip + 1);
-                        break;
-                    }
-                }
+                uint32_t ip = _leases.Unused();
 
-                if (result == nullptr) {
-                    // Still not found a free IP slot, attempt picking up one of the expired ones
-                    for (ip = _minAddress; ip <= _maxAddress ; ip++) {
-                        Lease* lease = Find(ip);
-                        if ((lease != nullptr) && (lease->IsExpired() == true)) {
-                            result = lease;
-                            result->Update(scratchPad.Id());
-                            break;
-                        }
+                if (ip != 0) {
+                    result = Create(scratchPad.Id(), ip);
+                } else {
+                    // Still not found a free IP slot, attempt picking up the one that expired first
+                    result = _leases.Expired(Core::Time::Now().Ticks());
+
+                    if (result != nullptr) {
+                        _leases.Update(*result, scratchPad.Id());
                     }
                 }
             }
@@ -823,7 +812,7 @@ namespace Plugin {
                     // Temporarily lock out the offered IP address until the client actually requests it
                     Core::Time timeout = Core::Time::Now();
                     timeout.Add(60 /* sec */ * 1000);
-                    result->Expiration(timeout.Ticks());
+                    _leases.Expiration(*result, timeout.Ticks());
                 }
 
                 response.Offer(result->Raw());
@@ -848,11 +837,11 @@ namespace Plugin {
                 Core::Time leaseExp = Core::Time::Now();
                 leaseExp.Add(DefaultLeaseTime * (60 /* min */ * 60 * 1000));
                 response.LeaseTime(DefaultLeaseTime);
-                result->Expiration(leaseExp.Ticks());
+                _leases.Expiration(*result, leaseExp.Ticks());
                 _ipRequestCallback(_interfaceName, result);
             } else {
                 if (result != nullptr) {
-                    result->Expiration(0); // Invalidate
+                    _leases.Expiration(*result, 0); // Invalidate
                 }
             }
 
@@ -956,7 +945,6 @@ namespace Plugin {
         uint32_t _poolSize;
         uint32_t _minAddress;
         uint32_t _maxAddress;
-        uint32_t _nextFreeIp;
         uint32_t _server;
         uint32_t _router;
         uint32_t _dns;
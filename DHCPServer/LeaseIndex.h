@@ -0,0 +1,203 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "AddressPool.h"
+#include "../helpers/Hash.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Besides the leases themselves, this keeps an index by address and by client identifier, a bitmap
+    // of the pool addresses that were never leased and a min-heap on expiration time. This way none of
+    // the DHCP messages requires a scan of the leases or the pool. The LeaseList of the server adds the
+    // lock, the benchmark floods it with leases of its own. A LEASE offers Raw(), Id(), Expiration(),
+    // Expiration(time) and Update(id), an IDENTIFIER offers Id(), Length() and ==.
+    template <typename LEASE, typename IDENTIFIER>
+    class LeaseIndexType : public std::list<LEASE> {
+    private:
+        LeaseIndexType(const LeaseIndexType<LEASE, IDENTIFIER>&) = delete;
+        LeaseIndexType<LEASE, IDENTIFIER>& operator=(const LeaseIndexType<LEASE, IDENTIFIER>&) = delete;
+
+        struct Expiry {
+            uint64_t Time;
+            uint32_t Address;
+        };
+        struct Later {
+            bool operator()(const Expiry& lhs, const Expiry& rhs) const
+            {
+                return (lhs.Time > rhs.Time);
+            }
+        };
+
+        typedef std::unordered_multimap<uint64_t, LEASE*> IdMap;
+
+    public:
+        LeaseIndexType()
+            : std::list<LEASE>()
+            , _byAddress()
+            , _byId()
+            , _expiry()
+            , _pool()
+        {
+        }
+        ~LeaseIndexType()
+        {
+        }
+
+    public:
+        // (Re)defines the address pool, the leases that are already there are taken into account.
+        void Pool(const uint32_t minAddress, const uint32_t maxAddress)
+        {
+            _pool.Define(minAddress, maxAddress);
+
+            for (const LEASE& lease : *this) {
+                _pool.Taken(lease.Raw());
+            }
+
+            Rebuild();
+        }
+        inline LEASE* Find(const uint32_t address)
+        {
+            typename std::unordered_map<uint32_t, LEASE*>::iterator index(_byAddress.find(address));
+
+            return (index != _byAddress.end() ? index->second : nullptr);
+        }
+        inline LEASE* Find(const IDENTIFIER& id)
+        {
+            LEASE* result = nullptr;
+            std::pair<typename IdMap::iterator, typename IdMap::iterator> range(_byId.equal_range(Hash(id)));
+
+            while ((range.first != range.second) && (result == nullptr)) {
+                if (range.first->second->Id() == id) {
+                    result = range.first->second;
+                }
+                range.first++;
+            }
+
+            return (result);
+        }
+        inline LEASE* Create(const IDENTIFIER& id, const uint32_t address)
+        {
+            return (Add(LEASE(id, address)));
+        }
+        LEASE* Add(const LEASE& lease)
+        {
+            this->push_back(lease);
+
+            LEASE* result = &(this->back());
+
+            _byAddress.emplace(result->Raw(), result);
+            _byId.emplace(Hash(result->Id()), result);
+            _pool.Taken(result->Raw());
+            Push(*result);
+
+            return (result);
+        }
+        void Update(LEASE& lease, const IDENTIFIER& id)
+        {
+            std::pair<typename IdMap::iterator, typename IdMap::iterator> range(_byId.equal_range(Hash(lease.Id())));
+
+            while ((range.first != range.second) && (range.first->second != &lease)) {
+                range.first++;
+            }
+            if (range.first != range.second) {
+                _byId.erase(range.first);
+            }
+
+            lease.Update(id);
+            _byId.emplace(Hash(id), &lease);
+        }
+        void Expiration(LEASE& lease, const uint64_t time)
+        {
+            lease.Expiration(time);
+            Push(lease);
+
+            // Every change leaves an outdated entry behind, clean up once they dominate.
+            if (_expiry.size() > ((2 * this->size()) + 64)) {
+                Rebuild();
+            }
+        }
+        // Returns the next address in the pool that was never leased, 0 if there is none left.
+        uint32_t Unused()
+        {
+            return (_pool.Unused());
+        }
+        // Returns the pool lease that expired first, nullptr if none of them expired before now.
+        LEASE* Expired(const uint64_t now)
+        {
+            LEASE* result = nullptr;
+            bool done = false;
+
+            while ((done == false) && (_expiry.empty() == false)) {
+                const Expiry& top(_expiry.front());
+                LEASE* lease = Find(top.Address);
+
+                if ((lease == nullptr) || (lease->Expiration() != top.Time) || (_pool.Contains(top.Address) == false)) {
+                    // Outdated entry, the lease has been extended or handed out again since.
+                    std::pop_heap(_expiry.begin(), _expiry.end(), Later());
+                    _expiry.pop_back();
+                } else {
+                    if (top.Time < now) {
+                        result = lease;
+                    }
+                    done = true;
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        static inline uint64_t Hash(const IDENTIFIER& id)
+        {
+            return (FNV1a64(id.Id(), id.Length()));
+        }
+        inline void Push(const LEASE& lease)
+        {
+            _expiry.push_back({ lease.Expiration(), lease.Raw() });
+            std::push_heap(_expiry.begin(), _expiry.end(), Later());
+        }
+        void Rebuild()
+        {
+            _expiry.clear();
+
+            for (const LEASE& lease : *this) {
+                _expiry.push_back({ lease.Expiration(), lease.Raw() });
+            }
+
+            std::make_heap(_expiry.begin(), _expiry.end(), Later());
+        }
+
+    private:
+        std::unordered_map<uint32_t, LEASE*> _byAddress;
+        IdMap _byId;
+        std::vector<Expiry> _expiry;
+        AddressPool _pool;
+    };
+
+} // namespace Plugin
+} // namespace WPEFramework
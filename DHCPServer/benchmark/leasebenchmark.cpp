@@ -0,0 +1,290 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Floods a pool with DISCOVER/REQUEST pairs of new clients until it is full, then lets all leases expire
+// and floods it again with other clients, so every address has to be reclaimed. "list" does what the
+// server used to do: linear lookups in a list of leases and a walk over the pool for a free or expired
+// address. "indexed" runs the LeaseIndexType the LeaseList of the server is built on: hashed lookups by
+// identifier and by address, the AddressPool for never leased addresses and a min-heap on expiration
+// time for the expired ones. It is driven the way the server handles DISCOVER and REQUEST.
+//
+// usage: leasebenchmark [prefix length]
+
+#include "LeaseIndex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+struct Lease {
+    uint64_t Id; // Stands in for the client identifier.
+    uint32_t Address;
+    uint64_t Expiration;
+};
+
+class ListServer {
+public:
+    ListServer(const uint32_t minAddress, const uint32_t maxAddress)
+        : _leases()
+        , _minAddress(minAddress)
+        , _maxAddress(maxAddress)
+        , _nextFreeIp(minAddress)
+    {
+    }
+
+public:
+    uint32_t Discover(const uint64_t id, const uint64_t now)
+    {
+        Lease* result = Find(id);
+
+        if (result == nullptr) {
+            for (uint32_t ip = _nextFreeIp; (ip <= _maxAddress) && (result == nullptr); ip++) {
+                if (Find(ip) == nullptr) {
+                    _leases.push_back({ id, ip, 0 });
+                    result = &(_leases.back());
+                    _nextFreeIp = ip + 1;
+                }
+            }
+            for (uint32_t ip = _minAddress; (ip <= _maxAddress) && (result == nullptr); ip++) {
+                Lease* lease = Find(ip);
+                if ((lease != nullptr) && (lease->Expiration < now)) {
+                    result = lease;
+                    result->Id = id;
+                }
+            }
+        }
+
+        return (result != nullptr ? result->Address : 0);
+    }
+    bool Request(const uint64_t id, const uint64_t expiration)
+    {
+        Lease* lease = Find(id);
+
+        if (lease != nullptr) {
+            lease->Expiration = expiration;
+        }
+
+        return (lease != nullptr);
+    }
+
+private:
+    Lease* Find(const uint64_t id)
+    {
+        std::list<Lease>::iterator index(_leases.begin());
+        while ((index != _leases.end()) && (index->Id != id)) {
+            index++;
+        }
+        return (index != _leases.end() ? &(*index) : nullptr);
+    }
+    Lease* Find(const uint32_t address)
+    {
+        std::list<Lease>::iterator index(_leases.begin());
+        while ((index != _leases.end()) && (index->Address != address)) {
+            index++;
+        }
+        return (index != _leases.end() ? &(*index) : nullptr);
+    }
+
+private:
+    std::list<Lease> _leases;
+    uint32_t _minAddress;
+    uint32_t _maxAddress;
+    uint32_t _nextFreeIp;
+};
+
+// The client identifier, as the server gets it in the DHCP options.
+class Identifier {
+public:
+    Identifier()
+        : _length(0)
+    {
+    }
+    Identifier(const uint64_t client)
+        : _length(sizeof(client))
+    {
+        memcpy(_id, &client, sizeof(client));
+    }
+
+public:
+    bool operator==(const Identifier& rhs) const
+    {
+        return ((_length == rhs._length) && (memcmp(_id, rhs._id, _length) == 0));
+    }
+    const uint8_t* Id() const
+    {
+        return (_id);
+    }
+    uint8_t Length() const
+    {
+        return (_length);
+    }
+
+private:
+    uint8_t _id[sizeof(uint64_t)];
+    uint8_t _length;
+};
+
+class IndexedLease {
+public:
+    IndexedLease(const Identifier& id, const uint32_t address)
+        : _id(id)
+        , _expiration(0)
+        , _address(address)
+    {
+    }
+
+public:
+    const Identifier& Id() const
+    {
+        return (_id);
+    }
+    uint32_t Raw() const
+    {
+        return (_address);
+    }
+    const uint64_t& Expiration() const
+    {
+        return (_expiration);
+    }
+    void Expiration(const uint64_t& time)
+    {
+        _expiration = time;
+    }
+    void Update(const Identifier& id)
+    {
+        _id = id;
+    }
+
+private:
+    Identifier _id;
+    uint64_t _expiration;
+    uint32_t _address;
+};
+
+class IndexedServer {
+public:
+    IndexedServer(const uint32_t minAddress, const uint32_t maxAddress)
+        : _leases()
+    {
+        _leases.Pool(minAddress, maxAddress);
+    }
+
+public:
+    uint32_t Discover(const uint64_t client, const uint64_t now)
+    {
+        const Identifier id(client);
+        IndexedLease* result = _leases.Find(id);
+
+        if (result == nullptr) {
+            const uint32_t ip = _leases.Unused();
+
+            if (ip != 0) {
+                result = _leases.Create(id, ip);
+            } else {
+                result = _leases.Expired(now);
+
+                if (result != nullptr) {
+                    _leases.Update(*result, id);
+                }
+            }
+        }
+
+        if (result != nullptr) {
+            if (result->Expiration() < now) {
+                // Locked out until the client requests it, as the server does.
+                _leases.Expiration(*result, now + 60);
+            }
+            return (result->Raw());
+        }
+
+        return (0);
+    }
+    bool Request(const uint64_t client, const uint64_t expiration)
+    {
+        IndexedLease* lease = _leases.Find(Identifier(client));
+
+        if (lease != nullptr) {
+            _leases.Expiration(*lease, expiration);
+        }
+
+        return (lease != nullptr);
+    }
+
+private:
+    LeaseIndexType<IndexedLease, Identifier> _leases;
+};
+
+template <typename SERVER>
+double Flood(const uint32_t minAddress, const uint32_t maxAddress, uint32_t& leased)
+{
+    const uint32_t size = maxAddress - minAddress + 1;
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    SERVER server(minAddress, maxAddress);
+
+    leased = 0;
+
+    // Fill the pool, every lease expires at time 1000.
+    for (uint32_t client = 0; client < size; client++) {
+        if ((server.Discover(client, 0) != 0) && (server.Request(client, 1000) == true)) {
+            leased++;
+        }
+    }
+    // At time 2000 all of them expired, other clients take over every address.
+    for (uint32_t client = size; client < (2 * size); client++) {
+        if ((server.Discover(client, 2000) != 0) && (server.Request(client, 3000) == true)) {
+            leased++;
+        }
+    }
+
+    return (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t prefix = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 22);
+
+    if ((prefix < 16) || (prefix > 30)) {
+        fprintf(stderr, "usage: %s [prefix length, 16..30]\n", argv[0]);
+        return (1);
+    }
+
+    // All host addresses of a 10.0.0.0/<prefix>, but the network and broadcast address.
+    const uint32_t network = 0x0A000000;
+    const uint32_t minAddress = network + 1;
+    const uint32_t maxAddress = network + (1u << (32 - prefix)) - 2;
+    uint32_t listLeased = 0;
+    uint32_t indexedLeased = 0;
+
+    const double list = Flood<ListServer>(minAddress, maxAddress, listLeased);
+    const double indexed = Flood<IndexedServer>(minAddress, maxAddress, indexedLeased);
+
+    printf("/%u pool, %u addresses, 2 x %u DISCOVER/REQUEST\n", prefix, maxAddress - minAddress + 1, maxAddress - minAddress + 1);
+    printf("list:    %10.3f ms, %u leases handed out\n", list, listLeased);
+    printf("indexed: %10.3f ms, %u leases handed out\n", indexed, indexedLeased);
+
+    return (listLeased == indexedLeased ? 0 : 1);
+}
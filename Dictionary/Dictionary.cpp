@@ -33,6 +33,11 @@ namespace Plugin {
 
     SERVICE_REGISTRATION(Dictionary, 1, 0);
 
+    /* static */ constexpr uint32_t Dictionary::Journal::Magic;
+    /* static */ constexpr uint16_t Dictionary::Journal::Version;
+    /* static */ constexpr uint32_t Dictionary::Journal::SyncDelay;
+    /* static */ constexpr uint32_t Dictionary::Journal::CompactionThreshold;
+
     static Core::ProxyPoolType<Web::JSONBodyType<Dictionary::NameSpace>> jsonBodyDataFactory(4);
     static Core::ProxyPoolType<Web::TextBody> textBodyDataFactory(4);
 
@@ -46,7 +51,7 @@ namespace Plugin {
         bool correctStructure(true);
         Core::JSON::ArrayType<NameSpace::Entry>::ConstIterator keyIndex(current.Dictionary.Elements());
         Core::JSON::ArrayType<NameSpace>::ConstIterator spaceIndex(current.Spaces.Elements());
-        std::list<RuntimeEntry>* currentList = NULL;
+        Space* currentList = NULL;
 
         // Fill in the keys from this name space...
         while ((correctStructure == true) && (keyIndex.Next() == true)) {
@@ -61,7 +66,18 @@ namespace Plugin {
                     ASSERT(currentList != NULL);
                 }
 
-                currentList->push_back(RuntimeEntry(key, keyIndex.Current().Value.Value(), keyIndex.Current().Type.Value()));
+                RuntimeEntry* entry = currentList->Find(key);
+
+                if (entry == nullptr) {
+                    currentList->Add(key, keyIndex.Current().Value.Value(), keyIndex.Current().Type.Value());
+
+                    if (keyIndex.Current().Type.Value() == PERSISTENT) {
+                        _persistent++;
+                    }
+                } else {
+                    entry->Value(keyIndex.Current().Value.Value());
+                    currentList->Changed();
+                }
             }
         }
 
@@ -86,8 +102,8 @@ namespace Plugin {
                 NameSpace& blockToFill(current[index->first]);
 
                 // No we got the namespace bloc, fill in the keys..
-                const std::list<RuntimeEntry>& keyList(index->second);
-                std::list<RuntimeEntry>::const_iterator keyIndex(keyList.begin());
+                const Space::Entries& keyList(index->second.Elements());
+                Space::Entries::const_iterator keyIndex(keyList.begin());
 
                 while (keyIndex != keyList.end()) {
                     NameSpace::Entry& entry(blockToFill.Dictionary.Add(NameSpace::Entry()));
@@ -109,17 +125,8 @@ namespace Plugin {
     {
         _config.FromString(service->ConfigLine());
 
-        Core::File dictionaryFile(service->PersistentPath() + _config.Storage.Value());
-
-        if (dictionaryFile.Open(true) == true) {
-            NameSpace dictionary;
-            Core::OptionalType<Core::JSON::Error> error;
-            dictionary.IElement::FromFile(dictionaryFile, error);
-            if (error.IsSet() == true) {
-                SYSLOG(Logging::ParsingError, (_T("Parsing failed with %s"), ErrorDisplayMessage(error.Value()).c_str()));
-            }
-            CreateInternalDictionary(EMPTY_STRING, dictionary);
-        }
+        _journal.Open(service->PersistentPath() + _config.Storage.Value());
+        _journal.Persistent(_persistent);
 
         _skipURL = static_cast<uint8_t>(service->WebPrefix().length());
 
@@ -129,20 +136,33 @@ namespace Plugin {
 
     /* virtual */ void Dictionary::Deinitialize(PluginHost::IShell* service)
     {
+        ObserverMap observers;
 
-        Core::File dictionaryFile(service->PersistentPath() + _config.Storage.Value());
+        _observerLock.Lock();
+        observers.swap(_observers);
+        _observerLock.Unlock();
 
-        if (dictionaryFile.Open(true) == true) {
-            NameSpace dictionary;
-            CreateExternalDictionary(EMPTY_STRING, dictionary);
-            dictionary.IElement::ToFile(dictionaryFile);
+        // Wait for deliveries in progress, without the lock, a sink might unregister from it.
+        for (Core::ProxyType<Subscriber>& subscriber : observers) {
+            subscriber->Close();
+            Core::IWorkerPool::Instance().Revoke(Core::ProxyType<Core::IDispatch>(subscriber));
         }
+
+        _journal.Close();
     }
 
     /* virtual */ string Dictionary::Information() const
     {
-        // No additional info to report.
-        return (string());
+        string result;
+        Statistics statistics;
+
+        _journal.Get(statistics);
+        statistics.Delivered = _counters->Delivered.load();
+        statistics.Coalesced = _counters->Coalesced.load();
+        statistics.Dropped = _counters->Dropped.load();
+        statistics.ToString(result);
+
+        return (result);
     }
 
     /* virtual */ void Dictionary::Inbound(Web::Request& request)
@@ -152,7 +172,10 @@ namespace Plugin {
     }
 
     // <GET> ../[namespace/]{Key}
+    // <GET> ../[namespace/]{Prefix}*
+    // <GET> ../[namespace/]?Keys={Key},{Key},...
     // <PUT> ../[namespace/]{Key}?Type=[persistent|volatile|closure]
+    // <POST> ../[namespace/] with a body like {"dictionary":[{"key":"k","value":"v"}]}
     /* virtual */ Core::ProxyType<Web::Response> Dictionary::Process(const Web::Request& request)
     {
         ASSERT(_skipURL <= request.Path.length());
@@ -178,7 +201,37 @@ namespace Plugin {
             key = index.Current().Text();
         }
 
-        if (request.Verb == Web::Request::HTTP_GET) {
+        if ((request.Verb == Web::Request::HTTP_GET) && (((key.empty() == false) && (key[key.length() - 1] == '*')) || ((key.empty() == true) && (request.Query.IsSet() == true)))) {
+            Entries entries;
+            Core::ProxyType<Web::JSONBodyType<Dictionary::NameSpace>> response(jsonBodyDataFactory.Element());
+
+            if (key.empty() == false) {
+                Scan(nameSpace, key.substr(0, key.length() - 1), entries);
+            } else {
+                std::list<string> keys;
+                Core::URL::KeyValue options(request.Query.Value());
+
+                if (options.Exists(_T("Keys"), true) == true) {
+                    Core::TextSegmentIterator list(options[_T("Keys")], true, ',');
+
+                    while (list.Next() == true) {
+                        keys.push_back(list.Current().Text());
+                    }
+                }
+
+                GetMany(nameSpace, keys, entries);
+            }
+
+            response->Name = nameSpace;
+            response->Dictionary.Clear();
+            for (const RuntimeEntry& entry : entries) {
+                response->Dictionary.Add(NameSpace::Entry(entry.Key(), entry.Value(), entry.Type()));
+            }
+
+            result->Body(Core::proxy_cast<Web::IBody>(response));
+            result->ErrorCode = Web::STATUS_OK;
+            result->Message = _T("OK");
+        } else if (request.Verb == Web::Request::HTTP_GET) {
             string value;
             Core::ProxyType<Web::TextBody> valueBody(textBodyDataFactory.Element());
 
@@ -200,10 +253,35 @@ namespace Plugin {
             }
 
             TRACE(Trace::Information, (_T("SetKey ( %s, %s, %s)"), key.c_str(), value.c_str(), Core::EnumerateType<Dictionary::enumType>(keyType).Data()));
-            Set(nameSpace, key, value);
+            Set(nameSpace, key, value, keyType);
 
             result->ErrorCode = Web::STATUS_OK;
             result->Message = _T("OK");
+        } else if ((request.Verb == Web::Request::HTTP_POST) && (key.empty() == true) && (request.HasBody() == true)) {
+            Core::ProxyType<const Web::TextBody> valueBody(request.Body<Web::TextBody>());
+            NameSpace entries;
+            Core::OptionalType<Core::JSON::Error> error;
+
+            if (valueBody.IsValid() == true) {
+                entries.IElement::FromString(string(*valueBody), error);
+            }
+
+            if ((valueBody.IsValid() == false) || (error.IsSet() == true)) {
+                result->ErrorCode = Web::STATUS_BAD_REQUEST;
+                result->Message = _T("Invalid dictionary.");
+            } else {
+                KeyValues values;
+                Core::JSON::ArrayType<NameSpace::Entry>::ConstIterator index(entries.Dictionary.Elements());
+
+                while (index.Next() == true) {
+                    values.emplace_back(index.Current().Key.Value(), index.Current().Value.Value());
+                }
+
+                SetMany(nameSpace, values);
+
+                result->ErrorCode = Web::STATUS_OK;
+                result->Message = _T("OK");
+            }
         } else {
             result->ErrorCode = Web::STATUS_BAD_REQUEST;
             result->Message = _T("Bad request.");
@@ -216,25 +294,20 @@ namespace Plugin {
     {
         bool result = false;
 
-        _adminLock.Lock();
+        _adminLock.ReadLock();
 
         DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
 
         if (index != _dictionary.end()) {
-            const std::list<RuntimeEntry>& container(index->second);
-            std::list<RuntimeEntry>::const_iterator listIndex(container.begin());
-
-            while ((listIndex != container.end()) && (listIndex->Key() != key)) {
-                listIndex++;
-            }
+            const RuntimeEntry* entry = index->second.Find(key);
 
-            if (listIndex != container.end()) {
+            if (entry != nullptr) {
                 result = true;
-                value = listIndex->Value();
+                value = entry->Value();
             }
         }
 
-        _adminLock.Unlock();
+        _adminLock.ReadUnlock();
 
         return (result);
     }
@@ -246,20 +319,20 @@ namespace Plugin {
 
         Exchange::IDictionary::IIterator* result = nullptr;
 
-        _adminLock.Lock();
+        _adminLock.ReadLock();
 
         DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
 
         if (index != _dictionary.end()) {
             Core::ProxyType<Iterator> entries(iterators.Element());
 
-            entries->Load(InternalIterator(index->second));
+            entries->Load(index->second.Current());
 
             result = &(*entries);
             result->AddRef();
         }
 
-        _adminLock.Unlock();
+        _adminLock.ReadUnlock();
 
         return (result);
     }
@@ -267,84 +340,217 @@ namespace Plugin {
     // Direct method to Set a value for a key in a certain namespace from the dictionary.
     // NameSpace and key MUST be filled.
     /* virtual */ bool Dictionary::Set(const string& nameSpace, const string& key, const string& value)
+    {
+        return (Set(nameSpace, key, value, VOLATILE));
+    }
+
+    bool Dictionary::Set(const string& nameSpace, const string& key, const string& value, const enumType type)
     {
         // Direct method to Set a value for a key in a certain namespace from the dictionary.
         bool result = false;
 
-        _adminLock.Lock();
+        _adminLock.WriteLock();
 
-        std::list<RuntimeEntry>& container(_dictionary[nameSpace]);
-        std::list<RuntimeEntry>::iterator listIndex(container.begin());
+        if (Update(nameSpace, _dictionary[nameSpace], key, value, type) == true) {
+            result = true;
+            Notify(nameSpace, key, value);
+        }
+
+        _adminLock.WriteUnlock();
 
-        while ((listIndex != container.end()) && (listIndex->Key() != key)) {
-            listIndex++;
+        return (result);
+    }
+
+    uint32_t Dictionary::GetMany(const string& nameSpace, const std::list<string>& keys, Entries& entries) const
+    {
+        uint32_t result = 0;
+
+        _adminLock.ReadLock();
+
+        DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
+
+        if (index != _dictionary.end()) {
+            for (const string& key : keys) {
+                const RuntimeEntry* entry = index->second.Find(key);
+
+                if (entry != nullptr) {
+                    entries.push_back(*entry);
+                    result++;
+                }
+            }
         }
 
-        if (listIndex == container.end()) {
-            result = true;
-            container.push_back(RuntimeEntry(key, value, VOLATILE));
-        } else if (listIndex->Value() != value) {
-            result = true;
-            listIndex->Value(value);
+        _adminLock.ReadUnlock();
+
+        return (result);
+    }
+
+    uint32_t Dictionary::SetMany(const string& nameSpace, const KeyValues& values)
+    {
+        uint32_t result = 0;
+
+        _adminLock.WriteLock();
+
+        Space& space(_dictionary[nameSpace]);
+
+        for (const std::pair<string, string>& entry : values) {
+            if ((IsValidName(entry.first) == true) && (Update(nameSpace, space, entry.first, entry.second, VOLATILE) == true)) {
+                Notify(nameSpace, entry.first, entry.second);
+                result++;
+            }
         }
 
-        if (result == true) {
-            ObserverMap::iterator index(_observers.begin());
+        _adminLock.WriteUnlock();
 
-            // Right, we updated send out the modification !!!
-            while (index != _observers.end()) {
-                if (index->first == nameSpace) {
-                    index->second->Modified(nameSpace, key, value);
+        return (result);
+    }
+
+    uint32_t Dictionary::Scan(const string& nameSpace, const string& prefix, Entries& entries) const
+    {
+        uint32_t result = 0;
+
+        _adminLock.ReadLock();
+
+        DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
+
+        if (index != _dictionary.end()) {
+            for (const RuntimeEntry& entry : index->second.Elements()) {
+                if (entry.Key().compare(0, prefix.length(), prefix) == 0) {
+                    entries.push_back(entry);
+                    result++;
                 }
-                index++;
             }
         }
 
-        _adminLock.Unlock();
+        _adminLock.ReadUnlock();
 
         return (result);
     }
 
+    // Should be called with the write lock taken. PERSISTENT keys that changed go to the journal.
+    bool Dictionary::Update(const string& nameSpace, Space& space, const string& key, const string& value, const enumType type)
+    {
+        bool result = false;
+        bool persist = false;
+        RuntimeEntry* entry = space.Find(key);
+
+        if (entry == nullptr) {
+            result = true;
+            entry = &(space.Add(key, value, type));
+
+            if (type == PERSISTENT) {
+                _persistent++;
+                persist = true;
+            }
+        } else {
+            if (entry->Value() != value) {
+                result = true;
+                entry->Value(value);
+                persist = (entry->Type() == PERSISTENT);
+            }
+            if ((type == PERSISTENT) && (entry->Type() != PERSISTENT)) {
+                entry->Type(PERSISTENT);
+                _persistent++;
+                persist = true;
+            }
+        }
+
+        if ((result == true) || (persist == true)) {
+            space.Changed();
+        }
+
+        if (persist == true) {
+            _journal.Append(nameSpace, key, value);
+            _journal.Persistent(_persistent);
+        }
+
+        return (result);
+    }
+
+    // Replaying the journal, the key is PERSISTENT with this value. No notifications, nobody is listening yet.
+    void Dictionary::Restore(const string& nameSpace, const string& key, const string& value)
+    {
+        Space& space(_dictionary[nameSpace]);
+        RuntimeEntry* entry = space.Find(key);
+
+        if (entry == nullptr) {
+            space.Add(key, value, PERSISTENT);
+            _persistent++;
+        } else {
+            entry->Value(value);
+
+            if (entry->Type() != PERSISTENT) {
+                entry->Type(PERSISTENT);
+                _persistent++;
+            }
+
+            space.Changed();
+        }
+    }
+
+    // Called with the write lock taken, so it only queues the change: the subscribers are called from the
+    // worker pool, where a sink can call back into the dictionary without deadlocking on the lock.
+    void Dictionary::Notify(const string& nameSpace, const string& key, const string& value)
+    {
+        _observerLock.Lock();
+
+        ObserverMap::iterator index(_observers.begin());
+
+        // Right, we updated send out the modification !!!
+        while (index != _observers.end()) {
+            if (((*index)->Matches(nameSpace) == true) && ((*index)->Post(nameSpace, key, value) == true)) {
+                Core::IWorkerPool::Instance().Submit(Core::ProxyType<Core::IDispatch>(*index));
+            }
+            index++;
+        }
+
+        _observerLock.Unlock();
+    }
+
+    // A nameSpace ending in '*' subscribes to all namespaces that start with the part before it.
     /* virtual */ void Dictionary::Register(const string& nameSpace, struct Exchange::IDictionary::INotification* sink)
     {
-        _adminLock.Lock();
+        _observerLock.Lock();
 
 #ifdef __DEBUG__
         ObserverMap::iterator index(_observers.begin());
 
         // DO NOT REGISTER THE SAME NOTIFICATION SINK ON THE SAME NAMESPACE MORE THAN ONCE. !!!!!!
         while (index != _observers.end()) {
-            ASSERT((index->second != sink) || (nameSpace != index->first));
+            ASSERT((*index)->IsRegistration(nameSpace, sink) == false);
 
             index++;
         }
 #endif
 
-        _observers.push_back(std::pair<string, struct Exchange::IDictionary::INotification*>(nameSpace, sink));
+        _observers.push_back(Core::ProxyType<Subscriber>::Create(nameSpace, sink, _counters));
 
-        _adminLock.Unlock();
+        _observerLock.Unlock();
     }
 
     /* virtual */ void Dictionary::Unregister(const string& nameSpace, struct Exchange::IDictionary::INotification* sink)
     {
         bool found = false;
 
-        _adminLock.Lock();
+        _observerLock.Lock();
 
         ObserverMap::iterator index(_observers.begin());
 
         while ((found == false) && (index != _observers.end())) {
-            found = ((index->second == sink) && (nameSpace == index->first));
+            found = (*index)->IsRegistration(nameSpace, sink);
             if (found == false) {
                 index++;
             }
         }
 
         if (index != _observers.end()) {
+            // Do not wait for a delivery in progress, the sink might be calling us from it. The worker
+            // pool holds on to the subscriber, and so to the sink, until that delivery is done.
+            (*index)->Close();
             _observers.erase(index);
         }
 
-        _adminLock.Unlock();
+        _observerLock.Unlock();
     }
 }
 }
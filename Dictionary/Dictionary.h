@@ -21,8 +21,20 @@
 #define __DICTIONARY_H
 
 #include "Module.h"
+#include "KeyStore.h"
+#include "../helpers/Delivery.h"
 #include <interfaces/IDictionary.h>
 
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace WPEFramework {
 namespace Plugin {
 
@@ -93,6 +105,11 @@ namespace Plugin {
             {
                 return (_type);
             }
+            inline void Type(const enumType type)
+            {
+                _dirty = true;
+                _type = type;
+            }
 
         private:
             string _key;
@@ -101,9 +118,14 @@ namespace Plugin {
             bool _dirty;
         };
 
-        typedef std::map<const string, std::list<RuntimeEntry>> DictionaryMap;
-        typedef std::list<std::pair<const string, struct Exchange::IDictionary::INotification*>> ObserverMap;
-        typedef Core::IteratorType<const std::list<RuntimeEntry>, const RuntimeEntry&, std::list<RuntimeEntry>::const_iterator> InternalIterator;
+        typedef KeyStore::SpaceType<RuntimeEntry> Space;
+        typedef KeyStore::ReadWriteLock ReadWriteLock;
+        typedef std::unordered_map<string, Space> DictionaryMap;
+        typedef Core::IteratorType<const Space::Snapshot, const RuntimeEntry&, Space::Snapshot::const_iterator> InternalIterator;
+
+    public:
+        typedef std::list<std::pair<string, string>> KeyValues;
+        typedef std::list<RuntimeEntry> Entries;
 
     public:
         class Iterator : public Exchange::IDictionary::IIterator {
@@ -113,7 +135,8 @@ namespace Plugin {
 
         public:
             Iterator()
-                : _iterator()
+                : _entries()
+                , _iterator()
                 , _lifeTime(nullptr)
             {
             }
@@ -127,10 +150,12 @@ namespace Plugin {
             }
 
         public:
-            void Load(const InternalIterator& iterator)
+            // The snapshot does not change, even if the namespace does while the iterator is in use.
+            void Load(const std::shared_ptr<const Space::Snapshot>& entries)
             {
                 ASSERT(_lifeTime != nullptr);
-                _iterator = iterator;
+                _entries = entries;
+                _iterator = InternalIterator(*_entries);
             }
             // IUnknown implementation
             // -----------------------------------------------
@@ -174,6 +199,7 @@ namespace Plugin {
             }
 
         private:
+            std::shared_ptr<const Space::Snapshot> _entries;
             InternalIterator _iterator;
             Core::IReferenceCounted* _lifeTime;
         };
@@ -318,6 +344,533 @@ namespace Plugin {
                 return (*current);
             }
         };
+        class Statistics : public Core::JSON::Container {
+        private:
+            Statistics(const Statistics&) = delete;
+            Statistics& operator=(const Statistics&) = delete;
+
+        public:
+            Statistics()
+                : Core::JSON::Container()
+            {
+                Add(_T("load"), &Load);
+                Add(_T("records"), &Records);
+                Add(_T("bytes"), &Bytes);
+                Add(_T("compactions"), &Compactions);
+                Add(_T("delivered"), &Delivered);
+                Add(_T("coalesced"), &Coalesced);
+                Add(_T("dropped"), &Dropped);
+            }
+            ~Statistics() override
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Load; // ms
+            Core::JSON::DecUInt64 Records;
+            Core::JSON::DecUInt64 Bytes;
+            Core::JSON::DecUInt32 Compactions;
+            Core::JSON::DecUInt64 Delivered; // notifications
+            Core::JSON::DecUInt64 Coalesced;
+            Core::JSON::DecUInt64 Dropped;
+        };
+
+        // Changes to PERSISTENT keys are appended to <storage>.journal as they happen. The journal is synced
+        // a little later, so a burst of changes shares one sync. Once the journal has grown enough, the
+        // dictionary is written as a new snapshot (the storage file, same format as before) in the
+        // background, and a new journal is started. The previous journal is kept as <storage>.journal.old
+        // until the snapshot is safely in place. If an earlier snapshot did not make it, that .old is still
+        // needed: it is replaced by one with all current PERSISTENT keys, which covers both journals, instead
+        // of renaming the journal over it. On start, the snapshot is loaded and the journal(s) are replayed
+        // on top of it. A record torn by a crash fails its checksum and ends the replay.
+        class Journal {
+        private:
+            Journal() = delete;
+            Journal(const Journal&) = delete;
+            Journal& operator=(const Journal&) = delete;
+
+#pragma pack(push, 1)
+            struct Header {
+                uint32_t Magic;
+                uint16_t Version;
+                uint16_t Reserved;
+            };
+            // Followed by the namespace, the key and the value, not '\0' terminated.
+            struct Record {
+                uint32_t Checksum; // Over everything that follows it.
+                uint16_t NameSpace;
+                uint16_t Key;
+                uint32_t Value;
+            };
+#pragma pack(pop)
+
+            static constexpr uint32_t Magic = 0x4c574344; // "DCWL"
+            static constexpr uint16_t Version = 1;
+            static constexpr uint32_t SyncDelay = 100; // ms, changes synced together
+            static constexpr uint32_t CompactionThreshold = 1024; // minimum number of records before compaction
+
+        public:
+            Journal(Dictionary& parent)
+                : _adminLock()
+                , _parent(parent)
+                , _snapshot()
+                , _journal()
+                , _descriptor(-1)
+                , _records(0)
+                , _persistent(0)
+                , _scheduled(false)
+                , _load(0)
+                , _written(0)
+                , _bytes(0)
+                , _compactions(0)
+                , _job(*this)
+            {
+            }
+            ~Journal()
+            {
+                ASSERT(_descriptor == -1);
+            }
+
+        public:
+            // Loads the snapshot and replays the journal(s) into the dictionary, which should be empty.
+            void Open(const string& snapshot)
+            {
+                const uint64_t start = Core::Time::Now().Ticks();
+
+                _snapshot = snapshot;
+                _journal = snapshot + _T(".journal");
+
+                Core::File dictionaryFile(_snapshot);
+
+                if (dictionaryFile.Open(true) == true) {
+                    NameSpace dictionary;
+                    Core::OptionalType<Core::JSON::Error> error;
+                    dictionary.IElement::FromFile(dictionaryFile, error);
+                    if (error.IsSet() == true) {
+                        SYSLOG(Logging::ParsingError, (_T("Parsing failed with %s"), ErrorDisplayMessage(error.Value()).c_str()));
+                    }
+                    _parent.CreateInternalDictionary(EMPTY_STRING, dictionary);
+                }
+
+                Replay(_journal + _T(".old"));
+                Replay(_journal);
+
+                // Start from a clean journal, so nothing gets appended after a torn record.
+                Compact();
+
+                _load = static_cast<uint32_t>((Core::Time::Now().Ticks() - start) / Core::Time::TicksPerMillisecond);
+
+                SYSLOG(Logging::Startup, (_T("Dictionary loaded in %d ms"), _load));
+            }
+            // Writes the whole dictionary as the snapshot, like it always was on the way down.
+            void Close()
+            {
+                _job.Revoke();
+
+                Compact();
+
+                _adminLock.Lock();
+                if (_descriptor != -1) {
+                    ::close(_descriptor);
+                    _descriptor = -1;
+                }
+                _adminLock.Unlock();
+            }
+            // Should be called with the write lock of the dictionary taken.
+            void Append(const string& nameSpace, const string& key, const string& value)
+            {
+                string buffer;
+
+                Encode(buffer, nameSpace, key, value);
+
+                _adminLock.Lock();
+
+                if (_descriptor != -1) {
+                    if (::write(_descriptor, buffer.data(), buffer.length()) != static_cast<ssize_t>(buffer.length())) {
+                        TRACE_L1("Could not append to journal %s", _journal.c_str());
+                    } else {
+                        _records++;
+                        _written++;
+                        _bytes += buffer.length();
+
+                        if (_scheduled == false) {
+                            _scheduled = true;
+                            _job.Schedule(Core::Time::Now().Add(SyncDelay));
+                        }
+                    }
+                }
+
+                _adminLock.Unlock();
+            }
+            // Number of PERSISTENT keys, to tell when compaction pays off.
+            void Persistent(const uint32_t count)
+            {
+                _adminLock.Lock();
+                _persistent = count;
+                _adminLock.Unlock();
+            }
+            void Get(Statistics& statistics) const
+            {
+                _adminLock.Lock();
+                statistics.Load = _load;
+                statistics.Records = _written;
+                statistics.Bytes = _bytes;
+                statistics.Compactions = _compactions;
+                _adminLock.Unlock();
+            }
+
+        private:
+            friend Core::ThreadPool::JobType<Journal&>;
+
+            void Dispatch()
+            {
+                bool compact = false;
+
+                _adminLock.Lock();
+
+                _scheduled = false;
+
+                if (_descriptor != -1) {
+                    ::fdatasync(_descriptor);
+
+                    compact = (_records > std::max(CompactionThreshold, 2 * _persistent));
+                }
+
+                _adminLock.Unlock();
+
+                if (compact == true) {
+                    Compact();
+                }
+            }
+            // Only building the snapshot in memory and starting the new journal hold up writers, writing the
+            // snapshot to disk does not. A left over .old is merged with the writers held up as well, but that
+            // only happens after a snapshot failed.
+            void Compact()
+            {
+                NameSpace dictionary;
+                const string old(_journal + _T(".old"));
+
+                _parent._adminLock.ReadLock();
+
+                _parent.CreateExternalDictionary(EMPTY_STRING, dictionary);
+
+                _adminLock.Lock();
+
+                if (_descriptor != -1) {
+                    ::fdatasync(_descriptor);
+                    ::close(_descriptor);
+                }
+
+                bool rotated;
+
+                if (::access(old.c_str(), F_OK) == 0) {
+                    rotated = ((Dump(old) == true) && ((::unlink(_journal.c_str()) == 0) || (errno == ENOENT)));
+                } else {
+                    rotated = ((::rename(_journal.c_str(), old.c_str()) == 0) || (errno == ENOENT));
+                }
+
+                if (rotated == false) {
+                    // Keep appending, truncating would lose records that are nowhere else.
+                    TRACE_L1("Could not rotate journal %s", _journal.c_str());
+                    _descriptor = ::open(_journal.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+                } else {
+                    _descriptor = ::open(_journal.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+
+                    if (_descriptor != -1) {
+                        const Header header = { Magic, Version, 0 };
+
+                        if (::write(_descriptor, &header, sizeof(header)) != sizeof(header)) {
+                            TRACE_L1("Could not write journal %s", _journal.c_str());
+                        }
+                    }
+
+                    _records = 0;
+                }
+
+                if (_descriptor == -1) {
+                    TRACE_L1("Could not open journal %s", _journal.c_str());
+                }
+
+                _compactions++;
+
+                _adminLock.Unlock();
+
+                _parent._adminLock.ReadUnlock();
+
+                const string temporary(_snapshot + _T(".tmp"));
+                Core::File dictionaryFile(temporary);
+
+                if (dictionaryFile.Create() == true) {
+                    dictionary.IElement::ToFile(dictionaryFile);
+                    dictionaryFile.Close();
+
+                    int descriptor = ::open(temporary.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (descriptor != -1) {
+                        ::fsync(descriptor);
+                        ::close(descriptor);
+                    }
+
+                    if (::rename(temporary.c_str(), _snapshot.c_str()) == 0) {
+                        ::unlink(old.c_str());
+                    }
+                } else {
+                    TRACE_L1("Could not write dictionary snapshot %s", temporary.c_str());
+                }
+            }
+            // Writes all PERSISTENT keys as a journal, in place of the given one once it is on disk. Should be
+            // called with the read lock of the dictionary taken.
+            bool Dump(const string& fileName) const
+            {
+                const string temporary(fileName + _T(".tmp"));
+                int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                bool result = false;
+
+                if (descriptor != -1) {
+                    const Header header = { Magic, Version, 0 };
+                    string buffer(reinterpret_cast<const char*>(&header), sizeof(header));
+
+                    for (DictionaryMap::const_iterator index(_parent._dictionary.cbegin()); index != _parent._dictionary.cend(); index++) {
+                        const Space::Entries& keyList(index->second.Elements());
+
+                        for (Space::Entries::const_iterator keyIndex(keyList.begin()); keyIndex != keyList.end(); keyIndex++) {
+                            if (keyIndex->Type() == PERSISTENT) {
+                                Encode(buffer, index->first, keyIndex->Key(), keyIndex->Value());
+                            }
+                        }
+                    }
+
+                    result = (::write(descriptor, buffer.data(), buffer.length()) == static_cast<ssize_t>(buffer.length()));
+                    result = result && (::fdatasync(descriptor) == 0);
+                    ::close(descriptor);
+
+                    result = result && (::rename(temporary.c_str(), fileName.c_str()) == 0);
+
+                    if (result == false) {
+                        TRACE_L1("Could not merge journal %s", fileName.c_str());
+                        ::unlink(temporary.c_str());
+                    }
+                }
+
+                return (result);
+            }
+            void Replay(const string& fileName)
+            {
+                int descriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+                if (descriptor != -1) {
+                    struct stat info;
+
+                    if ((::fstat(descriptor, &info) == 0) && (static_cast<size_t>(info.st_size) >= sizeof(Header))) {
+                        const size_t size = static_cast<size_t>(info.st_size);
+                        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+                        if (mapped != MAP_FAILED) {
+                            const uint8_t* data = static_cast<const uint8_t*>(mapped);
+                            Header header;
+
+                            ::memcpy(&header, data, sizeof(header));
+
+                            if ((header.Magic == Magic) && (header.Version == Version)) {
+                                size_t offset = sizeof(header);
+                                bool valid = true;
+
+                                while ((valid == true) && ((offset + sizeof(Record)) <= size)) {
+                                    Record record;
+                                    ::memcpy(&record, &data[offset], sizeof(record));
+
+                                    const size_t length = sizeof(record) + record.NameSpace + record.Key + record.Value;
+
+                                    valid = (((offset + length) <= size) && (record.Checksum == Checksum(&data[offset + sizeof(record.Checksum)], length - sizeof(record.Checksum))));
+
+                                    if (valid == true) {
+                                        const char* text = reinterpret_cast<const char*>(&data[offset + sizeof(record)]);
+
+                                        _parent.Restore(string(text, record.NameSpace), string(&text[record.NameSpace], record.Key), string(&text[record.NameSpace + record.Key], record.Value));
+
+                                        offset += length;
+                                    }
+                                }
+                            }
+
+                            ::munmap(mapped, size);
+                        }
+                    }
+
+                    ::close(descriptor);
+                }
+            }
+            static void Encode(string& buffer, const string& nameSpace, const string& key, const string& value)
+            {
+                const size_t start = buffer.length();
+                Record record;
+
+                record.NameSpace = static_cast<uint16_t>(std::min(nameSpace.length(), static_cast<size_t>(0xFFFF)));
+                record.Key = static_cast<uint16_t>(std::min(key.length(), static_cast<size_t>(0xFFFF)));
+                record.Value = static_cast<uint32_t>(value.length());
+
+                buffer.reserve(start + sizeof(record) + record.NameSpace + record.Key + record.Value);
+                buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+                buffer.append(nameSpace, 0, record.NameSpace);
+                buffer.append(key, 0, record.Key);
+                buffer.append(value);
+
+                record.Checksum = Checksum(reinterpret_cast<const uint8_t*>(&buffer[start + sizeof(record.Checksum)]), buffer.length() - start - sizeof(record.Checksum));
+                buffer.replace(start, sizeof(record.Checksum), reinterpret_cast<const char*>(&record.Checksum), sizeof(record.Checksum));
+            }
+            static inline uint32_t Checksum(const uint8_t data[], const size_t length)
+            {
+                return (FNV1a32(data, length));
+            }
+
+        private:
+            mutable Core::CriticalSection _adminLock;
+            Dictionary& _parent;
+            string _snapshot;
+            string _journal;
+            int _descriptor;
+            uint32_t _records; // In the current journal.
+            uint32_t _persistent;
+            bool _scheduled;
+            uint32_t _load;
+            uint64_t _written;
+            uint64_t _bytes;
+            uint32_t _compactions;
+            Core::WorkerPool::JobType<Journal&> _job;
+        };
+
+        typedef DeliveryCounters Counters;
+
+        // The changes pending for one subscriber. Changes to a key that are still pending are coalesced, only
+        // the last value is kept. When it is full, the oldest pending change is dropped.
+        class ChangeQueue {
+        private:
+            ChangeQueue(const ChangeQueue&) = delete;
+            ChangeQueue& operator=(const ChangeQueue&) = delete;
+
+            static constexpr uint16_t MaxPending = 256;
+
+        public:
+            struct Change {
+                string NameSpace;
+                string Key;
+                string Value;
+            };
+            typedef Change Item;
+
+            enum state {
+                QUEUED,
+                DROPPED,
+                COALESCED
+            };
+
+        public:
+            ChangeQueue()
+                : _pending()
+                , _index()
+            {
+            }
+            ~ChangeQueue()
+            {
+            }
+
+        public:
+            inline bool IsEmpty() const
+            {
+                return (_pending.empty());
+            }
+            state Push(const string& nameSpace, const string& key, const string& value)
+            {
+                state result = QUEUED;
+                string id;
+
+                id.reserve(nameSpace.length() + 1 + key.length());
+                id.append(nameSpace).append(1, '\0').append(key);
+
+                std::unordered_map<string, std::list<Change>::iterator>::iterator index(_index.find(id));
+
+                if (index != _index.end()) {
+                    index->second->Value = value;
+                    result = COALESCED;
+                } else {
+                    if (_pending.size() >= MaxPending) {
+                        const Change& oldest(_pending.front());
+                        _index.erase(string(oldest.NameSpace).append(1, '\0').append(oldest.Key));
+                        _pending.pop_front();
+                        result = DROPPED;
+                    }
+                    _pending.push_back(Change { nameSpace, key, value });
+                    _index.emplace(std::move(id), std::prev(_pending.end()));
+                }
+
+                return (result);
+            }
+            // Hands out all pending changes, batch should be empty.
+            inline void Take(std::list<Change>& batch)
+            {
+                batch.swap(_pending);
+                _index.clear();
+            }
+            inline void Clear()
+            {
+                _index.clear();
+                _pending.clear();
+            }
+
+        private:
+            std::list<Change> _pending;
+            std::unordered_map<string, std::list<Change>::iterator> _index;
+        };
+
+        // Changes are delivered to every subscriber from the worker pool, so a slow (out of process)
+        // subscriber only delays itself and never the writers. A namespace ending in '*' subscribes to all
+        // namespaces starting with what comes before it.
+        class Subscriber : public DeliveryType<ChangeQueue> {
+        private:
+            Subscriber() = delete;
+            Subscriber(const Subscriber&) = delete;
+            Subscriber& operator=(const Subscriber&) = delete;
+
+        public:
+            Subscriber(const string& nameSpace, struct Exchange::IDictionary::INotification* sink, const std::shared_ptr<Counters>& counters)
+                : DeliveryType<ChangeQueue>(counters)
+                , _registration(nameSpace)
+                , _prefix((nameSpace.empty() == false) && (nameSpace[nameSpace.length() - 1] == '*'))
+                , _nameSpace(_prefix == true ? nameSpace.substr(0, nameSpace.length() - 1) : nameSpace)
+                , _sink(sink)
+            {
+                ASSERT(sink != nullptr);
+                _sink->AddRef();
+            }
+            ~Subscriber() override
+            {
+                _sink->Release();
+            }
+
+        public:
+            inline bool IsRegistration(const string& nameSpace, const struct Exchange::IDictionary::INotification* sink) const
+            {
+                return ((_sink == sink) && (_registration == nameSpace));
+            }
+            inline bool Matches(const string& nameSpace) const
+            {
+                return (_prefix == true ? (nameSpace.compare(0, _nameSpace.length(), _nameSpace) == 0) : (nameSpace == _nameSpace));
+            }
+
+        private:
+            void Deliver(const ChangeQueue::Change& change) override
+            {
+                _sink->Modified(change.NameSpace, change.Key, change.Value);
+            }
+
+        private:
+            const string _registration;
+            const bool _prefix;
+            const string _nameSpace;
+            struct Exchange::IDictionary::INotification* _sink;
+        };
+
+        typedef std::list<Core::ProxyType<Subscriber>> ObserverMap;
+
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&) = delete;
@@ -347,6 +900,11 @@ namespace Plugin {
             , _skipURL(0)
             , _config()
             , _dictionary()
+            , _observerLock()
+            , _observers()
+            , _counters(std::make_shared<Counters>())
+            , _persistent(0)
+            , _journal(*this)
         {
         }
         virtual ~Dictionary()
@@ -403,19 +961,40 @@ namespace Plugin {
         // Direct method to Set a value for a key in a certain namespace from the dictionary.
         // NameSpace and key MUST be filled.
         virtual bool Set(const string& nameSpace, const string& key, const string& value);
+
+        // As Set, the type is used if the key is new. An existing key can be made PERSISTENT, but not back.
+        bool Set(const string& nameSpace, const string& key, const string& value, const enumType type);
         virtual void Register(const string& nameSpace, struct Exchange::IDictionary::INotification* sink);
         virtual void Unregister(const string& nameSpace, struct Exchange::IDictionary::INotification* sink);
 
+        //  Bulk methods, not (yet) part of IDictionary
+        // -------------------------------------------------------------------------------------------------------
+        // Look up all the given keys under one lock, the ones found are added to entries. Returns the number found.
+        uint32_t GetMany(const string& nameSpace, const std::list<string>& keys, Entries& entries) const;
+
+        // Set all the given keys under one lock. Returns the number of keys that changed.
+        uint32_t SetMany(const string& nameSpace, const KeyValues& values);
+
+        // Add all keys of the namespace starting with prefix (an empty prefix is all keys) to entries.
+        uint32_t Scan(const string& nameSpace, const string& prefix, Entries& entries) const;
+
     private:
         bool CreateInternalDictionary(const string& currentSpace, const NameSpace& data);
         void CreateExternalDictionary(const string& currentSpace, NameSpace& data) const;
+        bool Update(const string& nameSpace, Space& space, const string& key, const string& value, const enumType type);
+        void Restore(const string& nameSpace, const string& key, const string& value);
+        void Notify(const string& nameSpace, const string& key, const string& value);
 
     private:
-        mutable Core::CriticalSection _adminLock;
+        mutable ReadWriteLock _adminLock;
         uint8_t _skipURL;
         Config _config;
         DictionaryMap _dictionary;
+        Core::CriticalSection _observerLock;
         ObserverMap _observers;
+        std::shared_ptr<Counters> _counters;
+        uint32_t _persistent;
+        Journal _journal;
     };
 }
 }
@@ -0,0 +1,246 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KEYSTORE_H
+#define __KEYSTORE_H
+
+#include "../helpers/Hash.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The key store of the Dictionary: the keys of a namespace and the lock that guards all of them. The
+// entry type is a template argument and the includer provides ASSERT, which is how the key store
+// benchmark runs it with entries of its own.
+namespace WPEFramework {
+namespace Plugin {
+
+    namespace KeyStore {
+
+        // The keys of one namespace, in order of creation, with an open addressing (linear probing) index
+        // on top. Keys are never removed, so the index does not need tombstones. The entries live in a
+        // deque, so they do not move (or lose their dirty flag) when more keys are added.
+        // Iterators share an immutable snapshot of the entries, it is only rebuilt after a change.
+        template <typename ENTRY>
+        class SpaceType {
+        private:
+            SpaceType(const SpaceType&) = delete;
+            SpaceType& operator=(const SpaceType&) = delete;
+
+            struct Slot {
+                uint32_t Hash;
+                uint32_t Index; // Entry + 1, 0 is an empty slot.
+            };
+
+            static constexpr uint32_t InitialSlots = 16;
+
+        public:
+            typedef std::deque<ENTRY> Entries;
+            typedef std::vector<ENTRY> Snapshot;
+
+            SpaceType()
+                : _entries()
+                , _slots(InitialSlots, Slot { 0, 0 })
+                , _snapshotLock()
+                , _snapshot()
+            {
+            }
+            ~SpaceType()
+            {
+            }
+
+        public:
+            inline const Entries& Elements() const
+            {
+                return (_entries);
+            }
+            // Should be called with (at least) the read lock taken, readers may build it concurrently.
+            std::shared_ptr<const Snapshot> Current() const
+            {
+                std::lock_guard<std::mutex> guard(_snapshotLock);
+
+                if (_snapshot == nullptr) {
+                    _snapshot = std::make_shared<const Snapshot>(_entries.begin(), _entries.end());
+                }
+
+                return (_snapshot);
+            }
+            // Should be called with the write lock taken, after an entry got a new value or type.
+            inline void Changed()
+            {
+                _snapshot.reset();
+            }
+            const ENTRY* Find(const std::string& key) const
+            {
+                const uint32_t hash = Hash(key);
+                const Slot& slot(_slots[Position(key, hash)]);
+
+                return (slot.Index != 0 ? &(_entries[slot.Index - 1]) : nullptr);
+            }
+            ENTRY* Find(const std::string& key)
+            {
+                return (const_cast<ENTRY*>(static_cast<const SpaceType&>(*this).Find(key)));
+            }
+            // The key should not be there yet, the entry is constructed from the key and the arguments.
+            template <typename... ARGUMENTS>
+            ENTRY& Add(const std::string& key, ARGUMENTS&&... arguments)
+            {
+                // Keep the load below 3/4, so probe sequences stay short.
+                if (((_entries.size() + 1) * 4) > (_slots.size() * 3)) {
+                    Grow();
+                }
+
+                const uint32_t hash = Hash(key);
+                Slot& slot(_slots[Position(key, hash)]);
+
+                ASSERT(slot.Index == 0);
+
+                _entries.push_back(ENTRY(key, std::forward<ARGUMENTS>(arguments)...));
+                slot.Hash = hash;
+                slot.Index = static_cast<uint32_t>(_entries.size());
+                _snapshot.reset();
+
+                return (_entries.back());
+            }
+
+        private:
+            static inline uint32_t Hash(const std::string& key)
+            {
+                return (FNV1a32(key));
+            }
+            // Slot holding the key, or the empty slot where it should go.
+            uint32_t Position(const std::string& key, const uint32_t hash) const
+            {
+                const uint32_t mask = static_cast<uint32_t>(_slots.size()) - 1;
+                uint32_t position = hash & mask;
+
+                while ((_slots[position].Index != 0) && ((_slots[position].Hash != hash) || (_entries[_slots[position].Index - 1].Key() != key))) {
+                    position = (position + 1) & mask;
+                }
+
+                return (position);
+            }
+            void Grow()
+            {
+                std::vector<Slot> slots(_slots.size() * 2, Slot { 0, 0 });
+                const uint32_t mask = static_cast<uint32_t>(slots.size()) - 1;
+
+                for (const Slot& slot : _slots) {
+                    if (slot.Index != 0) {
+                        uint32_t position = slot.Hash & mask;
+                        while (slots[position].Index != 0) {
+                            position = (position + 1) & mask;
+                        }
+                        slots[position] = slot;
+                    }
+                }
+
+                _slots.swap(slots);
+            }
+
+        private:
+            Entries _entries;
+            std::vector<Slot> _slots;
+            mutable std::mutex _snapshotLock;
+            mutable std::shared_ptr<const Snapshot> _snapshot;
+        };
+
+        // Readers share the lock, a writer has it alone. Writers that are waiting go first, so a steady
+        // stream of readers can not starve them. It is not recursive: nothing that might call back into
+        // the dictionary (like a notification sink) may run while the write lock is taken.
+        class ReadWriteLock {
+        private:
+            ReadWriteLock(const ReadWriteLock&) = delete;
+            ReadWriteLock& operator=(const ReadWriteLock&) = delete;
+
+        public:
+            ReadWriteLock()
+                : _lock()
+                , _readers()
+                , _writers()
+                , _reading(0)
+                , _waiting(0)
+                , _writing(false)
+                , _writer()
+            {
+            }
+            ~ReadWriteLock()
+            {
+            }
+
+        public:
+            void ReadLock()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                ASSERT((_writing == false) || (_writer != std::this_thread::get_id()));
+                _readers.wait(guard, [this]() { return ((_writing == false) && (_waiting == 0)); });
+                _reading++;
+            }
+            void ReadUnlock()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                ASSERT(_reading > 0);
+                if ((--_reading == 0) && (_waiting > 0)) {
+                    _writers.notify_one();
+                }
+            }
+            void WriteLock()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                ASSERT((_writing == false) || (_writer != std::this_thread::get_id()));
+                _waiting++;
+                _writers.wait(guard, [this]() { return ((_writing == false) && (_reading == 0)); });
+                _waiting--;
+                _writing = true;
+                _writer = std::this_thread::get_id();
+            }
+            void WriteUnlock()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                ASSERT(_writing == true);
+                _writing = false;
+                _writer = std::thread::id();
+                if (_waiting > 0) {
+                    _writers.notify_one();
+                } else {
+                    _readers.notify_all();
+                }
+            }
+
+        private:
+            std::mutex _lock;
+            std::condition_variable _readers;
+            std::condition_variable _writers;
+            uint32_t _reading;
+            uint32_t _waiting;
+            bool _writing;
+            std::thread::id _writer;
+        };
+    }
+}
+}
+
+#endif // __KEYSTORE_H
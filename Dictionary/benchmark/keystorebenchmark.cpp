@@ -0,0 +1,258 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reader threads Get random keys of a namespace while one writer thread Sets them, and every so often
+// adds a new one. "list" is how the Dictionary used to keep its keys: a std::map of namespaces, every
+// namespace a std::list that is searched key by key, all of it behind one (recursive) lock. "store" is
+// how it does now: KeyStore::SpaceType behind the KeyStore::ReadWriteLock, so readers do not wait for
+// each other.
+//
+// usage: keystorebenchmark [keys [readers [operations]]]
+
+#include <cassert>
+#define ASSERT(expression) assert(expression)
+
+#include "KeyStore.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+class Entry {
+public:
+    Entry(const std::string& key, const std::string& value)
+        : _key(key)
+        , _value(value)
+    {
+    }
+
+public:
+    inline const std::string& Key() const
+    {
+        return (_key);
+    }
+    inline const std::string& Value() const
+    {
+        return (_value);
+    }
+    inline void Value(const std::string& value)
+    {
+        _value = value;
+    }
+
+private:
+    std::string _key;
+    std::string _value;
+};
+
+class ListStore {
+public:
+    ListStore()
+        : _lock()
+        , _spaces()
+    {
+    }
+
+public:
+    bool Get(const std::string& nameSpace, const std::string& key, std::string& value) const
+    {
+        bool result = false;
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        std::map<const std::string, std::list<Entry>>::const_iterator space(_spaces.find(nameSpace));
+
+        if (space != _spaces.end()) {
+            std::list<Entry>::const_iterator index(space->second.begin());
+            while ((index != space->second.end()) && (index->Key() != key)) {
+                index++;
+            }
+            if (index != space->second.end()) {
+                value = index->Value();
+                result = true;
+            }
+        }
+
+        return (result);
+    }
+    void Set(const std::string& nameSpace, const std::string& key, const std::string& value)
+    {
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        std::list<Entry>& space(_spaces[nameSpace]);
+        std::list<Entry>::iterator index(space.begin());
+
+        while ((index != space.end()) && (index->Key() != key)) {
+            index++;
+        }
+        if (index == space.end()) {
+            space.push_back(Entry(key, value));
+        } else {
+            index->Value(value);
+        }
+    }
+
+private:
+    mutable std::recursive_mutex _lock;
+    std::map<const std::string, std::list<Entry>> _spaces;
+};
+
+class Store {
+public:
+    Store()
+        : _lock()
+        , _spaces()
+    {
+    }
+
+public:
+    bool Get(const std::string& nameSpace, const std::string& key, std::string& value) const
+    {
+        bool result = false;
+
+        _lock.ReadLock();
+
+        std::unordered_map<std::string, KeyStore::SpaceType<Entry>>::const_iterator space(_spaces.find(nameSpace));
+
+        if (space != _spaces.end()) {
+            const Entry* entry = space->second.Find(key);
+            if (entry != nullptr) {
+                value = entry->Value();
+                result = true;
+            }
+        }
+
+        _lock.ReadUnlock();
+
+        return (result);
+    }
+    void Set(const std::string& nameSpace, const std::string& key, const std::string& value)
+    {
+        _lock.WriteLock();
+
+        KeyStore::SpaceType<Entry>& space(_spaces[nameSpace]);
+        Entry* entry = space.Find(key);
+
+        if (entry == nullptr) {
+            space.Add(key, value);
+        } else {
+            entry->Value(value);
+            space.Changed();
+        }
+
+        _lock.WriteUnlock();
+    }
+
+private:
+    mutable KeyStore::ReadWriteLock _lock;
+    std::unordered_map<std::string, KeyStore::SpaceType<Entry>> _spaces;
+};
+
+std::string Key(const uint32_t index)
+{
+    return ("setting." + std::to_string(index));
+}
+
+// Returns the wall clock time it took, the number of failed Gets is added to failures.
+template <typename STORE>
+double Run(const uint32_t keys, const uint32_t readers, const uint32_t operations, uint32_t& failures)
+{
+    const std::string nameSpace("/com.example/player");
+    STORE store;
+    std::atomic<uint32_t> missing(0);
+
+    for (uint32_t index = 0; index < keys; index++) {
+        store.Set(nameSpace, Key(index), "initial");
+    }
+
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    std::vector<std::thread> threads;
+
+    for (uint32_t reader = 0; reader < readers; reader++) {
+        threads.emplace_back([&store, &nameSpace, &missing, keys, operations, reader]() {
+            std::mt19937 random(reader);
+            std::string value;
+            uint32_t lost = 0;
+            for (uint32_t count = 0; count < operations; count++) {
+                if (store.Get(nameSpace, Key(random() % keys), value) == false) {
+                    lost++;
+                }
+            }
+            missing += lost;
+        });
+    }
+    // One write per ten reads of a reader, one in a hundred writes adds a key.
+    threads.emplace_back([&store, &nameSpace, keys, operations]() {
+        std::mt19937 random(4242);
+        uint32_t added = keys;
+        for (uint32_t count = 0; count < (operations / 10); count++) {
+            if ((count % 100) == 0) {
+                store.Set(nameSpace, Key(added++), "added");
+            } else {
+                store.Set(nameSpace, Key(random() % keys), std::to_string(count));
+            }
+        }
+    });
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    failures += missing;
+
+    return (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t keys = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 500);
+    const uint32_t readers = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 4);
+    const uint32_t operations = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 100000);
+
+    if ((keys == 0) || (readers == 0) || (operations == 0)) {
+        fprintf(stderr, "usage: %s [keys [readers [operations]]]\n", argv[0]);
+        return (1);
+    }
+
+    uint32_t failures = 0;
+    const double list = Run<ListStore>(keys, readers, operations, failures);
+    const double store = Run<Store>(keys, readers, operations, failures);
+    const double gets = static_cast<double>(readers) * operations;
+
+    printf("%u keys, %u readers x %u Gets, 1 writer x %u Sets\n", keys, readers, operations, operations / 10);
+    printf("list:  %9.3f ms, %7.0f Gets per ms\n", list, gets / list);
+    printf("store: %9.3f ms, %7.0f Gets per ms\n", store, gets / store);
+
+    if (failures != 0) {
+        fprintf(stderr, "%u Gets did not find their key.\n", failures);
+        return (1);
+    }
+
+    return (0);
+}
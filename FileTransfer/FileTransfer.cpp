@@ -42,7 +42,13 @@ namespace Plugin {
 
     string FileTransfer::Information() const
     {
-        return string();
+        string result;
+        Statistics statistics;
+
+        _logOutput.Get(statistics);
+        statistics.ToString(result);
+
+        return (result);
     }
 } // namespace Plugin
 } // namespace WPEFramework
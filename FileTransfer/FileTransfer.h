@@ -19,9 +19,11 @@
  
 #pragma once
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
 #include <unordered_map>
-#include <iostream>
-#include <fstream>
 #include "../FileTransfer/Module.h"
 
 namespace WPEFramework {
@@ -124,7 +126,7 @@ namespace Core {
                 }
                 else
                 {
-                    int fileFd = inotify_add_watch(_notifyFd, filename.c_str(), IN_CLOSE_WRITE);
+                    int fileFd = inotify_add_watch(_notifyFd, filename.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
                     if (fileFd >= 0) {
                         _files.emplace(std::piecewise_construct,
                                        std::forward_as_tuple(filename),
@@ -188,13 +190,16 @@ namespace Core {
             void Handle(const uint16_t events) override
             {
                 if ((events & POLLIN) != 0) {
-                    uint8_t eventBuffer[(sizeof(struct inotify_event) + NAME_MAX + 1)];
+                    alignas(struct inotify_event) uint8_t eventBuffer[4 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
                     int length;
                     do
                     {
                         length = ::read(_notifyFd, eventBuffer, sizeof(eventBuffer));
-                        if (length > 0) {
-                            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(eventBuffer);
+                        int offset = 0;
+
+                        // A single read can hold several events.
+                        while (offset < length) {
+                            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(&(eventBuffer[offset]));
 
                             _adminLock.Lock();
 
@@ -205,6 +210,8 @@ namespace Core {
                             }
 
                             _adminLock.Unlock();
+
+                            offset += sizeof(struct inotify_event) + event->len;
                         }
                     } while (length > 0);
                 }
@@ -220,8 +227,14 @@ namespace Core {
 
 namespace Plugin
 {
+    // Follows a (log) file: the file stays open and everything appended to it since the previous update
+    // is read with pread into a buffer that is reused, and handed out line by line. A file that shrinks is
+    // read again from the start, a file that is replaced (rotated) is drained and the new one is opened.
     class FileObserver {
         private:
+            static constexpr uint32_t BufferSize = 16 * 1024;
+            static constexpr uint32_t RetryDelay = 1000; // ms, before looking for a rotated file again
+
             class Sink : public Core::FileSystemMonitor::ICallback, public Core::IDispatch {
                 public:
                     Sink() = delete;
@@ -253,7 +266,8 @@ namespace Plugin
             struct ICallback
             {
                 virtual ~ICallback() {}
-                virtual void NewLine(const string &) = 0;
+                // The line is not '\0' terminated and only valid during the call.
+                virtual void NewLine(const char line[], const uint32_t length) = 0;
             };
 
         public:
@@ -264,6 +278,11 @@ namespace Plugin
                 , _callback(nullptr)
                 , _position(0)
                 , _path()
+                , _descriptor(-1)
+                , _device(0)
+                , _inode(0)
+                , _carry(0)
+                , _pending(false)
             {
             }
             ~FileObserver()
@@ -281,14 +300,11 @@ namespace Plugin
             {
                 ASSERT((_callback == nullptr) && (callback != nullptr));
 
-                if (fullFile == false) {
-                    _position = GetCurrentPosition(entry);
-                } else {
-                    _position = 0;
-                }
-
                 _path = entry;
                 _callback = callback;
+
+                Open(fullFile == false);
+
                 Core::FileSystemMonitor::Instance().Register(&(*_job), _path);
             }
             void Unregister()
@@ -301,66 +317,201 @@ namespace Plugin
                 // Potentially the Job might still be waiting, let’s kill it
                 Core::IWorkerPool::Instance().Revoke(Core::proxy_cast<Core::IDispatchType<void> >(_job));
 
+                Close();
+
                 _path = EMPTY_STRING;
-                _position = 0;
                 _callback = nullptr;
+                _pending = false;
             }
 
         private:
-            long int GetCurrentPosition(const string &filePath) const
+            bool Open(const bool atEnd)
             {
-                long int pos = 0;
-                std::ifstream file(filePath.c_str());
-                if (file) {
-                    file.seekg(0, file.end);
-                    pos = file.tellg();
+                struct stat info;
+
+                _descriptor = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+                _position = 0;
+                _carry = 0;
+
+                if ((_descriptor != -1) && (::fstat(_descriptor, &info) == 0)) {
+                    _device = info.st_dev;
+                    _inode = info.st_ino;
+
+                    if (atEnd == true) {
+                        _position = info.st_size;
+                    }
+                }
+
+                return (_descriptor != -1);
+            }
+            void Close()
+            {
+                if (_descriptor != -1) {
+                    ::close(_descriptor);
+                    _descriptor = -1;
                 }
-                return pos;
+                _position = 0;
+                _carry = 0;
             }
             void Dispatch()
             {
-                std::ifstream file(_path);
-                if (file) {
-                    file.seekg(_position, file.beg);
-                    std::string str;
-                    while ((std::getline(file, str)) && (str.size() > 0)) {
-                        ASSERT(_callback != nullptr);
-                        _callback->NewLine(str);
+                struct stat info;
+
+                _pending = false;
+
+                // Has the file been replaced since it was opened?
+                const bool rotated = (::stat(_path.c_str(), &info) != 0) || (_descriptor == -1) || (info.st_dev != _device) || (info.st_ino != _inode);
+
+                if (_descriptor != -1) {
+                    struct stat current;
+
+                    if ((::fstat(_descriptor, &current) == 0) && (current.st_size < _position)) {
+                        // Truncated, start all over.
+                        _position = 0;
+                        _carry = 0;
                     }
+
+                    Read();
+                }
+
+                if (rotated == true) {
+                    // Whatever was left without a line end, will not get one anymore.
+                    Emit(0, _carry);
+                    Close();
+
+                    if (Open(false) == true) {
+                        // The watch is bound to the file that is gone, move it to the new one.
+                        Core::FileSystemMonitor::Instance().Unregister(&(*_job), _path);
+                        Core::FileSystemMonitor::Instance().Register(&(*_job), _path);
+
+                        Read();
+                    } else {
+                        Core::IWorkerPool::Instance().Schedule(Core::Time::Now().Add(RetryDelay), Core::proxy_cast<Core::IDispatchType<void> >(_job));
+                    }
+                }
+            }
+            void Read()
+            {
+                ssize_t length;
+
+                while ((length = ::pread(_descriptor, &(_buffer[_carry]), sizeof(_buffer) - _carry, _position)) > 0) {
+                    const uint32_t available = _carry + static_cast<uint32_t>(length);
+                    uint32_t start = 0;
+                    const char* end;
+
+                    _position += length;
+
+                    while ((end = static_cast<const char*>(::memchr(&(_buffer[start]), '\n', available - start))) != nullptr) {
+                        const uint32_t stop = static_cast<uint32_t>(end - _buffer);
+
+                        Emit(start, stop - start);
+                        start = stop + 1;
+                    }
+
+                    if ((start == 0) && (available == sizeof(_buffer))) {
+                        // A line that does not even fit the buffer, pass it on in pieces.
+                        Emit(0, available);
+                        start = available;
+                    }
+
+                    _carry = available - start;
+                    ::memmove(_buffer, &(_buffer[start]), _carry);
+                }
+            }
+            inline void Emit(const uint32_t start, uint32_t length)
+            {
+                if ((length > 0) && (_buffer[start + length - 1] == '\r')) {
+                    length--;
+                }
+                if (length > 0) {
+                    ASSERT(_callback != nullptr);
+                    _callback->NewLine(&(_buffer[start]), length);
                 }
-                _position = GetCurrentPosition(_path);
             }
             void Updated()
             {
-                Core::IWorkerPool::Instance().Submit(Core::proxy_cast<Core::IDispatchType<void> >(_job));
+                // A busy file reports lots of changes, one pending read covers all of them.
+                if (_pending.exchange(true) == false) {
+                    Core::IWorkerPool::Instance().Submit(Core::proxy_cast<Core::IDispatchType<void> >(_job));
+                }
             }
 
         private:
             const Core::ProxyType<Sink> _job;
             ICallback *_callback;
-            long int _position;
+            off_t _position;
             string _path;
+            int _descriptor;
+            dev_t _device;
+            ino_t _inode;
+            uint32_t _carry; // Bytes at the start of the buffer, waiting for their line end.
+            std::atomic<bool> _pending;
+            char _buffer[BufferSize];
         };
 
     class FileTransfer : public PluginHost::IPlugin {
         private:
 
-            static constexpr uint16_t MAX_BUFFER_LENGHT = 1024;
+            // Payload of a UDP datagram that fits an ethernet MTU (1500 - IPv4 header - UDP header).
+            static constexpr uint16_t MAX_BUFFER_LENGHT = 1472;
             static constexpr uint16_t TIMEOUT_MS = 0;
 
+            class Statistics : public Core::JSON::Container {
+                private:
+                    Statistics(const Statistics &) = delete;
+                    Statistics &operator=(const Statistics &) = delete;
+
+                public:
+                    Statistics()
+                        : Core::JSON::Container()
+                    {
+                        Add(_T("lines"), &Lines);
+                        Add(_T("bytes"), &Bytes);
+                        Add(_T("datagrams"), &Datagrams);
+                        Add(_T("dropped"), &Dropped);
+                    }
+                    ~Statistics() override
+                    {
+                    }
+
+                public:
+                    Core::JSON::DecUInt64 Lines;
+                    Core::JSON::DecUInt64 Bytes;
+                    Core::JSON::DecUInt64 Datagrams;
+                    Core::JSON::DecUInt64 Dropped;
+            };
+
+            // Packs the lines into datagrams as they come in. A line only gets split over datagrams if it
+            // does not fit in one. If the network can not keep up, and all frames are filled, new lines are
+            // dropped. Lines count as sent once the frame they end in is handed to the socket.
             class TextChannel : public Core::SocketDatagram
             {
+                private:
+                    static constexpr uint8_t Frames = 64;
+
+                    struct Frame {
+                        uint16_t Length;
+                        uint16_t Lines; // Ending in this frame.
+                        uint8_t Data[MAX_BUFFER_LENGHT];
+                    };
+
                 public:
                     TextChannel()
                         : Core::SocketDatagram(false, Core::NodeId().Origin(), Core::NodeId(), MAX_BUFFER_LENGHT, 0)
-                        , _sendQueue()
-                        , _offset(0)
+                        , _adminLock()
+                        , _head(0)
+                        , _tail(0)
+                        , _closed(0)
+                        , _lines(0)
+                        , _bytes(0)
+                        , _datagrams(0)
+                        , _dropped(0)
                     {
+                        _frames[_tail].Length = 0;
+                        _frames[_tail].Lines = 0;
                     }
                     virtual ~TextChannel()
                     {
-                        _sendQueue.clear();
-                        _offset = 0;
                         Close(Core::infinite);
                     }
 
@@ -373,12 +524,33 @@ namespace Plugin
                         Open(TIMEOUT_MS);
                     }
 
-                    void NewLine(const string& text)
+                    void NewLine(const char text[], const uint32_t length)
                     {
+                        const uint8_t markerSize = static_cast<uint8_t>(_terminator.SizeOf() * sizeof(TCHAR));
+                        const uint32_t size = length + markerSize;
+                        bool trigger = false;
+
                         _adminLock.Lock();
 
-                        _sendQueue.emplace_back(text);
-                        bool trigger = (_sendQueue.size() == 1);
+                        Frame* frame = &(_frames[_tail]);
+
+                        // Start on a fresh frame if that keeps the line in a single datagram.
+                        if (((frame->Length + size) > MAX_BUFFER_LENGHT) && (size <= MAX_BUFFER_LENGHT) && (frame->Length != 0)) {
+                            frame = Next();
+                        }
+
+                        const uint32_t room = (frame != nullptr ? (MAX_BUFFER_LENGHT - frame->Length) + ((Frames - 1 - _closed) * MAX_BUFFER_LENGHT) : 0);
+
+                        if (room < size) {
+                            _dropped++;
+                        } else {
+                            trigger = ((_closed == 0) && (frame->Length == 0));
+
+                            Copy(frame, reinterpret_cast<const uint8_t*>(text), length);
+                            Copy(frame, reinterpret_cast<const uint8_t*>(_terminator.Marker()), markerSize);
+
+                            frame->Lines++;
+                        }
 
                         _adminLock.Unlock();
 
@@ -387,7 +559,51 @@ namespace Plugin
                             Trigger();
                         }
                     }
+                    void Get(Statistics& statistics) const
+                    {
+                        _adminLock.Lock();
+
+                        statistics.Lines = _lines;
+                        statistics.Bytes = _bytes;
+                        statistics.Datagrams = _datagrams;
+                        statistics.Dropped = _dropped;
+
+                        _adminLock.Unlock();
+                    }
+
                 private:
+                    // Closes the frame being filled and returns the next one, nullptr if they are all in use.
+                    Frame* Next()
+                    {
+                        Frame* result = nullptr;
+
+                        if (_closed < (Frames - 1)) {
+                            _closed++;
+                            _tail = (_tail + 1) % Frames;
+                            result = &(_frames[_tail]);
+                            result->Length = 0;
+                            result->Lines = 0;
+                        }
+
+                        return (result);
+                    }
+                    void Copy(Frame*& frame, const uint8_t data[], uint32_t length)
+                    {
+                        while (length > 0) {
+                            if (frame->Length == MAX_BUFFER_LENGHT) {
+                                frame = Next();
+                                ASSERT(frame != nullptr);
+                            }
+
+                            const uint16_t size = std::min(length, static_cast<uint32_t>(MAX_BUFFER_LENGHT - frame->Length));
+
+                            ::memcpy(&(frame->Data[frame->Length]), data, size);
+                            frame->Length += size;
+                            data += size;
+                            length -= size;
+                        }
+                    }
+
                     // Methods to extract and insert data into the socket buffers
                     uint16_t SendData(uint8_t *dataFrame, const uint16_t maxSendSize) override
                     {
@@ -395,39 +611,31 @@ namespace Plugin
 
                         _adminLock.Lock();
 
-                        if (_offset == static_cast<uint32_t>(~0)) {
-                            // We are done with this entry it has been sent!!! discard it.
-                            _sendQueue.pop_front();
-                            _offset = 0;
+                        if ((_closed == 0) && (_frames[_tail].Length != 0)) {
+                            // Nothing waiting but the frame being filled, send what is there.
+                            Next();
                         }
 
-                        if (_sendQueue.size() > 0) {
-                            const string& sendObject = _sendQueue.front();
+                        if (_closed > 0) {
+                            const Frame& frame(_frames[_head]);
 
-                            // Do we still need to send data from the text..
-                            if (_offset < (sendObject.size() * sizeof(TCHAR))) {
-                                result = (((sendObject.size() * sizeof(TCHAR)) - _offset) > maxSendSize ? maxSendSize : ((sendObject.size() * sizeof(TCHAR)) - _offset));
+                            ASSERT(frame.Length <= maxSendSize);
 
-                                _offset += SendCharacters(dataFrame, &(sendObject.c_str()[(_offset / sizeof(TCHAR))]), (_offset % sizeof(TCHAR)), result);
-                            }
+                            result = std::min(frame.Length, maxSendSize);
+                            ::memcpy(dataFrame, frame.Data, result);
 
-                            // See if we can write the closing marker
-                            if ((maxSendSize != result) && (_offset >= (sendObject.size() * sizeof(TCHAR))) && (_offset < ((sendObject.size() + (_terminator.SizeOf())) * sizeof(TCHAR)))) {
-                                uint8_t markerSize = (static_cast<uint8_t>(_terminator.SizeOf()) * sizeof(TCHAR));
-                                uint8_t markerOffset = ((sendObject.size() * sizeof(TCHAR)) - _offset);
-                                uint16_t size = ((markerSize - markerOffset) > (maxSendSize - result) ? (maxSendSize - result) : (markerSize - markerOffset));
+                            _head = (_head + 1) % Frames;
+                            _closed--;
 
-                                _offset += SendCharacters(&(dataFrame[result]), &(_terminator.Marker()[(markerOffset / sizeof(TCHAR))]), (markerOffset % sizeof(TCHAR)), size);
-                                result += size;
+                            _datagrams++;
+                            _bytes += result;
 
-                                if ((size + markerOffset) == markerSize) {
-                                    // Report as completed on the next run
-                                    _offset = static_cast<uint32_t>(~0);
-                                }
+                            if (result == frame.Length) {
+                                _lines += frame.Lines;
+                            } else {
+                                // Cut short, the lines ending in it did not make it.
+                                _dropped += frame.Lines;
                             }
-
-                            // If we went through this entry we must have processed something....
-                            ASSERT(result != 0);
                         }
 
                         _adminLock.Unlock();
@@ -444,18 +652,16 @@ namespace Plugin
                     {
                     }
 
-                    uint16_t SendCharacters(uint8_t *dataFrame, const TCHAR stream[], const uint8_t delta, const uint16_t total)
-                    {
-                        ASSERT(delta == 0);
-                        // Copying from an aligned position..
-                        ::memcpy(dataFrame, stream, total);
-                        return (total);
-                    }
-
                 private:
-                    Core::CriticalSection _adminLock;
-                    std::list<string> _sendQueue;
-                    uint32_t _offset;
+                    mutable Core::CriticalSection _adminLock;
+                    Frame _frames[Frames];
+                    uint8_t _head; // Oldest frame to be sent.
+                    uint8_t _tail; // Frame being filled.
+                    uint8_t _closed; // Frames ready to be sent.
+                    uint64_t _lines;
+                    uint64_t _bytes;
+                    uint64_t _datagrams;
+                    uint64_t _dropped;
                     Core::TerminatorCarriageReturn _terminator;
             };
 
@@ -463,8 +669,7 @@ namespace Plugin
             {
                 public:
                     OnChangeFile(TextChannel *parent)
-                        : _adminLock()
-                        , _parent(*parent)
+                        : _parent(*parent)
                     {
                     }
                     ~OnChangeFile()
@@ -474,16 +679,11 @@ namespace Plugin
                     OnChangeFile(const OnChangeFile &) = delete;
                     OnChangeFile &operator=(const OnChangeFile &) = delete;
 
-                    void NewLine(const string &text) override
+                    void NewLine(const char line[], const uint32_t length) override
                     {
-                        _adminLock.Lock();
-
-                        _parent.NewLine(text);
-
-                        _adminLock.Unlock();
+                        _parent.NewLine(line, length);
                     }
 
-               Core::CriticalSection _adminLock;
                TextChannel &_parent;
             };
 
@@ -0,0 +1,114 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <list>
+#include <string>
+
+namespace WPEFramework {
+
+namespace Plugin {
+
+    // The messages pending for one user, at most depth of them. When it is full, the oldest message makes
+    // room for the new one; when coalescing, the oldest one of the same sender, if there is one. It does not
+    // lock, the owner does. The fan-out benchmark queues its messages in it as well, without the framework.
+    class MessageQueue {
+    public:
+        struct Message {
+            std::string Sender;
+            std::string Text;
+        };
+        typedef Message Item;
+
+        enum state {
+            QUEUED,
+            DROPPED,
+            COALESCED
+        };
+
+    public:
+        MessageQueue() = delete;
+        MessageQueue(const MessageQueue&) = delete;
+        MessageQueue& operator=(const MessageQueue&) = delete;
+
+        MessageQueue(const uint16_t depth, const bool coalesce)
+            : _pending()
+            , _depth(depth)
+            , _coalesce(coalesce)
+        {
+        }
+        ~MessageQueue()
+        {
+        }
+
+    public:
+        inline bool IsEmpty() const
+        {
+            return (_pending.empty());
+        }
+        // Tells what had to make room for the message, if anything.
+        state Push(const std::string& sender, const std::string& text)
+        {
+            state result = QUEUED;
+
+            if (_pending.size() >= _depth) {
+                std::list<Message>::iterator index(_pending.begin());
+
+                result = DROPPED;
+
+                if (_coalesce == true) {
+                    while ((index != _pending.end()) && (index->Sender != sender)) {
+                        index++;
+                    }
+                    if (index != _pending.end()) {
+                        result = COALESCED;
+                    } else {
+                        index = _pending.begin();
+                    }
+                }
+
+                _pending.erase(index);
+            }
+
+            _pending.push_back(Message { sender, text });
+
+            return (result);
+        }
+        // Hands out all pending messages, batch should be empty.
+        inline void Take(std::list<Message>& batch)
+        {
+            batch.swap(_pending);
+        }
+        inline void Clear()
+        {
+            _pending.clear();
+        }
+
+    private:
+        std::list<Message> _pending;
+        uint16_t _depth;
+        bool _coalesce;
+    };
+
+} // namespace Plugin
+
+} // namespace WPEFramework
@@ -40,6 +40,11 @@ namespace Plugin {
         _service = service;
         _service->AddRef();
 
+        Config config;
+        config.FromString(service->ConfigLine());
+        _batchInterval = config.BatchInterval.Value();
+        _backlog = std::max(config.Backlog.Value(), static_cast<uint16_t>(1));
+
         _roomAdmin = service->Root<Exchange::IRoomAdministrator>(_connectionId, 2000, _T("RoomMaintainer"));
         ASSERT(_roomAdmin != nullptr);
 
@@ -59,6 +64,14 @@ namespace Plugin {
 
         _roomIds.clear();
 
+        // Without channels nothing is scheduled anymore.
+        _channelLock.Lock();
+        _channels.clear();
+        _channelLock.Unlock();
+
+        _job.Revoke();
+        _scheduled = false;
+
         _roomAdmin->Unregister(this);
         _rooms.clear();
 
@@ -81,6 +94,12 @@ namespace Plugin {
         ASSERT(sink != nullptr);
 
         if (sink != nullptr) {
+            // The room may start sending (its history) right away, so be ready for it. The room ID may
+            // already be in use by the same user, joining twice within a second, leave that one alone.
+            _channelLock.Lock();
+            const bool inserted = _channels.emplace(roomId, Channel(roomName, userName)).second;
+            _channelLock.Unlock();
+
             Exchange::IRoomAdministrator::IRoom* room = _roomAdmin->Join(roomName, userName, sink);
 
             // Note: Join() can return nullptr if the user has already joined the room.
@@ -93,6 +112,12 @@ namespace Plugin {
             }
 
             sink->Release(); // Make room the only owner of the notification object.
+
+            if ((result == false) && (inserted == true)) {
+                _channelLock.Lock();
+                _channels.erase(roomId);
+                _channelLock.Unlock();
+            }
         }
 
         return (result? roomId : string{});
@@ -146,6 +171,12 @@ namespace Plugin {
 
         _adminLock.Unlock();
 
+        if (result == true) {
+            _channelLock.Lock();
+            _channels.erase(roomId);
+            _channelLock.Unlock();
+        }
+
         return result;
     }
 
@@ -168,6 +199,145 @@ namespace Plugin {
         return result;
     }
 
+    void Messenger::MessageHandler(const string& roomId, const string& senderName, const string& message)
+    {
+        bool direct = false;
+
+        _channelLock.Lock();
+
+        auto it(_channels.find(roomId));
+
+        if (it != _channels.end()) {
+            Channel& channel((*it).second);
+            const uint64_t now = Core::Time::Now().Ticks();
+
+            channel.Received++;
+            channel.WindowCount++;
+
+            if ((now - channel.WindowStart) >= Second) {
+                channel.Rate = static_cast<uint32_t>((static_cast<uint64_t>(channel.WindowCount) * Second) / (now - channel.WindowStart));
+                channel.WindowStart = now;
+                channel.WindowCount = 0;
+            }
+
+            // Only send it right away if that does not overtake older messages.
+            if ((channel.Single == true) && (channel.Undelivered == 0)) {
+                channel.Notifications++;
+                direct = true;
+            }
+
+            if ((channel.Batched == true) || (direct == false)) {
+                if (channel.Pending.size() >= _backlog) {
+                    if (channel.Pending.front().Delivered == false) {
+                        channel.Undelivered--;
+                    }
+                    channel.Pending.pop_front();
+                    channel.Dropped++;
+                }
+
+                channel.Pending.push_back(Entry { senderName, message, direct });
+
+                if (direct == false) {
+                    channel.Undelivered++;
+                }
+
+                channel.Peak = std::max(channel.Peak, static_cast<uint32_t>(channel.Pending.size()));
+
+                if (channel.IsLive() == true) {
+                    Flush((channel.Single == true) && (direct == false));
+                }
+            }
+        }
+
+        _channelLock.Unlock();
+
+        if (direct == true) {
+            event_message(roomId, senderName, message);
+        }
+    }
+
+    void Messenger::SubscribeMessage(const string& roomId, const bool batched, const bool subscribe)
+    {
+        _channelLock.Lock();
+
+        auto it(_channels.find(roomId));
+
+        if (it != _channels.end()) {
+            if (batched == true) {
+                (*it).second.Batched = subscribe;
+            }
+            else {
+                (*it).second.Single = subscribe;
+            }
+
+            if ((subscribe == true) && ((*it).second.Pending.empty() == false)) {
+                Flush(batched == false);
+            }
+        }
+
+        _channelLock.Unlock();
+    }
+
+    // Call with the channel lock taken. Batches go out once per batch interval, messages waiting for a
+    // "message" subscriber (immediate) are sent as soon as possible. If a batch is already scheduled, they
+    // go along with it.
+    void Messenger::Flush(const bool immediate)
+    {
+        if (_scheduled == false) {
+            _scheduled = true;
+
+            if ((immediate == true) || (_batchInterval == 0)) {
+                _job.Submit();
+            }
+            else {
+                _job.Schedule(Core::Time::Now().Add(_batchInterval));
+            }
+        }
+    }
+
+    void Messenger::Dispatch()
+    {
+        struct Batch {
+            string Id;
+            std::list<Entry> Entries;
+            bool Single;
+            bool Batched;
+        };
+
+        std::list<Batch> batches;
+
+        _channelLock.Lock();
+
+        _scheduled = false;
+
+        for (auto& entry : _channels) {
+            Channel& channel(entry.second);
+
+            if ((channel.IsLive() == true) && (channel.Pending.empty() == false)) {
+                channel.Notifications += ((channel.Single == true ? channel.Undelivered : 0) + (channel.Batched == true ? 1 : 0));
+
+                batches.push_back(Batch { entry.first, std::list<Entry>(), channel.Single, channel.Batched });
+                batches.back().Entries.swap(channel.Pending);
+                channel.Undelivered = 0;
+            }
+        }
+
+        _channelLock.Unlock();
+
+        for (const Batch& batch : batches) {
+            if (batch.Single == true) {
+                for (const Entry& message : batch.Entries) {
+                    if (message.Delivered == false) {
+                        event_message(batch.Id, message.User, message.Text);
+                    }
+                }
+            }
+            if (batch.Batched == true) {
+                event_messages(batch.Id, batch.Entries);
+            }
+        }
+    }
+
     // Helpers
 
     string Messenger::GenerateRoomId(const string& roomName, const string& userName)
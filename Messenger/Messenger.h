@@ -33,6 +33,165 @@ namespace Plugin {
     class Messenger : public PluginHost::IPlugin
                     , public Exchange::IRoomAdministrator::INotification
                     , public PluginHost::JSONRPCSupportsEventStatus {
+    private:
+        class Config : public Core::JSON::Container {
+        private:
+            Config(const Config&) = delete;
+            Config& operator=(const Config&) = delete;
+
+        public:
+            Config()
+                : Core::JSON::Container()
+                , BatchInterval(0)
+                , Backlog(64)
+            {
+                Add(_T("batchinterval"), &BatchInterval);
+                Add(_T("backlog"), &Backlog);
+            }
+            ~Config()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt16 BatchInterval; // ms, 0 sends every message as a notification of its own.
+            Core::JSON::DecUInt16 Backlog;
+        };
+
+        static constexpr uint64_t Second = 1000 * Core::Time::TicksPerMillisecond;
+
+        struct Entry {
+            string User;
+            string Text;
+            bool Delivered; // Already sent as a "message" notification, only waits for the batch.
+        };
+
+        // The messages for one joined room ID on their way to its websocket client. A client can subscribe
+        // to "message", one notification per message, and/or to "messages", one notification per batch
+        // interval. Messages that arrive before the client subscribed to either (e.g. the history of the
+        // room) are kept until it does.
+        struct Channel {
+            Channel(const string& room, const string& user)
+                : Room(room)
+                , User(user)
+                , Pending()
+                , Undelivered(0)
+                , Single(false)
+                , Batched(false)
+                , Received(0)
+                , Notifications(0)
+                , Dropped(0)
+                , Peak(0)
+                , Rate(0)
+                , WindowStart(Core::Time::Now().Ticks())
+                , WindowCount(0)
+            {
+            }
+
+            bool IsLive() const
+            {
+                return ((Single == true) || (Batched == true));
+            }
+
+            string Room;
+            string User;
+            std::list<Entry> Pending;
+            uint32_t Undelivered; // Entries in Pending not sent as a "message" notification yet.
+            bool Single;
+            bool Batched;
+            uint64_t Received;
+            uint64_t Notifications;
+            uint64_t Dropped;
+            uint32_t Peak;
+            uint32_t Rate; // Messages per second, over the last window.
+            uint64_t WindowStart;
+            uint32_t WindowCount;
+        };
+
+    public:
+        class MessageData : public Core::JSON::Container {
+        public:
+            MessageData()
+                : Core::JSON::Container()
+            {
+                Add(_T("user"), &User);
+                Add(_T("message"), &Message);
+            }
+            MessageData(const MessageData& copy)
+                : Core::JSON::Container()
+                , User(copy.User)
+                , Message(copy.Message)
+            {
+                Add(_T("user"), &User);
+                Add(_T("message"), &Message);
+            }
+            MessageData& operator=(const MessageData&) = delete;
+
+        public:
+            Core::JSON::String User;
+            Core::JSON::String Message;
+        };
+
+        class MessagesData : public Core::JSON::Container {
+        public:
+            MessagesData(const MessagesData&) = delete;
+            MessagesData& operator=(const MessagesData&) = delete;
+
+            MessagesData()
+                : Core::JSON::Container()
+            {
+                Add(_T("messages"), &Messages);
+            }
+
+        public:
+            Core::JSON::ArrayType<MessageData> Messages;
+        };
+
+        class StatisticsData : public Core::JSON::Container {
+        public:
+            StatisticsData()
+                : Core::JSON::Container()
+            {
+                Init();
+            }
+            StatisticsData(const StatisticsData& copy)
+                : Core::JSON::Container()
+                , Room(copy.Room)
+                , User(copy.User)
+                , Rate(copy.Rate)
+                , Received(copy.Received)
+                , Notifications(copy.Notifications)
+                , Dropped(copy.Dropped)
+                , Depth(copy.Depth)
+                , Peak(copy.Peak)
+            {
+                Init();
+            }
+            StatisticsData& operator=(const StatisticsData&) = delete;
+
+        private:
+            void Init()
+            {
+                Add(_T("room"), &Room);
+                Add(_T("user"), &User);
+                Add(_T("rate"), &Rate);
+                Add(_T("received"), &Received);
+                Add(_T("notifications"), &Notifications);
+                Add(_T("dropped"), &Dropped);
+                Add(_T("depth"), &Depth);
+                Add(_T("peak"), &Peak);
+            }
+
+        public:
+            Core::JSON::String Room;
+            Core::JSON::String User;
+            Core::JSON::DecUInt32 Rate;
+            Core::JSON::DecUInt64 Received;
+            Core::JSON::DecUInt64 Notifications;
+            Core::JSON::DecUInt64 Dropped;
+            Core::JSON::DecUInt32 Depth;
+            Core::JSON::DecUInt32 Peak;
+        };
+
     public:
         Messenger(const Messenger&) = delete;
         Messenger& operator=(const Messenger&) = delete;
@@ -43,6 +202,12 @@ namespace Plugin {
             , _roomAdmin(nullptr)
             , _roomIds()
             , _adminLock()
+            , _batchInterval(0)
+            , _backlog(0)
+            , _channels()
+            , _channelLock()
+            , _scheduled(false)
+            , _job(*this)
         {
             RegisterAll();
         }
@@ -141,10 +306,7 @@ namespace Plugin {
             event_userupdate(roomId, userName, JsonData::Messenger::UserupdateParamsData::ActionType::LEFT);
         }
 
-        void MessageHandler(const string& roomId, const string& senderName, const string& message)
-        {
-            event_message(roomId, senderName, message);
-        }
+        void MessageHandler(const string& roomId, const string& senderName, const string& message);
 
         // IMessenger::INotification methods
         void Created(const string& roomName) override
@@ -168,8 +330,13 @@ namespace Plugin {
         }
 
     private:
+        friend Core::ThreadPool::JobType<Messenger&>;
+
         string GenerateRoomId(const string& roomName, const string& userName);
         bool SubscribeUserUpdate(const string& roomId, bool subscribe);
+        void SubscribeMessage(const string& roomId, const bool batched, const bool subscribe);
+        void Flush(const bool immediate);
+        void Dispatch();
 
         // JSON-RPC
         void RegisterAll();
@@ -180,6 +347,8 @@ namespace Plugin {
         void event_roomupdate(const string& room, const JsonData::Messenger::RoomupdateParamsData::ActionType& action);
         void event_userupdate(const string& id, const string& user, const JsonData::Messenger::UserupdateParamsData::ActionType& action);
         void event_message(const string& id, const string& user, const string& message);
+        void event_messages(const string& id, const std::list<Entry>& messages);
+        uint32_t get_statistics(Core::JSON::ArrayType<StatisticsData>& response) const;
 
         uint32_t _connectionId;
         PluginHost::IShell* _service;
@@ -187,6 +356,12 @@ namespace Plugin {
         std::map<string, Exchange::IRoomAdministrator::IRoom*> _roomIds;
         std::set<string> _rooms;
         mutable Core::CriticalSection _adminLock;
+        uint16_t _batchInterval;
+        uint16_t _backlog;
+        std::map<string, Channel> _channels;
+        mutable Core::CriticalSection _channelLock;
+        bool _scheduled;
+        Core::WorkerPool::JobType<Messenger&> _job;
     }; // class Messenger
 
 } // namespace Plugin
@@ -46,16 +46,29 @@ namespace Plugin {
             SubscribeUserUpdate(roomId, status == Status::registered);
         });
 
+        RegisterEventStatusListener(_T("message"), [this](const string& client, Status status) {
+            // Messages that came in before (e.g. the history of the room) are delivered now.
+            SubscribeMessage(client.substr(0, client.find('.')), false, status == Status::registered);
+        });
+
+        RegisterEventStatusListener(_T("messages"), [this](const string& client, Status status) {
+            SubscribeMessage(client.substr(0, client.find('.')), true, status == Status::registered);
+        });
+
         Register<JoinParamsData,JoinResultInfo>(_T("join"), &Messenger::endpoint_join, this);
         Register<JoinResultInfo,void>(_T("leave"), &Messenger::endpoint_leave, this);
         Register<SendParamsData,void>(_T("send"), &Messenger::endpoint_send, this);
+        Property<Core::JSON::ArrayType<StatisticsData>>(_T("statistics"), &Messenger::get_statistics, nullptr, this);
     }
 
     void Messenger::UnregisterAll()
     {
+        Unregister(_T("statistics"));
         Unregister(_T("send"));
         Unregister(_T("leave"));
         Unregister(_T("join"));
+        UnregisterEventStatusListener(_T("messages"));
+        UnregisterEventStatusListener(_T("message"));
         UnregisterEventStatusListener(_T("userupdate"));
         UnregisterEventStatusListener(_T("roomupdate"));
     }
@@ -115,6 +128,37 @@ namespace Plugin {
         return result? Core::ERROR_NONE : Core::ERROR_UNKNOWN_KEY;
     }
 
+    // Delivery statistics of every joined room ID.
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t Messenger::get_statistics(Core::JSON::ArrayType<StatisticsData>& response) const
+    {
+        const uint64_t now = Core::Time::Now().Ticks();
+
+        _channelLock.Lock();
+
+        for (const auto& entry : _channels) {
+            const Channel& channel(entry.second);
+            StatisticsData room;
+
+            room.Room = channel.Room;
+            room.User = channel.User;
+            // Nothing came in for a while, the last rate is no longer true.
+            room.Rate = ((now - channel.WindowStart) < (2 * Second) ? channel.Rate : 0);
+            room.Received = channel.Received;
+            room.Notifications = channel.Notifications;
+            room.Dropped = channel.Dropped;
+            room.Depth = static_cast<uint32_t>(channel.Pending.size());
+            room.Peak = channel.Peak;
+
+            response.Add(room);
+        }
+
+        _channelLock.Unlock();
+
+        return Core::ERROR_NONE;
+    }
+
     // Notifies about room status updates.
     void Messenger::event_roomupdate(const string& room, const RoomupdateParamsData::ActionType& action)
     {
@@ -151,6 +195,24 @@ namespace Plugin {
         });
     }
 
+    // Notifies about a batch of new messages in a room.
+    void Messenger::event_messages(const string& id, const std::list<Entry>& messages)
+    {
+        MessagesData params;
+
+        for (const Entry& message : messages) {
+            MessageData entry;
+            entry.User = message.User;
+            entry.Message = message.Text;
+            params.Messages.Add(entry);
+        }
+
+        Notify(_T("messages"), params, [&](const string& designator) -> bool {
+            const string designator_id = designator.substr(0, designator.find('.'));
+            return (id == designator_id);
+        });
+    }
+
 } // namespace Plugin
 
 }
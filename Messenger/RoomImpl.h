@@ -38,17 +38,13 @@ namespace Plugin {
             , _userId(userId)
             , _roomAdmin(admin)
             , _callback(nullptr)
-            , _messageSink(messageSink)
+            , _mailbox(admin->CreateMailbox(messageSink))
             , _adminLock()
         {
             ASSERT(admin != nullptr);
 
             _roomAdmin->AddRef();
 
-            if (_messageSink) {
-                _messageSink->AddRef();
-            }
-
             if (userId.size() == 0) {
                 TRACE(Trace::Warning, (_T("Created a user with empty userId")));
             }
@@ -63,9 +59,8 @@ namespace Plugin {
             // Release the callback if necessary.
             SetCallback(nullptr);
 
-            if (_messageSink) {
-                _messageSink->Release();
-            }
+            // Messages still pending are not delivered anymore, the sink goes with the last reference.
+            _mailbox->Close();
 
             _roomAdmin->Release();
         }
@@ -135,11 +130,9 @@ namespace Plugin {
             _adminLock.Unlock();
         }
 
-        void MessageReceived(const string& userId, const string& message)
+        Core::ProxyType<RoomMaintainer::Mailbox> Mailbox() const
         {
-            if (_messageSink != nullptr) {
-                _messageSink->Message(userId, message);
-            }
+            return (_mailbox);
         }
 
         const string& UserId() const { return _userId; }
@@ -155,7 +148,7 @@ namespace Plugin {
         string _userId;
         RoomMaintainer* _roomAdmin;
         Exchange::IRoomAdministrator::IRoom::ICallback* _callback;
-        Exchange::IRoomAdministrator::IRoom::IMsgNotification* _messageSink;
+        Core::ProxyType<RoomMaintainer::Mailbox> _mailbox;
         mutable Core::CriticalSection _adminLock;
     };
 
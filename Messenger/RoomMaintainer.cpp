@@ -27,21 +27,52 @@ namespace Plugin {
 
     SERVICE_REGISTRATION(RoomMaintainer, 1, 0);
 
+    constexpr uint8_t RoomMaintainer::Shards;
+
+    /* static */ void RoomMaintainer::Rebuild(Room& room)
+    {
+        // Never modify the current list in place, someone may be delivering to it.
+        std::shared_ptr<Mailboxes> members(new Mailboxes());
+        members->reserve(room.Users.size());
+
+        for (RoomImpl* user : room.Users) {
+            members->push_back(user->Mailbox());
+        }
+
+        room.Members = members;
+    }
+
+    /* static */ void RoomMaintainer::Remember(Room& room, const string& sender, const string& text)
+    {
+        if ((MESSENGER_HISTORY_DEPTH > 0) && ((sender.size() + text.size()) <= MESSENGER_HISTORY_BYTES)) {
+            room.History.push_back(Message { sender, text });
+            room.HistoryBytes += (sender.size() + text.size());
+
+            while ((room.History.size() > MESSENGER_HISTORY_DEPTH) || (room.HistoryBytes > MESSENGER_HISTORY_BYTES)) {
+                room.HistoryBytes -= (room.History.front().Sender.size() + room.History.front().Text.size());
+                room.History.pop_front();
+            }
+        }
+    }
+
     /* virtual */ Exchange::IRoomAdministrator::IRoom* RoomMaintainer::Join(const string& roomId, const string& userId,
                                                                             Exchange::IRoomAdministrator::IRoom::IMsgNotification* messageSink)
     {
         // Note: Nullptr message sink is allowed (e.g. for broadcast-only users).
 
         RoomImpl* newRoomUser = nullptr;
+        Shard& shard(Select(roomId));
 
-        _adminLock.Lock();
+        shard.Lock.Lock();
 
-        auto  it(_roomMap.find(roomId));
+        auto  it(shard.Rooms.find(roomId));
 
-        if (it == _roomMap.end()) {
+        if (it == shard.Rooms.end()) {
             // Room not found, so create one, already emplacing the first user.
             newRoomUser = Core::Service<RoomImpl>::Create<RoomImpl>(this, roomId, userId, messageSink);
-            it = _roomMap.emplace(roomId, std::list<RoomImpl*>({newRoomUser})).first;
+            it = shard.Rooms.emplace(roomId, Room()).first;
+            (*it).second.Users.push_back(newRoomUser);
+            Rebuild((*it).second);
 
             TRACE(Trace::Information, (_T("Room Maintainer: Room '%s' created"), roomId.c_str()));
             if (roomId.size() == 0) {
@@ -49,13 +80,17 @@ namespace Plugin {
             }
 
             // Notify the observers about a new room.
+            _adminLock.Lock();
+
             for (auto& observer : _observers) {
                 observer->Created(roomId);
             }
+
+            _adminLock.Unlock();
         }
         else {
             // Room already created; try to add another user.
-            std::list<RoomImpl*>& users = (*it).second;
+            std::list<RoomImpl*>& users = (*it).second.Users;
 
             if (std::find_if(users.begin(), users.end(), [&userId](const RoomImpl* user) { return (user->UserId() == userId);}) == users.end()) {
                 newRoomUser = Core::Service<RoomImpl>::Create<RoomImpl>(this, roomId, userId, messageSink);
@@ -67,6 +102,21 @@ namespace Plugin {
                 }
 
                 users.push_back(newRoomUser);
+                Rebuild((*it).second);
+
+                // Let the newcomer catch up. Sends remember their message under this lock as well, so a
+                // message is either in the history or will still reach the new user, never both.
+                if ((*it).second.History.empty() == false) {
+                    Core::ProxyType<Mailbox> mailbox(newRoomUser->Mailbox());
+                    bool submit = false;
+
+                    for (const Message& message : (*it).second.History) {
+                        submit = mailbox->Post(message.Sender, message.Text) || submit;
+                    }
+                    if (submit == true) {
+                        Core::IWorkerPool::Instance().Submit(Core::ProxyType<Core::IDispatch>(mailbox));
+                    }
+                }
             }
             else {
                 TRACE(Trace::Error, (_T("Room Maintainer: User '%s' has already joined room '%s'"),
@@ -79,7 +129,7 @@ namespace Plugin {
                     userId.c_str(), roomId.c_str()));
         }
 
-        _adminLock.Unlock();
+        shard.Lock.Unlock();
 
         // May be nullptr if the user has already joined the room earlier.
         return newRoomUser;
@@ -89,13 +139,15 @@ namespace Plugin {
     {
         ASSERT(roomUser != nullptr);
 
-        _adminLock.Lock();
+        Shard& shard(Select(roomUser->RoomId()));
+
+        shard.Lock.Lock();
 
-        auto it(_roomMap.find(roomUser->RoomId()));
-        ASSERT(it != _roomMap.end());
+        auto it(shard.Rooms.find(roomUser->RoomId()));
+        ASSERT(it != shard.Rooms.end());
 
-        if (it != _roomMap.end()) {
-            std::list<RoomImpl*>& users = (*it).second;
+        if (it != shard.Rooms.end()) {
+            std::list<RoomImpl*>& users = (*it).second.Users;
 
             auto uit(std::find(users.begin(), users.end(), roomUser));
             ASSERT(uit != users.end());
@@ -113,61 +165,86 @@ namespace Plugin {
 
                 // Was it the last user?
                 if (users.size() == 0) {
-                    _roomMap.erase(it);
+                    shard.Rooms.erase(it);
 
                     TRACE(Trace::Information, (_T("Room Maintainer: Room '%s' has been destroyed"), roomUser->RoomId().c_str()));
 
                     // Notify the observers about the destruction of this room.
+                    _adminLock.Lock();
+
                     for (auto& observer : _observers) {
                         observer->Destroyed(roomUser->RoomId());
                     }
+
+                    _adminLock.Unlock();
+                }
+                else {
+                    Rebuild((*it).second);
                 }
             }
         }
 
-        _adminLock.Unlock();
+        shard.Lock.Unlock();
     }
 
     void RoomMaintainer::Notify(RoomImpl* roomUser)
     {
         ASSERT(roomUser != nullptr);
 
-        _adminLock.Lock();
+        Shard& shard(Select(roomUser->RoomId()));
+
+        shard.Lock.Lock();
 
-        auto it = _roomMap.find(roomUser->RoomId());
-        ASSERT(it != _roomMap.end());
+        auto it = shard.Rooms.find(roomUser->RoomId());
+        ASSERT(it != shard.Rooms.end());
 
-        if (it != _roomMap.end()) {
-            for (auto& user : (*it).second) {
+        if (it != shard.Rooms.end()) {
+            for (auto& user : (*it).second.Users) {
                 roomUser->UserJoined(user->UserId());
             }
         }
 
-        _adminLock.Unlock();
+        shard.Lock.Unlock();
     }
 
     void RoomMaintainer::Send(const string& message, RoomImpl* roomUser)
     {
         ASSERT(roomUser != nullptr);
 
-        _adminLock.Lock();
+        std::shared_ptr<const Mailboxes> members;
+        Shard& shard(Select(roomUser->RoomId()));
 
-        auto it(_roomMap.find(roomUser->RoomId()));
-        ASSERT(it != _roomMap.end());
+        shard.Lock.Lock();
 
-        if (it != _roomMap.end()) {
-            for (RoomImpl* user : (*it).second) {
-                user->MessageReceived(roomUser->UserId(), message);
-            }
+        auto it(shard.Rooms.find(roomUser->RoomId()));
+        ASSERT(it != shard.Rooms.end());
+
+        if (it != shard.Rooms.end()) {
+            members = (*it).second.Members;
+            Remember((*it).second, roomUser->UserId(), message);
         }
 
-        _adminLock.Unlock();
+        shard.Lock.Unlock();
+
+        // Only queue it here, the worker pool does the actual delivery.
+        if (members) {
+            for (const Core::ProxyType<Mailbox>& member : *members) {
+                if (member->Post(roomUser->UserId(), message) == true) {
+                    Core::IWorkerPool::Instance().Submit(Core::ProxyType<Core::IDispatch>(member));
+                }
+            }
+        }
     }
 
     /* virtual */ void RoomMaintainer::Register(INotification* sink)
     {
         ASSERT(sink != nullptr);
 
+        // Hold all shards, so no room comes or goes while the sink is brought up to date.
+        for (uint8_t index = 0; index < Shards; index++) {
+            _shards[index].Lock.Lock();
+        }
+
         _adminLock.Lock();
 
         // Make sure it's not registered multiple times.
@@ -177,12 +254,18 @@ namespace Plugin {
         sink->AddRef();
 
         // Notify the caller about all rooms created to date.
-        for (auto const& room : _roomMap) {
-            sink->Created(room.first);
+        for (uint8_t index = 0; index < Shards; index++) {
+            for (auto const& room : _shards[index].Rooms) {
+                sink->Created(room.first);
+            }
         }
 
         _adminLock.Unlock();
 
+        for (uint8_t index = Shards; index > 0; index--) {
+            _shards[index - 1].Lock.Unlock();
+        }
+
         TRACE(Trace::Information, (_T("Room Maintainer: Registered a notification sink")));
     }
 
@@ -20,7 +20,25 @@
 #pragma once
 
 #include "Module.h"
+#include "MessageQueue.h"
+#include "../helpers/Delivery.h"
+#include "../helpers/Hash.h"
 #include <interfaces/IMessenger.h>
+#include <memory>
+#include <vector>
+
+// Number of messages that may be pending for a user before it is considered to be falling behind.
+#ifndef MESSENGER_QUEUE_DEPTH
+#define MESSENGER_QUEUE_DEPTH 64
+#endif
+
+// Number of messages, and the total size of them, a room remembers for users joining later. 0 disables it.
+#ifndef MESSENGER_HISTORY_DEPTH
+#define MESSENGER_HISTORY_DEPTH 32
+#endif
+#ifndef MESSENGER_HISTORY_BYTES
+#define MESSENGER_HISTORY_BYTES 16384
+#endif
 
 namespace WPEFramework {
 
@@ -29,13 +47,102 @@ namespace Plugin {
     class RoomImpl;
 
     class RoomMaintainer : public Exchange::IRoomAdministrator {
+    public:
+        typedef MessageQueue::Message Message;
+
+        typedef DeliveryCounters Counters;
+
+        // The messages for one user. They are delivered from the worker pool, so a slow user never holds up
+        // the sender, or the other users in the room. If a user falls behind, the oldest pending message is
+        // dropped. If built with MESSENGER_COALESCE, the oldest pending message of the same sender is
+        // replaced instead, if there is one: only the latest state of every sender is kept.
+        class Mailbox : public DeliveryType<MessageQueue> {
+        private:
+#ifdef MESSENGER_COALESCE
+            static constexpr bool Coalesce = true;
+#else
+            static constexpr bool Coalesce = false;
+#endif
+
+        public:
+            Mailbox() = delete;
+            Mailbox(const Mailbox&) = delete;
+            Mailbox& operator=(const Mailbox&) = delete;
+
+            Mailbox(IRoom::IMsgNotification* sink, const std::shared_ptr<Counters>& counters)
+                : DeliveryType<MessageQueue>(counters, MESSENGER_QUEUE_DEPTH, static_cast<bool>(Coalesce))
+                , _sink(sink)
+            {
+                if (_sink != nullptr) {
+                    _sink->AddRef();
+                }
+            }
+            ~Mailbox() override
+            {
+                if (_sink != nullptr) {
+                    _sink->Release();
+                }
+            }
+
+        public:
+            // Returns true if the mailbox should be submitted to the worker pool.
+            inline bool Post(const string& sender, const string& text)
+            {
+                return ((_sink != nullptr) && (DeliveryType<MessageQueue>::Post(sender, text) == true));
+            }
+
+        private:
+            void Deliver(const Message& message) override
+            {
+                _sink->Message(message.Sender, message.Text);
+            }
+
+        private:
+            IRoom::IMsgNotification* _sink;
+        };
+
+        // Immutable, a new one is made whenever someone joins or leaves. Senders take a reference and
+        // deliver without holding any lock.
+        typedef std::vector<Core::ProxyType<Mailbox>> Mailboxes;
+
+    private:
+        struct Room {
+            Room()
+                : Users()
+                , Members()
+                , History()
+                , HistoryBytes(0)
+            {
+            }
+
+            std::list<RoomImpl*> Users;
+            std::shared_ptr<const Mailboxes> Members;
+            std::list<Message> History;
+            size_t HistoryBytes;
+        };
+
+        // Rooms are spread over a number of shards, by the hash of their name, each with its own lock.
+        struct Shard {
+            Shard()
+                : Lock()
+                , Rooms()
+            {
+            }
+
+            Core::CriticalSection Lock;
+            std::map<string, Room> Rooms;
+        };
+
+        static constexpr uint8_t Shards = 16;
+
     public:
         RoomMaintainer(const RoomMaintainer&) = delete;
         RoomMaintainer& operator=(const RoomMaintainer&) = delete;
 
         RoomMaintainer()
             : _observers()
-            , _roomMap()
+            , _shards()
+            , _counters(std::make_shared<Counters>())
             , _adminLock()
         { /* empty */}
 
@@ -48,6 +155,10 @@ namespace Plugin {
         void Exit(const RoomImpl* roomUser);
         void Send(const string& message, RoomImpl* roomUser);
         void Notify(RoomImpl* roomUser);
+        Core::ProxyType<Mailbox> CreateMailbox(IRoom::IMsgNotification* messageSink)
+        {
+            return (Core::ProxyType<Mailbox>::Create(messageSink, _counters));
+        }
 
         // QueryInterface implementation
         BEGIN_INTERFACE_MAP(RoomMaintainer)
@@ -55,8 +166,18 @@ namespace Plugin {
         END_INTERFACE_MAP
 
     private:
+        Shard& Select(const string& roomId)
+        {
+            return (_shards[FNV1a32(roomId) % Shards]);
+        }
+        static void Rebuild(Room& room);
+        static void Remember(Room& room, const string& sender, const string& text);
+
+    private:
+        // Lock order: the shard(s), in index order, before _adminLock.
         std::list<INotification*> _observers;
-        std::map<string, std::list<RoomImpl*>> _roomMap;
+        Shard _shards[Shards];
+        std::shared_ptr<Counters> _counters; // Shared with the mailboxes, they may outlive the maintainer.
         mutable Core::CriticalSection _adminLock;
     };
 
@@ -0,0 +1,385 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fans messages out over N rooms of M users. Every user has a sink that takes a while to accept a message,
+// like a COM-RPC call to another process does; the first user of the first room is a lot slower. Sender
+// threads send to random rooms.
+// "locked" is how the Messenger used to deliver: one lock over all rooms and every sink called from the
+// sender, under that lock. "queued" is how it does now: rooms in shards with their own lock, a snapshot of
+// the members, and per user a MessageQueue drained by a pool of workers, as the Mailbox does. What the
+// senders wait for, and the time until everything is delivered, are measured. Throughput is counted in
+// messages that reached a sink. By default the queues are deep enough to hold every message, so nothing is
+// dropped and both do the same work; pass a smaller depth to see what a user that falls behind costs.
+//
+// usage: fanoutbenchmark [rooms [users [messages [depth]]]]
+
+#include "MessageQueue.h"
+#include "../helpers/Hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+static constexpr uint32_t Senders = 4;
+static constexpr uint32_t Workers = 4;
+static constexpr uint8_t Shards = 16;
+
+class Sink {
+public:
+    Sink(const uint32_t cost)
+        : _cost(cost)
+        , _delivered(0)
+    {
+    }
+
+public:
+    void Message(const std::string&, const std::string&)
+    {
+        const std::chrono::steady_clock::time_point end(std::chrono::steady_clock::now() + std::chrono::microseconds(_cost));
+        while (std::chrono::steady_clock::now() < end) {
+        }
+        _delivered++;
+    }
+    uint64_t Delivered() const
+    {
+        return (_delivered);
+    }
+
+private:
+    uint32_t _cost; // us
+    std::atomic<uint64_t> _delivered;
+};
+
+struct Result {
+    double Sending; // ms, the longest a sender was busy
+    double Total; // ms, until all is delivered
+    uint64_t Delivered;
+    uint64_t Dropped;
+};
+
+class Locked {
+public:
+    Locked(std::vector<std::unique_ptr<Sink>>& sinks, const uint32_t rooms, const uint32_t users, const uint16_t)
+        : _lock()
+        , _rooms()
+    {
+        for (uint32_t room = 0; room < rooms; room++) {
+            std::vector<Sink*>& members(_rooms[std::to_string(room)]);
+            for (uint32_t user = 0; user < users; user++) {
+                members.push_back(sinks[(room * users) + user].get());
+            }
+        }
+    }
+
+public:
+    void Send(const std::string& room, const std::string& sender, const std::string& text)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        for (Sink* sink : _rooms[room]) {
+            sink->Message(sender, text);
+        }
+    }
+    void Flush()
+    {
+    }
+    uint64_t Dropped() const
+    {
+        return (0);
+    }
+
+private:
+    std::mutex _lock;
+    std::map<std::string, std::vector<Sink*>> _rooms;
+};
+
+class Queued {
+private:
+    class Mailbox {
+    public:
+        Mailbox(Sink* sink, const uint16_t depth)
+            : _lock()
+            , _sink(sink)
+            , _pending(depth, false)
+            , _scheduled(false)
+        {
+        }
+
+    public:
+        // Returns true if the mailbox should be handed to a worker.
+        bool Post(const std::string& sender, const std::string& text, std::atomic<uint64_t>& dropped)
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_pending.Push(sender, text) != MessageQueue::QUEUED) {
+                dropped++;
+            }
+            const bool result = (_scheduled == false);
+            _scheduled = true;
+            return (result);
+        }
+        void Dispatch()
+        {
+            std::list<MessageQueue::Message> batch;
+            std::unique_lock<std::mutex> guard(_lock);
+
+            while (_pending.IsEmpty() == false) {
+                _pending.Take(batch);
+                guard.unlock();
+                for (const MessageQueue::Message& message : batch) {
+                    _sink->Message(message.Sender, message.Text);
+                }
+                batch.clear();
+                guard.lock();
+            }
+
+            _scheduled = false;
+        }
+
+    private:
+        std::mutex _lock;
+        Sink* _sink;
+        MessageQueue _pending;
+        bool _scheduled;
+    };
+
+    typedef std::vector<std::shared_ptr<Mailbox>> Mailboxes;
+
+    struct Shard {
+        std::mutex Lock;
+        std::map<std::string, std::shared_ptr<const Mailboxes>> Rooms;
+    };
+
+public:
+    Queued(std::vector<std::unique_ptr<Sink>>& sinks, const uint32_t rooms, const uint32_t users, const uint16_t depth)
+        : _shards()
+        , _lock()
+        , _jobs()
+        , _signal()
+        , _idle()
+        , _busy(0)
+        , _stop(false)
+        , _workers()
+        , _dropped(0)
+    {
+        for (uint32_t room = 0; room < rooms; room++) {
+            const std::string name(std::to_string(room));
+            std::shared_ptr<Mailboxes> members(std::make_shared<Mailboxes>());
+            for (uint32_t user = 0; user < users; user++) {
+                members->push_back(std::make_shared<Mailbox>(sinks[(room * users) + user].get(), depth));
+            }
+            Select(name).Rooms[name] = members;
+        }
+        for (uint32_t worker = 0; worker < Workers; worker++) {
+            _workers.emplace_back(&Queued::Work, this);
+        }
+    }
+    ~Queued()
+    {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+        }
+        _signal.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+public:
+    void Send(const std::string& room, const std::string& sender, const std::string& text)
+    {
+        std::shared_ptr<const Mailboxes> members;
+        Shard& shard(Select(room));
+
+        shard.Lock.lock();
+        members = shard.Rooms[room];
+        shard.Lock.unlock();
+
+        for (const std::shared_ptr<Mailbox>& mailbox : *members) {
+            if (mailbox->Post(sender, text, _dropped) == true) {
+                Submit(mailbox);
+            }
+        }
+    }
+    // Waits until the workers have delivered everything.
+    void Flush()
+    {
+        std::unique_lock<std::mutex> guard(_lock);
+        _idle.wait(guard, [this]() { return ((_jobs.empty() == true) && (_busy == 0)); });
+    }
+    uint64_t Dropped() const
+    {
+        return (_dropped);
+    }
+
+private:
+    Shard& Select(const std::string& room)
+    {
+        // As the RoomMaintainer does.
+        return (_shards[FNV1a32(room) % Shards]);
+    }
+    void Submit(const std::shared_ptr<Mailbox>& mailbox)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _jobs.push_back(mailbox);
+        }
+        _signal.notify_one();
+    }
+    void Work()
+    {
+        std::unique_lock<std::mutex> guard(_lock);
+
+        while (true) {
+            _signal.wait(guard, [this]() { return ((_stop == true) || (_jobs.empty() == false)); });
+
+            if (_jobs.empty() == true) {
+                break;
+            }
+
+            std::shared_ptr<Mailbox> mailbox(_jobs.front());
+            _jobs.pop_front();
+            _busy++;
+            guard.unlock();
+
+            mailbox->Dispatch();
+
+            guard.lock();
+            _busy--;
+            if ((_busy == 0) && (_jobs.empty() == true)) {
+                _idle.notify_all();
+            }
+        }
+    }
+
+private:
+    Shard _shards[Shards];
+    std::mutex _lock;
+    std::deque<std::shared_ptr<Mailbox>> _jobs;
+    std::condition_variable _signal;
+    std::condition_variable _idle;
+    uint32_t _busy;
+    bool _stop;
+    std::vector<std::thread> _workers;
+    std::atomic<uint64_t> _dropped;
+};
+
+double Milliseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename MESSENGER>
+Result Run(const uint32_t rooms, const uint32_t users, const uint32_t messages, const uint16_t depth)
+{
+    std::vector<std::unique_ptr<Sink>> sinks;
+
+    for (uint32_t index = 0; index < (rooms * users); index++) {
+        sinks.emplace_back(new Sink(index == 0 ? 500 : 2));
+    }
+
+    Result result;
+    std::vector<double> sending(Senders, 0);
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    {
+        MESSENGER messenger(sinks, rooms, users, depth);
+        std::vector<std::thread> senders;
+
+        for (uint32_t sender = 0; sender < Senders; sender++) {
+            senders.emplace_back([&messenger, &sending, rooms, messages, sender]() {
+                const std::chrono::steady_clock::time_point begin(std::chrono::steady_clock::now());
+                const std::string name("sender" + std::to_string(sender));
+                std::mt19937 random(sender);
+                for (uint32_t message = 0; message < (messages / Senders); message++) {
+                    messenger.Send(std::to_string(random() % rooms), name, "{\"position\":" + std::to_string(message) + "}");
+                }
+                sending[sender] = Milliseconds(begin);
+            });
+        }
+        for (std::thread& sender : senders) {
+            sender.join();
+        }
+
+        messenger.Flush();
+        result.Dropped = messenger.Dropped();
+    }
+
+    result.Total = Milliseconds(start);
+    result.Sending = 0;
+    result.Delivered = 0;
+
+    for (const double time : sending) {
+        result.Sending = (time > result.Sending ? time : result.Sending);
+    }
+    for (const std::unique_ptr<Sink>& sink : sinks) {
+        result.Delivered += sink->Delivered();
+    }
+
+    return (result);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t rooms = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 8);
+    const uint32_t users = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 16);
+    const uint32_t messages = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 4000);
+    const uint32_t depth = (argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : std::min(messages, static_cast<uint32_t>(0xFFFF)));
+
+    if ((rooms == 0) || (users == 0) || (messages < Senders) || (depth == 0) || (depth > 0xFFFF)) {
+        fprintf(stderr, "usage: %s [rooms [users [messages [depth]]]]\n", argv[0]);
+        return (1);
+    }
+
+    const Result locked = Run<Locked>(rooms, users, messages, static_cast<uint16_t>(depth));
+    const Result queued = Run<Queued>(rooms, users, messages, static_cast<uint16_t>(depth));
+    const uint32_t sent = (messages / Senders) * Senders;
+
+    printf("%u rooms x %u users, %u senders x %u messages, queue depth %u\n", rooms, users, Senders, sent / Senders, depth);
+    printf("locked: senders %9.3f ms (%7.3f ms per message), all delivered %9.3f ms, %8llu delivered (%9.0f/s), %6llu dropped\n",
+        locked.Sending, locked.Sending * Senders / sent, locked.Total, static_cast<unsigned long long>(locked.Delivered), locked.Delivered * 1000.0 / locked.Total, static_cast<unsigned long long>(locked.Dropped));
+    printf("queued: senders %9.3f ms (%7.3f ms per message), all delivered %9.3f ms, %8llu delivered (%9.0f/s), %6llu dropped\n",
+        queued.Sending, queued.Sending * Senders / sent, queued.Total, static_cast<unsigned long long>(queued.Delivered), queued.Delivered * 1000.0 / queued.Total, static_cast<unsigned long long>(queued.Dropped));
+
+    if (queued.Dropped > 0) {
+        printf("queued dropped messages, so it did less work than locked, compare the delivered/s.\n");
+    }
+
+    if (queued.Delivered + queued.Dropped != locked.Delivered) {
+        fprintf(stderr, "Messages went missing.\n");
+        return (1);
+    }
+
+    return (0);
+}
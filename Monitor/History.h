@@ -0,0 +1,472 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Module.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Streaming estimate of a single quantile in constant memory, using the P-square algorithm of
+    // Jain and Chlamtac. Exact for the first five samples.
+    class Quantile {
+    public:
+        Quantile() = delete;
+        Quantile& operator=(const Quantile&) = delete;
+
+        Quantile(const double quantile)
+            : _quantile(quantile)
+            , _count(0)
+        {
+        }
+        Quantile(const Quantile& copy) = default;
+        ~Quantile()
+        {
+        }
+
+    public:
+        void Reset()
+        {
+            _count = 0;
+        }
+        void Add(const double value)
+        {
+            if (_count < 5) {
+                _heights[_count] = value;
+
+                if (_count == 4) {
+                    std::sort(&_heights[0], &_heights[5]);
+
+                    for (uint8_t index = 0; index < 5; index++) {
+                        _positions[index] = index;
+                    }
+
+                    _desired[0] = 0;
+                    _desired[1] = 2 * _quantile;
+                    _desired[2] = 4 * _quantile;
+                    _desired[3] = 2 + (2 * _quantile);
+                    _desired[4] = 4;
+                    _increments[0] = 0;
+                    _increments[1] = _quantile / 2;
+                    _increments[2] = _quantile;
+                    _increments[3] = (1 + _quantile) / 2;
+                    _increments[4] = 1;
+                }
+            } else {
+                uint8_t cell;
+
+                if (value < _heights[0]) {
+                    _heights[0] = value;
+                    cell = 0;
+                } else if (value >= _heights[4]) {
+                    _heights[4] = value;
+                    cell = 3;
+                } else {
+                    cell = 0;
+                    while (value >= _heights[cell + 1]) {
+                        cell++;
+                    }
+                }
+
+                for (uint8_t index = cell + 1; index < 5; index++) {
+                    _positions[index] += 1;
+                }
+                for (uint8_t index = 0; index < 5; index++) {
+                    _desired[index] += _increments[index];
+                }
+                for (uint8_t index = 1; index < 4; index++) {
+                    Adjust(index);
+                }
+            }
+
+            _count++;
+        }
+        double Value() const
+        {
+            double result = 0;
+
+            if (_count > 5) {
+                result = _heights[2];
+            } else if (_count > 0) {
+                double sorted[5];
+
+                // Insertion sort, there are 5 elements at most.
+                for (uint8_t index = 0; index < _count; index++) {
+                    uint8_t position = index;
+
+                    while ((position > 0) && (sorted[position - 1] > _heights[index])) {
+                        sorted[position] = sorted[position - 1];
+                        position--;
+                    }
+                    sorted[position] = _heights[index];
+                }
+
+                result = sorted[static_cast<uint8_t>((_quantile * (_count - 1)) + 0.5)];
+            }
+
+            return (result);
+        }
+
+    private:
+        void Adjust(const uint8_t index)
+        {
+            double delta = _desired[index] - _positions[index];
+
+            if (((delta >= 1) && ((_positions[index + 1] - _positions[index]) > 1)) || ((delta <= -1) && ((_positions[index - 1] - _positions[index]) < -1))) {
+                int8_t step = (delta >= 0 ? 1 : -1);
+                double candidate = Parabolic(index, step);
+
+                if ((_heights[index - 1] < candidate) && (candidate < _heights[index + 1])) {
+                    _heights[index] = candidate;
+                } else {
+                    _heights[index] += step * (_heights[index + step] - _heights[index]) / (_positions[index + step] - _positions[index]);
+                }
+
+                _positions[index] += step;
+            }
+        }
+        double Parabolic(const uint8_t index, const int8_t step) const
+        {
+            return (_heights[index] + (step / (_positions[index + 1] - _positions[index - 1])) * ((((_positions[index] - _positions[index - 1]) + step) * (_heights[index + 1] - _heights[index]) / (_positions[index + 1] - _positions[index])) + (((_positions[index + 1] - _positions[index]) - step) * (_heights[index] - _heights[index - 1]) / (_positions[index] - _positions[index - 1]))));
+        }
+
+    private:
+        double _quantile;
+        uint32_t _count;
+        double _heights[5];
+        double _positions[5];
+        double _desired[5];
+        double _increments[5];
+    };
+
+    // The percentiles reported for a metric.
+    class Percentiles {
+    public:
+        Percentiles(const Percentiles&) = delete;
+        Percentiles& operator=(const Percentiles&) = delete;
+
+        Percentiles()
+            : _p50(0.50)
+            , _p95(0.95)
+            , _p99(0.99)
+        {
+        }
+        ~Percentiles()
+        {
+        }
+
+    public:
+        inline void Add(const uint64_t value)
+        {
+            _p50.Add(static_cast<double>(value));
+            _p95.Add(static_cast<double>(value));
+            _p99.Add(static_cast<double>(value));
+        }
+        inline void Reset()
+        {
+            _p50.Reset();
+            _p95.Reset();
+            _p99.Reset();
+        }
+        inline uint64_t P50() const
+        {
+            return (static_cast<uint64_t>(_p50.Value()));
+        }
+        inline uint64_t P95() const
+        {
+            return (static_cast<uint64_t>(_p95.Value()));
+        }
+        inline uint64_t P99() const
+        {
+            return (static_cast<uint64_t>(_p99.Value()));
+        }
+
+    private:
+        Quantile _p50;
+        Quantile _p95;
+        Quantile _p99;
+    };
+
+    // Tracks the level and growth rate of a metric with double exponential (Holt) smoothing, so the time
+    // left until it crosses a limit can be predicted.
+    class Growth {
+    public:
+        Growth(const Growth&) = delete;
+        Growth& operator=(const Growth&) = delete;
+
+        Growth()
+            : _time(0)
+            , _level(0)
+            , _trend(0)
+            , _samples(0)
+        {
+        }
+        ~Growth()
+        {
+        }
+
+    public:
+        inline void Reset()
+        {
+            _samples = 0;
+        }
+        // The time is in ms.
+        void Add(const uint64_t time, const uint64_t value)
+        {
+            if (_samples == 0) {
+                _level = static_cast<double>(value);
+                _trend = 0;
+                _samples = 1;
+            } else if (time > _time) {
+                double elapsed = static_cast<double>(time - _time) / 1000.0;
+                double level = (Alpha * static_cast<double>(value)) + ((1 - Alpha) * (_level + (_trend * elapsed)));
+
+                _trend = (Beta * ((level - _level) / elapsed)) + ((1 - Beta) * _trend);
+                _level = level;
+                _samples = std::min(_samples + 1, static_cast<uint32_t>(Warmup));
+            }
+
+            _time = time;
+        }
+        // Units per second.
+        inline double Rate() const
+        {
+            return (_trend);
+        }
+        // Seconds until the limit is reached at the current rate, ~0 if it is not growing towards it or
+        // there are not enough samples yet to tell.
+        uint32_t Remaining(const uint64_t limit) const
+        {
+            uint32_t result = static_cast<uint32_t>(~0);
+
+            if (_samples >= Warmup) {
+                if (_level >= static_cast<double>(limit)) {
+                    result = 0;
+                } else if (_trend > 0) {
+                    double seconds = (static_cast<double>(limit) - _level) / _trend;
+
+                    if (seconds < static_cast<double>(result)) {
+                        result = static_cast<uint32_t>(seconds);
+                    }
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        static constexpr double Alpha = 0.5;
+        static constexpr double Beta = 0.3;
+        static constexpr uint8_t Warmup = 3;
+
+        uint64_t _time;
+        double _level;
+        double _trend;
+        uint32_t _samples;
+    };
+
+    // Keeps the most recent samples of an observable in a fixed amount of memory. The samples are stored
+    // as zigzag/varint encoded deltas in blocks. Each block starts with an absolute sample, so once the
+    // memory is used, the oldest block can simply be overwritten.
+    class History {
+    public:
+        struct Sample {
+            uint64_t Time; // ms since the epoch
+            uint64_t Resident;
+            uint64_t Allocated;
+            uint64_t Shared;
+            uint8_t Processes;
+            bool Operational;
+        };
+
+    private:
+        static constexpr uint16_t BlockSize = 128;
+
+        struct Block {
+            uint16_t Count;
+            uint16_t Used;
+            uint8_t Data[BlockSize - (2 * sizeof(uint16_t))];
+        };
+
+        // A sample can never take more than this, 4 64 bits varints and one small one.
+        static constexpr uint8_t MaxSampleSize = (4 * 10) + 2;
+
+    public:
+        History() = delete;
+        History(const History&) = delete;
+        History& operator=(const History&) = delete;
+
+        // The size is in bytes, rounded down to whole blocks, with a minimum of 2 blocks.
+        History(const uint32_t size)
+            : _blocks(std::max(static_cast<uint32_t>(2), size / BlockSize))
+            , _current(0)
+            , _wrapped(false)
+            , _samples(0)
+            , _last()
+        {
+            Clear();
+        }
+        ~History()
+        {
+        }
+
+    public:
+        void Clear()
+        {
+            for (Block& block : _blocks) {
+                block.Count = 0;
+                block.Used = 0;
+            }
+            _current = 0;
+            _wrapped = false;
+            _samples = 0;
+        }
+        inline uint32_t Size() const
+        {
+            return (static_cast<uint32_t>(_blocks.size() * sizeof(Block)));
+        }
+        inline uint32_t Samples() const
+        {
+            return (_samples);
+        }
+        void Add(const Sample& sample)
+        {
+            uint8_t buffer[MaxSampleSize];
+            Block* block = &(_blocks[_current]);
+            uint8_t length = Encode(sample, (block->Count == 0 ? nullptr : &_last), buffer);
+
+            if ((block->Used + length) > sizeof(block->Data)) {
+                _current = (_current + 1) % _blocks.size();
+                _wrapped = _wrapped || (_current == 0);
+
+                block = &(_blocks[_current]);
+                _samples -= block->Count;
+                block->Count = 0;
+                block->Used = 0;
+
+                length = Encode(sample, nullptr, buffer);
+            }
+
+            ::memcpy(&(block->Data[block->Used]), buffer, length);
+            block->Used += length;
+            block->Count++;
+            _samples++;
+            _last = sample;
+        }
+        // Visits the samples, oldest first.
+        template <typename ACTION>
+        void Visit(ACTION&& action) const
+        {
+            uint32_t index = (_wrapped == true ? (_current + 1) % _blocks.size() : 0);
+
+            for (uint32_t count = 0; count < _blocks.size(); count++) {
+                const Block& block(_blocks[index]);
+                const uint8_t* data = block.Data;
+                Sample sample = {};
+
+                for (uint16_t entry = 0; entry < block.Count; entry++) {
+                    data = Decode(data, sample);
+                    action(sample);
+                }
+
+                index = (index + 1) % _blocks.size();
+            }
+        }
+
+    private:
+        static uint8_t Encode(const Sample& sample, const Sample* previous, uint8_t buffer[])
+        {
+            static const Sample zero = {};
+            const Sample& base(previous == nullptr ? zero : *previous);
+            uint8_t length = 0;
+
+            length += Write(sample.Time - base.Time, &buffer[length]);
+            length += Write(ZigZag(sample.Resident - base.Resident), &buffer[length]);
+            length += Write(ZigZag(sample.Allocated - base.Allocated), &buffer[length]);
+            length += Write(ZigZag(sample.Shared - base.Shared), &buffer[length]);
+            length += Write((ZigZag(static_cast<uint64_t>(sample.Processes) - base.Processes) << 1) | (sample.Operational ? 1 : 0), &buffer[length]);
+
+            return (length);
+        }
+        static const uint8_t* Decode(const uint8_t* data, Sample& sample)
+        {
+            uint64_t value;
+
+            data = Read(data, value);
+            sample.Time += value;
+            data = Read(data, value);
+            sample.Resident += UnZigZag(value);
+            data = Read(data, value);
+            sample.Allocated += UnZigZag(value);
+            data = Read(data, value);
+            sample.Shared += UnZigZag(value);
+            data = Read(data, value);
+            sample.Processes = static_cast<uint8_t>(sample.Processes + UnZigZag(value >> 1));
+            sample.Operational = ((value & 1) != 0);
+
+            return (data);
+        }
+        // The deltas are computed modulo 2^64, interpreted as signed, they are small in both directions.
+        static inline uint64_t ZigZag(const uint64_t value)
+        {
+            return ((value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63));
+        }
+        static inline uint64_t UnZigZag(const uint64_t value)
+        {
+            return ((value >> 1) ^ (~(value & 1) + 1));
+        }
+        static inline uint8_t Write(uint64_t value, uint8_t buffer[])
+        {
+            uint8_t length = 0;
+
+            while (value >= 0x80) {
+                buffer[length++] = static_cast<uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+            buffer[length++] = static_cast<uint8_t>(value);
+
+            return (length);
+        }
+        static inline const uint8_t* Read(const uint8_t* data, uint64_t& value)
+        {
+            uint8_t shift = 0;
+
+            value = 0;
+
+            do {
+                value |= static_cast<uint64_t>(*data & 0x7F) << shift;
+                shift += 7;
+            } while ((*data++ & 0x80) != 0);
+
+            return (data);
+        }
+
+    private:
+        std::vector<Block> _blocks;
+        uint32_t _current;
+        bool _wrapped;
+        uint32_t _samples;
+        Sample _last;
+    };
+}
+}
@@ -20,6 +20,7 @@
 #ifndef __MONITOR_H
 #define __MONITOR_H
 
+#include "History.h"
 #include "Module.h"
 #include <interfaces/IMemory.h>
 #include <interfaces/json/JsonData_Monitor.h>
@@ -85,12 +86,12 @@ namespace Plugin {
             }
 
         public:
-            void Measure(Exchange::IMemory* memInterface)
+            void Measure(const uint64_t resident, const uint64_t allocated, const uint64_t shared, const uint8_t processes)
             {
-                _resident.Set(memInterface->Resident());
-                _allocated.Set(memInterface->Allocated());
-                _shared.Set(memInterface->Shared());
-                _process.Set(memInterface->Processes());
+                _resident.Set(resident);
+                _allocated.Set(allocated);
+                _shared.Set(shared);
+                _process.Set(processes);
             }
             void Operational(const bool operational)
             {
@@ -370,6 +371,141 @@ namespace Plugin {
             RestartInfo Restart;
         };
 
+        class HistoryParams : public Core::JSON::Container {
+        private:
+            HistoryParams(const HistoryParams&) = delete;
+            HistoryParams& operator=(const HistoryParams&) = delete;
+
+        public:
+            HistoryParams()
+                : Core::JSON::Container()
+                , Callsign()
+                , Samples(0)
+            {
+                Add(_T("callsign"), &Callsign);
+                Add(_T("samples"), &Samples);
+            }
+            ~HistoryParams()
+            {
+            }
+
+        public:
+            Core::JSON::String Callsign;
+            Core::JSON::DecUInt16 Samples; // maximum number of samples to return, 0 returns all of them
+        };
+
+        class HistoryData : public Core::JSON::Container {
+        public:
+            class PercentileData : public Core::JSON::Container {
+            private:
+                PercentileData(const PercentileData&) = delete;
+                PercentileData& operator=(const PercentileData&) = delete;
+
+            public:
+                PercentileData()
+                    : Core::JSON::Container()
+                {
+                    Add(_T("p50"), &P50);
+                    Add(_T("p95"), &P95);
+                    Add(_T("p99"), &P99);
+                }
+                ~PercentileData()
+                {
+                }
+
+                PercentileData& operator=(const Percentiles& RHS)
+                {
+                    P50 = RHS.P50();
+                    P95 = RHS.P95();
+                    P99 = RHS.P99();
+
+                    return (*this);
+                }
+
+            public:
+                Core::JSON::DecUInt64 P50;
+                Core::JSON::DecUInt64 P95;
+                Core::JSON::DecUInt64 P99;
+            };
+
+            class SampleData : public Core::JSON::Container {
+            public:
+                SampleData()
+                    : Core::JSON::Container()
+                {
+                    Init();
+                }
+                SampleData(const SampleData& copy)
+                    : Core::JSON::Container()
+                    , Time(copy.Time)
+                    , Resident(copy.Resident)
+                    , Allocated(copy.Allocated)
+                    , Shared(copy.Shared)
+                    , Process(copy.Process)
+                    , Operational(copy.Operational)
+                {
+                    Init();
+                }
+                ~SampleData()
+                {
+                }
+
+                SampleData& operator=(const SampleData& RHS)
+                {
+                    Time = RHS.Time;
+                    Resident = RHS.Resident;
+                    Allocated = RHS.Allocated;
+                    Shared = RHS.Shared;
+                    Process = RHS.Process;
+                    Operational = RHS.Operational;
+
+                    return (*this);
+                }
+
+            private:
+                void Init()
+                {
+                    Add(_T("time"), &Time);
+                    Add(_T("resident"), &Resident);
+                    Add(_T("allocated"), &Allocated);
+                    Add(_T("shared"), &Shared);
+                    Add(_T("process"), &Process);
+                    Add(_T("operational"), &Operational);
+                }
+
+            public:
+                Core::JSON::DecUInt64 Time; // ms since the epoch
+                Core::JSON::DecUInt64 Resident;
+                Core::JSON::DecUInt64 Allocated;
+                Core::JSON::DecUInt64 Shared;
+                Core::JSON::DecUInt8 Process;
+                Core::JSON::Boolean Operational;
+            };
+
+        private:
+            HistoryData(const HistoryData&) = delete;
+            HistoryData& operator=(const HistoryData&) = delete;
+
+        public:
+            HistoryData()
+                : Core::JSON::Container()
+            {
+                Add(_T("callsign"), &Callsign);
+                Add(_T("resident"), &Resident);
+                Add(_T("allocated"), &Allocated);
+                Add(_T("samples"), &Samples);
+            }
+            ~HistoryData()
+            {
+            }
+
+        public:
+            Core::JSON::String Callsign;
+            PercentileData Resident;
+            PercentileData Allocated;
+            Core::JSON::ArrayType<SampleData> Samples;
+        };
+
     private:
         Monitor(const Monitor&);
         Monitor& operator=(const Monitor&);
@@ -387,12 +523,18 @@ namespace Plugin {
             public:
                 Entry()
                     : Core::JSON::Container()
+                    , History(4)
+                    , Horizon(0)
+                    , Adaptive(false)
                 {
                     Add(_T("callsign"), &Callsign);
                     Add(_T("memory"), &MetaData);
                     Add(_T("memorylimit"), &MetaDataLimit);
                     Add(_T("operational"), &Operational);
                     Add(_T("restart"), &Restart);
+                    Add(_T("history"), &History);
+                    Add(_T("horizon"), &Horizon);
+                    Add(_T("adaptive"), &Adaptive);
                 }
                 Entry(const Entry& copy)
                     : Core::JSON::Container()
@@ -401,12 +543,18 @@ namespace Plugin {
                     , MetaDataLimit(copy.MetaDataLimit)
                     , Operational(copy.Operational)
                     , Restart(copy.Restart)
+                    , History(copy.History)
+                    , Horizon(copy.Horizon)
+                    , Adaptive(copy.Adaptive)
                 {
                     Add(_T("callsign"), &Callsign);
                     Add(_T("memory"), &MetaData);
                     Add(_T("memorylimit"), &MetaDataLimit);
                     Add(_T("operational"), &Operational);
                     Add(_T("restart"), &Restart);
+                    Add(_T("history"), &History);
+                    Add(_T("horizon"), &Horizon);
+                    Add(_T("adaptive"), &Adaptive);
                 }
                 ~Entry()
                 {
@@ -418,6 +566,9 @@ namespace Plugin {
                 Core::JSON::DecUInt32 MetaDataLimit;
                 Core::JSON::DecSInt32 Operational;
                 RestartInfo Restart;
+                Core::JSON::DecUInt16 History; // KB of memory for the measurement history
+                Core::JSON::DecUInt16 Horizon; // s, warn if the memorylimit is expected to be exceeded within this time, 0 disables
+                Core::JSON::Boolean Adaptive; // adapt the memory probe rate to the predicted risk, requires a horizon
             };
 
         public:
@@ -445,6 +596,7 @@ namespace Plugin {
             class MonitorObject {
             public:
                 MonitorObject() = delete;
+                MonitorObject(const MonitorObject&) = delete;
                 MonitorObject& operator=(const MonitorObject&) = delete;
 
                 enum evaluation {
@@ -458,18 +610,38 @@ namespace Plugin {
                     int32_t WindowSeconds;
                 } RestartSettings;
 
+            private:
+                enum probe {
+                    OPERATIONAL = 0x01,
+                    MEMORY = 0x02
+                };
+
             public:
+#ifdef __WINDOWS__
+#pragma warning(disable : 4355)
+#endif
                 MonitorObject(
+                    MonitorObjects& parent,
+                    const string& callsign,
                     const bool actOnOperational,
                     const uint32_t operationalInterval,
                     const uint32_t memoryInterval,
                     const uint64_t memoryThreshold,
                     const uint64_t absTime,
                     const uint16_t restartWindow,
-                    const uint8_t restartLimit)
-                    : _operationalInterval(operationalInterval)
+                    const uint8_t restartLimit,
+                    const uint32_t historySize,
+                    const uint16_t horizon,
+                    const bool adaptive)
+                    : _parent(parent)
+                    , _callsign(callsign)
+                    , _operationalInterval(operationalInterval)
                     , _memoryInterval(memoryInterval)
                     , _memoryThreshold(memoryThreshold * 1024)
+                    , _horizon((_memoryThreshold != 0) && (_memoryInterval != 0) ? horizon : 0)
+                    , _memoryMin(((_horizon != 0) && (adaptive == true)) ? (_memoryInterval / 4) : _memoryInterval)
+                    , _memoryMax(((_memoryMin != _memoryInterval) && (_memoryInterval <= (static_cast<uint32_t>(~0) / 4))) ? (_memoryInterval * 4) : _memoryInterval)
+                    , _memoryCurrent(memoryInterval)
                     , _operationalSlots(operationalInterval)
                     , _memorySlots(memoryInterval)
                     , _nextSlot(absTime)
@@ -478,36 +650,29 @@ namespace Plugin {
                     , _restartCount(0)
                     , _restartLimit(restartLimit)
                     , _measurement()
+                    , _history(historySize)
+                    , _resident()
+                    , _allocated()
+                    , _growth()
+                    , _warned(false)
                     , _operationalEvaluate(actOnOperational)
                     , _source(nullptr)
                     , _active{ false }
+                    , _generation(0)
+                    , _pending(0)
+                    , _job(*this)
                 {
                     ASSERT((_operationalInterval != 0) || (_memoryInterval != 0));
-                    _interval = gcd(_operationalInterval, _memoryInterval);
-                }
-                MonitorObject(const MonitorObject& copy)
-                    : _operationalInterval(copy._operationalInterval)
-                    , _memoryInterval(copy._memoryInterval)
-                    , _memoryThreshold(copy._memoryThreshold)
-                    , _operationalSlots(copy._operationalSlots)
-                    , _memorySlots(copy._memorySlots)
-                    , _nextSlot(copy._nextSlot)
-                    , _restartWindow(copy._restartWindow)
-                    , _restartWindowStart(copy._restartWindowStart)
-                    , _restartCount(copy._restartCount)
-                    , _restartLimit(copy._restartLimit)
-                    , _measurement(copy._measurement)
-                    , _operationalEvaluate(copy._operationalEvaluate)
-                    , _source(copy._source)
-                    , _interval(copy._interval)
-                    , _active{ copy._active }
-                {
-                    if (_source != nullptr) {
-                        _source->AddRef();
-                    }
+                    // All memory intervals the rate controller picks are a multiple of the shortest one.
+                    _interval = gcd(_operationalInterval, _memoryMin);
                 }
+#ifdef __WINDOWS__
+#pragma warning(default : 4355)
+#endif
                 ~MonitorObject()
                 {
+                    _job.Revoke();
+
                     if (_source != nullptr) {
                         _source->Release();
                         _source = nullptr;
@@ -527,7 +692,7 @@ namespace Plugin {
                         _restartWindowStart = Core::Time::Now().Add(_restartWindow * 1000 /* ms */);
                         _restartCount = 0;
                     }
-                    
+
                     bool result = ((_restartLimit == 0) || (_restartCount < _restartLimit));
                     if (result == false) {
                         _restartCount = 0;
@@ -564,16 +729,34 @@ namespace Plugin {
                 }
                 inline bool HasMeasurement() const
                 {
-                    return (((_measurement.Allocated().Min() == Core::NumberType<uint64_t>::Max()) && 
+                    return (((_measurement.Allocated().Min() == Core::NumberType<uint64_t>::Max()) &&
                     (_measurement.Allocated().Max() == Core::NumberType<uint64_t>::Min())) ? false : true);
                 }
                 inline uint64_t TimeSlot() const
                 {
                     return (_nextSlot);
                 }
+                inline uint32_t Generation() const
+                {
+                    return (_generation);
+                }
+                inline const History& Trend() const
+                {
+                    return (_history);
+                }
+                inline const Percentiles& Resident() const
+                {
+                    return (_resident);
+                }
+                inline const Percentiles& Allocated() const
+                {
+                    return (_allocated);
+                }
                 inline void Reset()
                 {
                     _measurement.Reset();
+                    _resident.Reset();
+                    _allocated.Reset();
                 }
                 inline void Retrigger(uint64_t currentSlot)
                 {
@@ -594,43 +777,161 @@ namespace Plugin {
                     }
 
                     _measurement.Operational(_source != nullptr);
+                    _growth.Reset();
+                    _memoryCurrent = _memoryInterval;
+                    _warned = false;
                 }
-                inline uint32_t Evaluate()
+                // Called, with the lock taken, when the time slot of this observable has come. The actual
+                // probing is done on the workerpool, so a slow (RPC) call does not hold up the others.
+                inline void Evaluate()
                 {
-                    uint32_t status(SUCCESFULL);
                     if (_source != nullptr) {
                         _operationalSlots -= _interval;
                         _memorySlots -= _interval;
 
                         if ((_operationalInterval != 0) && (_operationalSlots == 0)) {
-                            bool operational = _source->IsOperational();
-                            _measurement.Operational(operational);
-                            if (operational == false) {
-                                status |= NOT_OPERATIONAL;
-                                TRACE_L1("Status not operational. %d", __LINE__);
-                            }
+                            _pending |= OPERATIONAL;
                             _operationalSlots = _operationalInterval;
                         }
                         if ((_memoryInterval != 0) && (_memorySlots == 0)) {
-                            _measurement.Measure(_source);
+                            _pending |= MEMORY;
+                            _memorySlots = _memoryCurrent;
+                        }
+                        if (_pending != 0) {
+                            _job.Submit();
+                        }
+                    }
+                }
+                inline void Revoke()
+                {
+                    _job.Revoke();
+                }
+
+                bool IsActive() const { return _active; }
+                // Changing the state makes all time slots that are still queued for this observable obsolete.
+                void Active(bool active)
+                {
+                    _active = active;
+                    _generation++;
+                }
+
+            private:
+                friend Core::ThreadPool::JobType<MonitorObject&>;
+
+                void Dispatch()
+                {
+                    Core::CriticalSection& adminLock(_parent._adminLock);
+                    uint32_t status(SUCCESFULL);
+                    uint32_t remaining(static_cast<uint32_t>(~0));
+                    bool warn(false);
+
+                    adminLock.Lock();
+
+                    uint8_t pending = _pending;
+                    Exchange::IMemory* source = _source;
+
+                    _pending = 0;
+
+                    if (source != nullptr) {
+                        source->AddRef();
+                    }
+
+                    adminLock.Unlock();
+
+                    if (source != nullptr) {
+                        bool operational = true;
+                        uint64_t resident = 0, allocated = 0, shared = 0;
+                        uint8_t processes = 0;
+
+                        if ((pending & OPERATIONAL) != 0) {
+                            operational = source->IsOperational();
+                        }
+                        if ((pending & MEMORY) != 0) {
+                            resident = source->Resident();
+                            allocated = source->Allocated();
+                            shared = source->Shared();
+                            processes = source->Processes();
+                        }
 
-                            if ((_memoryThreshold != 0) && (_measurement.Resident().Last() > _memoryThreshold)) {
-                                status |= EXCEEDED_MEMORY;
-                                TRACE_L1("Status MetaData Exceeded. %d", __LINE__);
+                        source->Release();
+
+                        adminLock.Lock();
+
+                        // The observable might have been deactivated while we were probing it.
+                        if (_source == source) {
+                            if ((pending & OPERATIONAL) != 0) {
+                                _measurement.Operational(operational);
+                                if (operational == false) {
+                                    status |= NOT_OPERATIONAL;
+                                    TRACE_L1("Status not operational. %d", __LINE__);
+                                }
+                            }
+                            if ((pending & MEMORY) != 0) {
+                                _measurement.Measure(resident, allocated, shared, processes);
+
+                                History::Sample sample = { Core::Time::Now().Ticks() / 1000, resident, allocated, shared, processes, _measurement.Operational() };
+                                _history.Add(sample);
+                                _resident.Add(resident);
+                                _allocated.Add(allocated);
+
+                                if (_horizon != 0) {
+                                    _growth.Add(sample.Time, resident);
+                                    remaining = _growth.Remaining(_memoryThreshold);
+                                    warn = Predict(remaining);
+                                }
+
+                                if ((_memoryThreshold != 0) && (_measurement.Resident().Last() > _memoryThreshold)) {
+                                    status |= EXCEEDED_MEMORY;
+                                    TRACE_L1("Status MetaData Exceeded. %d", __LINE__);
+                                }
                             }
-                            _memorySlots = _memoryInterval;
+                        }
+
+                        adminLock.Unlock();
+
+                        if (status != SUCCESFULL) {
+                            _parent.Act(_callsign, status);
+                        } else if (warn == true) {
+                            _parent.Warn(_callsign, remaining);
                         }
                     }
-                    return (status);
                 }
 
-                bool IsActive() const { return _active; }
-                void Active(bool active) { _active = active; }
+                // Returns true if the threshold is now expected to be crossed within the horizon, and it was
+                // not before. Healthy observables are probed less often, the ones at risk more often.
+                bool Predict(const uint32_t remaining)
+                {
+                    bool result = false;
+
+                    if (remaining < _horizon) {
+                        result = (_warned == false);
+                        _warned = true;
+                        _memoryCurrent = _memoryMin;
+                    } else {
+                        // Some hysteresis, so a single sample does not toggle the warning.
+                        if (remaining > (static_cast<uint64_t>(_horizon) * 2)) {
+                            _warned = false;
+                        }
+                        if (remaining > (static_cast<uint64_t>(_horizon) * 4)) {
+                            _memoryCurrent = static_cast<uint32_t>(std::min(static_cast<uint64_t>(_memoryCurrent) * 2, static_cast<uint64_t>(_memoryMax)));
+                        } else {
+                            _memoryCurrent = _memoryInterval;
+                        }
+                    }
+
+                    return (result);
+                }
 
             private:
+                MonitorObjects& _parent;
+                const string _callsign;
                 const uint32_t _operationalInterval; //!< Interval (s) to check the monitored processes
                 const uint32_t _memoryInterval; //!<  Interval (s) for a memory measurement.
                 const uint64_t _memoryThreshold; //!< MetaData threshold in bytes for all processes.
+                const uint16_t _horizon; //!< Time (s) within which a predicted threshold crossing is reported.
+                const uint32_t _memoryMin; //!< Shortest interval the rate controller may pick.
+                const uint32_t _memoryMax; //!< Longest interval the rate controller may pick.
+                uint32_t _memoryCurrent; //!< Interval for the next memory measurement.
                 uint32_t _operationalSlots;
                 uint32_t _memorySlots;
                 uint64_t _nextSlot;
@@ -639,10 +940,33 @@ namespace Plugin {
                 uint32_t _restartCount;
                 uint8_t _restartLimit;
                 MetaData _measurement;
+                History _history;
+                Percentiles _resident;
+                Percentiles _allocated;
+                Growth _growth;
+                bool _warned;
                 bool _operationalEvaluate;
                 Exchange::IMemory* _source;
                 uint32_t _interval; //!< The greatest possible interval to check both memory and processes.
                 bool _active;
+                uint32_t _generation;
+                uint8_t _pending;
+                Core::WorkerPool::JobType<MonitorObject&> _job;
+            };
+
+        private:
+            // An entry in the schedule. Entries are never removed from the heap, an entry of which the generation
+            // no longer matches the one of its observable is simply dropped once it comes out.
+            struct Slot {
+                uint64_t Time;
+                MonitorObject* Object;
+                uint32_t Generation;
+            };
+            struct Later {
+                bool operator()(const Slot& lhs, const Slot& rhs) const
+                {
+                    return (lhs.Time > rhs.Time);
+                }
             };
 
         public:
@@ -652,6 +976,8 @@ namespace Plugin {
             MonitorObjects(Monitor* parent)
                 : _adminLock()
                 , _monitor()
+                , _schedule()
+                , _active(0)
                 , _job(*this)
                 , _service(nullptr)
                 , _parent(*parent)
@@ -713,15 +1039,21 @@ namespace Plugin {
                     }
                     SYSLOG(Logging::Startup, (_T("Monitoring: %s (%d,%d)."), callSign.c_str(), (interval / 1000000), (memory / 1000000)));
                     if ((interval != 0) || (memory != 0)) {
-                        _monitor.insert(
-                            std::pair<string, MonitorObject>(callSign, MonitorObject(
-                                element.Operational.Value() >= 0, 
-                                interval, 
-                                memory, 
-                                memoryThreshold, 
-                                baseTime, 
-                                restartWindow, 
-                                restartLimit)));
+                        _monitor.emplace(std::piecewise_construct,
+                            std::forward_as_tuple(callSign),
+                            std::forward_as_tuple(
+                                *this,
+                                callSign,
+                                element.Operational.Value() >= 0,
+                                interval,
+                                memory,
+                                memoryThreshold,
+                                baseTime,
+                                restartWindow,
+                                restartLimit,
+                                element.History.Value() * 1024,
+                                element.Horizon.Value(),
+                                element.Adaptive.Value()));
                     }
                 }
 
@@ -735,7 +1067,14 @@ namespace Plugin {
 
                 _job.Revoke();
 
+                // A probe might be running, it takes the lock, so wait for it without holding the lock.
+                for (std::pair<const string, MonitorObject>& entry : _monitor) {
+                    entry.second.Revoke();
+                }
+
                 _adminLock.Lock();
+                _schedule.clear();
+                _active = 0;
                 _monitor.clear();
                 _adminLock.Unlock();
                 _service->Release();
@@ -753,19 +1092,24 @@ namespace Plugin {
                     PluginHost::IShell::state currentState(service->State());
 
                     if (currentState == PluginHost::IShell::ACTIVATED) {
-                        bool is_active = index->second.IsActive();
-                        index->second.Active(true);
-                        if (is_active == false && std::count_if(_monitor.begin(), _monitor.end(), [](const std::pair<string, MonitorObject>& v) {
-                                return v.second.IsActive();
-                            }) == 1) {
-
-                            // A monitor which previously was stopped restarting is being activated.
-                            // Moreover it's the only only which now becomes active. This means probing
-                            // has to be activated as well since it was stopped at point the last observee
-                            // turned inactive
-                            _job.Submit();
+                        if (index->second.IsActive() == false) {
+                            MonitorObject& object(index->second);
+
+                            object.Active(true);
+                            object.Retrigger(Core::Time::Now().Ticks());
+                            Schedule(object);
+
+                            _active++;
 
-                            TRACE(Trace::Information, (_T("Starting to probe as active observee appeared.")));
+                            if (_active == 1) {
+                                // A monitor which previously was stopped restarting is being activated.
+                                // Moreover it's the only only which now becomes active. This means probing
+                                // has to be activated as well since it was stopped at point the last observee
+                                // turned inactive
+                                _job.Submit();
+
+                                TRACE(Trace::Information, (_T("Starting to probe as active observee appeared.")));
+                            }
                         }
 
                         // Get the MetaData interface
@@ -778,7 +1122,10 @@ namespace Plugin {
                     } else if (currentState == PluginHost::IShell::DEACTIVATION) {
                         index->second.Set(nullptr);
                     } else if ((currentState == PluginHost::IShell::DEACTIVATED)) {
-                        index->second.Active(false);
+                        if (index->second.IsActive() == true) {
+                            index->second.Active(false);
+                            _active--;
+                        }
                         if ((index->second.HasRestartAllowed() == true) && ((service->Reason() == PluginHost::IShell::MEMORY_EXCEEDED) || (service->Reason() == PluginHost::IShell::FAILURE))) {
                             if (index->second.RegisterRestart(service->Reason()) == false) {
                                 TRACE(Trace::Fatal, (_T("Giving up restarting of %s: Failed more than %d times within %d seconds."), service->Callsign().c_str(), index->second.RestartLimit(), index->second.RestartWindow()));
@@ -876,6 +1223,63 @@ namespace Plugin {
                 _adminLock.Unlock();
             }
 
+            // Returns the recorded samples, oldest first. If more samples are recorded than requested, consecutive
+            // samples are averaged (the process count takes the maximum, operational only if all were).
+            bool Samples(const string& name, const uint16_t maxSamples, Monitor::HistoryData& response)
+            {
+                bool found = false;
+
+                _adminLock.Lock();
+
+                std::map<string, MonitorObject>::iterator index(_monitor.find(name));
+
+                if (index != _monitor.end()) {
+                    const History& history(index->second.Trend());
+                    uint32_t stored = history.Samples();
+                    uint32_t bucket = (((maxSamples == 0) || (stored <= maxSamples)) ? 1 : ((stored + maxSamples - 1) / maxSamples));
+                    uint32_t count = 0;
+                    uint64_t resident = 0, allocated = 0, shared = 0;
+                    uint8_t processes = 0;
+                    bool operational = true;
+
+                    response.Callsign = name;
+                    response.Resident = index->second.Resident();
+                    response.Allocated = index->second.Allocated();
+
+                    history.Visit([&](const History::Sample& sample) {
+                        resident += sample.Resident;
+                        allocated += sample.Allocated;
+                        shared += sample.Shared;
+                        processes = std::max(processes, sample.Processes);
+                        operational = operational && sample.Operational;
+                        count++;
+                        stored--;
+
+                        if ((count == bucket) || (stored == 0)) {
+                            Monitor::HistoryData::SampleData& element(response.Samples.Add());
+
+                            element.Time = sample.Time;
+                            element.Resident = resident / count;
+                            element.Allocated = allocated / count;
+                            element.Shared = shared / count;
+                            element.Process = processes;
+                            element.Operational = operational;
+
+                            count = 0;
+                            resident = allocated = shared = 0;
+                            processes = 0;
+                            operational = true;
+                        }
+                    });
+
+                    found = true;
+                }
+
+                _adminLock.Unlock();
+
+                return (found);
+            }
+
             bool Reset(const string& name, Monitor::MetaData& result)
             {
                 bool found = false;
@@ -920,54 +1324,36 @@ namespace Plugin {
         private:
             friend Core::ThreadPool::JobType<MonitorObjects&>;
 
-            // Dispatch can be run in an unlocked state as the destruction of the observer list
-            // is always done if the thread that calls the Dispatch is blocked (paused)
+            // Only the observables of which the time slot has come are touched, they are taken from the
+            // top of the schedule and put back with their next time slot.
             void Dispatch()
             {
                 uint64_t scheduledTime(Core::Time::Now().Ticks());
                 uint64_t nextSlot(static_cast<uint64_t>(~0));
 
-                std::map<string, MonitorObject>::iterator index(_monitor.begin());
-
-                // Go through the list of pending observations...
-                while (index != _monitor.end()) {
-                    MonitorObject& info(index->second);
-                    if (info.IsActive() == false) {
-                        ++index;
-                        continue;
-                    }
-
-                    if (info.TimeSlot() <= scheduledTime) {
-                        uint32_t value(info.Evaluate());
-
-                        if ((value & (MonitorObject::NOT_OPERATIONAL | MonitorObject::EXCEEDED_MEMORY)) != 0) {
-                            PluginHost::IShell* plugin(_service->QueryInterfaceByCallsign<PluginHost::IShell>(index->first));
-
-                            if (plugin != nullptr) {
-                                Core::EnumerateType<PluginHost::IShell::reason> why(((value & MonitorObject::EXCEEDED_MEMORY) != 0) ? PluginHost::IShell::MEMORY_EXCEEDED : PluginHost::IShell::FAILURE);
-
-                                const string message("{\"callsign\": \"" + plugin->Callsign() + "\", \"action\": \"Deactivate\", \"reason\": \"" + why.Data() + "\" }");
-                                SYSLOG(Trace::Fatal, (_T("FORCED Shutdown: %s by reason: %s."), plugin->Callsign().c_str(), why.Data()));
+                _adminLock.Lock();
 
-                                _service->Notify(message);
+                while ((_schedule.empty() == false) && (_schedule.front().Time <= scheduledTime)) {
+                    Slot slot(_schedule.front());
 
-                                _parent.event_action(plugin->Callsign(), "Deactivate", why.Data());
+                    std::pop_heap(_schedule.begin(), _schedule.end(), Later());
+                    _schedule.pop_back();
 
-                                Core::IWorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(plugin, PluginHost::IShell::DEACTIVATED, why.Value()));
+                    MonitorObject& info(*slot.Object);
 
-                                plugin->Release();
-                            }
-                        }
-                        info.Retrigger(scheduledTime);
-                    }
-
-                    if (info.TimeSlot() < nextSlot) {
-                        nextSlot = info.TimeSlot();
+                    if ((info.IsActive() == true) && (info.Generation() == slot.Generation)) {
+                        info.Evaluate();
+                        info.Retrigger(scheduledTime + 1);
+                        Schedule(info);
                     }
+                }
 
-                    index++;
+                if (_schedule.empty() == false) {
+                    nextSlot = _schedule.front().Time;
                 }
 
+                _adminLock.Unlock();
+
                 if (nextSlot != static_cast<uint64_t>(~0)) {
                     if (nextSlot < Core::Time::Now().Ticks()) {
                         _job.Submit();
@@ -979,6 +1365,44 @@ namespace Plugin {
                     TRACE(Trace::Information, (_T("Stopping to probe due to lack of active observees.")));
                 }
             }
+            inline void Schedule(MonitorObject& object)
+            {
+                _schedule.push_back({ object.TimeSlot(), &object, object.Generation() });
+                std::push_heap(_schedule.begin(), _schedule.end(), Later());
+            }
+            // Called from the probe of an observable that failed, on a workerpool thread.
+            void Act(const string& callsign, const uint32_t value)
+            {
+                PluginHost::IShell* plugin(_service->QueryInterfaceByCallsign<PluginHost::IShell>(callsign));
+
+                if (plugin != nullptr) {
+                    Core::EnumerateType<PluginHost::IShell::reason> why(((value & MonitorObject::EXCEEDED_MEMORY) != 0) ? PluginHost::IShell::MEMORY_EXCEEDED : PluginHost::IShell::FAILURE);
+
+                    const string message("{\"callsign\": \"" + plugin->Callsign() + "\", \"action\": \"Deactivate\", \"reason\": \"" + why.Data() + "\" }");
+                    SYSLOG(Trace::Fatal, (_T("FORCED Shutdown: %s by reason: %s."), plugin->Callsign().c_str(), why.Data()));
+
+                    _service->Notify(message);
+
+                    _parent.event_action(plugin->Callsign(), "Deactivate", why.Data());
+
+                    Core::IWorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(plugin, PluginHost::IShell::DEACTIVATED, why.Value()));
+
+                    plugin->Release();
+                }
+            }
+
+            // Called from the probe of an observable that is expected to exceed its memory limit soon.
+            void Warn(const string& callsign, const uint32_t remaining)
+            {
+                const string reason("Memory limit expected to be exceeded within " + std::to_string(remaining) + " seconds");
+                const string message("{\"callsign\": \"" + callsign + "\", \"action\": \"Warning\", \"reason\": \"" + reason + "\" }");
+
+                SYSLOG(Logging::Notification, (_T("%s: %s."), callsign.c_str(), reason.c_str()));
+
+                _service->Notify(message);
+
+                _parent.event_action(callsign, "Warning", reason);
+            }
 
         private:
             template <typename T>
@@ -992,6 +1416,8 @@ namespace Plugin {
 
             Core::CriticalSection _adminLock;
             std::map<string, MonitorObject> _monitor;
+            std::vector<Slot> _schedule;
+            uint32_t _active;
             Core::WorkerPool::JobType<MonitorObjects&> _job;
             PluginHost::IShell* _service;
             Monitor& _parent;
@@ -1071,6 +1497,7 @@ namespace Plugin {
         uint32_t endpoint_restartlimits(const JsonData::Monitor::RestartlimitsParamsData& params);
         uint32_t endpoint_resetstats(const JsonData::Monitor::ResetstatsParamsData& params, JsonData::Monitor::InfoInfo& response);
         uint32_t get_status(const string& index, Core::JSON::ArrayType<JsonData::Monitor::InfoInfo>& response) const;
+        uint32_t endpoint_history(const HistoryParams& params, HistoryData& response);
         void event_action(const string& callsign, const string& action, const string& reason);
     };
 }
@@ -35,6 +35,7 @@ namespace Plugin {
         Register<RestartlimitsParamsData,void>(_T("restartlimits"), &Monitor::endpoint_restartlimits, this);
         Register<ResetstatsParamsData,InfoInfo>(_T("resetstats"), &Monitor::endpoint_resetstats, this);
         Property<Core::JSON::ArrayType<InfoInfo>>(_T("status"), &Monitor::get_status, nullptr, this);
+        Register<HistoryParams,HistoryData>(_T("history"), &Monitor::endpoint_history, this);
     }
 
     void Monitor::UnregisterAll()
@@ -42,6 +43,7 @@ namespace Plugin {
         Unregister(_T("resetstats"));
         Unregister(_T("restartlimits"));
         Unregister(_T("status"));
+        Unregister(_T("history"));
     }
 
     // API implementation
@@ -75,6 +77,21 @@ namespace Plugin {
         return Core::ERROR_NONE;
     }
 
+    // Method: history - The recorded measurements and their percentiles for a single plugin watched by the Monitor
+    // Return codes:
+    //  - ERROR_NONE: Success
+    //  - ERROR_UNKNOWN_KEY: The plugin is not watched by the Monitor
+    uint32_t Monitor::endpoint_history(const HistoryParams& params, HistoryData& response)
+    {
+        uint32_t result = Core::ERROR_UNKNOWN_KEY;
+
+        if (_monitor->Samples(params.Callsign.Value(), params.Samples.Value(), response) == true) {
+            result = Core::ERROR_NONE;
+        }
+
+        return (result);
+    }
+
     // Property: status - The memory and process statistics either for a single plugin or all plugins watched by the Monitor
     // Return codes:
     //  - ERROR_NONE: Success
@@ -0,0 +1,91 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CONTENTTYPE_H
+#define __CONTENTTYPE_H
+
+#include <cctype>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Splits a content type, as passed to IsTypeSupported, in its mime type and codecs. Only std::string and
+// std::regex are used, so the content type benchmark can time the same parser.
+namespace WPEFramework {
+namespace Plugin {
+
+    namespace ContentType {
+
+        static constexpr char Expression[] = "\\s*([a-zA-Z0-9\\-\\+]+/[a-zA-Z0-9\\-\\+]+)\\s*(;\\s*codecs\\*?\\s*=\\s*\"?([a-zA-Z0-9,\\s\\+\\-\\.']+)\"?\\s*)?";
+
+        inline void TrimWs(const std::string& str, size_t& start, size_t& end)
+        {
+            while(std::isspace(str[start]) && start < end) {
+                ++start;
+            }
+
+            while(std::isspace(str[end - 1]) && end - 1 > 0) {
+             --end;
+            }
+        }
+
+        inline std::vector<std::string> Tokenize(const std::string& str, char token)
+        {
+            std::vector<std::string> tokens;
+            size_t startPos = 0;
+            size_t endPos = 0;
+            do {
+                endPos = str.find(token, startPos);
+                if (endPos != std::string::npos) {
+                    size_t end = endPos;
+                    TrimWs(str, startPos, end);
+                    tokens.emplace_back(std::string(&str[startPos], end - startPos));
+                    startPos = endPos + 1;
+                }
+            } while (endPos != std::string::npos && startPos < str.length());
+            size_t end = str.size();
+            TrimWs(str, startPos, end);
+            tokens.emplace_back(std::string(&str[startPos], end - startPos));
+            return tokens;
+        }
+
+        // The expression is built once, on first use.
+        inline void Parse(const std::string& contentType, std::string& mimeType, std::vector<std::string>& codecsList) {
+            codecsList.clear();
+            if (contentType.empty() == false) {
+                std::smatch matches;
+                const size_t kCaptureGroupsNumber = 4;
+                static const std::regex expr(Expression);
+                // regex_match only matches the content type as a whole, so matches[0] is all of it.
+                bool matched = std::regex_match(contentType, matches, expr, std::regex_constants::match_default);
+
+                if (matched && matches.size() == kCaptureGroupsNumber) {
+                    mimeType = matches[1];
+                    if (matches[2].str().empty() == false) {
+                        std::vector<std::string> codecs = Tokenize(matches[3], ',');
+                        codecsList.swap(codecs);
+                    }
+                }
+            }
+        }
+    }
+}
+}
+
+#endif // __CONTENTTYPE_H
@@ -0,0 +1,295 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DECRYPTPOOL_H
+#define __DECRYPTPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // A fixed number of threads draining the buffers of all sessions. Sessions are spread over the
+    // workers. A worker that serves a single session blocks on it, like a DecryptThread does. A worker
+    // that serves more sessions picks up whatever is pending and otherwise blocks on the session that
+    // was served last, for at most a slice, before it looks at the others again. There is no signal
+    // that covers more buffers, so while none of them has anything, the wait doubles every round, up
+    // to MaxIdle. The session served last is still picked up at once, the others within that time.
+    //
+    // The server pools its session buffers, the sample ring benchmark sessions of its own. A SESSION
+    // offers:
+    //   uint32_t RequestConsume(const uint32_t waitTime) - wait at most waitTime ms (Infinite: no limit)
+    //                                                      for a sample, returns 0 if there is one.
+    //   void Produced()                                  - signal a sample, wakes up whoever waits.
+    //   void Decrypt()                                   - decrypt what is pending, hand the buffer back.
+    template <typename SESSION>
+    class DecryptPoolType {
+    private:
+        DecryptPoolType() = delete;
+        DecryptPoolType(const DecryptPoolType<SESSION>&) = delete;
+        DecryptPoolType<SESSION>& operator=(const DecryptPoolType<SESSION>&) = delete;
+
+    public:
+        static constexpr uint32_t Infinite = 0xFFFFFFFF;
+
+    private:
+        class Drainer {
+        private:
+            Drainer() = delete;
+            Drainer(const Drainer&) = delete;
+            Drainer& operator=(const Drainer&) = delete;
+
+            static constexpr uint32_t MaxIdle = 64; // ms
+
+        public:
+            Drainer(const uint32_t slice)
+                : _adminLock()
+                , _sessions()
+                , _signal()
+                , _released()
+                , _slice(slice)
+                , _idle(slice)
+                , _last(0)
+                , _current(nullptr)
+                , _waiting(false)
+                , _kicked(false)
+                , _running(true)
+                , _thread()
+            {
+                _thread = std::thread(&Drainer::Worker, this);
+            }
+            ~Drainer()
+            {
+                std::unique_lock<std::mutex> guard(_adminLock);
+
+                _running = false;
+                Kick();
+
+                guard.unlock();
+
+                _signal.notify_one();
+                _thread.join();
+            }
+
+        public:
+            uint32_t Load() const
+            {
+                std::lock_guard<std::mutex> guard(_adminLock);
+
+                return (static_cast<uint32_t>(_sessions.size()));
+            }
+            void Add(SESSION* session)
+            {
+                std::unique_lock<std::mutex> guard(_adminLock);
+
+                _sessions.push_back(session);
+
+                // A blocking wait on the only other session has to be cut short.
+                Kick();
+                _idle = _slice;
+
+                guard.unlock();
+
+                _signal.notify_one();
+            }
+            bool Remove(SESSION* session)
+            {
+                std::unique_lock<std::mutex> guard(_adminLock);
+
+                typename std::vector<SESSION*>::iterator index(std::find(_sessions.begin(), _sessions.end(), session));
+                const bool removed = (index != _sessions.end());
+
+                if (removed == true) {
+                    if (static_cast<uint32_t>(std::distance(_sessions.begin(), index)) < _last) {
+                        _last--;
+                    }
+                    _sessions.erase(index);
+
+                    // Do not return before the worker let go of this buffer.
+                    while (_current == session) {
+                        Kick();
+                        _released.wait(guard);
+                    }
+                }
+
+                return (removed);
+            }
+
+        private:
+            // Wake the worker if it is blocked on a buffer. The signal is a fake one, so the worker
+            // will not touch the buffer for it. Should be called with the lock taken.
+            void Kick()
+            {
+                if ((_waiting == true) && (_kicked == false)) {
+                    _kicked = true;
+                    _current->Produced();
+                }
+            }
+            void Worker()
+            {
+                std::unique_lock<std::mutex> guard(_adminLock);
+
+                while (_running == true) {
+
+                    SESSION* session = nullptr;
+                    bool pending = false;
+
+                    const uint32_t count = static_cast<uint32_t>(_sessions.size());
+
+                    if (_last >= count) {
+                        _last = 0;
+                    }
+
+                    // Anything pending? Start after the one served last, so no session starves.
+                    for (uint32_t index = 1; (index <= count) && (pending == false); index++) {
+                        const uint32_t position = (_last + index) % count;
+
+                        if (_sessions[position]->RequestConsume(0) == 0) {
+                            session = _sessions[position];
+                            _last = position;
+                            pending = true;
+                        }
+                    }
+
+                    if ((pending == false) && (count > 0)) {
+                        session = _sessions[_last];
+                        _waiting = true;
+                    }
+
+                    _current = session;
+
+                    if (session == nullptr) {
+                        _signal.wait(guard, [this]() { return ((_running == false) || (_sessions.empty() == false)); });
+                    } else {
+                        if (pending == false) {
+                            const uint32_t waitTime = (count == 1 ? static_cast<uint32_t>(Infinite) : _idle);
+
+                            guard.unlock();
+
+                            pending = (session->RequestConsume(waitTime) == 0);
+
+                            guard.lock();
+
+                            if ((pending == false) && (_kicked == false) && (count > 1)) {
+                                // Nothing anywhere, look at the others less often.
+                                const uint32_t limit = (_slice > MaxIdle ? _slice : static_cast<uint32_t>(MaxIdle));
+
+                                _idle = (_idle >= (limit / 2) ? limit : (_idle == 0 ? 1 : _idle * 2));
+                            }
+
+                            if (_kicked == true) {
+                                // If we timed out, the fake signal is still there, take it away.
+                                if (pending == false) {
+                                    session->RequestConsume(Infinite);
+                                }
+                                // A real sample that came in as well is picked up in the next round.
+                                _kicked = false;
+                                pending = false;
+                            }
+                            _waiting = false;
+                        }
+
+                        if (pending == true) {
+                            guard.unlock();
+
+                            session->Decrypt();
+
+                            guard.lock();
+
+                            _idle = _slice;
+                        }
+
+                        _current = nullptr;
+                        _released.notify_all();
+                    }
+                }
+            }
+
+        private:
+            mutable std::mutex _adminLock;
+            std::vector<SESSION*> _sessions;
+            std::condition_variable _signal;
+            std::condition_variable _released;
+            const uint32_t _slice;
+            uint32_t _idle;
+            uint32_t _last;
+            SESSION* _current;
+            bool _waiting;
+            bool _kicked;
+            bool _running;
+            std::thread _thread;
+        };
+
+    public:
+        DecryptPoolType(const uint8_t workers, const uint32_t slice)
+            : _workers()
+        {
+            for (uint8_t index = 0; index < workers; index++) {
+                _workers.push_back(new Drainer(slice));
+            }
+        }
+        ~DecryptPoolType()
+        {
+            for (Drainer* worker : _workers) {
+                delete worker;
+            }
+        }
+
+    public:
+        // Returns false if there is no pool, the session needs a thread of its own.
+        bool Register(SESSION* session)
+        {
+            Drainer* selected = nullptr;
+            uint32_t load = ~0;
+
+            for (Drainer* worker : _workers) {
+                const uint32_t current = worker->Load();
+                if (current < load) {
+                    load = current;
+                    selected = worker;
+                }
+            }
+
+            if (selected != nullptr) {
+                selected->Add(session);
+            }
+
+            return (selected != nullptr);
+        }
+        void Unregister(SESSION* session)
+        {
+            typename std::vector<Drainer*>::iterator index(_workers.begin());
+
+            while ((index != _workers.end()) && ((*index)->Remove(session) == false)) {
+                index++;
+            }
+        }
+
+    private:
+        std::vector<Drainer*> _workers;
+    };
+}
+}
+
+#endif // __DECRYPTPOOL_H
@@ -17,8 +17,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <deque>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Module.h"
@@ -35,6 +38,9 @@
 #include <interfaces/IContentDecryption.h>
 
 #include "CENCParser.h"
+#include "ContentType.h"
+#include "DecryptPool.h"
+#include "SampleRing.h"
 
 #include <ocdm/open_cdm.h>
 
@@ -47,56 +53,6 @@ namespace WPEFramework {
 
 namespace Plugin {
 
-    static void TrimWs(const std::string& str, size_t& start, size_t& end)
-    {
-        while(std::isspace(str[start]) && start < end) {
-            ++start;
-        }
-
-        while(std::isspace(str[end - 1]) && end - 1 > 0) {
-         --end;
-        }
-    }
-
-    static std::vector<std::string> Tokenize(const std::string& str, char token)
-    {
-        std::vector<std::string> tokens;
-        size_t startPos = 0;
-        size_t endPos = 0;
-        do {
-            endPos = str.find(token, startPos);
-            if (endPos != std::string::npos) {
-                size_t end = endPos;
-                TrimWs(str, startPos, end);
-                tokens.emplace_back(std::string(&str[startPos], end - startPos));
-                startPos = endPos + 1;
-            }
-        } while (endPos != std::string::npos && startPos < str.length());
-        size_t end = str.size();
-        TrimWs(str, startPos, end);
-        tokens.emplace_back(std::string(&str[startPos], end - startPos));
-        return tokens;
-    }
-
-    static void ParseContentType(const std::string& contentType, std::string& mimeType, std::vector<std::string>& codecsList) {
-        codecsList.clear();
-        if (contentType.empty() == false) {
-            std::smatch matches;
-            const size_t kCaptureGroupsNumber = 4;
-            std::regex expr("\\s*([a-zA-Z0-9\\-\\+]+/[a-zA-Z0-9\\-\\+]+)\\s*(;\\s*codecs\\*?\\s*=\\s*\"?([a-zA-Z0-9,\\s\\+\\-\\.']+)\"?\\s*)?");
-            bool matched = std::regex_match(contentType, matches, expr, std::regex_constants::match_default);
-
-            if (matched && matches.size() == kCaptureGroupsNumber) {
-                ASSERT(matches[0] == contentType);
-                mimeType = matches[1];
-                if (matches[2].str().empty() == false) {
-                    std::vector<std::string> codecs = Tokenize(matches[3], ',');
-                    codecsList.swap(codecs);
-                }
-            }
-        }
-    }
-
     static const TCHAR BufferFileName[] = _T("ocdmbuffer.");
 
     class OCDMImplementation : public Exchange::IContentDecryption {
@@ -157,6 +113,191 @@ namespace Plugin {
             AccessorOCDM(const AccessorOCDM&) = delete;
             AccessorOCDM& operator=(const AccessorOCDM&) = delete;
 
+            class DataExchange : public ::OCDM::DataExchange {
+            private:
+                DataExchange() = delete;
+                DataExchange(const DataExchange&) = delete;
+                DataExchange& operator=(const DataExchange&) = delete;
+
+            public:
+                DataExchange(const string& name, const uint32_t defaultSize)
+                    : ::OCDM::DataExchange(name, defaultSize)
+                    , _mediaKeys(nullptr)
+                    , _mediaKeysExt(nullptr)
+                    , _sessionKey(nullptr)
+                    , _sessionKeyLength(0)
+                {
+                    TRACE_L1("Constructing buffer server side: %p - %s", this, name.c_str());
+                }
+                ~DataExchange()
+                {
+                    TRACE_L1("Destructing buffer server side: %p - %s", this, ::OCDM::DataExchange::Name().c_str());
+                }
+
+            public:
+                // Buffers are created ahead of the session that will use them.
+                void Attach(CDMi::IMediaKeySession* mediaKeys)
+                {
+                    _mediaKeys = mediaKeys;
+                    _mediaKeysExt = dynamic_cast<CDMi::IMediaKeySessionExt*>(mediaKeys);
+                }
+                // Back to the state of a new buffer, so the next session can use it: no sample pending, free for
+                // the producer, and nothing of the previous session left in it. The session should be gone.
+                void Reset()
+                {
+                    while (RequestConsume(0) == Core::ERROR_NONE) {
+                    }
+                    while (RequestProduce(0) == Core::ERROR_NONE) {
+                    }
+
+                    ::memset(Buffer(), 0, BytesWritten());
+                    Status(0);
+
+                    _mediaKeys = nullptr;
+                    _mediaKeysExt = nullptr;
+
+                    // One (and only one) produce is allowed again.
+                    Consumed();
+                }
+                // Decrypt the sample, or the ring of samples, the other side has produced and hand the buffer back.
+                void Decrypt()
+                {
+                    ASSERT(_mediaKeys != nullptr);
+
+                    SampleRing::Header* ring = Ring();
+
+                    if (ring != nullptr) {
+                        Drain(*ring);
+                    } else {
+                        DecryptSample();
+                    }
+
+                    // Whatever the result, we are done with the buffer..
+                    Consumed();
+                }
+
+            private:
+                void DecryptSample()
+                {
+                    uint32_t clearContentSize = 0;
+                    uint8_t* clearContent = nullptr;
+                    uint8_t keyIdLength = 0;
+                    const uint8_t* keyIdData = KeyId(keyIdLength);
+
+                    int cr = _mediaKeys->Decrypt(
+                        _sessionKey,
+                        _sessionKeyLength,
+                        nullptr, //subsamples
+                        0, //number of subsamples
+                        IVKey(),
+                        IVKeyLength(),
+                        Buffer(),
+                        BytesWritten(),
+                        &clearContentSize,
+                        &clearContent,
+                        keyIdLength,
+                        keyIdData,
+                        InitWithLast15());
+                    if ((cr == 0) && (clearContentSize != 0)) {
+                        if (clearContentSize != BytesWritten()) {
+                            TRACE_L1("Returned clear sample size (%d) differs from encrypted buffer size (%d)", clearContentSize, BytesWritten());
+                            Size(clearContentSize);
+                        }
+
+                        // Adjust the buffer on our sied (this process) on what we will write back
+                        SetBuffer(0, clearContentSize, clearContent);
+                    }
+
+                    // Store the status we have for the other side.
+                    Status(static_cast<uint32_t>(cr));
+                }
+                // The data area holds a ring if it starts with a valid ring header and has room for its slots.
+                SampleRing::Header* Ring()
+                {
+                    SampleRing::Header* result = nullptr;
+                    const uint32_t length = BytesWritten();
+                    const uint32_t offset = SampleRing::Offset(Buffer());
+
+                    if (length >= (offset + sizeof(SampleRing::Header))) {
+                        SampleRing::Header* header = reinterpret_cast<SampleRing::Header*>(&(Buffer()[offset]));
+
+                        if ((header->Magic == SampleRing::Magic) && (header->Version == SampleRing::Version) && (header->Slots > 0) && ((length - offset - sizeof(SampleRing::Header)) >= (header->Slots * sizeof(SampleRing::Slot)))) {
+                            result = header;
+                        }
+                    }
+
+                    return (result);
+                }
+                // Decrypt all the other side queued, the samples must lie after the slots.
+                void Drain(SampleRing::Header& ring)
+                {
+                    const uint32_t length = BytesWritten();
+                    const uint32_t samples = static_cast<uint32_t>((reinterpret_cast<uint8_t*>(&ring) - Buffer()) + sizeof(SampleRing::Header) + (ring.Slots * sizeof(SampleRing::Slot)));
+
+                    if (SampleRing::Drain(ring, [&](SampleRing::Slot& slot) { DecryptSlot(slot, samples, length); }) == false) {
+                        TRACE_L1("Ring of %s is out of sync", ::OCDM::DataExchange::Name().c_str());
+                    }
+                }
+                // The sample must lie after the slots and within what is written, with its subsample map in front.
+                void DecryptSlot(SampleRing::Slot& slot, const uint32_t start, const uint32_t length)
+                {
+                    const uint32_t offset = slot.Offset;
+                    const uint32_t size = slot.Length;
+                    const uint32_t subsamples = slot.Subsamples;
+                    const uint32_t map = subsamples * 2 * sizeof(uint32_t);
+
+                    if ((offset < start) || (offset > length) || (((reinterpret_cast<uintptr_t>(Buffer()) + offset) & 3) != 0) || (map > (length - offset)) || (size > (length - offset - map)) || (slot.KeyIdLength > sizeof(slot.KeyId)) || (slot.IVLength > sizeof(slot.IV))) {
+                        slot.Status = SampleRing::Invalid;
+                    } else {
+                        uint32_t clearContentSize = 0;
+                        uint8_t* clearContent = nullptr;
+                        uint8_t* data = &(Buffer()[offset + map]);
+
+                        int cr = _mediaKeys->Decrypt(
+                            _sessionKey,
+                            _sessionKeyLength,
+                            (subsamples > 0 ? reinterpret_cast<const uint32_t*>(&(Buffer()[offset])) : nullptr),
+                            subsamples * 2, // number of uint32_t values in the map
+                            slot.IV,
+                            slot.IVLength,
+                            data,
+                            size,
+                            &clearContentSize,
+                            &clearContent,
+                            slot.KeyIdLength,
+                            slot.KeyId,
+                            slot.InitWithLast15 != 0);
+
+                        if ((cr == 0) && (clearContentSize != 0)) {
+                            if (clearContentSize > size) {
+                                // The clear sample does not fit where the encrypted one was.
+                                TRACE_L1("Returned clear sample size (%d) exceeds the slot (%d)", clearContentSize, size);
+                                cr = static_cast<int>(SampleRing::Invalid);
+                            } else {
+                                if (clearContent != data) {
+                                    ::memmove(data, clearContent, clearContentSize);
+                                }
+                                slot.Length = clearContentSize;
+                            }
+                        }
+
+                        slot.Status = static_cast<uint32_t>(cr);
+                    }
+                }
+
+            private:
+                CDMi::IMediaKeySession* _mediaKeys;
+                CDMi::IMediaKeySessionExt* _mediaKeysExt;
+                uint8_t* _sessionKey;
+                uint32_t _sessionKeyLength;
+            };
+
+            // Hands out the shared buffers for the sessions. Creating a buffer (file, mapping and semaphores)
+            // takes a while, so a number of spare buffers is kept ready, refilled in the background, and a new
+            // session just picks one. The buffer of a session that is gone is reset (a client that went away
+            // halfway a sample leaves its semaphores taken) and goes back to the spares. So there are never more
+            // buffers than the peak number of sessions plus the spares; only beyond that a buffer is destroyed.
+            // All buffers have the same size, a new session does not tell what it will need.
             class BufferAdministrator {
             private:
                 BufferAdministrator() = delete;
@@ -164,46 +305,168 @@ namespace Plugin {
                 BufferAdministrator& operator=(const BufferAdministrator&) = delete;
 
             public:
-                BufferAdministrator(const string pathName)
+                BufferAdministrator(const string pathName, const uint32_t size, const uint8_t spares)
                     : _adminLock()
                     , _basePath(Core::Directory::Normalize(pathName))
-                    , _occupation(0)
+                    , _size(size)
+                    , _spares(spares)
+                    , _occupation()
+                    , _available()
+                    , _inUse(0)
+                    , _peak(0)
+                    , _created(0)
+                    , _recycled(0)
+                    , _creationTime(0)
+                    , _maxCreationTime(0)
+                    , _job(*this)
                 {
+                    if (_spares > 0) {
+                        _job.Submit();
+                    }
                 }
                 ~BufferAdministrator()
                 {
+                    _job.Revoke();
+
+                    for (DataExchange* buffer : _available) {
+                        delete buffer;
+                    }
                 }
 
             public:
-                bool AquireBuffer(string& locator)
+                DataExchange* Acquire(CDMi::IMediaKeySession* mediaKeys)
                 {
-                    uint8_t index = 0;
+                    DataExchange* result = nullptr;
+
+                    _adminLock.Lock();
+
+                    if (_available.empty() == false) {
+                        result = _available.front();
+                        _available.pop_front();
+                    }
+
+                    _adminLock.Unlock();
+
+                    if (result == nullptr) {
+                        // Out of spares, the session has to wait for its buffer.
+                        result = Create();
+                    }
 
-                    locator.clear();
+                    result->Attach(mediaKeys);
 
                     _adminLock.Lock();
 
-                    while ((index < (sizeof(_occupation) * 8)) && ((_occupation & (1 << index)) != 0)) {
-                        index++;
+                    _inUse++;
+                    if (_inUse > _peak) {
+                        _peak = _inUse;
                     }
 
-                    // We do not expect more that 4 buffers to be allocated concurrently,
-                    // so more than X would be dramatic
-                    ASSERT(index < (sizeof(_occupation) * 8));
+                    TRACE(Trace::Information, (_T("Buffer %s acquired, in use: %d, peak: %d, spare: %d, created: %d, recycled: %d, creation: %d us average, %d us max"),
+                        result->Name().c_str(), _inUse, _peak, static_cast<uint32_t>(_available.size()), _created, _recycled,
+                        static_cast<uint32_t>(_creationTime / _created), _maxCreationTime));
+
+                    _adminLock.Unlock();
 
-                    if (index < (sizeof(_occupation) * 8)) {
-                        _occupation |= (1 << index);
-                        locator = _basePath + BufferFileName + Core::NumberType<uint8_t>(index).Text();
+                    if (_spares > 0) {
+                        _job.Submit();
+                    }
+
+                    return (result);
+                }
+                void Release(DataExchange* buffer)
+                {
+                    buffer->Reset();
+
+                    _adminLock.Lock();
+
+                    ASSERT(_inUse > 0);
+                    _inUse--;
+
+                    if ((_inUse + _available.size()) < (_peak + _spares)) {
+                        _available.push_back(buffer);
+                        _recycled++;
+                        buffer = nullptr;
                     }
 
                     _adminLock.Unlock();
 
-                    return (locator.empty() == false);
+                    if (buffer != nullptr) {
+                        const uint32_t slot = Slot(buffer->Name());
+
+                        delete buffer;
+
+                        _adminLock.Lock();
+
+                        ASSERT(slot < _occupation.size());
+
+                        if (slot < _occupation.size()) {
+                            // Freeing a buffer that is already free sounds dangerous !!!
+                            ASSERT(_occupation[slot] == true);
+                            _occupation[slot] = false;
+                        }
+
+                        _adminLock.Unlock();
+                    }
                 }
-                bool ReleaseBuffer(const string& locator)
+
+            private:
+                friend Core::ThreadPool::JobType<BufferAdministrator&>;
+
+                // Refill the spares.
+                void Dispatch()
                 {
+                    _adminLock.Lock();
+
+                    while (_available.size() < _spares) {
+                        _adminLock.Unlock();
+
+                        DataExchange* buffer = Create();
+
+                        _adminLock.Lock();
+
+                        _available.push_back(buffer);
+                    }
+
+                    _adminLock.Unlock();
+                }
+                DataExchange* Create()
+                {
+                    _adminLock.Lock();
+
+                    // Take the lowest free slot, so the file names are reused.
+                    uint32_t slot = 0;
+                    while ((slot < _occupation.size()) && (_occupation[slot] == true)) {
+                        slot++;
+                    }
+                    if (slot == _occupation.size()) {
+                        _occupation.push_back(true);
+                    } else {
+                        _occupation[slot] = true;
+                    }
+
+                    _adminLock.Unlock();
+
+                    const uint64_t start = Core::Time::Now().Ticks();
+
+                    DataExchange* result = new DataExchange(_basePath + BufferFileName + Core::NumberType<uint32_t>(slot).Text(), _size);
+
+                    const uint32_t duration = static_cast<uint32_t>(Core::Time::Now().Ticks() - start);
 
-                    bool released = false;
+                    _adminLock.Lock();
+
+                    _created++;
+                    _creationTime += duration;
+                    if (duration > _maxCreationTime) {
+                        _maxCreationTime = duration;
+                    }
+
+                    _adminLock.Unlock();
+
+                    return (result);
+                }
+                uint32_t Slot(const string& locator) const
+                {
+                    uint32_t slot = ~0;
 
                     if (locator.compare(0, _basePath.length(), _basePath) == 0) {
                         string actualFile(locator.substr(_basePath.length()));
@@ -211,125 +474,84 @@ namespace Plugin {
 
                         if (actualFile.compare(0, baseLength, BufferFileName) == 0) {
                             // Than the last part is the number..
-                            uint8_t number(Core::NumberType<uint8_t>(&(actualFile.c_str()[baseLength]), static_cast<uint32_t>(actualFile.length() - baseLength)).Value());
-
-                            if (number <= (sizeof(_occupation) * 8)) {
-                                _adminLock.Lock();
-
-                                if ((_occupation & (1 << number)) != 0) {
-                                    _occupation ^= (1 << number);
-                                    released = true;
-                                } else {
-                                    // Freeing a buffer that is already free sounds dangerous !!!
-                                    ASSERT(false);
-                                }
-
-                                _adminLock.Unlock();
-                            }
+                            slot = Core::NumberType<uint32_t>(&(actualFile.c_str()[baseLength]), static_cast<uint32_t>(actualFile.length() - baseLength)).Value();
                         }
                     }
-                    return (released);
+
+                    return (slot);
                 }
 
             private:
-                Core::CriticalSection _adminLock;
-                string _basePath;
-                uint16_t _occupation;
+                mutable Core::CriticalSection _adminLock;
+                const string _basePath;
+                const uint32_t _size;
+                const uint8_t _spares;
+                std::vector<bool> _occupation;
+                std::list<DataExchange*> _available;
+                uint32_t _inUse;
+                uint32_t _peak;
+                uint32_t _created;
+                uint32_t _recycled;
+                uint64_t _creationTime;
+                uint32_t _maxCreationTime;
+                Core::WorkerPool::JobType<BufferAdministrator&> _job;
             };
 
-            // IMediaKeys defines the MediaKeys interface.
-            class SessionImplementation : public ::OCDM::ISession, public ::OCDM::ISessionExt {
+            // A thread per session, blocking on the buffer of that session. Used if no pool is configured.
+            class DecryptThread : public Core::Thread {
             private:
-                SessionImplementation() = delete;
-                SessionImplementation(const SessionImplementation&) = delete;
-                SessionImplementation& operator=(const SessionImplementation&) = delete;
+                DecryptThread() = delete;
+                DecryptThread(const DecryptThread&) = delete;
+                DecryptThread& operator=(const DecryptThread&) = delete;
 
-                class DataExchange : public ::OCDM::DataExchange, public Core::Thread {
-                private:
-                    DataExchange() = delete;
-                    DataExchange(const DataExchange&) = delete;
-                    DataExchange& operator=(const DataExchange&) = delete;
+            public:
+                DecryptThread(DataExchange& buffer)
+                    : Core::Thread(Core::Thread::DefaultStackSize(), _T("DRMSessionThread"))
+                    , _buffer(buffer)
+                {
+                    Core::Thread::Run();
+                }
+                ~DecryptThread()
+                {
+                    // Make sure the thread reaches a HALT.. We are done.
+                    Core::Thread::Stop();
 
-                public:
-                    DataExchange(CDMi::IMediaKeySession* mediaKeys, const string& name, const uint32_t defaultSize)
-                        : ::OCDM::DataExchange(name, defaultSize)
-                        , Core::Thread(Core::Thread::DefaultStackSize(), _T("DRMSessionThread"))
-                        , _mediaKeys(mediaKeys)
-                        , _mediaKeysExt(dynamic_cast<CDMi::IMediaKeySessionExt*>(mediaKeys))
-                        , _sessionKey(nullptr)
-                        , _sessionKeyLength(0)
-                    {
-                        Core::Thread::Run();
-                        TRACE_L1("Constructing buffer server side: %p - %s", this, name.c_str());
-                    }
-                    ~DataExchange()
-                    {
-                        TRACE_L1("Destructing buffer server side: %p - %s", this, ::OCDM::DataExchange::Name().c_str());
-                        // Make sure the thread reaches a HALT.. We are done.
-                        Core::Thread::Stop();
+                    // If the thread is waiting for a semaphore, fake a signal :-)
+                    _buffer.Produced();
 
-                        // If the thread is waiting for a semaphore, fake a signal :-)
-                        Produced();
+                    Core::Thread::Wait(Core::Thread::STOPPED, Core::infinite);
+                }
 
-                        Core::Thread::Wait(Core::Thread::STOPPED, Core::infinite);
-                    }
+            private:
+                virtual uint32_t Worker() override
+                {
+                    while (IsRunning() == true) {
 
-                private:
-                    virtual uint32_t Worker() override
-                    {
+                        _buffer.RequestConsume(Core::infinite);
 
-                        while (IsRunning() == true) {
-
-                            uint32_t clearContentSize = 0;
-                            uint8_t* clearContent = nullptr;
-
-                            RequestConsume(Core::infinite);
-
-                            if (IsRunning() == true) {
-                                uint8_t keyIdLength = 0;
-                                const uint8_t* keyIdData = KeyId(keyIdLength);
-
-                                int cr = _mediaKeys->Decrypt(
-                                    _sessionKey,
-                                    _sessionKeyLength,
-                                    nullptr, //subsamples
-                                    0, //number of subsamples
-                                    IVKey(),
-                                    IVKeyLength(),
-                                    Buffer(),
-                                    BytesWritten(),
-                                    &clearContentSize,
-                                    &clearContent,
-                                    keyIdLength,
-                                    keyIdData,
-                                    InitWithLast15());
-                                if ((cr == 0) && (clearContentSize != 0)) {
-                                    if (clearContentSize != BytesWritten()) {
-                                        TRACE_L1("Returned clear sample size (%d) differs from encrypted buffer size (%d)", clearContentSize, BytesWritten());
-                                        Size(clearContentSize);
-                                    }
+                        if (IsRunning() == true) {
+                            _buffer.Decrypt();
+                        }
+                    }
 
-                                    // Adjust the buffer on our sied (this process) on what we will write back
-                                    SetBuffer(0, clearContentSize, clearContent);
-                                }
+                    return (Core::infinite);
+                }
 
-                                // Store the status we have for the other side.
-                                Status(static_cast<uint32_t>(cr));
+            private:
+                DataExchange& _buffer;
+            };
 
-                                // Whatever the result, we are done with the buffer..
-                                Consumed();
-                            }
-                        }
+            typedef DecryptPoolType<DataExchange> DecryptPool;
 
-                        return (Core::infinite);
-                    }
+            static_assert(DecryptPool::Infinite == Core::infinite, "The pool waits on the buffers with their own timeout.");
+            static_assert(Core::ERROR_NONE == 0, "The pool takes 0 for a pending sample.");
 
-                private:
-                    CDMi::IMediaKeySession* _mediaKeys;
-                    CDMi::IMediaKeySessionExt* _mediaKeysExt;
-                    uint8_t* _sessionKey;
-                    uint32_t _sessionKeyLength;
-                };
+            // IMediaKeys defines the MediaKeys interface.
+            class SessionImplementation : public ::OCDM::ISession, public ::OCDM::ISessionExt {
+            private:
+                SessionImplementation() = delete;
+                SessionImplementation(const SessionImplementation&) = delete;
+                SessionImplementation& operator=(const SessionImplementation&) = delete;
 
                 // IMediaKeys defines the MediaKeys interface.
                 class Sink : public CDMi::IMediaKeySessionCallback {
@@ -445,8 +667,7 @@ namespace Plugin {
                     const std::string keySystem,
                     CDMi::IMediaKeySession* mediaKeySession,
                     ::OCDM::ISession::ICallback* callback,
-                    const string bufferName,
-                    const uint32_t defaultSize,
+                    DataExchange* buffer,
                     const CommonEncryptionData* sessionData)
                     : _parent(*parent)
                     , _refCount(1)
@@ -455,15 +676,17 @@ namespace Plugin {
                     , _mediaKeySession(mediaKeySession)
                     , _mediaKeySessionExt(dynamic_cast<CDMi::IMediaKeySessionExt*>(mediaKeySession))
                     , _sink(this, callback)
-                    , _buffer(new DataExchange(mediaKeySession, bufferName, defaultSize))
+                    , _buffer(buffer)
+                    , _thread(parent->_pool.Register(_buffer) == true ? nullptr : new DecryptThread(*_buffer))
                     , _cencData(*sessionData)
                 {
                     ASSERT(parent != nullptr);
+                    ASSERT(buffer != nullptr);
                     ASSERT(sessionData != nullptr);
                     ASSERT(_mediaKeySession != nullptr);
 
                     _mediaKeySession->Run(&_sink);
-                    TRACE(Trace::Information, ("Server::Session::Session(%s,%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), bufferName.c_str(), this));
+                    TRACE(Trace::Information, ("Server::Session::Session(%s,%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), _buffer->Name().c_str(), this));
                     TRACE_L1("Constructed the Session Server side: %p", this);
                 }
 
@@ -472,8 +695,7 @@ namespace Plugin {
                     const std::string keySystem,
                     CDMi::IMediaKeySessionExt* mediaKeySession,
                     ::OCDM::ISession::ICallback* callback,
-                    const string bufferName,
-                    const uint32_t defaultSize,
+                    DataExchange* buffer,
                     const CommonEncryptionData* sessionData)
                     : _parent(*parent)
                     , _refCount(1)
@@ -482,10 +704,12 @@ namespace Plugin {
                     , _mediaKeySession(dynamic_cast<CDMi::IMediaKeySession*>(mediaKeySession))
                     , _mediaKeySessionExt(mediaKeySession)
                     , _sink(this, callback)
-                    , _buffer(new DataExchange(dynamic_cast<CDMi::IMediaKeySession*>(mediaKeySession), bufferName, defaultSize))
+                    , _buffer(buffer)
+                    , _thread(parent->_pool.Register(_buffer) == true ? nullptr : new DecryptThread(*_buffer))
                     , _cencData(*sessionData)
                 {
                     ASSERT(parent != nullptr);
+                    ASSERT(buffer != nullptr);
                     ASSERT(sessionData != nullptr);
                     ASSERT(_mediaKeySession != nullptr);
 
@@ -508,7 +732,13 @@ namespace Plugin {
                     // the parent to lock handing out new entries before we clear.
                     _parent.Remove(this, _keySystem, _mediaKeySession);
 
-                    delete _buffer;
+                    if (_thread != nullptr) {
+                        delete _thread;
+                    } else {
+                        _parent._pool.Unregister(_buffer);
+                    }
+
+                    _parent._administrator.Release(_buffer);
 
                     TRACE(Trace::Information, ("Server::Session::~Session(%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), this));
                     TRACE_L1("Destructed the Session Server side: %p", this);
@@ -643,16 +873,17 @@ namespace Plugin {
                 CDMi::IMediaKeySessionExt* _mediaKeySessionExt;
                 Core::Sink<Sink> _sink;
                 DataExchange* _buffer;
+                DecryptThread* _thread;
                 CommonEncryptionData _cencData;
             };
 
         public:
-            AccessorOCDM(OCDMImplementation* parent, const string& name, const uint32_t defaultSize)
+            AccessorOCDM(OCDMImplementation* parent, const string& name, const uint32_t defaultSize, const uint8_t spares, const uint8_t workers, const uint32_t slice)
                 : _parent(*parent)
                 , _adminLock()
-                , _administrator(name)
-                , _defaultSize(defaultSize)
+                , _administrator(name, defaultSize, spares)
                 , _sessionList()
+                , _pool(workers, slice)
             {
                 ASSERT(parent != nullptr);
             }
@@ -715,38 +946,30 @@ namespace Plugin {
                      {
                          if (sessionInterface != nullptr)
                          {
-                             std::string bufferId;
+                             // Spare buffers are kept ready, so this should not take long.
+                             DataExchange* buffer = _administrator.Acquire(sessionInterface);
 
-                             // See if there is a buffer available we can use..
-                             if (_administrator.AquireBuffer(bufferId) == true)
-                             {
-
-                                 SessionImplementation *newEntry = 
-                                    Core::Service<SessionImplementation>::Create<SessionImplementation>(this,
-                                                 keySystem, sessionInterface,
-                                                 callback, bufferId, _defaultSize, &keyIds);
+                             SessionImplementation *newEntry = 
+                                Core::Service<SessionImplementation>::Create<SessionImplementation>(this,
+                                             keySystem, sessionInterface,
+                                             callback, buffer, &keyIds);
 
-                                 session = newEntry;
-                                 sessionId = newEntry->SessionId();
+                             session = newEntry;
+                             sessionId = newEntry->SessionId();
 
-                                 _adminLock.Lock();
+                             _adminLock.Lock();
 
-                                 _sessionList.push_front(newEntry);
-                                
-                                if(false == keyIds.IsEmpty())
-                                {
-                                    CommonEncryptionData::Iterator index(keyIds.Keys());
-                                    while (index.Next() == true) {
-                                        const CommonEncryptionData::KeyId& entry(index.Current());
-                                        callback->OnKeyStatusUpdate( entry.Id(), entry.Length(), ::OCDM::ISession::StatusPending);
-                                    }
-                                }
-                                _adminLock.Unlock();
-                             } else {
-                                 TRACE_L1("Could not allocate a buffer for session: %s", sessionId.c_str());
+                             _sessionList.push_front(newEntry);
 
-                                 // TODO: We need to drop the session somehow...
+                             if(false == keyIds.IsEmpty())
+                             {
+                                 CommonEncryptionData::Iterator index(keyIds.Keys());
+                                 while (index.Next() == true) {
+                                     const CommonEncryptionData::KeyId& entry(index.Current());
+                                     callback->OnKeyStatusUpdate( entry.Id(), entry.Length(), ::OCDM::ISession::StatusPending);
+                                 }
                              }
+                             _adminLock.Unlock();
                          }
                      }
                  }
@@ -957,8 +1180,6 @@ namespace Plugin {
 
                 if (session != nullptr) {
 
-                    _administrator.ReleaseBuffer(session->BufferId());
-
                     std::list<SessionImplementation*>::iterator index(_sessionList.begin());
 
                     while ((index != _sessionList.end()) && (session != (*index))) {
@@ -981,8 +1202,8 @@ namespace Plugin {
             OCDMImplementation& _parent;
             mutable Core::CriticalSection _adminLock;
             BufferAdministrator _administrator;
-            uint32_t _defaultSize;
             std::list<SessionImplementation*> _sessionList;
+            DecryptPool _pool;
         };
 
         class Config : public Core::JSON::Container {
@@ -1036,12 +1257,18 @@ namespace Plugin {
                 , Connector(_T("/tmp/ocdm"))
                 , SharePath(_T("/tmp"))
                 , ShareSize(8 * 1024)
+                , ShareSpares(1)
+                , DecryptWorkers(0)
+                , DecryptSlice(2)
                 , KeySystems()
             {
                 Add(_T("location"), &Location);
                 Add(_T("connector"), &Connector);
                 Add(_T("sharepath"), &SharePath);
                 Add(_T("sharesize"), &ShareSize);
+                Add(_T("sharespares"), &ShareSpares);
+                Add(_T("decryptworkers"), &DecryptWorkers);
+                Add(_T("decryptslice"), &DecryptSlice);
                 Add(_T("systems"), &KeySystems);
             }
             ~Config()
@@ -1053,6 +1280,9 @@ namespace Plugin {
             Core::JSON::String Connector;
             Core::JSON::String SharePath;
             Core::JSON::DecUInt32 ShareSize;
+            Core::JSON::DecUInt8 ShareSpares; // Buffers created ahead of the sessions.
+            Core::JSON::DecUInt8 DecryptWorkers; // 0 is a thread per session.
+            Core::JSON::DecUInt32 DecryptSlice; // ms
             Core::JSON::ArrayType<Systems> KeySystems;
         };
 
@@ -1062,6 +1292,7 @@ namespace Plugin {
             , _service(nullptr)
             , _compliant(false)
             , _systemToFactory()
+            , _typeCache()
             , _systemLibraries()
         {
             TRACE_L1("Constructing OCDMImplementation Service: %p", this);
@@ -1168,7 +1399,7 @@ namespace Plugin {
                 SYSLOG(Logging::Startup, (_T("No DRM factories specified. OCDM can not service any DRM requests.")));
             }
 
-            _entryPoint = Core::Service<AccessorOCDM>::Create<::OCDM::IAccessorOCDM>(this, config.SharePath.Value(), config.ShareSize.Value());
+            _entryPoint = Core::Service<AccessorOCDM>::Create<::OCDM::IAccessorOCDM>(this, config.SharePath.Value(), config.ShareSize.Value(), config.ShareSpares.Value(), config.DecryptWorkers.Value(), config.DecryptSlice.Value());
             Core::ProxyType<RPC::InvokeServer> server = Core::ProxyType<RPC::InvokeServer>::Create(&Core::IWorkerPool::Instance());
             _service = new ExternalAccess(Core::NodeId(config.Connector.Value().c_str()), _entryPoint, server);
 
@@ -1252,7 +1483,9 @@ namespace Plugin {
             //  and that check belongs in our domain.
             bool result = (keySystem.empty() == false);
 
-            if (result == true) {
+            const bool cached = ((result == true) && (contentType.empty() == false) && (_typeCache.Find(keySystem, contentType, result) == true));
+
+            if ((result == true) && (cached == false)) {
                 std::map<const std::string, SystemFactory>::iterator index(_systemToFactory.find(keySystem));
 
                 if (index == _systemToFactory.end()) {
@@ -1261,13 +1494,13 @@ namespace Plugin {
                     if (contentType.empty() == false) {
                         std::string mimeType;
                         std::vector<std::string> codecs;
-                        ParseContentType(contentType, mimeType, codecs);
+                        ContentType::Parse(contentType, mimeType, codecs);
                         if (mimeType.empty() == false) {
-                            Blacklist::iterator systemMediaTypeRegexps = _systemBlacklistedMediaTypeRegexps.find(index->second.Name);
+                            Blacklist::const_iterator systemMediaTypeRegexps = _systemBlacklistedMediaTypeRegexps.find(index->second.Name);
                             if (systemMediaTypeRegexps != _systemBlacklistedMediaTypeRegexps.end()) {
-                                for (auto& systemMediaTypeRegexp : systemMediaTypeRegexps->second) {
-                                    if (std::regex_match(mimeType, std::regex(systemMediaTypeRegexp))) {
-                                        TRACE(Trace::Information, ("%s mime type matches blacklisted %s regexp", mimeType.c_str(), systemMediaTypeRegexp.c_str()));
+                                for (const Pattern& systemMediaTypeRegexp : systemMediaTypeRegexps->second) {
+                                    if (std::regex_match(mimeType, systemMediaTypeRegexp.Expression)) {
+                                        TRACE(Trace::Information, ("%s mime type matches blacklisted %s regexp", mimeType.c_str(), systemMediaTypeRegexp.Text.c_str()));
                                         result = false;
                                         break;
                                     }
@@ -1275,12 +1508,12 @@ namespace Plugin {
                             }
 
                             if (result == true && codecs.size() > 0) {
-                                Blacklist::iterator systemCodecRegexps = _systemBlacklistedCodecRegexps.find(index->second.Name);
+                                Blacklist::const_iterator systemCodecRegexps = _systemBlacklistedCodecRegexps.find(index->second.Name);
                                 if (systemCodecRegexps != _systemBlacklistedCodecRegexps.end()) {
                                     for (const std::string& codec : codecs) {
-                                        for (const std::string& codecRegexp : systemCodecRegexps->second) {
-                                            if (std::regex_match(codec, std::regex(codecRegexp))) {
-                                                TRACE(Trace::Information, ("%s codec matches blacklisted %s regexp", codec.c_str(), codecRegexp.c_str()));
+                                        for (const Pattern& codecRegexp : systemCodecRegexps->second) {
+                                            if (std::regex_match(codec, codecRegexp.Expression)) {
+                                                TRACE(Trace::Information, ("%s codec matches blacklisted %s regexp", codec.c_str(), codecRegexp.Text.c_str()));
                                                 result = false;
                                                 break;
                                             }
@@ -1289,11 +1522,13 @@ namespace Plugin {
                                 }
                             }
                         }
+
+                        _typeCache.Insert(keySystem, contentType, result);
                     }
                 }
             }
 
-            TRACE(Trace::Information, ("IsTypeSupported(%s,%s) => %s", keySystem.c_str(), contentType.c_str(), result ? _T("True") : _T("False")));
+            TRACE(Trace::Information, ("IsTypeSupported(%s,%s) => %s%s", keySystem.c_str(), contentType.c_str(), result ? _T("True") : _T("False"), cached ? _T(" (cached)") : _T("")));
 
             return result;
         }
@@ -1345,28 +1580,108 @@ namespace Plugin {
         END_INTERFACE_MAP
 
     private:
-        using Blacklist = std::map<const std::string, std::vector<std::string>>;
+        // The patterns are compiled once, when the configuration is loaded.
+        struct Pattern {
+            std::string Text;
+            std::regex Expression;
+        };
+        using Blacklist = std::map<const std::string, std::vector<Pattern>>;
         void FillBlacklist(Blacklist& blacklist, const std::string& system, const Core::JSON::ArrayType<Core::JSON::String>& list)
         {
             Core::JSON::ArrayType<Core::JSON::String>::ConstIterator iter(list.Elements());
 
-            std::vector<std::string> elements;
+            std::vector<Pattern> elements;
             while (iter.Next() == true) {
                 const string element(iter.Current().Value());
                 if (element.empty() == false) {
-                    elements.emplace_back(std::move(element));
+                    try {
+                        elements.push_back(Pattern { element, std::regex(element, std::regex::optimize) });
+                    } catch (const std::regex_error&) {
+                        SYSLOG(Logging::Startup, (_T("Invalid blacklist regexp [%s] for %s, ignored."), element.c_str(), system.c_str()));
+                    }
                 }
             }
 
-            blacklist.insert(std::pair<const std::string, std::vector<std::string>>(system, elements));
+            blacklist.insert(std::pair<const std::string, std::vector<Pattern>>(system, std::move(elements)));
         }
 
+        // Players ask the same questions over and over again while they probe, remember the answers.
+        // The configuration does not change after Initialize, so the answers do not go stale.
+        class TypeCache {
+        private:
+            TypeCache(const TypeCache&) = delete;
+            TypeCache& operator=(const TypeCache&) = delete;
+
+            static constexpr uint16_t MaxEntries = 128;
+
+        public:
+            TypeCache()
+                : _adminLock()
+                , _entries()
+                , _order()
+            {
+            }
+            ~TypeCache()
+            {
+            }
+
+        public:
+            bool Find(const std::string& keySystem, const std::string& contentType, bool& supported) const
+            {
+                _adminLock.Lock();
+
+                std::unordered_map<std::string, bool>::const_iterator index(_entries.find(Key(keySystem, contentType)));
+                const bool found = (index != _entries.end());
+
+                if (found == true) {
+                    supported = index->second;
+                }
+
+                _adminLock.Unlock();
+
+                return (found);
+            }
+            void Insert(const std::string& keySystem, const std::string& contentType, const bool supported)
+            {
+                std::string key(Key(keySystem, contentType));
+
+                _adminLock.Lock();
+
+                if (_entries.find(key) == _entries.end()) {
+                    // Full, forget the oldest answer.
+                    if (_order.size() >= MaxEntries) {
+                        _entries.erase(_order.front());
+                        _order.pop_front();
+                    }
+                    _order.push_back(key);
+                    _entries.emplace(std::move(key), supported);
+                }
+
+                _adminLock.Unlock();
+            }
+
+        private:
+            static std::string Key(const std::string& keySystem, const std::string& contentType)
+            {
+                std::string result;
+                result.reserve(keySystem.length() + 1 + contentType.length());
+                result.append(keySystem).append(1, '\0').append(contentType);
+                return (result);
+            }
+
+        private:
+            mutable Core::CriticalSection _adminLock;
+            std::unordered_map<std::string, bool> _entries;
+            std::deque<std::string> _order;
+        };
+
         ::OCDM::IAccessorOCDM* _entryPoint;
         ExternalAccess* _service;
         bool _compliant;
         std::map<const std::string, SystemFactory> _systemToFactory;
         Blacklist _systemBlacklistedCodecRegexps;
         Blacklist _systemBlacklistedMediaTypeRegexps;
+        TypeCache _typeCache;
         std::list<Core::Library> _systemLibraries;
         std::list<string> _keySystems;
     };
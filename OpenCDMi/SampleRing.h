@@ -0,0 +1,119 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SAMPLERING_H
+#define __SAMPLERING_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Layout of a ring of samples in the data area of a session buffer (::OCDM::DataExchange). The client
+// side fills the ring, so it includes this file too.
+//
+// The client writes the ring in the data area and marks all of it as written. The header starts at the
+// first 8 byte aligned address of the data area, the slots follow it, the rest is free for the samples.
+// A sample is placed at Slot::Offset, counted from the start of the data area but 4 byte aligned in
+// memory: first the subsample map, Slot::Subsamples pairs of uint32_t (clear, encrypted bytes), then the
+// data.
+//
+// Both sides count Head and Tail up, the slot is the count modulo Slots. The client fills the slot at
+// Head and moves Head on, as many slots as are free. Then it rings the buffer (Produced). The server
+// decrypts from Tail up to Head in place, sets the Status and Length of every slot, moves Tail on and
+// keeps going while Head moves. Only then it hands the buffer back (Consumed). A client that queued a
+// sample after that (Tail != Head) rings again.
+namespace WPEFramework {
+namespace Plugin {
+
+    namespace SampleRing {
+
+        static constexpr uint32_t Magic = 0x5244434F; // "OCDR"
+        static constexpr uint16_t Version = 1;
+        static constexpr uint32_t Invalid = 0xFFFFFFFF; // Status of a slot that does not fit the buffer.
+
+        struct Header {
+            uint32_t Magic;
+            uint16_t Version;
+            uint16_t Slots;
+            std::atomic<uint32_t> Head; // Written by the client.
+            std::atomic<uint32_t> Tail; // Written by the server.
+        };
+
+        struct Slot {
+            uint32_t Offset;
+            uint32_t Length; // Encrypted length, on return the clear length.
+            uint32_t Status; // On return, the result of the decrypt.
+            uint16_t Subsamples;
+            uint8_t KeyIdLength;
+            uint8_t IVLength;
+            uint8_t KeyId[16];
+            uint8_t IV[16];
+            uint8_t InitWithLast15;
+            uint8_t Reserved[7];
+        };
+
+        static_assert(ATOMIC_INT_LOCK_FREE == 2, "The ring is shared between processes, its counters must be lock free.");
+        static_assert((sizeof(Header) % 8) == 0, "The slots must be 8 byte aligned.");
+        static_assert((sizeof(Slot) % 8) == 0, "The slots must be 8 byte aligned.");
+
+        inline uint32_t Offset(const uint8_t* dataArea)
+        {
+            return (static_cast<uint32_t>((8 - (reinterpret_cast<uintptr_t>(dataArea) & 7)) & 7));
+        }
+
+        // Server side: decrypt from Tail up to Head, and keep going as long as the client adds samples. The
+        // decrypt is called with every slot in turn. Returns false if the ring was out of sync; more than a
+        // ring full can not be right, so those slots are skipped.
+        template <typename DECRYPT>
+        bool Drain(Header& ring, DECRYPT&& decrypt)
+        {
+            const uint16_t count = ring.Slots;
+            Slot* slots = reinterpret_cast<Slot*>(&ring + 1);
+            uint32_t tail = ring.Tail.load(std::memory_order_relaxed);
+            uint32_t head = ring.Head.load(std::memory_order_acquire);
+            bool inSync = ((head - tail) <= count);
+
+            if (inSync == false) {
+                tail = head;
+            }
+
+            while (tail != head) {
+                decrypt(slots[tail % count]);
+
+                tail++;
+                ring.Tail.store(tail, std::memory_order_release);
+
+                if (tail == head) {
+                    head = ring.Head.load(std::memory_order_acquire);
+
+                    if ((head - tail) > count) {
+                        inSync = false;
+                        tail = head;
+                    }
+                }
+            }
+
+            ring.Tail.store(tail, std::memory_order_release);
+
+            return (inSync);
+        }
+    }
+}
+}
+
+#endif // __SAMPLERING_H
@@ -0,0 +1,217 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Answers IsTypeSupported for the content types a player probes with, against a media type and a codec
+// blacklist. "per call" is how it used to be: the content type expression and every blacklist pattern
+// are compiled on each call. "precompiled" is the plugin now on a first question: ContentType::Parse and
+// patterns compiled once with std::regex::optimize. "cached" is a repeated question, answered from a
+// map keyed like the TypeCache of the plugin.
+//
+// usage: contenttypebenchmark [rounds]
+
+#include "ContentType.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+const char* const ContentTypes[] = {
+    "video/mp4; codecs=\"avc1.42E01E\"",
+    "video/mp4; codecs=\"avc1.4d401f\"",
+    "video/mp4; codecs=\"avc1.640028\"",
+    "video/mp4; codecs=\"hev1.1.6.L93.B0\"",
+    "video/mp4; codecs=\"hvc1.2.4.L153.B0\"",
+    "video/mp4; codecs=\"dvh1.05.06\"",
+    "video/mp4; codecs=\"av01.0.08M.08\"",
+    "video/webm; codecs=\"vp9\"",
+    "video/webm; codecs=\"vp09.00.10.08\"",
+    "video/webm; codecs=\"vp8, vorbis\"",
+    "audio/mp4; codecs=\"mp4a.40.2\"",
+    "audio/mp4; codecs=\"ec-3\"",
+    "audio/mp4; codecs=\"ac-3\"",
+    "audio/webm; codecs=\"opus\"",
+    "audio/mp4",
+    "video/mp2t; codecs=\"avc1.42E01E, mp4a.40.2\""
+};
+const char* const MediaTypes[] = { "video/webm", "audio/webm" };
+const char* const Codecs[] = { "vp8.*", "vp09?.*", "dvh.*", "av01.*", "opus" };
+
+template <typename EXPRESSION>
+bool Listed(const std::string& value, const EXPRESSION& list)
+{
+    bool result = false;
+    for (const auto& pattern : list) {
+        if (std::regex_match(value, std::regex(pattern))) {
+            result = true;
+            break;
+        }
+    }
+    return (result);
+}
+
+bool Listed(const std::string& value, const std::vector<std::regex>& list)
+{
+    bool result = false;
+    for (const std::regex& pattern : list) {
+        if (std::regex_match(value, pattern)) {
+            result = true;
+            break;
+        }
+    }
+    return (result);
+}
+
+// As the plugin used to: everything compiled again on every call.
+bool PerCall(const std::string& contentType)
+{
+    bool result = true;
+    std::smatch matches;
+    std::string mimeType;
+    std::vector<std::string> codecs;
+    std::regex expr(ContentType::Expression);
+
+    if ((std::regex_match(contentType, matches, expr) == true) && (matches.size() == 4)) {
+        mimeType = matches[1];
+        if (matches[2].str().empty() == false) {
+            codecs = ContentType::Tokenize(matches[3], ',');
+        }
+    }
+    if (mimeType.empty() == false) {
+        result = (Listed(mimeType, MediaTypes) == false);
+        for (uint32_t index = 0; (result == true) && (index < codecs.size()); index++) {
+            result = (Listed(codecs[index], Codecs) == false);
+        }
+    }
+
+    return (result);
+}
+
+bool Precompiled(const std::string& contentType, const std::vector<std::regex>& mediaTypes, const std::vector<std::regex>& codecList)
+{
+    bool result = true;
+    std::string mimeType;
+    std::vector<std::string> codecs;
+
+    ContentType::Parse(contentType, mimeType, codecs);
+
+    if (mimeType.empty() == false) {
+        result = (Listed(mimeType, mediaTypes) == false);
+        for (uint32_t index = 0; (result == true) && (index < codecs.size()); index++) {
+            result = (Listed(codecs[index], codecList) == false);
+        }
+    }
+
+    return (result);
+}
+
+std::string Key(const std::string& keySystem, const std::string& contentType)
+{
+    std::string result;
+    result.reserve(keySystem.length() + 1 + contentType.length());
+    result.append(keySystem).append(1, '\0').append(contentType);
+    return (result);
+}
+
+double Microseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t rounds = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200);
+    const std::string keySystem("com.widevine.alpha");
+    const uint32_t count = sizeof(ContentTypes) / sizeof(ContentTypes[0]);
+
+    if (rounds == 0) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return (1);
+    }
+
+    std::vector<std::string> contentTypes(ContentTypes, ContentTypes + count);
+    std::vector<std::regex> mediaTypes;
+    std::vector<std::regex> codecs;
+
+    for (const char* pattern : MediaTypes) {
+        mediaTypes.emplace_back(pattern, std::regex::optimize);
+    }
+    for (const char* pattern : Codecs) {
+        codecs.emplace_back(pattern, std::regex::optimize);
+    }
+
+    std::vector<bool> before;
+    std::vector<bool> after;
+    std::unordered_map<std::string, bool> cache;
+    std::mutex lock;
+    uint32_t supported = 0;
+
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    for (uint32_t round = 0; round < rounds; round++) {
+        before.clear();
+        for (const std::string& contentType : contentTypes) {
+            before.push_back(PerCall(contentType));
+        }
+    }
+    const double perCall = Microseconds(start) / (rounds * count);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        after.clear();
+        for (const std::string& contentType : contentTypes) {
+            after.push_back(Precompiled(contentType, mediaTypes, codecs));
+        }
+    }
+    const double precompiled = Microseconds(start) / (rounds * count);
+
+    for (uint32_t index = 0; index < count; index++) {
+        cache.emplace(Key(keySystem, contentTypes[index]), after[index]);
+        supported += (after[index] ? 1 : 0);
+    }
+
+    volatile uint32_t hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (const std::string& contentType : contentTypes) {
+            std::lock_guard<std::mutex> guard(lock);
+            std::unordered_map<std::string, bool>::const_iterator index(cache.find(Key(keySystem, contentType)));
+            hits = hits + ((index != cache.end()) && (index->second == true) ? 1 : 0);
+        }
+    }
+    const double cached = Microseconds(start) / (rounds * count);
+
+    printf("%u content types, %u supported, %u rounds\n", count, supported, rounds);
+    printf("per call:    %9.3f us per question\n", perCall);
+    printf("precompiled: %9.3f us per question\n", precompiled);
+    printf("cached:      %9.3f us per question\n", cached);
+
+    if ((before != after) || (hits != (supported * rounds))) {
+        fprintf(stderr, "The answers differ.\n");
+        return (1);
+    }
+
+    return (0);
+}
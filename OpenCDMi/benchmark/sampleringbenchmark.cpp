@@ -0,0 +1,677 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Clients push AES-128-CTR encrypted samples through session buffers to the decrypt side. A buffer is
+// signalled with two semaphores, like ::OCDM::DataExchange does with Produced and Consumed, and the
+// decrypt is done in software, standing in for the CDMi::IMediaKeySession of a DRM system. The time
+// from queueing a sample to getting it back decrypted is measured for every sample.
+//
+// First a single session floods its buffer. "single" is the single sample path: one Produced/Consumed
+// round trip per sample. "ring" queues the samples in a SampleRing, drained with SampleRing::Drain as
+// the server does now, so one round trip covers all samples the client queued meanwhile.
+//
+// Then a number of sessions send samples at random intervals, with some idle time in between, like
+// streams do. "threads" serves every session with a thread of its own, as the server does without
+// "decryptworkers". "pool" serves them with the DecryptPoolType of the server, so the idle backoff of
+// its workers shows in the latencies.
+//
+// usage: sampleringbenchmark [samples [sample size [slots [sessions [workers [interval]]]]]]
+
+#include "DecryptPool.h"
+#include "SampleRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <semaphore.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+class Buffer;
+
+typedef DecryptPoolType<Buffer> DecryptPool;
+
+static constexpr uint32_t Slice = 2; // ms, the default "decryptslice" of the plugin.
+
+const uint8_t Key[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+// AES-128, only the forward cipher, which is all CTR mode needs (FIPS-197).
+class AES128 {
+public:
+    AES128(const uint8_t key[16])
+    {
+        static const uint8_t RoundConstants[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36 };
+
+        memcpy(_roundKeys, key, 16);
+
+        for (uint8_t index = 4; index < 44; index++) {
+            uint8_t word[4];
+
+            memcpy(word, &_roundKeys[(index - 1) * 4], 4);
+
+            if ((index % 4) == 0) {
+                const uint8_t first = word[0];
+                word[0] = SBox[word[1]] ^ RoundConstants[(index / 4) - 1];
+                word[1] = SBox[word[2]];
+                word[2] = SBox[word[3]];
+                word[3] = SBox[first];
+            }
+
+            for (uint8_t byte = 0; byte < 4; byte++) {
+                _roundKeys[(index * 4) + byte] = _roundKeys[((index - 4) * 4) + byte] ^ word[byte];
+            }
+        }
+    }
+
+public:
+    void Encrypt(const uint8_t input[16], uint8_t output[16]) const
+    {
+        uint8_t state[16];
+
+        for (uint8_t index = 0; index < 16; index++) {
+            state[index] = input[index] ^ _roundKeys[index];
+        }
+
+        for (uint8_t round = 1; round <= 10; round++) {
+            uint8_t shifted[16];
+
+            // SubBytes and ShiftRows, the state is stored column by column.
+            for (uint8_t column = 0; column < 4; column++) {
+                for (uint8_t row = 0; row < 4; row++) {
+                    shifted[(column * 4) + row] = SBox[state[(((column + row) % 4) * 4) + row]];
+                }
+            }
+
+            if (round < 10) {
+                for (uint8_t column = 0; column < 4; column++) {
+                    uint8_t* a = &shifted[column * 4];
+                    const uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                    const uint8_t first = a[0];
+
+                    a[0] ^= all ^ Times2(a[0] ^ a[1]);
+                    a[1] ^= all ^ Times2(a[1] ^ a[2]);
+                    a[2] ^= all ^ Times2(a[2] ^ a[3]);
+                    a[3] ^= all ^ Times2(a[3] ^ first);
+                }
+            }
+
+            for (uint8_t index = 0; index < 16; index++) {
+                state[index] = shifted[index] ^ _roundKeys[(round * 16) + index];
+            }
+        }
+
+        memcpy(output, state, 16);
+    }
+
+private:
+    static uint8_t Times2(const uint8_t value)
+    {
+        return (static_cast<uint8_t>((value << 1) ^ ((value & 0x80) != 0 ? 0x1B : 0x00)));
+    }
+
+    static const uint8_t SBox[256];
+
+private:
+    uint8_t _roundKeys[176];
+};
+
+const uint8_t AES128::SBox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+// Stands in for the CDMi::IMediaKeySession: AES-128-CTR with a single key, in place. The IV is the first
+// counter block, an 8 byte IV gets a zero block counter appended, as in CENC. The client encrypts with
+// it as well, CTR mode is its own inverse.
+class MediaKeySession {
+public:
+    MediaKeySession(const uint8_t key[16])
+        : _cipher(key)
+    {
+    }
+
+public:
+    uint32_t Decrypt(const uint8_t iv[], const uint8_t ivLength, uint8_t data[], const uint32_t length) const
+    {
+        uint32_t result = 1;
+
+        if ((ivLength == 8) || (ivLength == 16)) {
+            uint8_t counter[16];
+            uint8_t stream[16];
+
+            memset(counter, 0, sizeof(counter));
+            memcpy(counter, iv, ivLength);
+
+            for (uint32_t offset = 0; offset < length; offset += 16) {
+                _cipher.Encrypt(counter, stream);
+
+                const uint32_t size = std::min(length - offset, static_cast<uint32_t>(16));
+                for (uint32_t index = 0; index < size; index++) {
+                    data[offset + index] ^= stream[index];
+                }
+
+                // The block counter is the last 8 bytes, big endian.
+                for (uint8_t index = 16; (index > 8) && (++counter[index - 1] == 0); index--) {
+                }
+            }
+
+            result = 0;
+        }
+
+        return (result);
+    }
+
+private:
+    AES128 _cipher;
+};
+
+// The IV of a sample is derived from its number, so every sample gets a different key stream.
+void IV(uint8_t iv[16], const uint32_t sample)
+{
+    memset(iv, 0, 16);
+    memcpy(iv, &sample, sizeof(sample));
+}
+
+// The client encrypts a sample filled with its number, decrypted it must hold that number again.
+void Fill(uint8_t data[], const uint32_t length, const uint32_t sample)
+{
+    memset(data, static_cast<int>(sample & 0xFF), length);
+}
+
+bool Check(const uint8_t data[], const uint32_t length, const uint32_t sample)
+{
+    return ((data[0] == static_cast<uint8_t>(sample & 0xFF)) && (data[length - 1] == static_cast<uint8_t>(sample & 0xFF)));
+}
+
+// The buffer of a session, the client produces, the server consumes and decrypts.
+class Buffer {
+public:
+    Buffer(const uint32_t size, const MediaKeySession& keys)
+        : Length(0)
+        , Status(0)
+        , Sample(0)
+        , _data(size + 8)
+        , _ring(nullptr)
+        , _keys(keys)
+    {
+        sem_init(&_produced, 0, 0);
+        sem_init(&_consumed, 0, 0);
+    }
+    ~Buffer()
+    {
+        sem_destroy(&_produced);
+        sem_destroy(&_consumed);
+    }
+
+public:
+    uint8_t* Data()
+    {
+        return (_data.data());
+    }
+    // The client put a ring in the data area.
+    void Ring(SampleRing::Header* ring)
+    {
+        _ring = ring;
+    }
+    void Produced()
+    {
+        sem_post(&_produced);
+    }
+    // As ::OCDM::DataExchange::RequestConsume, 0 if a sample was produced within the time.
+    uint32_t RequestConsume(const uint32_t waitTime)
+    {
+        int result;
+
+        if (waitTime == 0) {
+            result = sem_trywait(&_produced);
+        } else if (waitTime == DecryptPool::Infinite) {
+            while (((result = sem_wait(&_produced)) != 0) && (errno == EINTR)) {
+            }
+        } else {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += waitTime / 1000;
+            deadline.tv_nsec += static_cast<long>(waitTime % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while (((result = sem_timedwait(&_produced, &deadline)) != 0) && (errno == EINTR)) {
+            }
+        }
+
+        return (result == 0 ? 0 : 1);
+    }
+    // As the server does: decrypt the ring or the single sample, and hand the buffer back.
+    void Decrypt()
+    {
+        if (_ring != nullptr) {
+            uint8_t* area = Data();
+
+            SampleRing::Drain(*_ring, [this, area](SampleRing::Slot& slot) {
+                slot.Status = _keys.Decrypt(slot.IV, slot.IVLength, &area[slot.Offset], slot.Length);
+            });
+        } else {
+            uint8_t iv[16];
+            IV(iv, Sample);
+            Status = _keys.Decrypt(iv, sizeof(iv), Data(), Length);
+        }
+
+        Consumed();
+    }
+    void Consumed()
+    {
+        sem_post(&_consumed);
+    }
+    void RequestProduce()
+    {
+        while ((sem_wait(&_consumed) != 0) && (errno == EINTR)) {
+        }
+    }
+    bool TryProduce()
+    {
+        return (sem_trywait(&_consumed) == 0);
+    }
+    // Wait for the buffer to come back, but not past until.
+    bool RequestProduce(const std::chrono::steady_clock::time_point& until)
+    {
+        const std::chrono::nanoseconds left(std::chrono::duration_cast<std::chrono::nanoseconds>(until - std::chrono::steady_clock::now()));
+        bool result = TryProduce();
+
+        if ((result == false) && (left.count() > 0)) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += static_cast<time_t>(left.count() / 1000000000);
+            deadline.tv_nsec += static_cast<long>(left.count() % 1000000000);
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            int outcome;
+            while (((outcome = sem_timedwait(&_consumed, &deadline)) != 0) && (errno == EINTR)) {
+            }
+            result = (outcome == 0);
+        }
+
+        return (result);
+    }
+public:
+    uint32_t Length;
+    uint32_t Status;
+    uint32_t Sample;
+
+private:
+    std::vector<uint8_t> _data;
+    SampleRing::Header* _ring;
+    const MediaKeySession& _keys;
+    sem_t _produced;
+    sem_t _consumed;
+};
+
+// A thread per session, as the server has without a pool.
+class DecryptThread {
+public:
+    DecryptThread(Buffer& buffer)
+        : _buffer(buffer)
+        , _done(false)
+        , _thread([this]() {
+            while (true) {
+                _buffer.RequestConsume(DecryptPool::Infinite);
+                if (_done.load() == true) {
+                    break;
+                }
+                _buffer.Decrypt();
+            }
+        })
+    {
+    }
+    ~DecryptThread()
+    {
+        _done.store(true);
+        _buffer.Produced();
+        _thread.join();
+    }
+
+private:
+    Buffer& _buffer;
+    std::atomic<bool> _done;
+    std::thread _thread;
+};
+
+struct Statistics {
+    std::vector<double> Latencies; // us
+    uint32_t RoundTrips;
+    uint32_t Failures;
+};
+
+// When the samples are sent: all at once, or at random intervals with the given mean.
+class Schedule {
+public:
+    Schedule(const uint32_t interval, const uint32_t seed)
+        : _generator(seed)
+        , _interval(interval > 0 ? 1.0 / interval : 1.0)
+        , _next(std::chrono::steady_clock::now())
+        , _paced(interval > 0)
+    {
+    }
+
+public:
+    std::chrono::steady_clock::time_point Next()
+    {
+        if (_paced == true) {
+            _next += std::chrono::microseconds(static_cast<uint64_t>(_interval(_generator)));
+        }
+        return (_next);
+    }
+
+private:
+    std::mt19937 _generator;
+    std::exponential_distribution<double> _interval;
+    std::chrono::steady_clock::time_point _next;
+    const bool _paced;
+};
+
+double Microseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Single(Buffer& buffer, const MediaKeySession& keys, const uint32_t samples, const uint32_t size, Schedule& schedule, Statistics& statistics)
+{
+    uint8_t iv[16];
+
+    for (uint32_t sample = 0; sample < samples; sample++) {
+        std::this_thread::sleep_until(schedule.Next());
+
+        const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+        Fill(buffer.Data(), size, sample);
+        IV(iv, sample);
+        keys.Decrypt(iv, sizeof(iv), buffer.Data(), size);
+        buffer.Sample = sample;
+        buffer.Length = size;
+        buffer.Produced();
+        statistics.RoundTrips++;
+        buffer.RequestProduce();
+
+        statistics.Latencies.push_back(Microseconds(start));
+
+        if ((buffer.Status != 0) || (Check(buffer.Data(), size, sample) == false)) {
+            statistics.Failures++;
+        }
+    }
+}
+
+void Ring(Buffer& buffer, const MediaKeySession& keys, const uint32_t samples, const uint32_t size, const uint16_t slotCount, Schedule& schedule, Statistics& statistics)
+{
+    uint8_t* area = buffer.Data();
+    const uint32_t offset = SampleRing::Offset(area);
+    SampleRing::Header& ring = *reinterpret_cast<SampleRing::Header*>(&area[offset]);
+    SampleRing::Slot* slots = reinterpret_cast<SampleRing::Slot*>(&ring + 1);
+    const uint32_t start = offset + sizeof(SampleRing::Header) + (slotCount * sizeof(SampleRing::Slot));
+    const uint32_t stride = (size + 3) & ~static_cast<uint32_t>(3);
+    std::vector<std::chrono::steady_clock::time_point> queued(slotCount);
+
+    ring.Magic = SampleRing::Magic;
+    ring.Version = SampleRing::Version;
+    ring.Slots = slotCount;
+    ring.Head.store(0);
+    ring.Tail.store(0);
+
+    bool inFlight = false;
+    uint32_t checked = 0;
+    uint32_t head = 0;
+
+    // The samples the server finished with can be checked and their slots used again.
+    auto collect = [&]() {
+        const uint32_t tail = ring.Tail.load(std::memory_order_acquire);
+        while (checked != tail) {
+            const SampleRing::Slot& slot(slots[checked % slotCount]);
+            statistics.Latencies.push_back(Microseconds(queued[checked % slotCount]));
+            if ((slot.Status != 0) || (Check(&area[slot.Offset], size, checked) == false)) {
+                statistics.Failures++;
+            }
+            checked++;
+        }
+    };
+    // Once the buffer is handed back, ring again if the server missed a sample.
+    auto handedBack = [&]() {
+        inFlight = false;
+        collect();
+        if (ring.Tail.load(std::memory_order_acquire) != head) {
+            buffer.Produced();
+            statistics.RoundTrips++;
+            inFlight = true;
+        }
+    };
+
+    for (uint32_t sample = 0; sample < samples; sample++) {
+        const std::chrono::steady_clock::time_point due(schedule.Next());
+
+        // Pick up what comes back until the sample is due, and until there is a free slot.
+        while ((std::chrono::steady_clock::now() < due) || ((head - checked) == slotCount)) {
+            if (inFlight == false) {
+                std::this_thread::sleep_until(due);
+            } else if (buffer.RequestProduce(std::max(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(1))) == true) {
+                handedBack();
+            }
+            collect();
+        }
+
+        SampleRing::Slot& slot(slots[head % slotCount]);
+        slot.Offset = start + ((head % slotCount) * stride);
+        slot.Length = size;
+        slot.Status = 0;
+        slot.Subsamples = 0;
+        slot.KeyIdLength = 0;
+        slot.IVLength = 16;
+        IV(slot.IV, sample);
+        Fill(&area[slot.Offset], size, sample);
+        keys.Decrypt(slot.IV, slot.IVLength, &area[slot.Offset], size);
+        queued[head % slotCount] = std::chrono::steady_clock::now();
+
+        head++;
+        ring.Head.store(head, std::memory_order_release);
+
+        if (inFlight == false) {
+            buffer.Produced();
+            statistics.RoundTrips++;
+            inFlight = true;
+        } else if (buffer.TryProduce() == true) {
+            handedBack();
+        }
+    }
+
+    while (inFlight == true) {
+        buffer.RequestProduce();
+        handedBack();
+    }
+    collect();
+
+    statistics.Failures += (samples - checked);
+}
+
+struct Result {
+    double Time; // us
+    uint32_t Samples;
+    uint32_t RoundTrips;
+    uint32_t Failures;
+    double P50; // us
+    double P99; // us
+    double Max; // us
+};
+
+// Runs a client per session, the sessions are served by a thread each or by a pool of workers.
+Result Run(const uint32_t sessions, const uint8_t workers, const bool ring, const uint32_t samples, const uint32_t size, const uint16_t slotCount, const uint32_t interval)
+{
+    const uint32_t stride = (size + 3) & ~static_cast<uint32_t>(3);
+    const uint32_t bufferSize = (ring == true ? sizeof(SampleRing::Header) + (slotCount * (sizeof(SampleRing::Slot) + stride)) : size);
+    const MediaKeySession keys(Key);
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<Statistics> statistics(sessions);
+
+    for (uint32_t index = 0; index < sessions; index++) {
+        buffers.emplace_back(new Buffer(bufferSize, keys));
+        if (ring == true) {
+            buffers.back()->Ring(reinterpret_cast<SampleRing::Header*>(&(buffers.back()->Data()[SampleRing::Offset(buffers.back()->Data())])));
+        }
+        statistics[index].RoundTrips = 0;
+        statistics[index].Failures = 0;
+        statistics[index].Latencies.reserve(samples);
+    }
+
+    std::unique_ptr<DecryptPool> pool(new DecryptPool(workers, Slice));
+    std::vector<std::unique_ptr<DecryptThread>> threads;
+
+    for (std::unique_ptr<Buffer>& buffer : buffers) {
+        if (pool->Register(buffer.get()) == false) {
+            threads.emplace_back(new DecryptThread(*buffer));
+        }
+    }
+
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    std::vector<std::thread> clients;
+
+    for (uint32_t index = 0; index < sessions; index++) {
+        clients.emplace_back([&, index]() {
+            Schedule schedule(interval, index + 1);
+            if (ring == true) {
+                Ring(*buffers[index], keys, samples, size, slotCount, schedule, statistics[index]);
+            } else {
+                Single(*buffers[index], keys, samples, size, schedule, statistics[index]);
+            }
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+
+    Result result;
+    result.Time = Microseconds(start);
+
+    for (std::unique_ptr<Buffer>& buffer : buffers) {
+        pool->Unregister(buffer.get());
+    }
+    pool.reset();
+    threads.clear();
+
+    std::vector<double> latencies;
+    result.Failures = 0;
+    result.RoundTrips = 0;
+    for (uint32_t index = 0; index < sessions; index++) {
+        latencies.insert(latencies.end(), statistics[index].Latencies.begin(), statistics[index].Latencies.end());
+        result.Failures += statistics[index].Failures;
+        result.RoundTrips += statistics[index].RoundTrips;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    result.Samples = static_cast<uint32_t>(latencies.size());
+    result.P50 = (latencies.empty() ? 0 : latencies[latencies.size() / 2]);
+    result.P99 = (latencies.empty() ? 0 : latencies[(latencies.size() * 99) / 100]);
+    result.Max = (latencies.empty() ? 0 : latencies.back());
+
+    return (result);
+}
+
+void Print(const char name[], const Result& result)
+{
+    printf("%-8s %9.0f samples/s, %8u round trips, latency p50 %9.1f us, p99 %9.1f us, max %9.1f us\n",
+        name, result.Samples * 1000000.0 / result.Time, result.RoundTrips, result.P50, result.P99, result.Max);
+}
+
+// FIPS-197, appendix C.1.
+bool SelfTest()
+{
+    const uint8_t key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F };
+    const uint8_t input[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+    const uint8_t expected[16] = { 0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A };
+    uint8_t output[16];
+
+    AES128(key).Encrypt(input, output);
+
+    return (memcmp(output, expected, sizeof(output)) == 0);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t samples = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20000);
+    const uint32_t size = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1024);
+    const uint32_t slotCount = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 32);
+    const uint32_t sessions = (argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 8);
+    const uint32_t workers = (argc > 5 ? static_cast<uint32_t>(atoi(argv[5])) : 2);
+    const uint32_t interval = (argc > 6 ? static_cast<uint32_t>(atoi(argv[6])) : 10000);
+
+    if ((samples == 0) || (size == 0) || (slotCount == 0) || (slotCount > 0xFFFF) || (sessions == 0) || (workers == 0) || (workers > 0xFF) || (interval == 0)) {
+        fprintf(stderr, "usage: %s [samples [sample size [slots [sessions [workers [interval, us]]]]]]\n", argv[0]);
+        return (1);
+    }
+
+    if (SelfTest() == false) {
+        fprintf(stderr, "AES-128 does not match the FIPS-197 example.\n");
+        return (1);
+    }
+
+    const uint32_t paced = std::max(samples / 40, static_cast<uint32_t>(1));
+
+    const Result single = Run(1, 0, false, samples, size, static_cast<uint16_t>(slotCount), 0);
+    const Result ring = Run(1, 0, true, samples, size, static_cast<uint16_t>(slotCount), 0);
+    const Result threads = Run(sessions, 0, true, paced, size, static_cast<uint16_t>(slotCount), interval);
+    const Result pool = Run(sessions, static_cast<uint8_t>(workers), true, paced, size, static_cast<uint16_t>(slotCount), interval);
+
+    printf("1 session, %u samples of %u bytes, %u slots\n", samples, size, slotCount);
+    Print("single:", single);
+    Print("ring:", ring);
+    printf("%u sessions, %u samples each, one every %u us on average, %u workers, %u ms slice\n", sessions, paced, interval, workers, Slice);
+    Print("threads:", threads);
+    Print("pool:", pool);
+
+    if ((single.Failures != 0) || (ring.Failures != 0) || (threads.Failures != 0) || (pool.Failures != 0)) {
+        fprintf(stderr, "Samples not decrypted correctly, single: %u, ring: %u, threads: %u, pool: %u\n", single.Failures, ring.Failures, threads.Failures, pool.Failures);
+        return (1);
+    }
+
+    return (0);
+}
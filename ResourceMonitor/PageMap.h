@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Operations on the page bitmaps of the ResourceMonitor, one bit per physical page. Plain loops over
+// plain arrays, the pagemap benchmark runs them on the host as they are.
+namespace WPEFramework {
+namespace Plugin {
+    namespace Pages {
+
+        // The maps filled by MarkOccupiedPages are 32 bit words, the group maps are 64 bit words. Copy, do not
+        // cast, so the compiler may not assume they do not alias; it still turns this into plain 64 bit loads.
+        inline void Merge(uint64_t target[], const uint32_t source[], const uint32_t words)
+        {
+            for (uint32_t index = 0; index < words; index++) {
+                uint64_t word;
+                memcpy(&word, &source[index * 2], sizeof(word));
+                target[index] |= word;
+            }
+        }
+
+        // Counts in 64 bit words, with independent accumulators so the compiler can keep several
+        // popcounts in flight or vectorize them where the target has a vector popcount.
+        inline uint32_t CountSetBits(const uint64_t pageBuffer[], const uint64_t* inverseMask, const uint32_t words)
+        {
+            uint64_t counts[4] = { 0, 0, 0, 0 };
+            uint32_t index = 0;
+            const uint32_t blocks = words & ~static_cast<uint32_t>(3);
+
+            if (inverseMask == nullptr) {
+                for (; index < blocks; index += 4) {
+                    counts[0] += __builtin_popcountll(pageBuffer[index]);
+                    counts[1] += __builtin_popcountll(pageBuffer[index + 1]);
+                    counts[2] += __builtin_popcountll(pageBuffer[index + 2]);
+                    counts[3] += __builtin_popcountll(pageBuffer[index + 3]);
+                }
+                for (; index < words; index++) {
+                    counts[0] += __builtin_popcountll(pageBuffer[index]);
+                }
+            } else {
+                for (; index < blocks; index += 4) {
+                    counts[0] += __builtin_popcountll(pageBuffer[index] & (~inverseMask[index]));
+                    counts[1] += __builtin_popcountll(pageBuffer[index + 1] & (~inverseMask[index + 1]));
+                    counts[2] += __builtin_popcountll(pageBuffer[index + 2] & (~inverseMask[index + 2]));
+                    counts[3] += __builtin_popcountll(pageBuffer[index + 3] & (~inverseMask[index + 3]));
+                }
+                for (; index < words; index++) {
+                    counts[0] += __builtin_popcountll(pageBuffer[index] & (~inverseMask[index]));
+                }
+            }
+
+            return static_cast<uint32_t>(counts[0] + counts[1] + counts[2] + counts[3]);
+        }
+    }
+}
+}
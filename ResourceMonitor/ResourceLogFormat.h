@@ -0,0 +1,257 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Layout of the binary resource log written by the ResourceMonitor. resourcelogconverter turns it into
+// CSV on the host.
+//
+// A file starts with a FileHeader, followed by records. Each record starts with its type. Process
+// names are written once per file as a NAME record and referred to by their id from SAMPLE records.
+// A SAMPLE record holds one measurement interval: a SampleHeader followed by Count ProcessSamples.
+// Apart from the system jiffies, all values are deltas (modulo 2^32, or 2^64 for the jiffies) to the
+// previous value of the same id in the same file, the first one is relative to 0. So every file is self
+// contained. When a file reaches its size limit, it is renamed to <path>.1 (the older ones shift up)
+// and a new file with the next sequence number is started. The same happens to the file of a previous
+// run when the monitor starts. Files are ordered by Run (the start time of the monitor that wrote them)
+// and then by Sequence. All fields are in host byte order.
+
+namespace WPEFramework {
+namespace Plugin {
+namespace ResourceLog {
+
+    static constexpr uint32_t Magic = 0x424c4d52; // "RMLB"
+    static constexpr uint16_t Version = 2;
+
+    enum record : uint8_t {
+        END = 0,
+        NAME = 1,
+        SAMPLE = 2
+    };
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Reserved;
+        uint32_t Run; // Seconds since the epoch, when the monitor started.
+        uint32_t Sequence;
+    };
+
+    // Followed by Length bytes of name, not '\0' terminated.
+    struct NameHeader {
+        uint8_t Type;
+        uint16_t Id;
+        uint16_t Length;
+    };
+
+    // Followed by Count ProcessSamples.
+    struct SampleHeader {
+        uint8_t Type;
+        uint32_t Time; // Delta, seconds.
+        uint64_t Jiffies; // Absolute, whole system.
+        uint16_t Count;
+    };
+
+    struct ProcessSample {
+        uint16_t Id;
+        uint32_t VSS; // Delta, pages.
+        uint32_t USS; // Delta, pages.
+        uint64_t Jiffies; // Delta.
+    };
+#pragma pack(pop)
+
+    // Turns the records of a single file back into absolute samples. The data can be fed in pieces,
+    // only complete records are consumed, so a file that is still being written can be followed.
+    class Parser {
+    public:
+        struct Process {
+            uint16_t Id;
+            uint32_t VSS;
+            uint32_t USS;
+            uint64_t Jiffies;
+        };
+        struct Sample {
+            uint32_t Time;
+            uint64_t Jiffies;
+            std::vector<Process> Processes;
+        };
+
+    public:
+        Parser(const Parser&) = delete;
+        Parser& operator=(const Parser&) = delete;
+
+        Parser()
+            : _names()
+            , _previous()
+            , _time(0)
+            , _run(0)
+            , _sequence(0)
+            , _valid(false)
+        {
+        }
+        ~Parser()
+        {
+        }
+
+    public:
+        inline bool IsValid() const
+        {
+            return (_valid);
+        }
+        inline uint32_t Run() const
+        {
+            return (_run);
+        }
+        inline uint32_t Sequence() const
+        {
+            return (_sequence);
+        }
+        const std::string& Name(const uint16_t id) const
+        {
+            static const std::string empty;
+            std::map<uint16_t, std::string>::const_iterator index(_names.find(id));
+
+            return (index != _names.end() ? index->second : empty);
+        }
+
+        // Starts a new file, returns the size of the header, 0 if it is not a resource log.
+        size_t Header(const uint8_t data[], const size_t length)
+        {
+            size_t result = 0;
+            FileHeader header;
+
+            _names.clear();
+            _previous.clear();
+            _time = 0;
+            _valid = false;
+
+            if (length >= sizeof(header)) {
+                ::memcpy(&header, data, sizeof(header));
+
+                if ((header.Magic == Magic) && (header.Version == Version)) {
+                    _run = header.Run;
+                    _sequence = header.Sequence;
+                    _valid = true;
+                    result = sizeof(header);
+                }
+            }
+
+            return (result);
+        }
+
+        // Calls action(const Sample&) for every complete sample, returns the number of bytes consumed.
+        template <typename ACTION>
+        size_t Parse(const uint8_t data[], const size_t length, ACTION&& action)
+        {
+            size_t offset = 0;
+            bool done = (_valid == false);
+            Sample sample;
+
+            while ((done == false) && (offset < length)) {
+                switch (data[offset]) {
+                case NAME: {
+                    NameHeader header;
+
+                    if ((offset + sizeof(header)) > length) {
+                        done = true;
+                    } else {
+                        ::memcpy(&header, &data[offset], sizeof(header));
+
+                        if ((offset + sizeof(header) + header.Length) > length) {
+                            done = true;
+                        } else {
+                            _names[header.Id] = std::string(reinterpret_cast<const char*>(&data[offset + sizeof(header)]), header.Length);
+                            _previous[header.Id] = Process { header.Id, 0, 0, 0 };
+                            offset += sizeof(header) + header.Length;
+                        }
+                    }
+                    break;
+                }
+                case SAMPLE: {
+                    SampleHeader header;
+
+                    if ((offset + sizeof(header)) > length) {
+                        done = true;
+                    } else {
+                        ::memcpy(&header, &data[offset], sizeof(header));
+
+                        const size_t size = sizeof(header) + (header.Count * sizeof(ProcessSample));
+
+                        if ((offset + size) > length) {
+                            done = true;
+                        } else {
+                            const uint8_t* entry = &data[offset + sizeof(header)];
+
+                            _time += header.Time;
+
+                            sample.Time = _time;
+                            sample.Jiffies = header.Jiffies;
+                            sample.Processes.clear();
+
+                            for (uint16_t index = 0; index < header.Count; index++, entry += sizeof(ProcessSample)) {
+                                ProcessSample delta;
+                                ::memcpy(&delta, entry, sizeof(delta));
+
+                                Process& process(_previous[delta.Id]);
+                                process.Id = delta.Id;
+                                process.VSS += delta.VSS;
+                                process.USS += delta.USS;
+                                process.Jiffies += delta.Jiffies;
+
+                                sample.Processes.push_back(process);
+                            }
+
+                            offset += size;
+
+                            action(static_cast<const Sample&>(sample));
+                        }
+                    }
+                    break;
+                }
+                default:
+                    // END marker or garbage, the rest is not used.
+                    done = true;
+                    _valid = false;
+                    break;
+                }
+            }
+
+            return (offset);
+        }
+
+    private:
+        std::map<uint16_t, std::string> _names;
+        std::map<uint16_t, Process> _previous;
+        uint32_t _time;
+        uint32_t _run;
+        uint32_t _sequence;
+        bool _valid;
+    };
+
+}
+}
+}
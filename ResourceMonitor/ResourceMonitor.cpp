@@ -27,6 +27,7 @@ namespace Plugin {
             message = _T("ResourceMonitor could not be instantiated.");
         } else {
             _monitor->Configure(service);
+            _tail = new Tail(config.Path.Value(), config.Samples.Value());
         }
 
         return message;
@@ -49,6 +50,9 @@ namespace Plugin {
             }
         }
 
+        delete _tail;
+        _tail = nullptr;
+
         _service = nullptr;
     }
 
@@ -1,12 +1,13 @@
 #pragma once
 
 #include "Module.h"
+#include "ResourceLogFormat.h"
 #include <interfaces/IMemory.h>
 #include <interfaces/IResourceMonitor.h>
 
 namespace WPEFramework {
 namespace Plugin {
-    class ResourceMonitor : public PluginHost::IPlugin, public PluginHost::IWeb {
+    class ResourceMonitor : public PluginHost::IPlugin, public PluginHost::IWeb, public PluginHost::JSONRPC {
     private:
         ResourceMonitor(const ResourceMonitor&) = delete;
         ResourceMonitor& operator=(const ResourceMonitor&) = delete;
@@ -20,8 +21,12 @@ namespace Plugin {
             Config()
                 : Core::JSON::Container()
                 , OutOfProcess(true)
+                , Path(_T("/tmp/resource-log.bin"))
+                , Samples(64)
             {
                 Add(_T("outofprocess"), &OutOfProcess);
+                Add(_T("path"), &Path);
+                Add(_T("samples"), &Samples);
             }
             ~Config()
             {
@@ -29,6 +34,281 @@ namespace Plugin {
 
         public:
             Core::JSON::Boolean OutOfProcess;
+            Core::JSON::String Path;
+            Core::JSON::DecUInt16 Samples; // Number of most recent samples kept for the samples method.
+        };
+
+    public:
+        class SamplesParams : public Core::JSON::Container {
+        private:
+            SamplesParams(const SamplesParams&) = delete;
+            SamplesParams& operator=(const SamplesParams&) = delete;
+
+        public:
+            SamplesParams()
+                : Core::JSON::Container()
+                , Count(0)
+            {
+                Add(_T("count"), &Count);
+            }
+            ~SamplesParams()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt16 Count; // maximum number of samples to return, 0 returns all of them
+        };
+
+        class SamplesData : public Core::JSON::Container {
+        public:
+            class ProcessData : public Core::JSON::Container {
+            public:
+                ProcessData()
+                    : Core::JSON::Container()
+                {
+                    Init();
+                }
+                ProcessData(const ProcessData& copy)
+                    : Core::JSON::Container()
+                    , Name(copy.Name)
+                    , Vss(copy.Vss)
+                    , Uss(copy.Uss)
+                    , Jiffies(copy.Jiffies)
+                {
+                    Init();
+                }
+                ~ProcessData()
+                {
+                }
+
+                ProcessData& operator=(const ProcessData& RHS)
+                {
+                    Name = RHS.Name;
+                    Vss = RHS.Vss;
+                    Uss = RHS.Uss;
+                    Jiffies = RHS.Jiffies;
+
+                    return (*this);
+                }
+
+            private:
+                void Init()
+                {
+                    Add(_T("name"), &Name);
+                    Add(_T("vss"), &Vss);
+                    Add(_T("uss"), &Uss);
+                    Add(_T("jiffies"), &Jiffies);
+                }
+
+            public:
+                Core::JSON::String Name;
+                Core::JSON::DecUInt32 Vss; // pages
+                Core::JSON::DecUInt32 Uss; // pages
+                Core::JSON::DecUInt64 Jiffies;
+            };
+
+            class SampleData : public Core::JSON::Container {
+            public:
+                SampleData()
+                    : Core::JSON::Container()
+                {
+                    Init();
+                }
+                SampleData(const SampleData& copy)
+                    : Core::JSON::Container()
+                    , Time(copy.Time)
+                    , Jiffies(copy.Jiffies)
+                    , Processes(copy.Processes)
+                {
+                    Init();
+                }
+                ~SampleData()
+                {
+                }
+
+                SampleData& operator=(const SampleData& RHS)
+                {
+                    Time = RHS.Time;
+                    Jiffies = RHS.Jiffies;
+                    Processes = RHS.Processes;
+
+                    return (*this);
+                }
+
+            private:
+                void Init()
+                {
+                    Add(_T("time"), &Time);
+                    Add(_T("jiffies"), &Jiffies);
+                    Add(_T("processes"), &Processes);
+                }
+
+            public:
+                Core::JSON::DecUInt32 Time; // seconds since the epoch
+                Core::JSON::DecUInt64 Jiffies;
+                Core::JSON::ArrayType<ProcessData> Processes;
+            };
+
+        private:
+            SamplesData(const SamplesData&) = delete;
+            SamplesData& operator=(const SamplesData&) = delete;
+
+        public:
+            SamplesData()
+                : Core::JSON::Container()
+            {
+                Add(_T("samples"), &Samples);
+            }
+            ~SamplesData()
+            {
+            }
+
+        public:
+            Core::JSON::ArrayType<SampleData> Samples;
+        };
+
+    private:
+        // Follows the resource log written by the implementation and keeps its most recent samples in
+        // memory. Only what was written since the previous query is read, so a query does not depend on
+        // the size of the log.
+        class Tail {
+        private:
+            struct Entry {
+                uint32_t Time;
+                uint64_t Jiffies;
+                std::vector<std::pair<string, ResourceLog::Parser::Process>> Processes;
+            };
+
+        public:
+            Tail() = delete;
+            Tail(const Tail&) = delete;
+            Tail& operator=(const Tail&) = delete;
+
+            Tail(const string& path, const uint16_t samples)
+                : _adminLock()
+                , _path(path)
+                , _parser()
+                , _offset(0)
+                , _ring(std::max(samples, static_cast<uint16_t>(1)))
+                , _next(0)
+                , _count(0)
+            {
+            }
+            ~Tail()
+            {
+            }
+
+        public:
+            // Oldest first, at most count (0 is all) of them.
+            void Samples(const uint16_t count, Core::JSON::ArrayType<SamplesData::SampleData>& response)
+            {
+                _adminLock.Lock();
+
+                Update();
+
+                const uint32_t length = ((count == 0) || (count > _count) ? _count : count);
+                uint32_t index = (_next + _ring.size() - length) % _ring.size();
+
+                for (uint32_t loop = 0; loop < length; loop++, index = (index + 1) % _ring.size()) {
+                    const Entry& entry(_ring[index]);
+                    SamplesData::SampleData& sample(response.Add());
+
+                    sample.Time = entry.Time;
+                    sample.Jiffies = entry.Jiffies;
+
+                    for (const std::pair<string, ResourceLog::Parser::Process>& process : entry.Processes) {
+                        SamplesData::ProcessData& element(sample.Processes.Add());
+
+                        element.Name = process.first;
+                        element.Vss = process.second.VSS;
+                        element.Uss = process.second.USS;
+                        element.Jiffies = process.second.Jiffies;
+                    }
+                }
+
+                _adminLock.Unlock();
+            }
+
+        private:
+            void Update()
+            {
+                ResourceLog::FileHeader header;
+                FILE* file = fopen(_path.c_str(), "rb");
+
+                if ((file != nullptr) && (fread(&header, 1, sizeof(header), file) == sizeof(header))) {
+                    fseek(file, 0, SEEK_END);
+                    const long size = ftell(file);
+
+                    const bool other = ((header.Run != _parser.Run()) || (header.Sequence != _parser.Sequence()));
+
+                    if ((_offset == 0) || (other == true) || (size < static_cast<long>(_offset)) || (_parser.IsValid() == false)) {
+                        // The log was rotated, pick up what was still written to the previous file.
+                        if ((_offset != 0) && (other == true) && (_parser.IsValid() == true)) {
+                            FILE* previous = fopen((_path + _T(".1")).c_str(), "rb");
+
+                            if (previous != nullptr) {
+                                ResourceLog::FileHeader older;
+
+                                if ((fread(&older, 1, sizeof(older), previous) == sizeof(older)) && (older.Run == _parser.Run()) && (older.Sequence == _parser.Sequence())) {
+                                    Read(previous);
+                                }
+                                fclose(previous);
+                            }
+                        }
+
+                        // Lost track of the file we were reading, start over with what is in there now.
+                        if ((_offset != 0) && ((other == false) || (_parser.IsValid() == false))) {
+                            _next = 0;
+                            _count = 0;
+                        }
+
+                        _offset = _parser.Header(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+                    }
+
+                    Read(file);
+                }
+
+                if (file != nullptr) {
+                    fclose(file);
+                }
+            }
+            void Read(FILE* file)
+            {
+                std::vector<uint8_t> data;
+
+                if (fseek(file, _offset, SEEK_SET) == 0) {
+                    uint8_t buffer[4096];
+                    size_t length;
+
+                    while ((length = fread(buffer, 1, sizeof(buffer), file)) != 0) {
+                        data.insert(data.end(), buffer, buffer + length);
+                    }
+                }
+
+                _offset += _parser.Parse(data.data(), data.size(), [this](const ResourceLog::Parser::Sample& sample) {
+                    Entry& entry(_ring[_next]);
+
+                    entry.Time = sample.Time;
+                    entry.Jiffies = sample.Jiffies;
+                    entry.Processes.clear();
+
+                    for (const ResourceLog::Parser::Process& process : sample.Processes) {
+                        entry.Processes.emplace_back(_parser.Name(process.Id), process);
+                    }
+
+                    _next = (_next + 1) % _ring.size();
+                    _count = std::min(_count + 1, static_cast<uint32_t>(_ring.size()));
+                });
+            }
+
+        private:
+            Core::CriticalSection _adminLock;
+            const string _path;
+            ResourceLog::Parser _parser;
+            uint32_t _offset; // Read up to here in the file with the sequence of the parser.
+            std::vector<Entry> _ring;
+            uint32_t _next;
+            uint32_t _count;
         };
 
     public:
@@ -36,12 +316,14 @@ namespace Plugin {
             : _service(nullptr)
             , _monitor(nullptr)
             , _connectionId(0)
+            , _tail(nullptr)
         {
-
+            RegisterAll();
         }
 
         virtual ~ResourceMonitor()
         {
+            UnregisterAll();
         }
 
         void Inbound(Web::Request& request) override
@@ -80,6 +362,7 @@ namespace Plugin {
         BEGIN_INTERFACE_MAP(ResourceMonitor)
         INTERFACE_ENTRY(IPlugin)
         INTERFACE_ENTRY(PluginHost::IWeb)
+        INTERFACE_ENTRY(PluginHost::IDispatcher)
         INTERFACE_AGGREGATE(Exchange::IResourceMonitor, _monitor)
         END_INTERFACE_MAP
 
@@ -88,10 +371,16 @@ namespace Plugin {
         void Deinitialize(PluginHost::IShell* service) override;
         string Information() const override;
 
+    private:
+        void RegisterAll();
+        void UnregisterAll();
+        uint32_t endpoint_samples(const SamplesParams& params, SamplesData& response);
+
     private:
         PluginHost::IShell* _service;
         Exchange::IResourceMonitor* _monitor;
         uint32_t _connectionId;
+        Tail* _tail;
         static Core::ProxyPoolType<Web::TextBody> webBodyFactory;
         uint32_t _skipURL;
     };
@@ -1,7 +1,11 @@
 #include "Module.h"
+#include "PageMap.h"
+#include "ResourceLogFormat.h"
 #include <core/ProcessInfo.h>
 #include <interfaces/IMemory.h>
 #include <interfaces/IResourceMonitor.h>
+#include <algorithm>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -37,11 +41,15 @@ namespace Plugin {
              , Interval()
              , Mode()
              , ParentName()
+             , FileSize(1024)
+             , Files(2)
          {
             Add(_T("path"), &Path);
             Add(_T("interval"), &Interval);
             Add(_T("mode"), &Mode);
             Add(_T("parent-name"), &ParentName);
+            Add(_T("filesize"), &FileSize);
+            Add(_T("files"), &Files);
          }
          Config(const Config& copy)
              : Core::JSON::Container()
@@ -49,11 +57,15 @@ namespace Plugin {
              , Interval(copy.Interval)
              , Mode(copy.Mode)
              , ParentName(copy.ParentName)
+             , FileSize(copy.FileSize)
+             , Files(copy.Files)
          {
             Add(_T("path"), &Path);
             Add(_T("interval"), &Interval);
             Add(_T("mode"), &Mode);
             Add(_T("parent-name"), &ParentName);
+            Add(_T("filesize"), &FileSize);
+            Add(_T("files"), &Files);
          }
          ~Config()
          {
@@ -81,25 +93,219 @@ namespace Plugin {
          Core::JSON::DecUInt32 Interval;
          Core::JSON::String Mode;
          Core::JSON::String ParentName;
+         Core::JSON::DecUInt32 FileSize; // KB, a new log file is started once this size is reached.
+         Core::JSON::DecUInt8 Files; // Number of log files kept, including the one being written.
+      };
+
+      // Writes the measurements in the format described in ResourceLogFormat.h. A whole interval is
+      // written with a single fwrite, once the current file would grow beyond its size it is rotated.
+      class Recorder {
+      private:
+         Recorder(const Recorder&) = delete;
+         Recorder& operator=(const Recorder&) = delete;
+
+      public:
+         Recorder(const string& path, const uint32_t fileSize, const uint8_t files)
+             : _path(path)
+             , _size(fileSize)
+             , _files(files)
+             , _file(nullptr)
+             , _written(0)
+             , _run(static_cast<uint32_t>(Core::Time::Now().Ticks() / 1000 / 1000))
+             , _sequence(0)
+             , _time(0)
+             , _ids()
+             , _previous()
+             , _record()
+             , _header()
+             , _entries()
+             , _names()
+         {
+            ASSERT(_files > 0);
+
+            // Keep what a previous run left behind, it moves up like any rotated file.
+            Shift();
+
+            Open();
+         }
+         ~Recorder()
+         {
+            if (_file != nullptr) {
+               fclose(_file);
+            }
+         }
+
+      public:
+         static string FileName(const string& path, const uint8_t index)
+         {
+            return (index == 0 ? path : path + '.' + std::to_string(index));
+         }
+
+         void Start(const uint32_t time, const uint64_t jiffies)
+         {
+            _header.Type = ResourceLog::SAMPLE;
+            _header.Time = time;
+            _header.Jiffies = jiffies;
+            _entries.clear();
+            _names.clear();
+         }
+         void Add(const string& name, const uint32_t vss, const uint32_t uss, const uint64_t jiffies)
+         {
+            _names.push_back(name);
+            _entries.push_back({ 0, vss, uss, jiffies });
+         }
+         void Commit()
+         {
+            if (_file != nullptr) {
+               uint32_t size = sizeof(ResourceLog::SampleHeader) + (_entries.size() * sizeof(ResourceLog::ProcessSample));
+
+               for (const string& name : _names) {
+                  if (_ids.find(name) == _ids.end()) {
+                     size += sizeof(ResourceLog::NameHeader) + name.length();
+                  }
+               }
+
+               if (((_written + size) > _size) && (_written > sizeof(ResourceLog::FileHeader))) {
+                  Rotate();
+               }
+
+               if (_file != nullptr) {
+                  Encode();
+
+                  fwrite(_record.data(), 1, _record.size(), _file);
+                  fflush(_file);
+
+                  _written += _record.size();
+               }
+            }
+         }
+
+      private:
+         void Encode()
+         {
+            _record.clear();
+
+            for (uint16_t index = 0; index < _entries.size(); index++) {
+               std::map<string, uint16_t>::iterator id(_ids.find(_names[index]));
+
+               if (id == _ids.end()) {
+                  const string& name(_names[index]);
+                  ResourceLog::NameHeader header = { ResourceLog::NAME, static_cast<uint16_t>(_previous.size()), static_cast<uint16_t>(name.length()) };
+
+                  id = _ids.emplace(name, header.Id).first;
+                  _previous.push_back({ header.Id, 0, 0, 0 });
+
+                  Append(&header, sizeof(header));
+                  Append(name.c_str(), name.length());
+               }
+
+               ResourceLog::ProcessSample& entry(_entries[index]);
+               ResourceLog::ProcessSample& previous(_previous[id->second]);
+               ResourceLog::ProcessSample delta = { id->second, entry.VSS - previous.VSS, entry.USS - previous.USS, entry.Jiffies - previous.Jiffies };
+
+               previous = entry;
+               entry = delta;
+            }
+
+            const uint32_t time = _header.Time;
+            _header.Time = time - _time;
+            _header.Count = static_cast<uint16_t>(_entries.size());
+            _time = time;
+
+            Append(&_header, sizeof(_header));
+            Append(_entries.data(), _entries.size() * sizeof(ResourceLog::ProcessSample));
+         }
+         inline void Append(const void* data, const size_t length)
+         {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            _record.insert(_record.end(), bytes, bytes + length);
+         }
+         void Open()
+         {
+            _file = fopen(_path.c_str(), "w");
+
+            if (_file == nullptr) {
+               TRACE_L1("Could not open the resource log %s", _path.c_str());
+            } else {
+               ResourceLog::FileHeader header = { ResourceLog::Magic, ResourceLog::Version, 0, _run, ++_sequence };
+
+               fwrite(&header, 1, sizeof(header), _file);
+               fflush(_file);
+            }
+
+            _written = sizeof(ResourceLog::FileHeader);
+            _time = 0;
+            _ids.clear();
+            _previous.clear();
+         }
+         void Shift()
+         {
+            for (uint8_t index = _files - 1; index > 0; index--) {
+               ::rename(FileName(_path, index - 1).c_str(), FileName(_path, index).c_str());
+            }
+         }
+         void Rotate()
+         {
+            fclose(_file);
+
+            Shift();
+
+            Open();
+         }
+
+      private:
+         const string _path;
+         const uint32_t _size;
+         const uint8_t _files;
+         FILE* _file;
+         uint32_t _written;
+         const uint32_t _run;
+         uint32_t _sequence;
+         uint32_t _time; // Of the previous sample in this file.
+         std::map<string, uint16_t> _ids; // Names written to this file.
+         vector<ResourceLog::ProcessSample> _previous; // Last values written, by id.
+         vector<uint8_t> _record;
+         ResourceLog::SampleHeader _header;
+         vector<ResourceLog::ProcessSample> _entries;
+         vector<string> _names;
       };
 
       class StatCollecter {
+      private:
+         // A tracked group of processes, logged as one entry.
+         struct Group {
+            Group(const string& name, const Core::ProcessInfo& info)
+                : Name(name)
+                , Info(info)
+                , Ids()
+            {
+            }
+
+            bool Contains(const ::ThreadId id) const
+            {
+               return (std::binary_search(Ids.cbegin(), Ids.cend(), id));
+            }
+
+            string Name;
+            Core::ProcessInfo Info;
+            vector<::ThreadId> Ids; // Sorted, all processes belonging to the group.
+         };
+
      public:
          explicit StatCollecter(const Config& config)
-             : _binFile(nullptr)
-             , _otherMap(nullptr)
-             , _ourMap(nullptr)
+             : _recorder(config.Path.Value(), std::max(config.FileSize.Value(), 1u) * 1024, std::max(config.Files.Value(), static_cast<uint8_t>(1)))
+             , _pageMaps()
+             , _outsideMap(nullptr)
+             , _scratchMap(nullptr)
              , _bufferEntries(0)
              , _interval(0)
              , _collectMode(Config::CollectMode::Invalid)
              , _activity(*this)
          {
-            _binFile = fopen(config.Path.Value().c_str(), "w");
-
             uint32_t pageCount = Core::SystemInfo::Instance().GetPhysicalPageCount();
-            const uint32_t bitPersUint32 = 32;
-            _bufferEntries = pageCount / bitPersUint32;
-            if ((pageCount % bitPersUint32) != 0) {
+            const uint32_t bitsPerUint64 = 64;
+            _bufferEntries = pageCount / bitsPerUint64;
+            if ((pageCount % bitsPerUint64) != 0) {
                _bufferEntries++;
             }
 
@@ -107,8 +313,8 @@ namespace Plugin {
             //    allocate a little extra to make sure we don't miss the highest ones.
             _bufferEntries += _bufferEntries / 10;
 
-            _ourMap = new uint32_t[_bufferEntries];
-            _otherMap = new uint32_t[_bufferEntries];
+            _outsideMap = new uint32_t[_bufferEntries * 2];
+            _scratchMap = new uint32_t[_bufferEntries * 2];
             _interval = config.Interval.Value();
             _collectMode = config.GetCollectMode();
             _parentName = config.ParentName.Value();
@@ -118,10 +324,8 @@ namespace Plugin {
 
          ~StatCollecter()
          {
-            fclose(_binFile);
-
-            delete [] _ourMap;
-            delete [] _otherMap;
+            delete [] _outsideMap;
+            delete [] _scratchMap;
          }
 
          void GetProcessNames(vector<string>& processNames)
@@ -132,235 +336,188 @@ namespace Plugin {
          }
 
       private:
-         // TODO: combine these "Collect*" methods
-         void CollectSingle()
+         void AddProcessName(const string& name)
          {
-            list<Core::ProcessInfo> processes;
-            Core::ProcessInfo::FindByName(_parentName, false, processes);
-
-            // TODO: check if only one, warning otherwise?
-            // TOOD: what if none found? will cause segfault when using .front() later on.
-            if (processes.empty()) {
-               TRACE_L1("Failed to find process %s", _parentName);
-               return;
-            }
-
-            if (processes.size() > 1) {
-               TRACE_L1("Found more than one process named %s, only tracking first", _parentName);
+            _namesLock.Lock();
+            if (std::find(_processNames.cbegin(), _processNames.cend(), name) == _processNames.cend()) {
+               _processNames.push_back(name);
             }
+            _namesLock.Unlock();
+         }
 
-            uint32_t mapBufferSize = sizeof(_ourMap[0]) * _bufferEntries;
-            memset(_ourMap, 0, mapBufferSize);
-            memset(_otherMap, 0, mapBufferSize);
+         static void AddProcessTree(Group& group, const ::ThreadId id)
+         {
+            Core::ProcessTree processTree(id);
 
-            vector<::ThreadId> processIds;
+            std::list<::ThreadId> processIds;
+            processTree.GetProcessIds(processIds);
+            group.Ids.insert(group.Ids.end(), processIds.begin(), processIds.end());
+         }
 
-            for (const Core::ProcessInfo& processInfo : processes) {
-               string processName = processInfo.Name();
+         void CollectSingle(vector<Group>& groups)
+         {
+            list<Core::ProcessInfo> processes;
+            Core::ProcessInfo::FindByName(_parentName, false, processes);
 
-               _namesLock.Lock();
-               if (find(_processNames.begin(), _processNames.end(), _parentName) == _processNames.end()) {
-                  _processNames.push_back(_parentName);
+            if (processes.empty()) {
+               TRACE_L1("Failed to find process %s", _parentName.c_str());
+            } else {
+               if (processes.size() > 1) {
+                  TRACE_L1("Found more than one process named %s, logging them as one", _parentName.c_str());
                }
-               _namesLock.Unlock();
-
-               Core::ProcessTree processTree(processInfo.Id());
 
-               processTree.MarkOccupiedPages(_ourMap, mapBufferSize);
+               AddProcessName(_parentName);
 
-               std::list<::ThreadId> addedProcessIds;
-               processTree.GetProcessIds(addedProcessIds);
-               processIds.insert(processIds.end(), addedProcessIds.begin(), addedProcessIds.end());
-            }
+               groups.emplace_back(_parentName, processes.front());
 
-            memset(_otherMap, 0, mapBufferSize);
-
-            // Find other processes
-            list<Core::ProcessInfo> otherProcesses;
-            Core::ProcessInfo::Iterator otherIterator;
-            while (otherIterator.Next()) {
-               ::ThreadId otherId = otherIterator.Current().Id();
-               if (find(processIds.begin(), processIds.end(), otherId) == processIds.end()) {
-                  otherIterator.Current().MarkOccupiedPages(_otherMap, mapBufferSize);
+               for (const Core::ProcessInfo& processInfo : processes) {
+                  AddProcessTree(groups.back(), processInfo.Id());
                }
             }
-
-            StartLogLine(1);
-            LogProcess(_parentName, processes.front());
          }
 
-         void CollectMultiple()
+         void CollectMultiple(vector<Group>& groups)
          {
             list<Core::ProcessInfo> processes;
             Core::ProcessInfo::FindByName(_parentName, false, processes);
 
-            StartLogLine(processes.size());
-
             for (const Core::ProcessInfo& processInfo : processes) {
-               uint32_t mapBufferSize = sizeof(_ourMap[0]) * _bufferEntries;
-               memset(_ourMap, 0, mapBufferSize);
-               memset(_otherMap, 0, mapBufferSize);
-
                string processName = processInfo.Name() + " (" + std::to_string(processInfo.Id()) + ")";
 
-               _namesLock.Lock();
-               if (find(_processNames.begin(), _processNames.end(), processName) == _processNames.end()) {
-                  _processNames.push_back(processName);
-               }
-               _namesLock.Unlock();
-
-               Core::ProcessTree processTree(processInfo.Id());
-
-               processTree.MarkOccupiedPages(_ourMap, mapBufferSize);
+               AddProcessName(processName);
 
-               list<Core::ProcessInfo> otherProcesses;
-               Core::ProcessInfo::Iterator otherIterator;
-               while (otherIterator.Next()) {
-                  ::ThreadId otherId = otherIterator.Current().Id();
-                  if (!processTree.ContainsProcess(otherId)) {
-                     otherIterator.Current().MarkOccupiedPages(_otherMap, mapBufferSize);
-                  }
-               }
-
-               LogProcess(processName, processInfo);
+               groups.emplace_back(processName, processInfo);
+               AddProcessTree(groups.back(), processInfo.Id());
             }
          }
 
-         void CollectWPEProcess(const string& argument)
+         void CollectWPEProcess(vector<Group>& groups, const string& argument)
          {
             const string processName = "WPEProcess-1.0.0";
 
             list<Core::ProcessInfo> processes;
             Core::ProcessInfo::FindByName(processName, false, processes);
 
-            vector<std::pair<Core::ProcessInfo, string> > processIds;
             for (const Core::ProcessInfo& processInfo : processes) {
                std::list<string> commandLine = processInfo.CommandLine();
 
-               bool shouldTrack = false;
-               string columnName;
-
                // Get callsign/classname
                std::list<string>::const_iterator i = std::find(commandLine.cbegin(), commandLine.cend(), argument);
-               if (i != commandLine.cend()) {
-                  i++;
-                  if (i != commandLine.cend()) {
-                     if (*i == _parentName) {
-                        columnName = _parentName + " (" + std::to_string(processInfo.Id()) + ")";
-                        processIds.push_back(std::pair<::ThreadId, string>(processInfo.Id(), columnName));
-                        shouldTrack = true;
-                     }
-                  }
-               }
+               if ((i != commandLine.cend()) && (++i != commandLine.cend()) && (*i == _parentName)) {
+                  string columnName = _parentName + " (" + std::to_string(processInfo.Id()) + ")";
 
-               if (!shouldTrack) {
-                  continue;
-               }
+                  AddProcessName(columnName);
 
-               _namesLock.Lock();
-               if (std::find(_processNames.cbegin(), _processNames.cend(), columnName) == _processNames.cend()) {
-                  _processNames.push_back(columnName);
+                  groups.emplace_back(columnName, processInfo);
+                  AddProcessTree(groups.back(), processInfo.Id());
                }
-               _namesLock.Unlock();
             }
+         }
+
+         // Reads the page map of every process on the system exactly once, and folds it into the maps
+         // of the groups. Processes outside all groups, by far the most, all end up in one shared map.
+         void Measure(vector<Group>& groups)
+         {
+            const uint32_t mapBufferSize = sizeof(_outsideMap[0]) * 2 * _bufferEntries;
+            const uint32_t groupCount = static_cast<uint32_t>(groups.size());
+
+            // Nothing to measure, the sample then only marks the interval.
+            if (groupCount > 0) {
+               for (Group& group : groups) {
+                  std::sort(group.Ids.begin(), group.Ids.end());
+                  group.Ids.erase(std::unique(group.Ids.begin(), group.Ids.end()), group.Ids.end());
+               }
+
+               // Per group, the pages it uses followed by the pages used by tracked processes outside of it.
+               _pageMaps.assign(static_cast<size_t>(groupCount) * 2 * _bufferEntries, 0);
+               memset(_outsideMap, 0, mapBufferSize);
 
-            StartLogLine(processIds.size());
-            for (std::pair<Core::ProcessInfo, string> processDesc : processIds) {
-               Core::ProcessTree tree(processDesc.first);
+               vector<bool> members(groupCount);
 
-               uint32_t mapBufferSize = sizeof(_ourMap[0]) * _bufferEntries;
-               memset(_ourMap, 0, mapBufferSize);
-               memset(_otherMap, 0, mapBufferSize);
+               Core::ProcessInfo::Iterator iterator;
+               while (iterator.Next()) {
+                  const Core::ProcessInfo process(iterator.Current());
+                  const ::ThreadId id = process.Id();
+                  bool tracked = false;
+
+                  for (uint32_t index = 0; index < groupCount; index++) {
+                     members[index] = groups[index].Contains(id);
+                     tracked = tracked || members[index];
+                  }
 
-               tree.MarkOccupiedPages(_ourMap, mapBufferSize);
+                  if (tracked == false) {
+                     process.MarkOccupiedPages(_outsideMap, mapBufferSize);
+                  } else {
+                     memset(_scratchMap, 0, mapBufferSize);
+                     process.MarkOccupiedPages(_scratchMap, mapBufferSize);
 
-               list<Core::ProcessInfo> otherProcesses;
-               Core::ProcessInfo::Iterator otherIterator;
-               while (otherIterator.Next()) {
-                  ::ThreadId otherId = otherIterator.Current().Id();
-                  if (!tree.ContainsProcess(otherId)) {
-                     otherIterator.Current().MarkOccupiedPages(_otherMap, mapBufferSize);
+                     for (uint32_t index = 0; index < groupCount; index++) {
+                        Pages::Merge(PageMap(index, members[index] ? 0 : 1), _scratchMap, _bufferEntries);
+                     }
                   }
                }
+            }
+
+            _recorder.Start(static_cast<uint32_t>(Core::Time::Now().Ticks() / 1000 / 1000), Core::SystemInfo::Instance().GetJiffies());
+
+            for (uint32_t index = 0; index < groupCount; index++) {
+               uint64_t* others = PageMap(index, 1);
+
+               Pages::Merge(others, _outsideMap, _bufferEntries);
 
-               LogProcess(processDesc.second, processDesc.first);
+               uint32_t vss = Pages::CountSetBits(PageMap(index, 0), nullptr, _bufferEntries);
+               uint32_t uss = Pages::CountSetBits(PageMap(index, 0), others, _bufferEntries);
+
+               _recorder.Add(groups[index].Name, vss, uss, groups[index].Info.Jiffies());
             }
+
+            _recorder.Commit();
          }
 
      protected:
          void Dispatch()
          {
+            vector<Group> groups;
+
             switch(_collectMode) {
                case Config::CollectMode::Single:
-                  CollectSingle();
+                  CollectSingle(groups);
                   break;
                case Config::CollectMode::Multiple: 
-                  CollectMultiple();
+                  CollectMultiple(groups);
                   break;
                case Config::CollectMode::Callsign: 
-                  CollectWPEProcess("-C");
+                  CollectWPEProcess(groups, "-C");
                   break;
                case Config::CollectMode::ClassName:
-                  CollectWPEProcess("-c");
+                  CollectWPEProcess(groups, "-c");
                   break;
                case Config::CollectMode::Invalid:
                   // TODO: ASSERT?
                   break;
             }
 
-            _activity.Schedule(Core::Time::Now().Add(_interval * 1000));
-         }
-
-    private:
-         uint32_t CountSetBits(uint32_t pageBuffer[], const uint32_t* inverseMask)
-         {
-            uint32_t count = 0;
-
-            if (inverseMask == nullptr) {
-               for (uint32_t index = 0; index < _bufferEntries; index++) {
-                  count += __builtin_popcount(pageBuffer[index]);
-               }
-            } else {
-               for (uint32_t index = 0; index < _bufferEntries; index++) {
-                  count += __builtin_popcount(pageBuffer[index] & (~inverseMask[index]));
-               }
+            // Single mode skips the interval if the process is not there, as it did before.
+            if ((groups.empty() == false) || (_collectMode != Config::CollectMode::Single)) {
+               Measure(groups);
             }
 
-            return count;
-         }
-
-         void LogProcess(const string& name, const Core::ProcessInfo& info)
-         {
-            uint32_t vss = CountSetBits(_ourMap, nullptr);
-            uint32_t uss = CountSetBits(_ourMap, _otherMap);
-            uint64_t jiffies = info.Jiffies();
-
-            uint32_t nameSize = name.length();
-            fwrite(&nameSize, sizeof(nameSize), 1, _binFile);
-            fwrite(name.c_str(), sizeof(name[0]), name.length(), _binFile);
-            fwrite(&vss, 1, sizeof(vss), _binFile);
-            fwrite(&uss, 1, sizeof(uss), _binFile);
-            fwrite(&jiffies, 1, sizeof(jiffies), _binFile);
-            fflush(_binFile);
+            _activity.Schedule(Core::Time::Now().Add(_interval * 1000));
          }
 
-         void StartLogLine(uint32_t processCount)
+    private:
+         inline uint64_t* PageMap(const uint32_t group, const uint8_t kind)
          {
-            // TODO: no simple time_t alike in Thunder?
-            uint32_t timestamp = static_cast<uint32_t>(Core::Time::Now().Ticks() / 1000 / 1000);
-            uint64_t jiffies = Core::SystemInfo::Instance().GetJiffies();
-
-            fwrite(&timestamp, 1, sizeof(timestamp), _binFile);
-            fwrite(&processCount, 1, sizeof(processCount), _binFile);
-            fwrite(&jiffies, 1, sizeof(jiffies), _binFile);
+            return (&_pageMaps[((static_cast<size_t>(group) * 2) + kind) * _bufferEntries]);
          }
 
-         FILE *_binFile;
+         Recorder _recorder;
          vector<string> _processNames; // Seen process names.
          Core::CriticalSection _namesLock;
-         uint32_t * _otherMap; // Buffer used to mark other processes pages.
-         uint32_t * _ourMap;   // Buffer for pages used by our process (tree).
-         uint32_t _bufferEntries; // Numer of entries in each buffer.
+         vector<uint64_t> _pageMaps; // Two page bitmaps per group: its own pages, pages of tracked processes outside it.
+         uint32_t * _outsideMap; // Pages used by processes not in any group.
+         uint32_t * _scratchMap; // Pages of the tracked process being read.
+         uint32_t _bufferEntries; // Number of 64 bit words in each buffer, these two have twice as many 32 bit ones.
          uint32_t _interval; // Seconds between measurement.
          Config::CollectMode _collectMode; // Collection style.
          string _parentName; // Process/plugin name we are looking for.
@@ -373,10 +530,29 @@ namespace Plugin {
       ResourceMonitorImplementation(const ResourceMonitorImplementation&) = delete;
       ResourceMonitorImplementation& operator=(const ResourceMonitorImplementation&) = delete;
 
+      static bool Load(const string& fileName, vector<uint8_t>& data)
+      {
+         FILE* inFile = fopen(fileName.c_str(), "rb");
+
+         if (inFile != nullptr) {
+            uint8_t buffer[4096];
+            size_t readCount;
+
+            while ((readCount = fread(buffer, 1, sizeof(buffer), inFile)) != 0) {
+               data.insert(data.end(), buffer, buffer + readCount);
+            }
+
+            fclose(inFile);
+         }
+
+         return (inFile != nullptr);
+      }
+
   public:
       ResourceMonitorImplementation()
           : _processThread(nullptr)
           , _binPath(_T("/tmp/resource-log.bin"))
+          , _files(1)
       {
       }
 
@@ -399,6 +575,8 @@ namespace Plugin {
 
          result = Core::ERROR_NONE;
 
+         _binPath = config.Path.Value();
+         _files = std::max(config.Files.Value(), static_cast<uint8_t>(1));
          _processThread = new StatCollecter(config);
 
          return (result);
@@ -407,7 +585,6 @@ namespace Plugin {
       string CompileMemoryCsv() override
       {
          // TODO: should we worry about doing this as repsonse to RPC (could take too long?)
-         FILE* inFile = fopen(_binPath.c_str(), "rb");
          stringstream output;
 
          vector<string> processNames;
@@ -423,63 +600,43 @@ namespace Plugin {
          bool seenFirstTimestamp = false;
          uint32_t firstTimestamp = 0;
 
-         while (true) {
-            std::fill(pageVector.begin(), pageVector.end(), 0);
-
-            uint32_t timestamp = 0;
-            size_t readCount = fread(&timestamp, sizeof(timestamp), 1, inFile);
-            if (readCount != 1) {
-               break;
-            }
-
-            if (!seenFirstTimestamp) {
-               firstTimestamp = timestamp;
-               seenFirstTimestamp = true;
-            }
-
-            uint32_t processCount = 0;
-            fread(&processCount, sizeof(processCount), 1, inFile);
-
-            uint64_t totalJiffies = 0;
-            fread(&totalJiffies, sizeof(totalJiffies), 1, inFile);
+         // Oldest file first, rotated files carry the higher index.
+         for (uint8_t index = _files; index > 0; index--) {
+            vector<uint8_t> data;
+            ResourceLog::Parser parser;
 
-            for (uint32_t processIndex = 0; processIndex < processCount; processIndex++) {
-               uint32_t nameLength = 0;
-               fread(&nameLength, sizeof(nameLength), 1, inFile);
-               // TODO: unicode?
-               char nameBuffer[nameLength + 1];
-               fread(nameBuffer, sizeof(char), nameLength, inFile);
+            if (Load(Recorder::FileName(_binPath, index - 1), data) == true) {
+               size_t offset = parser.Header(data.data(), data.size());
 
-               nameBuffer[nameLength] = '\0';
-               string name(nameBuffer);
+               parser.Parse(data.data() + offset, data.size() - offset, [&](const ResourceLog::Parser::Sample& sample) {
+                  std::fill(pageVector.begin(), pageVector.end(), 0);
 
-               vector<string>::const_iterator nameIterator = std::find(processNames.cbegin(), processNames.cend(), name);
+                  if (!seenFirstTimestamp) {
+                     firstTimestamp = sample.Time;
+                     seenFirstTimestamp = true;
+                  }
 
-               uint32_t vss, uss;
-               uint64_t jiffies;
-               fread(&vss, sizeof(vss), 1, inFile);
-               fread(&uss, sizeof(uss), 1, inFile);
-               fread(&jiffies, sizeof(jiffies), 1, inFile);
-               if (nameIterator == processNames.cend()) {
-                   continue;
-               }
+                  for (const ResourceLog::Parser::Process& process : sample.Processes) {
+                     vector<string>::const_iterator nameIterator = std::find(processNames.cbegin(), processNames.cend(), parser.Name(process.Id));
 
-               int index = nameIterator - processNames.cbegin();
+                     if (nameIterator != processNames.cend()) {
+                        int position = nameIterator - processNames.cbegin();
 
-               pageVector[index * 3] = static_cast<uint64_t>(vss);
-               pageVector[index * 3 + 1] = static_cast<uint64_t>(uss);
-               pageVector[index * 3 + 2] = jiffies;
-            }
+                        pageVector[position * 3] = process.VSS;
+                        pageVector[position * 3 + 1] = process.USS;
+                        pageVector[position * 3 + 2] = process.Jiffies;
+                     }
+                  }
 
-            output << (timestamp - firstTimestamp) << "\t" << totalJiffies;
-            for (uint32_t pageEntry : pageVector) {
-               output << "\t" << pageEntry;
+                  output << (sample.Time - firstTimestamp) << "\t" << sample.Jiffies;
+                  for (uint64_t pageEntry : pageVector) {
+                     output << "\t" << pageEntry;
+                  }
+                  output << endl;
+               });
             }
-            output << endl;
          }
 
-         fclose(inFile);
-
          return output.str();
       }
 
@@ -490,6 +647,7 @@ namespace Plugin {
   private:
       StatCollecter* _processThread;
       string _binPath;
+      uint8_t _files;
    };
 
    SERVICE_REGISTRATION(ResourceMonitorImplementation, 1, 0);
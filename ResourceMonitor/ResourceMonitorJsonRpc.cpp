@@ -0,0 +1,60 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Module.h"
+#include "ResourceMonitor.h"
+
+namespace WPEFramework {
+
+namespace Plugin {
+
+    // Registration
+    //
+
+    void ResourceMonitor::RegisterAll()
+    {
+        Register<SamplesParams,SamplesData>(_T("samples"), &ResourceMonitor::endpoint_samples, this);
+    }
+
+    void ResourceMonitor::UnregisterAll()
+    {
+        Unregister(_T("samples"));
+    }
+
+    // API implementation
+    //
+
+    // Method: samples - The most recent samples of the resource log, oldest first
+    // Return codes:
+    //  - ERROR_NONE: Success
+    //  - ERROR_UNAVAILABLE: The plugin is not activated
+    uint32_t ResourceMonitor::endpoint_samples(const SamplesParams& params, SamplesData& response)
+    {
+        uint32_t result = Core::ERROR_UNAVAILABLE;
+
+        if (_tail != nullptr) {
+            _tail->Samples(params.Count.Value(), response.Samples);
+            result = Core::ERROR_NONE;
+        }
+
+        return (result);
+    }
+
+} // namespace Plugin
+}
@@ -0,0 +1,251 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures one ResourceMonitor interval on a synthetic system: every process has a page bitmap, a few
+// groups of processes are tracked. "per group" is how the monitor used to work, every group reads the
+// page map of every process on the system again. "single pass" is how it works now, every page map is
+// read once and folded into the group maps with Pages::Merge, and counted with Pages::CountSetBits.
+// Reading a page map (MarkOccupiedPages) is simulated by OR'ing a prepared bitmap, on a real system it
+// is a read of /proc/<pid>/pagemap and far more expensive, so the number of reads matters most.
+//
+// usage: pagemapbenchmark [processes [groups [pages]]]
+
+#include "PageMap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+struct System {
+    uint32_t Words32; // Per bitmap, in 32 bit words.
+    std::vector<std::vector<uint32_t>> Maps; // Per process.
+    std::vector<std::vector<uint32_t>> Groups; // Process indexes per group.
+};
+
+// Every process maps part of a shared region (libraries) and some private pages.
+System Create(const uint32_t processes, const uint32_t groups, const uint32_t pages)
+{
+    System system;
+    std::mt19937 random(42);
+    const uint32_t shared = pages / 8;
+
+    system.Words32 = ((pages + 63) / 64) * 2;
+    system.Maps.assign(processes, std::vector<uint32_t>(system.Words32, 0));
+
+    for (std::vector<uint32_t>& map : system.Maps) {
+        for (uint32_t count = 0; count < (shared / 2); count++) {
+            const uint32_t page = random() % shared;
+            map[page / 32] |= (1u << (page % 32));
+        }
+        for (uint32_t count = 0; count < (pages / processes); count++) {
+            const uint32_t page = shared + (random() % (pages - shared));
+            map[page / 32] |= (1u << (page % 32));
+        }
+    }
+
+    // Three processes per group, the first ones.
+    for (uint32_t group = 0; group < groups; group++) {
+        system.Groups.emplace_back();
+        for (uint32_t member = 0; (member < 3) && (((group * 3) + member) < processes); member++) {
+            system.Groups.back().push_back((group * 3) + member);
+        }
+    }
+
+    return (system);
+}
+
+void Mark(const System& system, const uint32_t process, uint32_t target[], uint32_t& reads)
+{
+    const std::vector<uint32_t>& map(system.Maps[process]);
+
+    for (uint32_t index = 0; index < system.Words32; index++) {
+        target[index] |= map[index];
+    }
+    reads++;
+}
+
+bool Member(const std::vector<uint32_t>& group, const uint32_t process)
+{
+    bool result = false;
+    for (const uint32_t entry : group) {
+        result = result || (entry == process);
+    }
+    return (result);
+}
+
+// As the monitor counted before: 32 bit words, one accumulator.
+uint32_t CountSetBits32(const uint32_t pageBuffer[], const uint32_t* inverseMask, const uint32_t words)
+{
+    uint32_t count = 0;
+
+    for (uint32_t index = 0; index < words; index++) {
+        count += __builtin_popcount(inverseMask == nullptr ? pageBuffer[index] : (pageBuffer[index] & ~inverseMask[index]));
+    }
+
+    return (count);
+}
+
+void PerGroup(const System& system, std::vector<uint32_t>& results, uint32_t& reads)
+{
+    std::vector<uint32_t> ours(system.Words32);
+    std::vector<uint32_t> others(system.Words32);
+
+    for (const std::vector<uint32_t>& group : system.Groups) {
+        std::fill(ours.begin(), ours.end(), 0);
+        std::fill(others.begin(), others.end(), 0);
+
+        for (uint32_t process = 0; process < system.Maps.size(); process++) {
+            Mark(system, process, (Member(group, process) ? ours.data() : others.data()), reads);
+        }
+
+        results.push_back(CountSetBits32(ours.data(), nullptr, system.Words32));
+        results.push_back(CountSetBits32(ours.data(), others.data(), system.Words32));
+    }
+}
+
+void SinglePass(const System& system, std::vector<uint32_t>& results, uint32_t& reads)
+{
+    const uint32_t words = system.Words32 / 2;
+    const uint32_t groups = static_cast<uint32_t>(system.Groups.size());
+    std::vector<uint64_t> maps(static_cast<size_t>(groups) * 2 * words, 0);
+    std::vector<uint32_t> outside(system.Words32, 0);
+    std::vector<uint32_t> scratch(system.Words32);
+
+    for (uint32_t process = 0; process < system.Maps.size(); process++) {
+        bool tracked = false;
+
+        for (const std::vector<uint32_t>& group : system.Groups) {
+            tracked = tracked || Member(group, process);
+        }
+
+        if (tracked == false) {
+            Mark(system, process, outside.data(), reads);
+        } else {
+            std::fill(scratch.begin(), scratch.end(), 0);
+            Mark(system, process, scratch.data(), reads);
+
+            for (uint32_t group = 0; group < groups; group++) {
+                const uint32_t kind = (Member(system.Groups[group], process) ? 0 : 1);
+                Pages::Merge(&maps[((group * 2) + kind) * words], scratch.data(), words);
+            }
+        }
+    }
+
+    for (uint32_t group = 0; group < groups; group++) {
+        uint64_t* ours = &maps[(group * 2) * words];
+        uint64_t* others = &maps[((group * 2) + 1) * words];
+
+        Pages::Merge(others, outside.data(), words);
+
+        results.push_back(Pages::CountSetBits(ours, nullptr, words));
+        results.push_back(Pages::CountSetBits(ours, others, words));
+    }
+}
+
+double Milliseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t processes = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200);
+    const uint32_t groups = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 4);
+    const uint32_t pages = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : (512 * 256)); // 512 MiB of 4 KiB pages
+    const uint32_t rounds = 10;
+
+    if ((processes == 0) || (pages < 64)) {
+        fprintf(stderr, "usage: %s [processes [groups [pages]]]\n", argv[0]);
+        return (1);
+    }
+
+    const System system(Create(processes, groups, pages));
+
+    printf("%u processes, %u groups, %u pages\n", processes, groups, pages);
+
+    std::vector<uint32_t> before;
+    std::vector<uint32_t> after;
+    uint32_t readsBefore = 0;
+    uint32_t readsAfter = 0;
+
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    for (uint32_t round = 0; round < rounds; round++) {
+        before.clear();
+        readsBefore = 0;
+        PerGroup(system, before, readsBefore);
+    }
+    const double perGroup = Milliseconds(start) / rounds;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        after.clear();
+        readsAfter = 0;
+        SinglePass(system, after, readsAfter);
+    }
+    const double singlePass = Milliseconds(start) / rounds;
+
+    printf("per group:   %8.3f ms per interval, %6u page map reads\n", perGroup, readsBefore);
+    printf("single pass: %8.3f ms per interval, %6u page map reads\n", singlePass, readsAfter);
+
+    if (before != after) {
+        fprintf(stderr, "The single pass counts differ from the per group ones.\n");
+        return (1);
+    }
+
+    // The counting alone, 32 bit words against Pages::CountSetBits.
+    const uint32_t words = system.Words32 / 2;
+    const uint32_t repeats = 2000;
+    std::vector<uint64_t> ours(words);
+    std::vector<uint64_t> others(words);
+    Pages::Merge(ours.data(), system.Maps[0].data(), words);
+    Pages::Merge(others.data(), system.Maps[1].data(), words);
+
+    volatile uint32_t sink = 0;
+    std::vector<uint32_t> ours32(system.Words32);
+    std::vector<uint32_t> others32(system.Words32);
+    memcpy(ours32.data(), ours.data(), words * sizeof(uint64_t));
+    memcpy(others32.data(), others.data(), words * sizeof(uint64_t));
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t repeat = 0; repeat < repeats; repeat++) {
+        sink = sink + CountSetBits32(ours32.data(), others32.data(), system.Words32);
+    }
+    const double count32 = Milliseconds(start) * 1000 / repeats;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t repeat = 0; repeat < repeats; repeat++) {
+        sink = sink + Pages::CountSetBits(ours.data(), others.data(), words);
+    }
+    const double count64 = Milliseconds(start) * 1000 / repeats;
+
+    printf("count, 32 bit words: %8.3f us per map\n", count32);
+    printf("count, 64 bit words: %8.3f us per map\n", count64);
+
+    return (0);
+}
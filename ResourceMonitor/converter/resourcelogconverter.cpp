@@ -0,0 +1,159 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Turns the binary resource log, written by the ResourceMonitor, into CSV on stdout.
+// Usage: resourcelogconverter <resource log file> [<resource log file> ...]
+// The files are converted in the order they were written, regardless of the order on the command line.
+
+#include "ResourceLogFormat.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+    struct File {
+        std::string Name;
+        uint32_t Run;
+        uint32_t Sequence;
+        std::vector<uint8_t> Data;
+    };
+
+    struct Row {
+        uint32_t Time;
+        uint64_t Jiffies;
+        std::map<uint32_t, ResourceLog::Parser::Process> Columns;
+    };
+
+    bool Load(const char name[], File& file)
+    {
+        bool result = false;
+        std::ifstream stream(name, std::ios::binary);
+
+        if (stream.is_open() == true) {
+            file.Name = name;
+            file.Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+            ResourceLog::FileHeader header;
+
+            if (file.Data.size() >= sizeof(header)) {
+                ::memcpy(&header, file.Data.data(), sizeof(header));
+
+                if ((header.Magic == ResourceLog::Magic) && (header.Version == ResourceLog::Version)) {
+                    file.Run = header.Run;
+                    file.Sequence = header.Sequence;
+                    result = true;
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    // Returns the number of samples converted. Columns are numbered in the order the names are first seen.
+    uint32_t Convert(const File& file, std::vector<std::string>& columns, std::vector<Row>& rows)
+    {
+        ResourceLog::Parser parser;
+        uint32_t samples = 0;
+        size_t offset = parser.Header(file.Data.data(), file.Data.size());
+
+        parser.Parse(file.Data.data() + offset, file.Data.size() - offset, [&](const ResourceLog::Parser::Sample& sample) {
+            Row row;
+            row.Time = sample.Time;
+            row.Jiffies = sample.Jiffies;
+
+            for (const ResourceLog::Parser::Process& process : sample.Processes) {
+                const std::string& name(parser.Name(process.Id));
+                std::vector<std::string>::const_iterator index = std::find(columns.cbegin(), columns.cend(), name);
+
+                if (index == columns.cend()) {
+                    index = columns.insert(columns.cend(), name);
+                }
+
+                row.Columns[static_cast<uint32_t>(index - columns.cbegin())] = process;
+            }
+
+            rows.push_back(std::move(row));
+            samples++;
+        });
+
+        return (samples);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<File> files;
+
+    for (int index = 1; index < argc; index++) {
+        File file;
+
+        if (Load(argv[index], file) == true) {
+            files.push_back(std::move(file));
+        } else {
+            fprintf(stderr, "Skipping %s, not a resource log file.\n", argv[index]);
+        }
+    }
+
+    if (files.empty() == true) {
+        fprintf(stderr, "Usage: %s <resource log file> [<resource log file> ...]\n", argv[0]);
+        return (1);
+    }
+
+    std::sort(files.begin(), files.end(), [](const File& lhs, const File& rhs) { return ((lhs.Run < rhs.Run) || ((lhs.Run == rhs.Run) && (lhs.Sequence < rhs.Sequence))); });
+
+    std::vector<std::string> columns;
+    std::vector<Row> rows;
+
+    for (const File& file : files) {
+        uint32_t samples = Convert(file, columns, rows);
+        fprintf(stderr, "%s: %u samples\n", file.Name.c_str(), samples);
+    }
+
+    printf("time (s),jiffies");
+    for (const std::string& column : columns) {
+        printf(",%s (VSS),%s (USS),%s (jiffies)", column.c_str(), column.c_str(), column.c_str());
+    }
+    printf("\n");
+
+    for (const Row& row : rows) {
+        printf("%u,%llu", row.Time - rows.front().Time, static_cast<unsigned long long>(row.Jiffies));
+
+        for (uint32_t column = 0; column < columns.size(); column++) {
+            std::map<uint32_t, ResourceLog::Parser::Process>::const_iterator entry = row.Columns.find(column);
+
+            if (entry == row.Columns.end()) {
+                printf(",,,");
+            } else {
+                printf(",%u,%u,%llu", entry->second.VSS, entry->second.USS, static_cast<unsigned long long>(entry->second.Jiffies));
+            }
+        }
+        printf("\n");
+    }
+
+    return (0);
+}
@@ -0,0 +1,194 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // The ACL only knows one wildcard, the '*'. Instead of translating every pattern into a
+    // std::regex and compiling it on each and every check, the pattern is broken up once, at
+    // load time, into literal fragments and character classes that can be matched in place.
+    class ACLPattern {
+    private:
+        enum class_type : uint8_t {
+            LITERAL,
+            IDENTIFIER, // [a-zA-Z0-9.]+
+            SCHEME,     // [a-z]+
+            PORT        // [0-9]+
+        };
+
+        struct Element {
+            Element(const class_type type, const std::string& text)
+                : Type(type)
+                , Text(text)
+            {
+            }
+
+            class_type Type;
+            std::string Text;
+        };
+
+    public:
+        ACLPattern() = delete;
+        ACLPattern& operator=(const ACLPattern&) = delete;
+
+        ACLPattern(const ACLPattern& copy)
+            : _anchored(copy._anchored)
+            , _elements(copy._elements)
+        {
+        }
+        ~ACLPattern()
+        {
+        }
+
+        // Callsign and method patterns: a pattern without a wildcard matches anywhere in
+        // the subject, a pattern with a wildcard has to match the subject as a whole.
+        static ACLPattern Identifier(const std::string& input)
+        {
+            ACLPattern result(input.find('*') != std::string::npos);
+            std::string literal;
+
+            for (const char entry : input) {
+                if (entry == '*') {
+                    result.Append(literal, IDENTIFIER);
+                } else {
+                    literal += entry;
+                }
+            }
+            result.Append(literal, LITERAL);
+
+            return (result);
+        }
+
+        // URL patterns: "*:" is a scheme, ":*" a port number and any other '*' a host
+        // name fragment. URL patterns match anywhere in the subject.
+        static ACLPattern URL(const std::string& input)
+        {
+            ACLPattern result(false);
+            std::string literal;
+
+            for (uint32_t index = 0; index < input.length(); index++) {
+                if (input[index] != '*') {
+                    literal += input[index];
+                } else if ((index > 0) && (input[index - 1] == ':')) {
+                    result.Append(literal, PORT);
+                } else if (((index + 1) < input.length()) && (input[index + 1] == ':')) {
+                    result.Append(literal, SCHEME);
+                } else {
+                    result.Append(literal, IDENTIFIER);
+                }
+            }
+            result.Append(literal, LITERAL);
+
+            return (result);
+        }
+
+    public:
+        bool Matches(const std::string& subject) const
+        {
+            bool found = Matches(subject, 0, 0);
+
+            if (_anchored == false) {
+                uint32_t offset = 1;
+                while ((found == false) && (offset < subject.length())) {
+                    found = Matches(subject, 0, offset);
+                    offset++;
+                }
+            }
+
+            return (found);
+        }
+
+    private:
+        ACLPattern(const bool anchored)
+            : _anchored(anchored)
+            , _elements()
+        {
+        }
+
+        void Append(std::string& literal, const class_type type)
+        {
+            if (literal.empty() == false) {
+                _elements.emplace_back(LITERAL, literal);
+                literal.clear();
+            }
+            if (type != LITERAL) {
+                _elements.emplace_back(type, std::string());
+            }
+        }
+        static bool InClass(const class_type type, const char entry)
+        {
+            bool result = false;
+
+            switch (type) {
+            case PORT:
+                result = ((entry >= '0') && (entry <= '9'));
+                break;
+            case SCHEME:
+                result = ((entry >= 'a') && (entry <= 'z'));
+                break;
+            case IDENTIFIER:
+                result = ((entry >= '0') && (entry <= '9')) || ((entry >= 'a') && (entry <= 'z')) || ((entry >= 'A') && (entry <= 'Z')) || (entry == '.');
+                break;
+            default:
+                break;
+            }
+            return (result);
+        }
+        bool Matches(const std::string& subject, const uint16_t element, const uint32_t offset) const
+        {
+            bool result = false;
+
+            if (element == _elements.size()) {
+                result = ((_anchored == false) || (offset == subject.length()));
+            } else {
+                const Element& current(_elements[element]);
+
+                if (current.Type == LITERAL) {
+                    result = (subject.compare(offset, current.Text.length(), current.Text) == 0) && Matches(subject, element + 1, static_cast<uint32_t>(offset + current.Text.length()));
+                } else {
+                    uint32_t end = offset;
+
+                    while ((end < subject.length()) && (InClass(current.Type, subject[end]) == true)) {
+                        end++;
+                    }
+
+                    // Greedy, at least one character, backtrack if the remainder does not fit.
+                    while ((end > offset) && (result == false)) {
+                        result = Matches(subject, element + 1, end);
+                        end--;
+                    }
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        bool _anchored;
+        std::vector<Element> _elements;
+    };
+}
+}
@@ -20,50 +20,7 @@
 #pragma once
 
 #include "Module.h"
-
-#include <regex>
-
-// helper functions
-namespace {
-    
-    void ReplaceString(string& subject, const string& search,const string& replace) 
-    {
-        size_t pos = 0;
-        while ((pos = subject.find(search, pos)) != string::npos) {
-             subject.replace(pos, search.length(), replace);
-             pos += replace.length();
-        }
-    }
-    
-    string CreateRegex(const string& input)
-    {
-        string regex = input;
-        
-        // order of replacing is important
-        ReplaceString(regex,"*","^[a-zA-Z0-9.]+$");
-        ReplaceString(regex,".","\\.");
-        
-        return regex;
-    }
-    
-    string CreateUrlRegex(const string& input)
-    {
-        string regex = input;
-        
-        // order of replacing is important
-        ReplaceString(regex,"/","\\/");
-        ReplaceString(regex,"[","\\[");
-        ReplaceString(regex,"]","\\]");
-        ReplaceString(regex,":*",":[0-9]+");
-        ReplaceString(regex,"*:","[a-z]+:");
-        ReplaceString(regex,".","\\.");
-        ReplaceString(regex,"*","[a-zA-Z0-9\\.]+");
-        regex.insert(regex.begin(),'(');
-        regex.insert(regex.end(),')');
-        
-        return regex;
-    }
-}
+#include "ACLPattern.h"
 
 namespace WPEFramework {
 namespace Plugin {
@@ -250,6 +207,8 @@ namespace Plugin {
         };
 
     public:
+        using Pattern = ACLPattern;
+
         class Filter {
         private:
             class Plugin {
@@ -258,39 +217,40 @@ namespace Plugin {
                 Plugin(const Plugin&) = delete;
                 Plugin& operator= (const Plugin&) = delete;
 
-                Plugin (const JSONACL::Plugins::Rules& rules)
-                    : _defaultBlocked(rules.Default.Value() == mode::BLOCKED) 
+                Plugin (const string& callsign, const JSONACL::Plugins::Rules& rules)
+                    : _callsign(Pattern::Identifier(callsign))
+                    , _defaultBlocked(rules.Default.Value() == mode::BLOCKED) 
                     , _methods() {
                     Core::JSON::ArrayType<Core::JSON::String>::ConstIterator index(rules.Methods.Elements());
                     while (index.Next() == true) {
-                        string str = index.Current().Value();
-                        _methods.emplace_back(CreateRegex(str));
+                        _methods.emplace_back(Pattern::Identifier(index.Current().Value()));
                     }
                 }
                 ~Plugin() {
                 }
 
             public:
+                inline bool Applies(const string& callsign) const
+                {
+                    return (_callsign.Matches(callsign));
+                }
                 bool Allowed(const string& method) const
                 {
                     bool found = false;
 
-                    std::list<string>::const_iterator index(_methods.begin());
+                    std::list<Pattern>::const_iterator index(_methods.begin());
 
                     while ((index != _methods.end()) && (found == false)) { 
-                        std::regex expression(index->c_str());
-                        std::smatch matchList;
-                        found = std::regex_search(method, matchList, expression);
-                        if (found == false) {
-                            index++;
-                        }
+                        found = index->Matches(method);
+                        index++;
                     }
                     return !(_defaultBlocked ^ found);
                 }
 
             private:
+                Pattern _callsign;
                 bool _defaultBlocked;
-                std::list<string> _methods;
+                std::list<Pattern> _methods;
             };
 
         public:
@@ -303,11 +263,18 @@ namespace Plugin {
                 , _plugins()
             {
                 JSONACL::Plugins::Iterator index(plugins.Elements());
-          
+                std::list<Plugin>::iterator generic(_plugins.end());
+
+                // Explicit callsigns are checked first, the wildcarded ones act as a fallback.
                 while (index.Next() == true) {
-                    _plugins.emplace(std::piecewise_construct,
-                            std::forward_as_tuple(CreateRegex(index.Key())),
-                            std::forward_as_tuple(index.Current()));
+                    if (index.Key().find('*') != string::npos) {
+                        _plugins.emplace_back(index.Key(), index.Current());
+                        if (generic == _plugins.end()) {
+                            generic = std::prev(_plugins.end());
+                        }
+                    } else {
+                        _plugins.emplace(generic, index.Key(), index.Current());
+                    }
                 }
             }
             ~Filter()
@@ -315,29 +282,23 @@ namespace Plugin {
             }
 
         public:
-            bool Allowed(const string callsign, const string& method) const
+            bool Allowed(const string& callsign, const string& method) const
             {
-                bool pluginFound = false;
-
-                std::map<string, Plugin>::const_iterator index(_plugins.begin());
-                while ((index != _plugins.end()) && (pluginFound == false)) {
-                    std::regex expression(index->first.c_str());
-                    std::smatch matchList;
-                    pluginFound = std::regex_search(callsign, matchList, expression);
-                    if (pluginFound == false) {
-                        index++;
-                    }
+                std::list<Plugin>::const_iterator index(_plugins.begin());
+
+                while ((index != _plugins.end()) && (index->Applies(callsign) == false)) {
+                    index++;
                 }
 
-                return (pluginFound == false ? !_defaultBlocked : index->second.Allowed(method));
+                return (index == _plugins.end() ? !_defaultBlocked : index->Allowed(method));
             }
 
         private:
             bool _defaultBlocked;
-            std::map<string, Plugin> _plugins;
+            std::list<Plugin> _plugins;
         };
 
-        using URLList = std::list<std::pair<string, Filter&>>;
+        using URLList = std::list<std::pair<Pattern, Filter&>>;
         using Iterator = Core::IteratorType<const std::list<string>, const string&, std::list<string>::const_iterator>;
 
     public:
@@ -374,16 +335,10 @@ namespace Plugin {
         const Filter* FilterMapFromURL(const string& URL) const
         {
             const Filter* result = nullptr;
-            std::smatch matchList;
             URLList::const_iterator index = _urlMap.begin();
 
             while ((index != _urlMap.end()) && (result == nullptr)) {
-                // regex_search() for searching the regex pattern
-                // 'r' in the string 's'. 'm' is flag for determining
-                // matching behavior.
-                std::regex expression(index->first.c_str());
-
-                if (std::regex_search(URL, matchList, expression) == true) {
+                if (index->first.Matches(URL) == true) {
                     result = &(index->second);
                 }
                 else {
@@ -432,12 +387,9 @@ namespace Plugin {
                     }
                 } else {
                     Filter& entry(selectedFilter->second);
-                    
-                    // create regex for url
-                    string url_regex = CreateUrlRegex(index.Current().URL.Value());
-                    
-                    _urlMap.emplace_back(std::pair<string, Filter&>(
-                        url_regex, entry));
+
+                    _urlMap.emplace_back(std::pair<Pattern, Filter&>(
+                        Pattern::URL(index.Current().URL.Value()), entry));
 
                     std::list<string>::iterator found = std::find(_unusedRoles.begin(), _unusedRoles.end(), role);
 
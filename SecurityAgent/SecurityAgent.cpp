@@ -74,18 +74,27 @@ namespace Plugin {
         }
     }
 
-    SecurityAgent::SecurityAgent() : _dispatcher(nullptr)
+    SecurityAgent::SecurityAgent()
+        : _tokenLock()
+        , _webToken(nullptr)
+        , _cache(0, 0)
+        , _dispatcher(nullptr)
     {
         RegisterAll();
 
         for (uint8_t index = 0; index < sizeof(_secretKey); index++) {
             Crypto::Random(_secretKey[index]);
         }
+
+        // The key never changes, so one token coder can serve all signing and validation requests.
+        _webToken = new Web::JSONWebToken(Web::JSONWebToken::SHA256, sizeof(_secretKey), _secretKey);
     }
 
     /* virtual */ SecurityAgent::~SecurityAgent()
     {
         UnregisterAll();
+
+        delete _webToken;
     }
 
     /* virtual */ const string SecurityAgent::Initialize(PluginHost::IShell* service)
@@ -100,6 +109,9 @@ namespace Plugin {
         if (aclFile.Exists() == false) {
             aclFile = service->DataPath() + config.ACL.Value();
         }
+        // Cached security contexts refer to the ACL they were created with.
+        _cache.Configure(config.CacheSize.Value(), config.CacheLifetime.Value());
+
         if ((aclFile.Exists() == true) && (aclFile.Open(true) == true)) {
 
             if (_acl.Load(aclFile) == Core::ERROR_INCOMPLETE_CONFIG) {
@@ -155,6 +167,7 @@ namespace Plugin {
             subSystem->Set(PluginHost::ISubSystem::NOT_SECURITY, nullptr);
             subSystem->Release();
         }
+        _cache.Clear();
         _acl.Clear();
     }
 
@@ -167,33 +180,62 @@ namespace Plugin {
     /* virtual */ uint32_t SecurityAgent::CreateToken(const uint16_t length, const uint8_t buffer[], string& token)
     {
         // Generate the token from the buffer coming in...
-        Web::JSONWebToken newToken(Web::JSONWebToken::SHA256, sizeof(_secretKey), _secretKey);
+        _tokenLock.Lock();
 
-        return (newToken.Encode(token, length, buffer) > 0 ? Core::ERROR_NONE : Core::ERROR_UNAVAILABLE);
+        uint16_t encoded = _webToken->Encode(token, length, buffer);
+
+        _tokenLock.Unlock();
+
+        return (encoded > 0 ? Core::ERROR_NONE : Core::ERROR_UNAVAILABLE);
     }
 
     /* virtual */ PluginHost::ISecurity* SecurityAgent::Officer(const string& token)
     {
-        PluginHost::ISecurity* result = nullptr;
+        SecurityContext* result = _cache.Find(token);
+
+        if (result == nullptr) {
+            uint16_t load = PayloadLength(token);
 
-        Web::JSONWebToken webToken(Web::JSONWebToken::SHA256, sizeof(_secretKey), _secretKey);
-        uint16_t load = webToken.PayloadLength(token);
+            // Validate the token
+            if (load != static_cast<uint16_t>(~0)) {
+                // It is potentially a valid token, extract the payload.
+                uint8_t* payload = reinterpret_cast<uint8_t*>(ALLOCA(load));
 
-        // Validate the token
-        if (load != static_cast<uint16_t>(~0)) {
-            // It is potentially a valid token, extract the payload.
-            uint8_t* payload = reinterpret_cast<uint8_t*>(ALLOCA(load));
+                load = Decode(token, load, payload);
 
-            load = webToken.Decode(token, load, payload);
+                if (load != static_cast<uint16_t>(~0)) {
+                    // Seems like we extracted a valid payload, time to create an security context
+                    result = Core::Service<SecurityContext>::Create<SecurityContext>(&_acl, load, payload);
 
-            if (load != static_cast<uint16_t>(~0)) {
-                // Seems like we extracted a valid payload, time to create an security context
-                result = Core::Service<SecurityContext>::Create<SecurityContext>(&_acl, load, payload);
+                    _cache.Insert(token, result);
+                }
             }
         }
         return (result);
     }
 
+    uint16_t SecurityAgent::PayloadLength(const string& token) const
+    {
+        _tokenLock.Lock();
+
+        uint16_t result = _webToken->PayloadLength(token);
+
+        _tokenLock.Unlock();
+
+        return (result);
+    }
+
+    uint16_t SecurityAgent::Decode(const string& token, const uint16_t length, uint8_t payload[]) const
+    {
+        _tokenLock.Lock();
+
+        uint16_t result = _webToken->Decode(token, length, payload);
+
+        _tokenLock.Unlock();
+
+        return (result);
+    }
+
     /* virtual */ void SecurityAgent::Inbound(Web::Request& request)
     {
         request.Body(textFactory.Element());
@@ -238,16 +280,15 @@ namespace Plugin {
                 result->Message = _T("Missing token");
 
                 if (request.WebToken.IsSet()) {
-                    Web::JSONWebToken webToken(Web::JSONWebToken::SHA256, sizeof(_secretKey), _secretKey);
                     const string& token = request.WebToken.Value().Token();
-                    uint16_t load = webToken.PayloadLength(token);
+                    uint16_t load = PayloadLength(token);
 
                     // Validate the token
                     if (load != static_cast<uint16_t>(~0)) {
                         // It is potentially a valid token, extract the payload.
                         uint8_t* payload = reinterpret_cast<uint8_t*>(ALLOCA(load));
 
-                        load = webToken.Decode(token, load, payload);
+                        load = Decode(token, load, payload);
 
                         if (load == static_cast<uint16_t>(~0)) {
                             result->ErrorCode = Web::STATUS_FORBIDDEN;
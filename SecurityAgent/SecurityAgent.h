@@ -21,10 +21,13 @@
 
 #include "Module.h"
 #include "AccessControlList.h"
+#include "SecurityContext.h"
 #include <securityagent/IPCSecurityToken.h>
 
 #include <interfaces/json/JsonData_SecurityAgent.h>
 
+#include <unordered_map>
+
 namespace WPEFramework {
 namespace Plugin {
 
@@ -81,6 +84,145 @@ namespace Plugin {
             Core::IPCChannelClientType<Core::Void, true, true> _channel;
         };
 
+        // Web UI's reconnect frequently with the same tokens. Keep the SecurityContexts of recently
+        // validated tokens around, so the signature check and payload parsing is done only once.
+        class TokenCache {
+        private:
+            struct Entry {
+                SecurityContext* Context;
+                uint64_t Expiry;
+                std::list<string>::iterator Position;
+            };
+
+            using EntryMap = std::unordered_map<string, Entry>;
+
+        public:
+            TokenCache() = delete;
+            TokenCache(const TokenCache&) = delete;
+            TokenCache& operator=(const TokenCache&) = delete;
+
+            TokenCache(const uint16_t size, const uint32_t lifetime)
+                : _adminLock()
+                , _size(size)
+                , _lifetime(lifetime)
+                , _entries()
+                , _order()
+                , _hits(0)
+                , _misses(0)
+            {
+            }
+            ~TokenCache()
+            {
+                Clear();
+            }
+
+        public:
+            void Configure(const uint16_t size, const uint32_t lifetime)
+            {
+                Clear();
+
+                _adminLock.Lock();
+                _size = size;
+                _lifetime = lifetime;
+                _adminLock.Unlock();
+            }
+            // Returns an AddRef'ed context or nullptr if the token is unknown or expired.
+            SecurityContext* Find(const string& token)
+            {
+                SecurityContext* result = nullptr;
+
+                _adminLock.Lock();
+
+                EntryMap::iterator index(_entries.find(token));
+
+                if (index != _entries.end()) {
+                    if (index->second.Expiry > Core::Time::Now().Ticks()) {
+                        result = index->second.Context;
+                        result->AddRef();
+                        _order.splice(_order.begin(), _order, index->second.Position);
+                    } else {
+                        Remove(index);
+                    }
+                }
+
+                if (result != nullptr) {
+                    _hits++;
+                } else {
+                    _misses++;
+                }
+
+                _adminLock.Unlock();
+
+                return (result);
+            }
+            void Insert(const string& token, SecurityContext* context)
+            {
+                ASSERT(context != nullptr);
+
+                _adminLock.Lock();
+
+                if ((_size > 0) && (_entries.find(token) == _entries.end())) {
+                    uint64_t expiry = Core::Time::Now().Ticks() + (static_cast<uint64_t>(_lifetime) * Core::Time::TicksPerMillisecond * 1000);
+
+                    if ((context->Expiry() != 0) && (context->Expiry() < expiry)) {
+                        expiry = context->Expiry();
+                    }
+
+                    if (_entries.size() >= _size) {
+                        Remove(_entries.find(_order.back()));
+                    }
+
+                    _order.push_front(token);
+
+                    Entry& entry(_entries[token]);
+                    entry.Context = context;
+                    entry.Expiry = expiry;
+                    entry.Position = _order.begin();
+
+                    context->AddRef();
+                }
+
+                _adminLock.Unlock();
+            }
+            void Clear()
+            {
+                _adminLock.Lock();
+
+                for (std::pair<const string, Entry>& entry : _entries) {
+                    entry.second.Context->Release();
+                }
+                _entries.clear();
+                _order.clear();
+
+                _adminLock.Unlock();
+            }
+            void Statistics(uint32_t& entries, uint32_t& hits, uint32_t& misses) const
+            {
+                _adminLock.Lock();
+                entries = static_cast<uint32_t>(_entries.size());
+                hits = _hits;
+                misses = _misses;
+                _adminLock.Unlock();
+            }
+
+        private:
+            void Remove(EntryMap::iterator index)
+            {
+                index->second.Context->Release();
+                _order.erase(index->second.Position);
+                _entries.erase(index);
+            }
+
+        private:
+            mutable Core::CriticalSection _adminLock;
+            uint16_t _size;
+            uint32_t _lifetime;
+            EntryMap _entries;
+            std::list<string> _order;
+            uint32_t _hits;
+            uint32_t _misses;
+        };
+
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&) = delete;
@@ -91,9 +233,13 @@ namespace Plugin {
                 : Core::JSON::Container()
                 , ACL(_T("acl.json"))
                 , Connector()
+                , CacheSize(32)
+                , CacheLifetime(3600)
             {
                 Add(_T("acl"), &ACL);
                 Add(_T("connector"), &Connector);
+                Add(_T("cachesize"), &CacheSize);
+                Add(_T("cachelifetime"), &CacheLifetime);
             }
             ~Config()
             {
@@ -102,6 +248,34 @@ namespace Plugin {
         public:
             Core::JSON::String ACL;
             Core::JSON::String Connector;
+            Core::JSON::DecUInt16 CacheSize;
+            Core::JSON::DecUInt32 CacheLifetime;
+        };
+
+        class CacheData : public Core::JSON::Container {
+        private:
+            CacheData(const CacheData&) = delete;
+            CacheData& operator=(const CacheData&) = delete;
+
+        public:
+            CacheData()
+                : Core::JSON::Container()
+                , Entries(0)
+                , Hits(0)
+                , Misses(0)
+            {
+                Add(_T("entries"), &Entries);
+                Add(_T("hits"), &Hits);
+                Add(_T("misses"), &Misses);
+            }
+            ~CacheData()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Entries;
+            Core::JSON::DecUInt32 Hits;
+            Core::JSON::DecUInt32 Misses;
         };
 
     public:
@@ -156,10 +330,17 @@ namespace Plugin {
         uint32_t endpoint_createtoken(const JsonData::SecurityAgent::CreatetokenParamsData& params, JsonData::SecurityAgent::CreatetokenResultInfo& response);
         #endif // DEBUG
         uint32_t endpoint_validate(const JsonData::SecurityAgent::CreatetokenResultInfo& params, JsonData::SecurityAgent::ValidateResultData& response);
+        uint32_t get_cache(CacheData& response) const;
+
+        uint16_t PayloadLength(const string& token) const;
+        uint16_t Decode(const string& token, const uint16_t length, uint8_t payload[]) const;
 
 
     private:
         uint8_t _secretKey[Crypto::SHA256::Length];
+        mutable Core::CriticalSection _tokenLock;
+        Web::JSONWebToken* _webToken;
+        TokenCache _cache;
         AccessControlList _acl;
         uint8_t _skipURL;
         TokenDispatcher* _dispatcher;
@@ -37,10 +37,12 @@ namespace Plugin {
         #endif  
 
         Register<CreatetokenResultInfo,ValidateResultData>(_T("validate"), &SecurityAgent::endpoint_validate, this);
+        Property<CacheData>(_T("cache"), &SecurityAgent::get_cache, nullptr, this);
     }
 
     void SecurityAgent::UnregisterAll()
     {
+        Unregister(_T("cache"));
         Unregister(_T("validate"));
         #ifdef SECURITY_TESTING_MODE
         Unregister(_T("createtoken"));
@@ -81,15 +83,14 @@ namespace Plugin {
         const string& token = params.Token.Value();
         response.Valid = false;
 
-        Web::JSONWebToken webToken(Web::JSONWebToken::SHA256, sizeof(_secretKey), _secretKey);
-        uint16_t load = webToken.PayloadLength(token);
+        uint16_t load = PayloadLength(token);
 
         // Validate the token
         if (load != static_cast<uint16_t>(~0)) {
             // It is potentially a valid token, extract the payload.
             uint8_t* payload = reinterpret_cast<uint8_t*>(ALLOCA(load));
 
-            load = webToken.Decode(token, load, payload);
+            load = Decode(token, load, payload);
 
              if (load != static_cast<uint16_t>(~0)) {
                 response.Valid = true;
@@ -99,6 +100,22 @@ namespace Plugin {
         return result;
     }
 
+    // Property: cache - Token cache statistics
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t SecurityAgent::get_cache(CacheData& response) const
+    {
+        uint32_t entries, hits, misses;
+
+        _cache.Statistics(entries, hits, misses);
+
+        response.Entries = entries;
+        response.Hits = hits;
+        response.Misses = misses;
+
+        return Core::ERROR_NONE;
+    }
+
 } // namespace Plugin
 
 }
@@ -17,36 +17,6 @@
  * limitations under the License.
  */
  
-// C++ program to demonstrate working of regex_search()
-#include <iostream>
-#include <string.h>
-#include <regex>
-
-int testApp()
-{
-    // Target sequence
-    std::string s = "I am looking for GeeksForGeeks "
-                    "articles";
-
-    // An object of regex for pattern to be searched
-    std::regex r("Geek[a-zA-Z]+");
-
-    // flag type for determining the matching behavior
-    // here it is for matches on 'string' objects
-    std::smatch m;
-
-    // regex_search() for searching the regex pattern
-    // 'r' in the string 's'. 'm' is flag for determining
-    // matching behavior.
-    std::regex_search(s, m, r);
-
-    // for each loop
-    for (auto x : m)
-        std::cout << x << " ";
-
-    return 0;
-}
-
 #include "SecurityContext.h"
 
 namespace WPEFramework {
@@ -55,6 +25,8 @@ namespace Plugin {
     SecurityContext::SecurityContext(const AccessControlList* acl, const uint16_t length, const uint8_t payload[])
         : _token(string(reinterpret_cast<const TCHAR*>(payload), length))
         , _accessControlList(nullptr)
+        , _adminLock()
+        , _verdicts()
     {
         _context.FromString(_token);
 
@@ -87,7 +59,30 @@ namespace Plugin {
     //! Allow a JSONRPC message to be checked before it is offered for processing.
     bool SecurityContext::Allowed(const Core::JSONRPC::Message& message) const /* override */ 
     {
-        return ((_accessControlList != nullptr) && (_accessControlList->Allowed(message.Callsign(), message.Method())));
+        bool allowed = false;
+
+        if (_accessControlList != nullptr) {
+            std::pair<string, string> key(message.Callsign(), message.Method());
+
+            _adminLock.Lock();
+
+            Verdicts::const_iterator index(_verdicts.find(key));
+
+            if (index != _verdicts.end()) {
+                allowed = index->second;
+            } else {
+                allowed = _accessControlList->Allowed(key.first, key.second);
+
+                if (_verdicts.size() >= MaxVerdicts) {
+                    _verdicts.clear();
+                }
+                _verdicts.emplace(std::move(key), allowed);
+            }
+
+            _adminLock.Unlock();
+        }
+
+        return (allowed);
     }
 
     string SecurityContext::Token() const /* override */
@@ -27,6 +27,12 @@ namespace Plugin {
 
     class SecurityContext : public PluginHost::ISecurity {
     private:
+        // A token is typically used for many calls to a small set of methods, remember what
+        // the ACL decided, up to a limited set of (callsign, method) combinations.
+        static constexpr uint16_t MaxVerdicts = 64;
+
+        using Verdicts = std::map<std::pair<string, string>, bool>;
+
         class Payload : public Core::JSON::Container {
         public:
             Payload(const Payload&) = delete;
@@ -37,10 +43,12 @@ namespace Plugin {
                 , URL()
                 , User()
                 , Hash()
+                , Expiration(0)
             {
                 Add(_T("url"), &URL);
                 Add(_T("user"), &User);
                 Add(_T("hash"), &Hash);
+                Add(_T("exp"), &Expiration);
             }
             ~Payload()
             {
@@ -50,6 +58,7 @@ namespace Plugin {
             Core::JSON::String URL;
             Core::JSON::String User;
             Core::JSON::String Hash;
+            Core::JSON::DecUInt64 Expiration;
         };
 
     public:
@@ -71,6 +80,12 @@ namespace Plugin {
 
         string Token() const override;
 
+        //! Moment (in ticks) the token expires, as set by its "exp" claim, 0 if it does not expire.
+        uint64_t Expiry() const
+        {
+            return (_context.Expiration.IsSet() == true ? (_context.Expiration.Value() * 1000 * 1000) : 0);
+        }
+
     private:
         // Build QueryInterface implementation, specifying all possible interfaces to be returned.
         BEGIN_INTERFACE_MAP(SecurityOfficer)
@@ -81,6 +96,8 @@ namespace Plugin {
         string _token;
         Payload _context;
         const AccessControlList::Filter* _accessControlList;
+        mutable Core::CriticalSection _adminLock;
+        mutable Verdicts _verdicts;
     };
 }
 }
@@ -0,0 +1,343 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks JSON-RPC calls against the example ACL (example_acl.json): the origin URL selects a role, the
+// role selects the rules of the callsign, the rules decide on the method. "regex" is how the SecurityAgent
+// used to do it: every pattern translated into a std::regex and compiled on every check. "precompiled" is
+// how it does now, with the ACLPattern of the plugin built once. The memo of the SecurityContext is not
+// part of it, every check goes through the ACL.
+//
+// usage: aclbenchmark [rounds]
+
+#include "ACLPattern.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <regex>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+struct Assign {
+    const char* URL;
+    const char* Role;
+};
+
+struct Rule {
+    const char* Role;
+    const char* Callsign;
+    bool DefaultBlocked;
+    std::vector<const char*> Methods;
+};
+
+struct Role {
+    const char* Name;
+    bool DefaultBlocked;
+};
+
+// example_acl.json
+const Assign Assigns[] = {
+    { "*://localhost", "local" },
+    { "*://localhost:*", "local" },
+    { "*://127.0.0.1", "local" },
+    { "*://127.0.0.1:*", "local" },
+    { "*://[::1]", "local" },
+    { "*://[::1]:*", "local" },
+    { "*://[0:0:0:0:0:0:0:1]", "local" },
+    { "*://[0:0:0:0:0:0:0:1]:*", "local" },
+    { "file://*", "local" },
+    { "*://*.comcast.com", "comcast" },
+    { "*://metrological.com", "metrological" },
+    { "*", "default" }
+};
+const Role Roles[] = {
+    { "default", true },
+    { "local", false },
+    { "metrological", true },
+    { "comcast", true }
+};
+const Rule Rules[] = {
+    { "metrological", "DeviceInfo", false, { "register", "unregister" } },
+    { "metrological", "JSONRPCPlugin", true, { "time", "status" } },
+    { "comcast", "Compositor", false, {} }
+};
+
+struct Call {
+    const char* Origin;
+    const char* Callsign;
+    const char* Method;
+};
+
+const Call Calls[] = {
+    { "http://localhost:8080", "DeviceInfo", "systeminfo" },
+    { "http://127.0.0.1", "Controller", "activate" },
+    { "https://metrological.com", "DeviceInfo", "register" },
+    { "https://metrological.com", "DeviceInfo", "systeminfo" },
+    { "https://metrological.com", "JSONRPCPlugin", "time" },
+    { "https://metrological.com", "JSONRPCPlugin", "exists" },
+    { "https://metrological.com", "Controller", "harakiri" },
+    { "https://apps.comcast.com", "Compositor", "zorder" },
+    { "https://apps.comcast.com", "DeviceInfo", "systeminfo" },
+    { "https://example.org", "DeviceInfo", "systeminfo" }
+};
+
+// As the SecurityAgent used to translate the patterns.
+void ReplaceString(std::string& subject, const std::string& search, const std::string& replace)
+{
+    size_t pos = 0;
+    while ((pos = subject.find(search, pos)) != std::string::npos) {
+        subject.replace(pos, search.length(), replace);
+        pos += replace.length();
+    }
+}
+
+std::string CreateRegex(const std::string& input)
+{
+    std::string regex = input;
+
+    // order of replacing is important
+    ReplaceString(regex, "*", "^[a-zA-Z0-9.]+$");
+    ReplaceString(regex, ".", "\\.");
+
+    return regex;
+}
+
+std::string CreateUrlRegex(const std::string& input)
+{
+    std::string regex = input;
+
+    // order of replacing is important
+    ReplaceString(regex, "/", "\\/");
+    ReplaceString(regex, "[", "\\[");
+    ReplaceString(regex, "]", "\\]");
+    ReplaceString(regex, ":*", ":[0-9]+");
+    ReplaceString(regex, "*:", "[a-z]+:");
+    ReplaceString(regex, ".", "\\.");
+    ReplaceString(regex, "*", "[a-zA-Z0-9\\.]+");
+    regex.insert(regex.begin(), '(');
+    regex.insert(regex.end(), ')');
+
+    return regex;
+}
+
+bool Search(const std::string& subject, const std::string& expression)
+{
+    std::smatch matchList;
+    std::regex compiled(expression.c_str());
+    return (std::regex_search(subject, matchList, compiled));
+}
+
+bool DefaultBlocked(const std::string& role)
+{
+    bool result = true;
+    for (const Role& entry : Roles) {
+        if (role == entry.Name) {
+            result = entry.DefaultBlocked;
+        }
+    }
+    return (result);
+}
+
+class RegexACL {
+public:
+    RegexACL()
+        : _urls()
+        , _rules()
+    {
+        for (const Assign& entry : Assigns) {
+            _urls.emplace_back(CreateUrlRegex(entry.URL), entry.Role);
+        }
+        for (const Rule& rule : Rules) {
+            std::list<std::string> methods;
+            for (const char* method : rule.Methods) {
+                methods.push_back(CreateRegex(method));
+            }
+            _rules.push_back(Entry { rule.Role, CreateRegex(rule.Callsign), rule.DefaultBlocked, methods });
+        }
+    }
+
+public:
+    bool Allowed(const std::string& origin, const std::string& callsign, const std::string& method) const
+    {
+        std::list<std::pair<std::string, std::string>>::const_iterator url(_urls.begin());
+
+        while ((url != _urls.end()) && (Search(origin, url->first) == false)) {
+            url++;
+        }
+
+        bool result = false;
+
+        if (url != _urls.end()) {
+            std::list<Entry>::const_iterator rule(_rules.begin());
+
+            while ((rule != _rules.end()) && ((rule->Role != url->second) || (Search(callsign, rule->Callsign) == false))) {
+                rule++;
+            }
+
+            if (rule == _rules.end()) {
+                result = !DefaultBlocked(url->second);
+            } else {
+                bool found = false;
+                std::list<std::string>::const_iterator index(rule->Methods.begin());
+                while ((index != rule->Methods.end()) && (found == false)) {
+                    found = Search(method, *index);
+                    index++;
+                }
+                result = !(rule->DefaultBlocked ^ found);
+            }
+        }
+
+        return (result);
+    }
+
+private:
+    struct Entry {
+        std::string Role;
+        std::string Callsign;
+        bool DefaultBlocked;
+        std::list<std::string> Methods;
+    };
+
+    std::list<std::pair<std::string, std::string>> _urls;
+    std::list<Entry> _rules;
+};
+
+class PrecompiledACL {
+public:
+    PrecompiledACL()
+        : _urls()
+        , _rules()
+    {
+        for (const Assign& entry : Assigns) {
+            _urls.emplace_back(ACLPattern::URL(entry.URL), entry.Role);
+        }
+        for (const Rule& rule : Rules) {
+            std::list<ACLPattern> methods;
+            for (const char* method : rule.Methods) {
+                methods.push_back(ACLPattern::Identifier(method));
+            }
+            _rules.push_back(Entry { rule.Role, ACLPattern::Identifier(rule.Callsign), rule.DefaultBlocked, methods });
+        }
+    }
+
+public:
+    bool Allowed(const std::string& origin, const std::string& callsign, const std::string& method) const
+    {
+        std::list<std::pair<ACLPattern, std::string>>::const_iterator url(_urls.begin());
+
+        while ((url != _urls.end()) && (url->first.Matches(origin) == false)) {
+            url++;
+        }
+
+        bool result = false;
+
+        if (url != _urls.end()) {
+            std::list<Entry>::const_iterator rule(_rules.begin());
+
+            while ((rule != _rules.end()) && ((rule->Role != url->second) || (rule->Callsign.Matches(callsign) == false))) {
+                rule++;
+            }
+
+            if (rule == _rules.end()) {
+                result = !DefaultBlocked(url->second);
+            } else {
+                bool found = false;
+                std::list<ACLPattern>::const_iterator index(rule->Methods.begin());
+                while ((index != rule->Methods.end()) && (found == false)) {
+                    found = index->Matches(method);
+                    index++;
+                }
+                result = !(rule->DefaultBlocked ^ found);
+            }
+        }
+
+        return (result);
+    }
+
+private:
+    struct Entry {
+        std::string Role;
+        ACLPattern Callsign;
+        bool DefaultBlocked;
+        std::list<ACLPattern> Methods;
+    };
+
+    std::list<std::pair<ACLPattern, std::string>> _urls;
+    std::list<Entry> _rules;
+};
+
+double Microseconds(const std::chrono::steady_clock::time_point& start)
+{
+    return (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t rounds = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200);
+    const uint32_t count = sizeof(Calls) / sizeof(Calls[0]);
+
+    if (rounds == 0) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return (1);
+    }
+
+    const RegexACL regex;
+    const PrecompiledACL precompiled;
+    std::vector<bool> before;
+    std::vector<bool> after;
+
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    for (uint32_t round = 0; round < rounds; round++) {
+        before.clear();
+        for (const Call& call : Calls) {
+            before.push_back(regex.Allowed(call.Origin, call.Callsign, call.Method));
+        }
+    }
+    const double regexTime = Microseconds(start) / (rounds * count);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        after.clear();
+        for (const Call& call : Calls) {
+            after.push_back(precompiled.Allowed(call.Origin, call.Callsign, call.Method));
+        }
+    }
+    const double precompiledTime = Microseconds(start) / (rounds * count);
+
+    uint32_t allowed = 0;
+    for (const bool verdict : after) {
+        allowed += (verdict ? 1 : 0);
+    }
+
+    printf("%u calls against the example ACL, %u allowed, %u rounds\n", count, allowed, rounds);
+    printf("regex:       %9.3f us per check\n", regexTime);
+    printf("precompiled: %9.3f us per check\n", precompiledTime);
+
+    if (before != after) {
+        fprintf(stderr, "The verdicts differ.\n");
+        return (1);
+    }
+
+    return (0);
+}
@@ -19,6 +19,7 @@
  
 #include "TraceControl.h"
 #include "TraceOutput.h"
+#include "TraceRecorder.h"
 
 namespace WPEFramework {
 
@@ -68,16 +69,23 @@ namespace Plugin {
         _skipURL = static_cast<uint8_t>(_service->WebPrefix().length());
 
         if (((service->Background() == false) && (_config.Console.IsSet() == false) && (_config.SysLog.IsSet() == false)) || ((_config.Console.IsSet() == true) && (_config.Console.Value() == true))) {
-            _outputs.push_back(new Plugin::TraceOutput(false, false));
+            _outputs.push_back(CreateOutput(false, false));
         }
         if (((service->Background() == true) && (_config.Console.IsSet() == false) && (_config.SysLog.IsSet() == false)) || ((_config.SysLog.IsSet() == true) && (_config.SysLog.Value() == true))) {
-            _outputs.push_back(new Plugin::TraceOutput(true, _config.Abbreviated.Value()));
+            _outputs.push_back(CreateOutput(true, _config.Abbreviated.Value()));
         }
         if (_config.Remote.IsSet() == true) {
             Core::NodeId logNode(_config.Remote.Binding.Value().c_str(), _config.Remote.Port.Value());
 
             _outputs.push_back(new Trace::TraceMedia(logNode));
         }
+#ifndef __WINDOWS__
+        if (_config.Recorder.IsSet() == true) {
+            string path(_config.Recorder.Path.IsSet() == true ? _config.Recorder.Path.Value() : service->PersistentPath());
+
+            _recorder = new Plugin::TraceRecorder(path, _config.Recorder.Size.Value(), _config.Recorder.Files.Value());
+        }
+#endif
 
         _service->Register(&_observer);
 
@@ -102,6 +110,13 @@ namespace Plugin {
 
             _outputs.pop_front();
         }
+
+#ifndef __WINDOWS__
+        if (_recorder != nullptr) {
+            delete _recorder;
+            _recorder = nullptr;
+        }
+#endif
     }
 
     /* virtual */ string TraceControl::Information() const
@@ -209,6 +224,22 @@ namespace Plugin {
         return (result);
     }
 
+    Trace::ITraceMedia* TraceControl::CreateOutput(const bool syslogging, const bool abbreviated) const
+    {
+        Trace::ITraceMedia* result = nullptr;
+
+#ifndef __WINDOWS__
+        if ((_config.Buffered.Value() == true) && (_config.BufferSize.Value() > 0)) {
+            result = new Plugin::BufferedTraceOutput(syslogging, abbreviated, _config.BufferSize.Value());
+        } else
+#endif
+        {
+            result = new Plugin::TraceOutput(syslogging, abbreviated);
+        }
+
+        return (result);
+    }
+
     void TraceControl::Dispatch(Observer::Source& information)
     {
         std::list<Trace::ITraceMedia*>::iterator index(_outputs.begin());
@@ -218,6 +249,14 @@ namespace Plugin {
             (*index)->Output(information.FileName(), information.LineNumber(), information.ClassName(), &wrapper);
             index++;
         }
+
+#ifndef __WINDOWS__
+        if (_recorder != nullptr) {
+            // The recorder keeps the timestamp of the producer, so it is not routed through ITraceMedia.
+            _recorder->Record(information.Timestamp(), information.LineNumber(), information.FileName(), information.Module(),
+                information.Category(), information.ClassName(), information.Information(), information.Length());
+        }
+#endif
     }
 }
 }
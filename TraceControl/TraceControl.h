@@ -20,12 +20,15 @@
 #pragma once
 
 #include "Module.h"
+#include "TraceMerge.h"
 #include <interfaces/json/JsonData_TraceControl.h>
 
 namespace WPEFramework {
 
 namespace Plugin {
 
+    class TraceRecorder;
+
     class TraceControl : public PluginHost::IPlugin, public PluginHost::IWeb, public PluginHost::JSONRPC {
 
     public:
@@ -556,6 +559,10 @@ namespace Plugin {
             Observer(TraceControl& parent)
                 : Thread(Core::Thread::DefaultStackSize(), _T("TraceWorker"))
                 , _buffers()
+                , _obsolete()
+                , _sources()
+                , _merge()
+                , _draining(false)
                 , _traceControl(Trace::TraceUnit::Instance())
                 , _parent(parent)
                 , _refcount(0)
@@ -616,7 +623,12 @@ namespace Plugin {
                 std::map<const uint32_t, Source*>::iterator index(_buffers.find(connection->Id()));
 
                 if (index != _buffers.end()) {
-                    delete (index->second);
+                    if (_draining == true) {
+                        // The worker might be reading from it, it will clean up once done.
+                        _obsolete.push_back(index->second);
+                    } else {
+                        delete (index->second);
+                    }
                     _buffers.erase(index);
                 }
 
@@ -678,63 +690,55 @@ namespace Plugin {
                     // Before we start we reset the flag, if new info is coming in, we will get a retrigger flag.
                     _traceControl.Acknowledge();
 
-                    Source* selected;
-
-                    uint64_t timeStamp;
-
-                    do {
-                        selected = nullptr;
-
-                        _adminLock.Lock();
-
-                        timeStamp = static_cast<uint64_t>(~0);
-
-                        std::map<const uint32_t, Source*>::iterator index(_buffers.begin());
+                    Drain();
+                }
 
-                        while (index != _buffers.end()) {
+                return (Core::infinite);
+            }
 
-                            Source::state state(index->second->Load());
+            // Merge the loaded entries of all sources in timestamp order. Sources are only read from
+            // this thread, the lock is only required to get a stable view on the set of sources. Sources
+            // that are deactivated while draining are kept alive until the drain has completed.
+            void Drain()
+            {
+                _adminLock.Lock();
 
-                            if (state == Source::LOADED) {
-                                if (index->second->Timestamp() < timeStamp) {
-                                    timeStamp = index->second->Timestamp();
+                _draining = true;
+                _sources.clear();
 
-                                    if (state == Source::LOADED) {
-                                        selected = index->second;
-                                    }
-                                }
-                            } else if (state == Source::FAILURE) {
-                                // Oops this requires recovery, so let's flush
-                                index->second->Flush();
-                            }
+                std::map<const uint32_t, Source*>::iterator index(_buffers.begin());
 
-                            index++;
-                        }
+                while (index != _buffers.end()) {
+                    _sources.push_back(index->second);
+                    index++;
+                }
 
-                        if (selected != nullptr) {
+                _adminLock.Unlock();
 
-                            // Oke, output this entry
-                            _parent.Dispatch(*selected);
+                _merge.Drain(
+                    _sources,
+                    [this](Source& selected) { _parent.Dispatch(selected); },
+                    [this]() { return (IsRunning()); });
 
-                            // Ready to load a new one..
-                            selected->Clear();
-                        } else if (timeStamp != static_cast<uint64_t>(~0)) {
-                            // Looks like we are waiting for a message to be completed.
-                            // Give up our slice, so the producer, can produce.
-                            ::SleepMs(0);
-                        }
+                _adminLock.Lock();
 
-                        _adminLock.Unlock();
+                _draining = false;
 
-                    } while ((IsRunning() == true) && (timeStamp != static_cast<uint64_t>(~0)));
+                while (_obsolete.size() != 0) {
+                    delete _obsolete.front();
+                    _obsolete.pop_front();
                 }
 
-                return (Core::infinite);
+                _adminLock.Unlock();
             }
 
         private:
             Core::CriticalSection _adminLock;
             std::map<const uint32_t, Source*> _buffers;
+            std::list<Source*> _obsolete;
+            std::vector<Source*> _sources;
+            TraceMergeType<Source> _merge;
+            bool _draining;
             Trace::TraceUnit& _traceControl;
             TraceControl& _parent;
             mutable uint32_t _refcount;
@@ -812,6 +816,31 @@ namespace Plugin {
             Core::JSON::DecUInt16 Port;
             Core::JSON::String Binding;
         };
+        class RecorderNode : public Core::JSON::Container {
+        private:
+            RecorderNode(const RecorderNode&) = delete;
+            RecorderNode& operator=(const RecorderNode&) = delete;
+
+        public:
+            RecorderNode()
+                : Core::JSON::Container()
+                , Path()
+                , Size(1024 * 1024)
+                , Files(4)
+            {
+                Add(_T("path"), &Path);
+                Add(_T("size"), &Size);
+                Add(_T("files"), &Files);
+            }
+            ~RecorderNode()
+            {
+            }
+
+        public:
+            Core::JSON::String Path;
+            Core::JSON::DecUInt32 Size;
+            Core::JSON::DecUInt8 Files;
+        };
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&);
@@ -823,12 +852,18 @@ namespace Plugin {
                 , Console(false)
                 , SysLog(true)
                 , Abbreviated(true)
+                , Buffered(false)
+                , BufferSize(64 * 1024)
                 , Remote()
+                , Recorder()
             {
                 Add(_T("console"), &Console);
                 Add(_T("syslog"), &SysLog);
                 Add(_T("abbreviated"), &Abbreviated);
+                Add(_T("buffered"), &Buffered);
+                Add(_T("buffersize"), &BufferSize);
                 Add(_T("remote"), &Remote);
+                Add(_T("recorder"), &Recorder);
             }
             ~Config()
             {
@@ -838,7 +873,10 @@ namespace Plugin {
             Core::JSON::Boolean Console;
             Core::JSON::Boolean SysLog;
             Core::JSON::Boolean Abbreviated;
+            Core::JSON::Boolean Buffered;
+            Core::JSON::DecUInt32 BufferSize;
             NetworkNode Remote;
+            RecorderNode Recorder;
         };
         class Data : public Core::JSON::Container {
         public:
@@ -934,6 +972,7 @@ namespace Plugin {
             : _skipURL(0)
             , _service(nullptr)
             , _outputs()
+            , _recorder(nullptr)
             , _tracePath()
             , _observer(*this)
         {
@@ -989,6 +1028,7 @@ namespace Plugin {
 
     private:
         void Dispatch(Observer::Source& information);
+        Trace::ITraceMedia* CreateOutput(const bool syslogging, const bool abbreviated) const;
 
         void RegisterAll();
         void UnregisterAll();
@@ -1005,6 +1045,7 @@ namespace Plugin {
         PluginHost::IShell* _service;
         Config _config;
         std::list<Trace::ITraceMedia*> _outputs;
+        TraceRecorder* _recorder;
         string _tracePath;
         Observer _observer;
     };
@@ -0,0 +1,75 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+#pragma once
+
+#include <stdint.h>
+
+// Layout of the binary trace files written by the TraceRecorder and read back by tracedecoder, on the
+// host.
+//
+// A file starts with a FileHeader, followed by records. Each record starts with its type. Names
+// (file, module, category and class) are written once per file as a STRING record and referred to
+// by their id from ENTRY records. Every file is self contained, the unused tail of a file is zero,
+// which reads as an END record. All fields are in host byte order.
+
+namespace WPEFramework {
+namespace Plugin {
+namespace TraceFormat {
+
+    static constexpr uint32_t Magic = 0x42435254; // "TRCB"
+    static constexpr uint16_t Version = 1;
+
+    enum record : uint8_t {
+        END = 0,
+        STRING = 1,
+        ENTRY = 2
+    };
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Reserved;
+        uint32_t Sequence;
+    };
+
+    // Followed by Length bytes of name, not '\0' terminated.
+    struct StringHeader {
+        uint8_t Type;
+        uint16_t Id;
+        uint16_t Length;
+    };
+
+    // Followed by Length bytes of trace information, not '\0' terminated.
+    struct EntryHeader {
+        uint8_t Type;
+        uint64_t Timestamp;
+        uint32_t LineNumber;
+        uint16_t File;
+        uint16_t Module;
+        uint16_t Category;
+        uint16_t ClassName;
+        uint16_t Length;
+    };
+#pragma pack(pop)
+
+}
+}
+}
@@ -0,0 +1,115 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Merges the entries of a set of trace sources in timestamp order. The Observer drains its cyclic
+    // buffers with it, the benchmark drains synthetic ones, which is why it takes the source as a
+    // template argument. A SOURCE offers:
+    //   state Load()         - make the next entry current, returns SOURCE::LOADED if there is one,
+    //                          SOURCE::FAILURE if the source is corrupt.
+    //   uint64_t Timestamp() - timestamp of the current entry.
+    //   void Clear()         - done with the current entry.
+    //   void Flush()         - drop everything, to recover from a FAILURE.
+    template <typename SOURCE>
+    class TraceMergeType {
+    private:
+        TraceMergeType(const TraceMergeType<SOURCE>&) = delete;
+        TraceMergeType<SOURCE>& operator=(const TraceMergeType<SOURCE>&) = delete;
+
+        struct Later {
+            bool operator()(const SOURCE* lhs, const SOURCE* rhs) const
+            {
+                return (lhs->Timestamp() > rhs->Timestamp());
+            }
+        };
+
+    public:
+        TraceMergeType()
+            : _heap()
+        {
+        }
+        ~TraceMergeType() = default;
+
+    public:
+        // Hands every entry to dispatch, oldest first, for as long as running() holds. Loaded sources
+        // are kept in a min-heap, so after an entry is dispatched only its own source is reloaded.
+        template <typename DISPATCH, typename RUNNING>
+        void Drain(const std::vector<SOURCE*>& sources, DISPATCH&& dispatch, RUNNING&& running)
+        {
+            bool loaded;
+
+            do {
+                loaded = false;
+
+                _heap.clear();
+
+                for (SOURCE* source : sources) {
+                    Enqueue(*source);
+                }
+
+                while ((running() == true) && (_heap.empty() == false)) {
+                    std::pop_heap(_heap.begin(), _heap.end(), Later());
+
+                    SOURCE& selected(*_heap.back());
+                    _heap.pop_back();
+
+                    // Oke, output this entry
+                    dispatch(selected);
+
+                    // Ready to load a new one..
+                    selected.Clear();
+
+                    Enqueue(selected);
+
+                    loaded = true;
+                }
+
+                // Producers might have committed entries to sources that ran empty while we were
+                // dispatching. Pick those up as well, but stop as soon as a pass yields nothing.
+            } while ((running() == true) && (loaded == true));
+        }
+
+    private:
+        void Enqueue(SOURCE& source)
+        {
+            typename SOURCE::state state(source.Load());
+
+            if (state == SOURCE::LOADED) {
+                _heap.push_back(&source);
+                std::push_heap(_heap.begin(), _heap.end(), Later());
+            } else if (state == SOURCE::FAILURE) {
+                // Oops this requires recovery, so let's flush
+                source.Flush();
+            }
+        }
+
+    private:
+        std::vector<SOURCE*> _heap;
+    };
+
+} // namespace Plugin
+} // namespace WPEFramework
@@ -23,11 +23,51 @@
 
 #ifndef __WINDOWS__
 #include <syslog.h>
+#include <sys/uio.h>
 #endif
 
 namespace WPEFramework {
 namespace Plugin {
 
+    // Formatting the time is relatively expensive, compared to emitting a trace line. Traces come in
+    // bursts, so keep the last formatted time around for as long as it is accurate.
+    class TraceTime {
+    public:
+        TraceTime(const TraceTime&) = delete;
+        TraceTime& operator=(const TraceTime&) = delete;
+
+        TraceTime(const bool abbreviated)
+            : _abbreviated(abbreviated)
+            , _resolution(abbreviated ? 1000 /* ms */ : 1000 * 1000 /* s */)
+            , _slot(0)
+            , _text()
+        {
+        }
+        ~TraceTime()
+        {
+        }
+
+    public:
+        const string& Now()
+        {
+            Core::Time now(Core::Time::Now());
+            uint64_t slot(now.Ticks() / _resolution);
+
+            if (slot != _slot) {
+                _slot = slot;
+                _text = (_abbreviated == true ? now.ToTimeOnly(true) : now.ToRFC1123(true));
+            }
+
+            return (_text);
+        }
+
+    private:
+        const bool _abbreviated;
+        const uint32_t _resolution;
+        uint64_t _slot;
+        string _text;
+    };
+
     class TraceOutput : public Trace::ITraceMedia {
     public:
         TraceOutput(const TraceOutput&) = delete;
@@ -36,6 +76,7 @@ namespace Plugin {
         TraceOutput(const bool syslogging, const bool abbreviated)
             : _syslogging(syslogging)
             , _abbreviated(abbreviated)
+            , _time(abbreviated)
         {
         }
         virtual ~TraceOutput()
@@ -45,23 +86,21 @@ namespace Plugin {
     public:
         virtual void Output(const char fileName[], const uint32_t lineNumber, const char className[], const Trace::ITrace* information)
         {
+            const string& time(_time.Now());
+
 #ifndef __WINDOWS__
             if (_syslogging == true) {
                 if( _abbreviated == true ) {
-                    string time(Core::Time::Now().ToTimeOnly(true));
                     syslog(LOG_NOTICE, "[%s]: %s\n", time.c_str(), information->Data());
                 } else {
-                    string time(Core::Time::Now().ToRFC1123(true));
                     syslog(LOG_NOTICE, "[%s]:[%s:%d] %s: %s\n", time.c_str(), Core::FileNameOnly(fileName), lineNumber, information->Category(), information->Data());
                 }
             } else
 #endif
             {
                 if( _abbreviated == true ) {
-                    string time(Core::Time::Now().ToTimeOnly(true));
                     printf("[%s]: %s\n", time.c_str(), information->Data());
                 } else {
-                    string time(Core::Time::Now().ToRFC1123(true));
                     printf("[%s]:[%s:%d] %s: %s\n", time.c_str(), Core::FileNameOnly(fileName), lineNumber, information->Category(), information->Data());
                 }
             }
@@ -70,6 +109,219 @@ namespace Plugin {
     private:
         bool _syslogging;
         bool _abbreviated;
+        TraceTime _time;
+    };
+
+#ifndef __WINDOWS__
+    // Same output as the TraceOutput, but the formatted lines are stored in a preallocated ring buffer
+    // and written out in batches from a dedicated thread, so a slow console (e.g. a serial line) does
+    // not hold up the TraceControl worker. If the writer can not keep up, lines are dropped and the
+    // number of dropped lines is reported in the output.
+    class BufferedTraceOutput : public Trace::ITraceMedia, public Core::Thread {
+    private:
+        static constexpr uint8_t MaxSegments = 2;
+
+    public:
+        BufferedTraceOutput() = delete;
+        BufferedTraceOutput(const BufferedTraceOutput&) = delete;
+        BufferedTraceOutput& operator=(const BufferedTraceOutput&) = delete;
+
+        BufferedTraceOutput(const bool syslogging, const bool abbreviated, const uint32_t size)
+            : Core::Thread(Core::Thread::DefaultStackSize(), _T("TraceOutput"))
+            , _syslogging(syslogging)
+            , _abbreviated(abbreviated)
+            , _time(abbreviated)
+            , _adminLock()
+            , _signal(false, true)
+            , _size(size)
+            , _buffer(new char[size])
+            , _head(0)
+            , _tail(0)
+            , _wrap(0)
+            , _dropped(0)
+        {
+            Run();
+        }
+        ~BufferedTraceOutput() override
+        {
+            Block();
+            _signal.SetEvent();
+            Wait(Thread::BLOCKED | Thread::STOPPED, Core::infinite);
+
+            // Whatever is left, should still be reported.
+            Flush();
+
+            delete[] _buffer;
+        }
+
+    public:
+        void Output(const char fileName[], const uint32_t lineNumber, const char className[], const Trace::ITrace* information) override
+        {
+            const string& time(_time.Now());
+
+            _adminLock.Lock();
+            uint32_t tail = _tail;
+            _adminLock.Unlock();
+
+            // Only this thread moves the head, only the writer moves the tail.
+            uint32_t head = _head;
+            uint32_t length = 0;
+            bool wrapped = false;
+
+            if (head >= tail) {
+                length = Format(&(_buffer[head]), _size - head - (tail == 0 ? 1 : 0), time, fileName, lineNumber, information);
+
+                if ((length == 0) && (tail > 0)) {
+                    length = Format(_buffer, tail - 1, time, fileName, lineNumber, information);
+                    wrapped = true;
+                }
+            } else {
+                length = Format(&(_buffer[head]), tail - head - 1, time, fileName, lineNumber, information);
+            }
+
+            _adminLock.Lock();
+
+            if (length == 0) {
+                _dropped++;
+            } else if (wrapped == true) {
+                _wrap = head;
+                _head = length;
+            } else {
+                _head = head + length;
+            }
+
+            _adminLock.Unlock();
+
+            if (length != 0) {
+                _signal.SetEvent();
+            }
+        }
+
+    private:
+        // Returns the number of bytes occupied in the buffer, 0 if it did not fit. Syslog records are
+        // kept '\0' terminated so they can be handed out one by one, console records are a plain
+        // stream of lines.
+        uint32_t Format(char destination[], const uint32_t space, const string& time, const char fileName[], const uint32_t lineNumber, const Trace::ITrace* information) const
+        {
+            int length;
+
+            if (_abbreviated == true) {
+                length = snprintf(destination, space, "[%s]: %s\n", time.c_str(), information->Data());
+            } else {
+                length = snprintf(destination, space, "[%s]:[%s:%d] %s: %s\n", time.c_str(), Core::FileNameOnly(fileName), lineNumber, information->Category(), information->Data());
+            }
+
+            return (((length < 0) || (static_cast<uint32_t>(length) >= space)) ? 0 : static_cast<uint32_t>(length) + (_syslogging == true ? 1 : 0));
+        }
+        uint32_t Worker() override
+        {
+            while (IsRunning() == true) {
+                _signal.Lock(Core::infinite);
+                _signal.ResetEvent();
+
+                Flush();
+            }
+
+            return (Core::infinite);
+        }
+        void Flush()
+        {
+            struct iovec segments[MaxSegments];
+            uint8_t count = 0;
+
+            _adminLock.Lock();
+
+            uint32_t head = _head;
+            uint32_t tail = _tail;
+            uint32_t wrap = _wrap;
+            uint32_t dropped = _dropped;
+
+            _dropped = 0;
+
+            if (head > tail) {
+                segments[count].iov_base = &(_buffer[tail]);
+                segments[count++].iov_len = head - tail;
+            } else if (head < tail) {
+                segments[count].iov_base = &(_buffer[tail]);
+                segments[count++].iov_len = wrap - tail;
+
+                if (head > 0) {
+                    segments[count].iov_base = _buffer;
+                    segments[count++].iov_len = head;
+                }
+            }
+
+            _adminLock.Unlock();
+
+            if (count > 0) {
+                if (_syslogging == true) {
+                    for (uint8_t index = 0; index < count; index++) {
+                        const char* record = static_cast<const char*>(segments[index].iov_base);
+                        const char* end = record + segments[index].iov_len;
+
+                        while (record < end) {
+                            syslog(LOG_NOTICE, "%s", record);
+                            record += strlen(record) + 1;
+                        }
+                    }
+                } else {
+                    Write(segments, count);
+                }
+
+                _adminLock.Lock();
+                _tail = head;
+                _adminLock.Unlock();
+            }
+
+            if (dropped > 0) {
+                char line[64];
+                int length = snprintf(line, sizeof(line), "[TraceControl]: %u trace lines dropped\n", dropped);
+
+                if (_syslogging == true) {
+                    syslog(LOG_NOTICE, "%s", line);
+                } else {
+                    struct iovec segment = { line, static_cast<size_t>(length) };
+                    Write(&segment, 1);
+                }
+            }
+        }
+        static void Write(struct iovec segments[], uint8_t count)
+        {
+            while (count > 0) {
+                ssize_t written = ::writev(STDOUT_FILENO, segments, count);
+
+                if (written < 0) {
+                    if (errno != EINTR) {
+                        break;
+                    }
+                } else {
+                    // Partial write, skip what made it and continue with the rest.
+                    while ((count > 0) && (static_cast<size_t>(written) >= segments->iov_len)) {
+                        written -= segments->iov_len;
+                        segments++;
+                        count--;
+                    }
+                    if (count > 0) {
+                        segments->iov_base = static_cast<char*>(segments->iov_base) + written;
+                        segments->iov_len -= written;
+                    }
+                }
+            }
+        }
+
+    private:
+        const bool _syslogging;
+        const bool _abbreviated;
+        TraceTime _time;
+        Core::CriticalSection _adminLock;
+        Core::Event _signal;
+        const uint32_t _size;
+        char* _buffer;
+        uint32_t _head;
+        uint32_t _tail;
+        uint32_t _wrap;
+        uint32_t _dropped;
     };
+#endif
 }
 }
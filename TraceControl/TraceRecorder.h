@@ -0,0 +1,307 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Module.h"
+#include "TraceFormat.h"
+#include "../helpers/Hash.h"
+
+#ifndef __WINDOWS__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <unordered_map>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+#ifndef __WINDOWS__
+    // Records the traces in a binary format (see TraceFormat.h) into a set of memory mapped files that
+    // are used round robin. Nothing is formatted on the device, names are written only once per file.
+    // Use the tracedecoder tool to turn the files into readable text. The sequence numbers continue
+    // where the files of a previous run left off, so a restart only overwrites the oldest file.
+    class TraceRecorder : public Trace::ITraceMedia {
+    private:
+        // Names are looked up by a hash of their content, so no string has to be built for every entry.
+        using NameMap = std::unordered_multimap<uint32_t, uint16_t>;
+
+        static constexpr uint16_t Unknown = 0xFFFF;
+        static constexpr uint64_t RetryDelay = 10 * 1000 * 1000; // us
+
+    public:
+        TraceRecorder() = delete;
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        TraceRecorder(const string& path, const uint32_t fileSize, const uint8_t files)
+            : _path(Core::Directory::Normalize(path))
+            , _size(fileSize)
+            , _sequence(0)
+            , _slots(files, 0)
+            , _descriptor(-1)
+            , _base(nullptr)
+            , _offset(0)
+            , _retry(0)
+            , _index()
+            , _names()
+        {
+            ASSERT(_size > sizeof(TraceFormat::FileHeader));
+            ASSERT(files > 0);
+
+            Core::Directory(_path.c_str()).CreatePath();
+
+            Scan();
+            Rotate(Core::Time::Now().Ticks());
+        }
+        ~TraceRecorder() override
+        {
+            Close();
+        }
+
+    public:
+        void Output(const char fileName[], const uint32_t lineNumber, const char className[], const Trace::ITrace* information) override
+        {
+            Record(Core::Time::Now().Ticks(), lineNumber, fileName, information->Module(), information->Category(), className, information->Data(), information->Length());
+        }
+        void Record(const uint64_t timestamp, const uint32_t lineNumber, const char fileName[], const char module[], const char category[], const char className[], const char text[], const uint16_t length)
+        {
+            if ((_base == nullptr) && (timestamp >= _retry)) {
+                Rotate(timestamp);
+            }
+
+            if (_base != nullptr) {
+                const char* names[] = { fileName, module, category, className };
+                uint32_t hashes[4];
+                uint16_t lengths[4];
+                uint16_t ids[4];
+                uint32_t required = sizeof(TraceFormat::EntryHeader) + length;
+
+                for (uint8_t index = 0; index < 4; index++) {
+                    ids[index] = Find(names[index], hashes[index], lengths[index]);
+
+                    if (ids[index] == Unknown) {
+                        required += sizeof(TraceFormat::StringHeader) + lengths[index];
+                    }
+                }
+
+                if ((_offset + required) > _size) {
+                    Rotate(timestamp);
+
+                    // A new file knows no names yet.
+                    required = sizeof(TraceFormat::EntryHeader) + length;
+
+                    for (uint8_t index = 0; index < 4; index++) {
+                        ids[index] = Unknown;
+                        required += sizeof(TraceFormat::StringHeader) + lengths[index];
+                    }
+                }
+
+                if ((_base != nullptr) && ((_offset + required) <= _size)) {
+                    for (uint8_t index = 0; index < 4; index++) {
+                        if (ids[index] == Unknown) {
+                            ids[index] = Intern(names[index], hashes[index], lengths[index]);
+                        }
+                    }
+
+                    TraceFormat::EntryHeader header;
+                    header.Type = TraceFormat::ENTRY;
+                    header.Timestamp = timestamp;
+                    header.LineNumber = lineNumber;
+                    header.File = ids[0];
+                    header.Module = ids[1];
+                    header.Category = ids[2];
+                    header.ClassName = ids[3];
+                    header.Length = length;
+
+                    Write(&header, sizeof(header));
+                    Write(text, length);
+                }
+            }
+        }
+
+    private:
+        // Hashes (FNV-1a) and measures the name in one go, returns its id or Unknown.
+        uint16_t Find(const char name[], uint32_t& hash, uint16_t& length) const
+        {
+            uint16_t result = Unknown;
+            const char* current = name;
+
+            hash = FNV1a32Basis;
+
+            while (*current != '\0') {
+                hash = FNV1a32(hash, static_cast<uint8_t>(*current));
+                current++;
+            }
+
+            length = static_cast<uint16_t>(current - name);
+
+            std::pair<NameMap::const_iterator, NameMap::const_iterator> range(_index.equal_range(hash));
+
+            while ((range.first != range.second) && (result == Unknown)) {
+                const string& known(_names[range.first->second]);
+
+                if ((known.length() == length) && (::memcmp(known.c_str(), name, length) == 0)) {
+                    result = range.first->second;
+                }
+                range.first++;
+            }
+
+            return (result);
+        }
+        uint16_t Intern(const char name[], const uint32_t hash, const uint16_t length)
+        {
+            uint32_t dummyHash;
+            uint16_t dummyLength;
+
+            // The same name can occur more than once in an entry.
+            uint16_t result = Find(name, dummyHash, dummyLength);
+
+            if (result == Unknown) {
+                result = static_cast<uint16_t>(_names.size());
+
+                TraceFormat::StringHeader header;
+                header.Type = TraceFormat::STRING;
+                header.Id = result;
+                header.Length = length;
+
+                Write(&header, sizeof(header));
+                Write(name, length);
+
+                _names.emplace_back(name, length);
+                _index.emplace(hash, result);
+            }
+
+            return (result);
+        }
+        inline void Write(const void* data, const uint32_t length)
+        {
+            ::memcpy(&(_base[_offset]), data, length);
+            _offset += length;
+        }
+        string FileName(const uint8_t slot) const
+        {
+            return (_path + _T("tracerecord.") + Core::NumberType<uint8_t>(slot).Text());
+        }
+        // Picks up the sequence numbers of the files left by a previous run.
+        void Scan()
+        {
+            for (uint8_t slot = 0; slot < _slots.size(); slot++) {
+                int descriptor = ::open(FileName(slot).c_str(), O_RDONLY);
+
+                if (descriptor != -1) {
+                    TraceFormat::FileHeader header;
+
+                    if ((::read(descriptor, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header))) && (header.Magic == TraceFormat::Magic) && (header.Version == TraceFormat::Version)) {
+                        // Stored as sequence + 1, 0 marks a free slot.
+                        _slots[slot] = header.Sequence + 1;
+                        _sequence = std::max(_sequence, header.Sequence + 1);
+                    }
+
+                    ::close(descriptor);
+                }
+            }
+        }
+        void Close()
+        {
+            if (_base != nullptr) {
+                ::munmap(_base, _size);
+                _base = nullptr;
+            }
+            if (_descriptor != -1) {
+                // Do not waste storage on the unused part.
+                if (::ftruncate(_descriptor, _offset) != 0) {
+                    TRACE_L1("Could not truncate trace record file. Error: %d", errno);
+                }
+                ::close(_descriptor);
+                _descriptor = -1;
+            }
+            _index.clear();
+            _names.clear();
+            _offset = 0;
+        }
+        void Rotate(const uint64_t now)
+        {
+            Close();
+
+            // Overwrite a free slot, or else the one with the oldest file.
+            uint8_t slot = 0;
+
+            for (uint8_t index = 1; index < _slots.size(); index++) {
+                if (_slots[index] < _slots[slot]) {
+                    slot = index;
+                }
+            }
+
+            string fileName(FileName(slot));
+
+            _descriptor = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP);
+
+            if (_descriptor == -1) {
+                SYSLOG(Logging::Notification, (_T("Could not open trace record file %s"), fileName.c_str()));
+            } else if (::ftruncate(_descriptor, _size) != 0) {
+                SYSLOG(Logging::Notification, (_T("Could not size trace record file %s"), fileName.c_str()));
+            } else {
+                void* base = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _descriptor, 0);
+
+                if (base != MAP_FAILED) {
+                    _base = static_cast<uint8_t*>(base);
+
+                    TraceFormat::FileHeader header;
+                    header.Magic = TraceFormat::Magic;
+                    header.Version = TraceFormat::Version;
+                    header.Reserved = 0;
+                    header.Sequence = _sequence;
+
+                    Write(&header, sizeof(header));
+
+                    _slots[slot] = _sequence + 1;
+                    _sequence++;
+                } else {
+                    SYSLOG(Logging::Notification, (_T("Could not map trace record file %s"), fileName.c_str()));
+                }
+            }
+
+            if ((_base == nullptr) && (_descriptor != -1)) {
+                ::close(_descriptor);
+                _descriptor = -1;
+            }
+
+            // Try again later, not for every trace.
+            _retry = (_base == nullptr ? now + RetryDelay : 0);
+        }
+
+    private:
+        const string _path;
+        const uint32_t _size;
+        uint32_t _sequence;
+        std::vector<uint32_t> _slots;
+        int _descriptor;
+        uint8_t* _base;
+        uint32_t _offset;
+        uint64_t _retry;
+        NameMap _index;
+        std::vector<string> _names;
+    };
+#endif
+}
+}
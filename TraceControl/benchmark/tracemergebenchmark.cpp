@@ -0,0 +1,323 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// N producer threads each write timestamped trace lines into their own cyclic buffer, while one worker
+// drains all buffers in timestamp order and formats every line, like the Observer of the TraceControl
+// does for the trace buffers of the processes. "rescan" is how the Observer used to drain: per line,
+// take the lock, load every buffer, pick the oldest entry and dispatch it. "heap" is how it does now,
+// with the TraceMergeType of the plugin. The lines the worker sustains per second are measured.
+//
+// usage: tracemergebenchmark [buffers [lines per buffer [slots]]]
+
+#include "TraceMerge.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+static constexpr uint32_t LineSize = 96;
+
+struct Line {
+    uint64_t Timestamp;
+    uint32_t Sequence;
+    char Text[LineSize];
+};
+
+// One producer, one consumer. The producer only ever moves the head, the consumer the tail.
+class Source {
+public:
+    enum state {
+        EMPTY,
+        LOADED,
+        FAILURE
+    };
+
+public:
+    Source(const uint32_t id, const uint32_t slots)
+        : _id(id)
+        , _slots(slots)
+        , _lines(new Line[slots])
+        , _head(0)
+        , _tail(0)
+        , _current()
+        , _state(EMPTY)
+        , _expected(0)
+        , _outOfOrder(0)
+    {
+    }
+
+public:
+    void Write(std::atomic<uint64_t>& clock, const uint32_t sequence)
+    {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+
+        while ((head - _tail.load(std::memory_order_acquire)) == _slots) {
+            std::this_thread::yield();
+        }
+
+        Line& line(_lines[head % _slots]);
+        line.Sequence = sequence;
+        snprintf(line.Text, sizeof(line.Text), "Source %u reached sequence %u", _id, sequence);
+        line.Timestamp = clock.fetch_add(1, std::memory_order_relaxed);
+
+        _head.store(head + 1, std::memory_order_release);
+    }
+    state Load()
+    {
+        if (_state == EMPTY) {
+            const uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+            if (tail != _head.load(std::memory_order_acquire)) {
+                _current = _lines[tail % _slots];
+                _tail.store(tail + 1, std::memory_order_release);
+                _state = LOADED;
+            }
+        }
+        return (_state);
+    }
+    uint64_t Timestamp() const
+    {
+        return (_current.Timestamp);
+    }
+    const Line& Current() const
+    {
+        return (_current);
+    }
+    uint32_t Id() const
+    {
+        return (_id);
+    }
+    void Clear()
+    {
+        if (_current.Sequence != _expected) {
+            _outOfOrder++;
+        }
+        _expected = _current.Sequence + 1;
+        _state = EMPTY;
+    }
+    void Flush()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+        _state = EMPTY;
+    }
+    uint32_t OutOfOrder() const
+    {
+        return (_outOfOrder);
+    }
+
+private:
+    const uint32_t _id;
+    const uint32_t _slots;
+    std::unique_ptr<Line[]> _lines;
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    Line _current;
+    state _state;
+    uint32_t _expected;
+    uint32_t _outOfOrder;
+};
+
+// What the outputs do with a line: format it.
+class Output {
+public:
+    Output()
+        : _lines(0)
+        , _characters(0)
+    {
+    }
+
+public:
+    void Dispatch(const Source& source)
+    {
+        char buffer[256];
+        const int length = snprintf(buffer, sizeof(buffer), "[%llu]:[%u]:[Tracing]: %s",
+            static_cast<unsigned long long>(source.Timestamp()), source.Id(), source.Current().Text);
+        _characters += static_cast<uint64_t>(length);
+        _lines++;
+    }
+    uint64_t Lines() const
+    {
+        return (_lines);
+    }
+    uint64_t Characters() const
+    {
+        return (_characters);
+    }
+
+private:
+    uint64_t _lines;
+    uint64_t _characters;
+};
+
+// As the Observer used to: per line the lock is taken and every source reloaded, the oldest is taken.
+class Rescan {
+public:
+    Rescan()
+        : _lock()
+    {
+    }
+
+public:
+    void Drain(const std::vector<Source*>& sources, Output& output)
+    {
+        Source* selected;
+
+        do {
+            selected = nullptr;
+
+            std::lock_guard<std::mutex> guard(_lock);
+
+            uint64_t timeStamp = static_cast<uint64_t>(~0);
+
+            for (Source* source : sources) {
+                Source::state state(source->Load());
+
+                if ((state == Source::LOADED) && (source->Timestamp() < timeStamp)) {
+                    timeStamp = source->Timestamp();
+                    selected = source;
+                } else if (state == Source::FAILURE) {
+                    source->Flush();
+                }
+            }
+
+            if (selected != nullptr) {
+                output.Dispatch(*selected);
+                selected->Clear();
+            }
+        } while (selected != nullptr);
+    }
+
+private:
+    std::mutex _lock;
+};
+
+class Heap {
+public:
+    Heap()
+        : _merge()
+    {
+    }
+
+public:
+    void Drain(const std::vector<Source*>& sources, Output& output)
+    {
+        _merge.Drain(
+            sources,
+            [&output](Source& selected) { output.Dispatch(selected); },
+            []() { return (true); });
+    }
+
+private:
+    TraceMergeType<Source> _merge;
+};
+
+struct Result {
+    double Time; // ms
+    uint64_t Lines;
+    uint64_t Characters;
+    uint32_t OutOfOrder;
+};
+
+template <typename DRAIN>
+Result Run(const uint32_t buffers, const uint32_t lines, const uint32_t slots)
+{
+    std::vector<std::unique_ptr<Source>> sources;
+    std::vector<Source*> view;
+    std::atomic<uint64_t> clock(0);
+    std::vector<std::thread> producers;
+    DRAIN drain;
+    Output output;
+
+    for (uint32_t index = 0; index < buffers; index++) {
+        sources.emplace_back(new Source(index, slots));
+        view.push_back(sources.back().get());
+    }
+
+    const uint64_t total = static_cast<uint64_t>(buffers) * lines;
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    for (Source* source : view) {
+        producers.emplace_back([source, &clock, lines]() {
+            for (uint32_t sequence = 0; sequence < lines; sequence++) {
+                source->Write(clock, sequence);
+            }
+        });
+    }
+
+    while (output.Lines() < total) {
+        const uint64_t before = output.Lines();
+        drain.Drain(view, output);
+        if (output.Lines() == before) {
+            std::this_thread::yield();
+        }
+    }
+
+    Result result;
+    result.Time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    result.Lines = output.Lines();
+    result.Characters = output.Characters();
+    result.OutOfOrder = 0;
+    for (const Source* source : view) {
+        result.OutOfOrder += source->OutOfOrder();
+    }
+
+    return (result);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t buffers = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 16);
+    const uint32_t lines = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 20000);
+    const uint32_t slots = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 256);
+
+    if ((buffers == 0) || (lines == 0) || (slots == 0)) {
+        fprintf(stderr, "usage: %s [buffers [lines per buffer [slots]]]\n", argv[0]);
+        return (1);
+    }
+
+    const Result rescan = Run<Rescan>(buffers, lines, slots);
+    const Result heap = Run<Heap>(buffers, lines, slots);
+
+    printf("%u buffers x %u lines, %u slots per buffer\n", buffers, lines, slots);
+    printf("rescan: %9.3f ms, %10.0f lines/s\n", rescan.Time, rescan.Lines * 1000.0 / rescan.Time);
+    printf("heap:   %9.3f ms, %10.0f lines/s\n", heap.Time, heap.Lines * 1000.0 / heap.Time);
+
+    if ((rescan.Lines != heap.Lines) || (rescan.Characters != heap.Characters) || (rescan.OutOfOrder != 0) || (heap.OutOfOrder != 0)) {
+        fprintf(stderr, "The drained lines differ.\n");
+        return (1);
+    }
+
+    return (0);
+}
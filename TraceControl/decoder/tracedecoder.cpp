@@ -0,0 +1,190 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Turns the binary trace records, written by the TraceControl recorder, into text.
+// Usage: tracedecoder [-a] <tracerecord file> [<tracerecord file> ...]
+// The files are decoded in the order they were written, regardless of the order on the command line.
+
+#include "TraceFormat.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+    struct File {
+        std::string Name;
+        uint32_t Sequence;
+        std::vector<uint8_t> Data;
+    };
+
+    bool Load(const char name[], File& file)
+    {
+        bool result = false;
+        std::ifstream stream(name, std::ios::binary);
+
+        if (stream.is_open() == true) {
+            file.Name = name;
+            file.Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+            TraceFormat::FileHeader header;
+
+            if (file.Data.size() >= sizeof(header)) {
+                ::memcpy(&header, file.Data.data(), sizeof(header));
+
+                if ((header.Magic == TraceFormat::Magic) && (header.Version == TraceFormat::Version)) {
+                    file.Sequence = header.Sequence;
+                    result = true;
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    void Timestamp(const uint64_t ticks, const bool abbreviated, char buffer[], const size_t length)
+    {
+        time_t seconds = static_cast<time_t>(ticks / (1000 * 1000));
+        struct tm moment;
+        gmtime_r(&seconds, &moment);
+
+        if (abbreviated == true) {
+            snprintf(buffer, length, "%02d:%02d:%02d.%03u", moment.tm_hour, moment.tm_min, moment.tm_sec, static_cast<uint32_t>((ticks / 1000) % 1000));
+        } else {
+            size_t size = strftime(buffer, length, "%a, %d %b %Y %H:%M:%S", &moment);
+            snprintf(&buffer[size], length - size, ".%06u GMT", static_cast<uint32_t>(ticks % (1000 * 1000)));
+        }
+    }
+
+    // Returns the number of entries decoded.
+    uint32_t Decode(const File& file, const bool abbreviated)
+    {
+        std::map<uint16_t, std::string> names;
+        const uint8_t* data = file.Data.data();
+        const size_t size = file.Data.size();
+        size_t offset = sizeof(TraceFormat::FileHeader);
+        uint32_t entries = 0;
+        bool done = false;
+
+        while ((done == false) && (offset < size)) {
+            switch (data[offset]) {
+            case TraceFormat::STRING: {
+                TraceFormat::StringHeader header;
+
+                if ((offset + sizeof(header)) > size) {
+                    done = true;
+                } else {
+                    ::memcpy(&header, &data[offset], sizeof(header));
+                    offset += sizeof(header);
+
+                    if ((offset + header.Length) > size) {
+                        done = true;
+                    } else {
+                        names[header.Id] = std::string(reinterpret_cast<const char*>(&data[offset]), header.Length);
+                        offset += header.Length;
+                    }
+                }
+                break;
+            }
+            case TraceFormat::ENTRY: {
+                TraceFormat::EntryHeader header;
+
+                if ((offset + sizeof(header)) > size) {
+                    done = true;
+                } else {
+                    ::memcpy(&header, &data[offset], sizeof(header));
+                    offset += sizeof(header);
+
+                    if ((offset + header.Length) > size) {
+                        done = true;
+                    } else {
+                        char time[64];
+                        Timestamp(header.Timestamp, abbreviated, time, sizeof(time));
+
+                        if (abbreviated == true) {
+                            printf("[%s]: %.*s\n", time, header.Length, reinterpret_cast<const char*>(&data[offset]));
+                        } else {
+                            const std::string& fileName(names[header.File]);
+                            size_t slash = fileName.find_last_of("/\\");
+
+                            printf("[%s]:[%s:%u] %s/%s %s: %.*s\n", time,
+                                (slash == std::string::npos ? fileName.c_str() : &(fileName.c_str()[slash + 1])),
+                                header.LineNumber, names[header.Module].c_str(), names[header.Category].c_str(),
+                                names[header.ClassName].c_str(), header.Length, reinterpret_cast<const char*>(&data[offset]));
+                        }
+
+                        offset += header.Length;
+                        entries++;
+                    }
+                }
+                break;
+            }
+            default:
+                // END marker, the rest of the file is not used.
+                done = true;
+                break;
+            }
+        }
+
+        return (entries);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool abbreviated = false;
+    std::vector<File> files;
+
+    for (int index = 1; index < argc; index++) {
+        if (strcmp(argv[index], "-a") == 0) {
+            abbreviated = true;
+        } else {
+            File file;
+
+            if (Load(argv[index], file) == true) {
+                files.push_back(std::move(file));
+            } else {
+                fprintf(stderr, "Skipping %s, not a trace record file.\n", argv[index]);
+            }
+        }
+    }
+
+    if (files.empty() == true) {
+        fprintf(stderr, "Usage: %s [-a] <tracerecord file> [<tracerecord file> ...]\n", argv[0]);
+        return (1);
+    }
+
+    std::sort(files.begin(), files.end(), [](const File& lhs, const File& rhs) { return (lhs.Sequence < rhs.Sequence); });
+
+    for (const File& file : files) {
+        uint32_t entries = Decode(file, abbreviated);
+        fprintf(stderr, "%s: %u entries\n", file.Name.c_str(), entries);
+    }
+
+    return (0);
+}
@@ -0,0 +1,109 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Single producer, single consumer ring. Each direction of the proxy has its own ring, the
+    // producing and consuming side run on different threads and never have to wait for each other.
+    class StreamRing {
+    private:
+        StreamRing() = delete;
+        StreamRing(const StreamRing&) = delete;
+        StreamRing& operator=(const StreamRing&) = delete;
+
+    public:
+        StreamRing(const uint32_t size)
+            : _mask(Capacity(size) - 1)
+            , _buffer(new uint8_t[_mask + 1])
+            , _head(0)
+            , _tail(0)
+        {
+        }
+        ~StreamRing()
+        {
+            delete[] _buffer;
+        }
+
+    public:
+        // Producer side. The second parameter is set if the consumer might have found the ring empty,
+        // and it needs to be triggered to come back for the new data.
+        uint16_t Write(const uint8_t data[], const uint16_t length, bool& wasEmpty)
+        {
+            uint32_t head = _head.load(std::memory_order_relaxed);
+            uint32_t free = (_mask + 1) - (head - _tail.load());
+            uint16_t result = static_cast<uint16_t>(std::min(static_cast<uint32_t>(length), free));
+            uint32_t offset = head & _mask;
+            uint32_t first = std::min(static_cast<uint32_t>(result), _mask + 1 - offset);
+
+            ::memcpy(&(_buffer[offset]), data, first);
+            ::memcpy(_buffer, &(data[first]), result - first);
+
+            _head.store(head + result);
+
+            // If the consumer did not take anything beyond the previous head, it saw an empty ring.
+            wasEmpty = ((result > 0) && (_tail.load() == head));
+
+            return (result);
+        }
+        // Consumer side.
+        uint16_t Read(uint8_t data[], const uint16_t length)
+        {
+            uint32_t tail = _tail.load(std::memory_order_relaxed);
+            uint32_t used = _head.load() - tail;
+            uint16_t result = static_cast<uint16_t>(std::min(static_cast<uint32_t>(length), used));
+            uint32_t offset = tail & _mask;
+            uint32_t first = std::min(static_cast<uint32_t>(result), _mask + 1 - offset);
+
+            ::memcpy(data, &(_buffer[offset]), first);
+            ::memcpy(&(data[first]), _buffer, result - first);
+
+            _tail.store(tail + result);
+
+            return (result);
+        }
+
+    private:
+        static uint32_t Capacity(const uint32_t size)
+        {
+            uint32_t result = 1024;
+
+            while (result < size) {
+                result <<= 1;
+            }
+
+            return (result);
+        }
+
+    private:
+        const uint32_t _mask;
+        uint8_t* _buffer;
+        std::atomic<uint32_t> _head;
+        std::atomic<uint32_t> _tail;
+    };
+
+} // namespace Plugin
+} // namespace WPEFramework
@@ -177,18 +177,19 @@ namespace Plugin {
 #ifdef __WINDOWS__
 #pragma warning(disable : 4355)
 #endif
-        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t bufferSize)
-            : WebProxy::Connector(channel, &_streamType)
+        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t ringSize, const uint32_t bufferSize)
+            : WebProxy::Connector(channel, &_streamType, ringSize)
             , _streamType(*this, bufferSize)
         {
         }
-        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t bufferSize, const Core::NodeId& remoteId)
-            : WebProxy::Connector(channel, &_streamType)
+        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t ringSize, const uint32_t bufferSize, const Core::NodeId& remoteId)
+            : WebProxy::Connector(channel, &_streamType, ringSize)
             , _streamType(*this, bufferSize, remoteId)
         {
         }
         inline ConnectorWrapper(
             PluginHost::Channel& channel,
+            const uint32_t ringSize,
             const uint32_t bufferSize,
             const string& deviceName,
             const Core::SerialPort::BaudRate baudrate,
@@ -196,7 +197,7 @@ namespace Plugin {
             const Core::SerialPort::DataBits dataBits,
             const Core::SerialPort::StopBits stopBits,
             const Core::SerialPort::FlowControl flowControl)
-            : WebProxy::Connector(channel, &_streamType)
+            : WebProxy::Connector(channel, &_streamType, ringSize)
             , _streamType(*this, bufferSize, deviceName, baudrate, parityE, dataBits, stopBits, flowControl)
         {
         }
@@ -225,6 +226,7 @@ namespace Plugin {
         config.FromString(service->ConfigLine());
 
         _maxConnections = config.Connections.Value();
+        _bufferSize = config.BufferSize.Value();
 
         // Copy all predefined links...
         if ((config.Links.IsSet() == true) && (config.Links.Length() != 0)) {
@@ -395,12 +397,12 @@ namespace Plugin {
             Core::NodeId remote(host.Text().c_str());
 
             if (datagram == true) {
-                result = new ConnectorWrapper<DatagramChannel>(channel, 1024, remote);
+                result = new ConnectorWrapper<DatagramChannel>(channel, _bufferSize, 1024, remote);
             } else {
-                result = new ConnectorWrapper<StreamChannel>(channel, 1024, remote);
+                result = new ConnectorWrapper<StreamChannel>(channel, _bufferSize, 1024, remote);
             }
         } else if ((device.Length() > 0) && (host.Length() == 0)) {
-            result = new ConnectorWrapper<DeviceChannel>(channel, 1024, device.Text(), baudRate, parity, dataBits, stopBits, flowControl);
+            result = new ConnectorWrapper<DeviceChannel>(channel, _bufferSize, 1024, device.Text(), baudRate, parity, dataBits, stopBits, flowControl);
         }
 
         if ((result != nullptr) && (text == true)) {
@@ -21,6 +21,7 @@
 #define __PLUGINWEBPROXY_H
 
 #include "Module.h"
+#include "StreamRing.h"
 
 namespace WPEFramework {
 namespace Plugin {
@@ -37,12 +38,12 @@ namespace Plugin {
             Connector& operator=(const Connector&) = delete;
 
         public:
-            Connector(PluginHost::Channel& channel, Core::IStream* link)
+            Connector(PluginHost::Channel& channel, Core::IStream* link, const uint32_t bufferSize)
                 : _link(link)
                 , _channel(&channel)
                 , _adminLock()
-                , _channelBuffer()
-                , _socketBuffer()
+                , _channelBuffer(bufferSize)
+                , _socketBuffer(bufferSize)
             {
             }
             virtual ~Connector()
@@ -71,62 +72,49 @@ namespace Plugin {
             {
                 return ((_channel == nullptr) && (_link->IsClosed()));
             }
-            // Methods to extract and insert data into the socket buffers
+            // Methods to extract and insert data into the socket buffers. The data itself is passed through
+            // the rings, the lock only guards the channel against a concurrent Detach.
             uint16_t SendData(uint8_t* dataFrame, const uint16_t maxSendSize)
             {
-                _adminLock.Lock();
-
-                uint16_t result = _socketBuffer.Read(dataFrame, maxSendSize);
-
-                _adminLock.Unlock();
-
-                return (result);
+                return (_socketBuffer.Read(dataFrame, maxSendSize));
             }
 
             uint16_t ReceiveData(uint8_t* dataFrame, const uint16_t receivedSize)
             {
-                _adminLock.Lock();
-
-                bool wasEmpty = _channelBuffer.IsEmpty();
+                bool wasEmpty;
 
-                uint16_t result = _channelBuffer.Write(dataFrame, receivedSize);
+                uint16_t result = _channelBuffer.Write(dataFrame, receivedSize, wasEmpty);
 
                 if (wasEmpty == true) {
                     // This is new data, there was nothing pending, trigger a request for a frambuffer.
-                    _channel->RequestOutbound();
-                }
+                    _adminLock.Lock();
 
-                _adminLock.Unlock();
+                    if (_channel != nullptr) {
+                        _channel->RequestOutbound();
+                    }
+
+                    _adminLock.Unlock();
+                }
 
                 return (result);
             }
 
             uint16_t ChannelSend(uint8_t* dataFrame, const uint16_t maxSendSize) const
             {
-                _adminLock.Lock();
-
-                uint16_t result = _channelBuffer.Read(dataFrame, maxSendSize);
-
-                _adminLock.Unlock();
-
-                return (result);
+                return (_channelBuffer.Read(dataFrame, maxSendSize));
             }
 
             uint16_t ChannelReceive(const uint8_t* dataFrame, const uint16_t receivedSize)
             {
-                _adminLock.Lock();
-
-                bool wasEmpty = _socketBuffer.IsEmpty();
+                bool wasEmpty;
 
-                uint16_t result = _socketBuffer.Write(dataFrame, receivedSize);
+                uint16_t result = _socketBuffer.Write(dataFrame, receivedSize, wasEmpty);
 
                 if (wasEmpty == true) {
                     // This is new data, there was nothing pending, trigger a request for a frambuffer.
                     _link->Trigger();
                 }
 
-                _adminLock.Unlock();
-
                 return (result);
             }
 
@@ -161,8 +149,8 @@ namespace Plugin {
             Core::IStream* _link;
             PluginHost::Channel* _channel;
             mutable Core::CriticalSection _adminLock;
-            Core::CyclicDataBuffer<Core::ScopedStorage<8192>> _channelBuffer;
-            Core::CyclicDataBuffer<Core::ScopedStorage<8192>> _socketBuffer;
+            mutable StreamRing _channelBuffer;
+            StreamRing _socketBuffer;
         };
         class Config : public Core::JSON::Container {
         public:
@@ -318,8 +306,10 @@ namespace Plugin {
             Config()
                 : Core::JSON::Container()
                 , Connections(10)
+                , BufferSize(8192)
             {
                 Add(_T("connections"), &Connections);
+                Add(_T("buffersize"), &BufferSize);
                 Add(_T("links"), &Links);
             }
             ~Config()
@@ -328,12 +318,15 @@ namespace Plugin {
 
         public:
             Core::JSON::DecUInt16 Connections;
+            Core::JSON::DecUInt32 BufferSize; // bytes per direction, rounded up to a power of 2
             Core::JSON::ArrayType<Link> Links;
         };
 
     public:
         WebProxy()
-            : _connectionMap()
+            : _maxConnections(0)
+            , _bufferSize(0)
+            , _connectionMap()
         {
         }
         virtual ~WebProxy()
@@ -389,6 +382,7 @@ namespace Plugin {
     private:
         string _prefix;
         uint32_t _maxConnections;
+        uint32_t _bufferSize;
         std::map<const uint32_t, Connector*> _connectionMap;
         std::map<const string, Config::Link> _linkInfo;
     };
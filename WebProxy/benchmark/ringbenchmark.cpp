@@ -0,0 +1,453 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Streams data through a proxy connector to an echo server on localhost and back. The channel thread
+// plays the websocket side: it writes frames into the connector and reads the echo from it. The socket
+// thread plays the link: it sends what the connector holds to the echo server and puts what comes back
+// into the connector. Both only wake the other side when it might have found its buffer empty, as the
+// WebProxy does with RequestOutbound and Trigger.
+// "locked" is how the Connector used to be: two cyclic buffers of 8 KB behind one lock, so both threads
+// take turns on every read and write. "ring" is how it is now: a StreamRing per direction.
+//
+// usage: ringbenchmark [megabytes [frame size [ring size]]]
+
+#include "StreamRing.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <semaphore.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+// Returns every byte it receives on its first connection.
+class EchoServer {
+public:
+    EchoServer()
+        : _listener(::socket(AF_INET, SOCK_STREAM, 0))
+        , _port(0)
+        , _worker()
+    {
+        sockaddr_in address;
+        socklen_t length = sizeof(address);
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if ((::bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) && (::listen(_listener, 1) == 0) && (::getsockname(_listener, reinterpret_cast<sockaddr*>(&address), &length) == 0)) {
+            _port = ntohs(address.sin_port);
+        }
+    }
+    ~EchoServer()
+    {
+        if (_worker.joinable() == true) {
+            _worker.join();
+        }
+        ::close(_listener);
+    }
+
+public:
+    uint16_t Port() const
+    {
+        return (_port);
+    }
+    // Serves one connection, until it is closed.
+    void Serve()
+    {
+        _worker = std::thread([this]() {
+            int fd = ::accept(_listener, nullptr, nullptr);
+            uint8_t buffer[16384];
+            ssize_t length;
+
+            while ((fd >= 0) && ((length = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)) {
+                ssize_t offset = 0;
+                while (offset < length) {
+                    ssize_t written = ::send(fd, &buffer[offset], length - offset, MSG_NOSIGNAL);
+                    if (written <= 0) {
+                        break;
+                    }
+                    offset += written;
+                }
+            }
+
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        });
+    }
+
+private:
+    int _listener;
+    uint16_t _port;
+    std::thread _worker;
+};
+
+// As the Core::CyclicDataBuffer the connector used to have.
+class CyclicBuffer {
+public:
+    CyclicBuffer()
+        : _head(0)
+        , _tail(0)
+    {
+    }
+
+public:
+    bool IsEmpty() const
+    {
+        return (_head == _tail);
+    }
+    uint16_t Write(const uint8_t data[], const uint16_t length)
+    {
+        const uint32_t free = (Size - 1) - Used();
+        const uint16_t result = static_cast<uint16_t>(length < free ? length : free);
+        const uint32_t first = (result < (Size - _head) ? result : Size - _head);
+
+        memcpy(&_data[_head], data, first);
+        memcpy(_data, &data[first], result - first);
+        _head = (_head + result) % Size;
+
+        return (result);
+    }
+    uint16_t Read(uint8_t data[], const uint16_t length)
+    {
+        const uint32_t used = Used();
+        const uint16_t result = static_cast<uint16_t>(length < used ? length : used);
+        const uint32_t first = (result < (Size - _tail) ? result : Size - _tail);
+
+        memcpy(data, &_data[_tail], first);
+        memcpy(&data[first], _data, result - first);
+        _tail = (_tail + result) % Size;
+
+        return (result);
+    }
+
+private:
+    uint32_t Used() const
+    {
+        return ((_head + Size - _tail) % Size);
+    }
+
+private:
+    static constexpr uint32_t Size = 8192;
+
+    uint8_t _data[Size];
+    uint32_t _head;
+    uint32_t _tail;
+};
+
+// The connector as it used to be: one lock over both directions.
+class Locked {
+public:
+    Locked(const uint32_t)
+        : _lock()
+        , _channelBuffer()
+        , _socketBuffer()
+    {
+    }
+
+public:
+    uint16_t SendData(uint8_t data[], const uint16_t length)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return (_socketBuffer.Read(data, length));
+    }
+    uint16_t ReceiveData(const uint8_t data[], const uint16_t length, bool& trigger)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        trigger = _channelBuffer.IsEmpty();
+        return (_channelBuffer.Write(data, length));
+    }
+    uint16_t ChannelSend(uint8_t data[], const uint16_t length)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return (_channelBuffer.Read(data, length));
+    }
+    uint16_t ChannelReceive(const uint8_t data[], const uint16_t length, bool& trigger)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        trigger = _socketBuffer.IsEmpty();
+        return (_socketBuffer.Write(data, length));
+    }
+
+private:
+    std::mutex _lock;
+    CyclicBuffer _channelBuffer;
+    CyclicBuffer _socketBuffer;
+};
+
+// The connector as it is now.
+class Ring {
+public:
+    Ring(const uint32_t size)
+        : _channelBuffer(size)
+        , _socketBuffer(size)
+    {
+    }
+
+public:
+    uint16_t SendData(uint8_t data[], const uint16_t length)
+    {
+        return (_socketBuffer.Read(data, length));
+    }
+    uint16_t ReceiveData(const uint8_t data[], const uint16_t length, bool& trigger)
+    {
+        return (_channelBuffer.Write(data, length, trigger));
+    }
+    uint16_t ChannelSend(uint8_t data[], const uint16_t length)
+    {
+        return (_channelBuffer.Read(data, length));
+    }
+    uint16_t ChannelReceive(const uint8_t data[], const uint16_t length, bool& trigger)
+    {
+        return (_socketBuffer.Write(data, length, trigger));
+    }
+
+private:
+    StreamRing _channelBuffer;
+    StreamRing _socketBuffer;
+};
+
+inline uint8_t Pattern(const uint64_t position)
+{
+    return (static_cast<uint8_t>((position * 7) + (position >> 11)));
+}
+
+struct Result {
+    double Time; // ms
+    uint64_t Corrupt;
+    uint32_t Wakeups;
+};
+
+// The socket thread: moves data between the connector and the echo server.
+template <typename CONNECTOR>
+void Link(CONNECTOR& connector, const int fd, const int wake, sem_t& channel, const std::atomic<bool>& done, uint32_t& wakeups)
+{
+    std::vector<uint8_t> out(16384);
+    std::vector<uint8_t> in(16384);
+    uint32_t outOffset = 0, outLength = 0;
+    uint32_t inOffset = 0, inLength = 0;
+
+    while (done == false) {
+        if (outOffset == outLength) {
+            outOffset = 0;
+            outLength = connector.SendData(out.data(), static_cast<uint16_t>(out.size()));
+        }
+        if (outOffset < outLength) {
+            ssize_t written = ::send(fd, &out[outOffset], outLength - outOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (written > 0) {
+                outOffset += static_cast<uint32_t>(written);
+            }
+        }
+        if (inOffset < inLength) {
+            bool trigger = false;
+            inOffset += connector.ReceiveData(&in[inOffset], static_cast<uint16_t>(inLength - inOffset), trigger);
+            if (trigger == true) {
+                sem_post(&channel);
+            }
+        }
+
+        pollfd descriptors[2] = { { fd, 0, 0 }, { wake, POLLIN, 0 } };
+
+        if (inOffset == inLength) {
+            descriptors[0].events |= POLLIN;
+        }
+        if (outOffset < outLength) {
+            descriptors[0].events |= POLLOUT;
+        }
+
+        // With echoed data that did not fit, come back soon, the channel side does not wake us for room.
+        if (::poll(descriptors, 2, (inOffset < inLength ? 1 : 100)) > 0) {
+            if ((descriptors[1].revents & POLLIN) != 0) {
+                char buffer[64];
+                if (::read(wake, buffer, sizeof(buffer)) > 0) {
+                    wakeups++;
+                }
+            }
+            if ((descriptors[0].revents & POLLIN) != 0) {
+                ssize_t length = ::recv(fd, in.data(), in.size(), MSG_DONTWAIT);
+                if (length > 0) {
+                    inOffset = 0;
+                    inLength = static_cast<uint32_t>(length);
+                }
+            }
+        }
+    }
+}
+
+template <typename CONNECTOR>
+Result Run(const uint16_t port, const uint64_t total, const uint16_t frameSize, const uint32_t ringSize)
+{
+    CONNECTOR connector(ringSize);
+    Result result = { 0, 0, 0 };
+    uint32_t linkWakeups = 0;
+    std::atomic<bool> done(false);
+    sem_t channel;
+    int wake[2];
+
+    sem_init(&channel, 0, 0);
+
+    if (::pipe(wake) != 0) {
+        result.Corrupt = total;
+        return (result);
+    }
+
+    ::fcntl(wake[0], F_SETFL, O_NONBLOCK);
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int on = 1;
+    sockaddr_in address;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        result.Corrupt = total;
+        return (result);
+    }
+
+    std::vector<uint8_t> frame(frameSize);
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    std::thread link([&connector, fd, &wake, &channel, &done, &linkWakeups]() {
+        Link(connector, fd, wake[0], channel, done, linkWakeups);
+    });
+
+    // The channel thread.
+    while (received < total) {
+        bool progress = false;
+
+        if (sent < total) {
+            const uint16_t length = static_cast<uint16_t>(std::min(static_cast<uint64_t>(frameSize), total - sent));
+            bool trigger = false;
+
+            for (uint16_t index = 0; index < length; index++) {
+                frame[index] = Pattern(sent + index);
+            }
+
+            const uint16_t written = connector.ChannelReceive(frame.data(), length, trigger);
+
+            if (trigger == true) {
+                const char signal = 1;
+                if (::write(wake[1], &signal, 1) != 1) {
+                    fprintf(stderr, "Could not wake the link.\n");
+                }
+            }
+
+            sent += written;
+            progress = (written > 0);
+        }
+
+        const uint16_t length = connector.ChannelSend(frame.data(), frameSize);
+
+        for (uint16_t index = 0; index < length; index++) {
+            if (frame[index] != Pattern(received + index)) {
+                result.Corrupt++;
+            }
+        }
+
+        received += length;
+        progress = progress || (length > 0);
+
+        if (progress == false) {
+            // Nothing moved, wait for the link to report new data. It does not report room, so do not
+            // wait long if there is still something to write.
+            timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += 1000000;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+            }
+            if (sem_timedwait(&channel, &until) == 0) {
+                result.Wakeups++;
+            }
+        }
+    }
+
+    result.Time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    done = true;
+    link.join();
+
+    result.Wakeups += linkWakeups;
+
+    ::close(fd);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    sem_destroy(&channel);
+
+    return (result);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t megabytes = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 64);
+    const uint32_t frameSize = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1024);
+    const uint32_t ringSize = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 8192);
+
+    if ((megabytes == 0) || (frameSize == 0) || (frameSize > 0xFFFF) || (ringSize == 0)) {
+        fprintf(stderr, "usage: %s [megabytes [frame size [ring size]]]\n", argv[0]);
+        return (1);
+    }
+
+    const uint64_t total = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+
+    EchoServer lockedEcho;
+    lockedEcho.Serve();
+    const Result locked = Run<Locked>(lockedEcho.Port(), total, static_cast<uint16_t>(frameSize), ringSize);
+
+    EchoServer ringEcho;
+    ringEcho.Serve();
+    const Result ring = Run<Ring>(ringEcho.Port(), total, static_cast<uint16_t>(frameSize), ringSize);
+
+    printf("%u MB echoed in frames of %u bytes, ring of %u bytes\n", megabytes, frameSize, ringSize);
+    printf("locked: %9.3f ms, %8.1f MB/s, %8u wakeups\n", locked.Time, megabytes * 1000.0 / locked.Time, locked.Wakeups);
+    printf("ring:   %9.3f ms, %8.1f MB/s, %8u wakeups\n", ring.Time, megabytes * 1000.0 / ring.Time, ring.Wakeups);
+
+    if ((locked.Corrupt != 0) || (ring.Corrupt != 0)) {
+        fprintf(stderr, "The echo differs, locked: %llu bytes, ring: %llu bytes\n", static_cast<unsigned long long>(locked.Corrupt), static_cast<unsigned long long>(ring.Corrupt));
+        return (1);
+    }
+
+    return (0);
+}
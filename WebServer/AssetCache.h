@@ -0,0 +1,691 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Module.h"
+
+#ifndef __WINDOWS__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+namespace WPEFramework {
+namespace Plugin {
+
+#ifndef __WINDOWS__
+    // Keeps a private copy of the (small) files served by the WebServer, so they only have to come from (slow)
+    // storage once. The files are read, not mapped: a file that is truncated or rewritten in place while it is
+    // being served would otherwise take down the process with a SIGBUS. Next to a file, a precompressed <file>.gz and/or <file>.br variant is picked up and served to
+    // the clients that accept it. Changes on disk are picked up through inotify, the entries of the touched
+    // files are dropped, so the next request maps the new content.
+    class AssetCache {
+    public:
+        enum encoding : uint8_t {
+            IDENTITY = 0x00,
+            GZIP = 0x01,
+            BROTLI = 0x02
+        };
+
+        class Asset {
+        public:
+            Asset() = delete;
+            Asset(const Asset&) = delete;
+            Asset& operator=(const Asset&) = delete;
+
+            Asset(const string& fileName, const encoding type, const uint32_t maxSize)
+                : _data()
+                , _size(0)
+                , _modified(0)
+                , _encoding(type)
+                , _varies(false)
+                , _tag()
+            {
+                int descriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+                if (descriptor != -1) {
+                    struct stat info;
+
+                    if ((::fstat(descriptor, &info) == 0) && (S_ISREG(info.st_mode)) && (info.st_size > 0) && (static_cast<uint64_t>(info.st_size) <= maxSize)) {
+                        const uint32_t size = static_cast<uint32_t>(info.st_size);
+                        const time_t modified = info.st_mtime;
+                        std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+                        uint32_t loaded = 0;
+                        ssize_t length = 1;
+
+                        while ((loaded < size) && (length > 0)) {
+                            length = ::read(descriptor, &(data[loaded]), size - loaded);
+
+                            if (length > 0) {
+                                loaded += static_cast<uint32_t>(length);
+                            } else if ((length == -1) && (errno == EINTR)) {
+                                length = 1;
+                            }
+                        }
+
+                        // Changed while reading, rather not cache it than serve a mix.
+                        if ((loaded == size) && (::fstat(descriptor, &info) == 0) && (static_cast<uint64_t>(info.st_size) == size) && (info.st_mtime == modified)) {
+                            _data = std::move(data);
+                            _size = size;
+                            _modified = static_cast<uint64_t>(info.st_mtime);
+                        }
+                    }
+
+                    ::close(descriptor);
+                }
+            }
+            ~Asset()
+            {
+            }
+
+        public:
+            inline bool IsValid() const
+            {
+                return (_data != nullptr);
+            }
+            inline const uint8_t* Data() const
+            {
+                return (_data.get());
+            }
+            inline uint32_t Size() const
+            {
+                return (_size);
+            }
+            inline encoding Encoding() const
+            {
+                return (_encoding);
+            }
+            // Seconds since the epoch.
+            inline uint64_t Modified() const
+            {
+                return (_modified);
+            }
+            inline const string& Tag() const
+            {
+                return (_tag);
+            }
+            // Other encodings of the same file exist, the response depends on Accept-Encoding.
+            inline bool Varies() const
+            {
+                return (_varies);
+            }
+            inline void Varies(const bool varies)
+            {
+                _varies = varies;
+            }
+            void Tag(const uint64_t modified, const uint32_t size)
+            {
+                static const TCHAR* suffix[] = { _T(""), _T("-gz"), _T("-br") };
+
+                TCHAR buffer[48];
+                ::snprintf(buffer, sizeof(buffer), _T("\"%llx-%x%s\""), static_cast<unsigned long long>(modified), size, suffix[_encoding]);
+                _tag = buffer;
+            }
+
+        private:
+            std::unique_ptr<uint8_t[]> _data;
+            uint32_t _size;
+            uint64_t _modified;
+            const encoding _encoding;
+            bool _varies;
+            string _tag;
+        };
+
+        // Streams a cached asset as a response body. The asset stays alive as long as a body refers to it,
+        // even if it is dropped from the cache in the meantime.
+        class Body : public Web::IBody {
+        public:
+            Body() = delete;
+            Body(const Body&) = delete;
+            Body& operator=(const Body&) = delete;
+
+            Body(const std::shared_ptr<const Asset>& asset)
+                : _asset(asset)
+                , _offset(0)
+            {
+            }
+            ~Body() override
+            {
+            }
+
+        private:
+            uint32_t Serialize() const override
+            {
+                _offset = 0;
+                return (_asset->Size());
+            }
+            uint32_t Deserialize() override
+            {
+                return (0);
+            }
+            void End() const override
+            {
+            }
+            uint16_t Serialize(uint8_t stream[], const uint16_t maxLength) const override
+            {
+                uint16_t size = static_cast<uint16_t>(std::min(static_cast<uint32_t>(maxLength), _asset->Size() - _offset));
+
+                ::memcpy(stream, &(_asset->Data()[_offset]), size);
+                _offset += size;
+
+                return (size);
+            }
+            uint16_t Deserialize(const uint8_t[], const uint16_t) override
+            {
+                return (0);
+            }
+
+        private:
+            std::shared_ptr<const Asset> _asset;
+            mutable uint32_t _offset;
+        };
+
+    private:
+        struct Entry {
+            std::shared_ptr<Asset> Variants[3];
+            uint32_t Size;
+            std::list<string>::iterator Position;
+        };
+
+        using EntryMap = std::unordered_map<string, Entry>;
+
+        // Receives the inotify events of the watched directories on the resource monitor thread.
+        class Watcher : public Core::IResource {
+        public:
+            Watcher() = delete;
+            Watcher(const Watcher&) = delete;
+            Watcher& operator=(const Watcher&) = delete;
+
+            Watcher(AssetCache& parent)
+                : _parent(parent)
+                , _adminLock()
+                , _descriptor(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+                , _directories()
+            {
+                if (_descriptor == -1) {
+                    SYSLOG(Logging::Notification, (_T("Could not create the inotify instance, cached files are not refreshed.")));
+                } else {
+                    Core::ResourceMonitor::Instance().Register(*this);
+                }
+            }
+            ~Watcher() override
+            {
+                if (_descriptor != -1) {
+                    Core::ResourceMonitor::Instance().Unregister(*this);
+                    ::close(_descriptor);
+                }
+            }
+
+        public:
+            void Watch(const string& directory)
+            {
+                if (_descriptor != -1) {
+                    int id = ::inotify_add_watch(_descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+
+                    if (id != -1) {
+                        _adminLock.Lock();
+                        _directories[id] = directory;
+                        _adminLock.Unlock();
+                    }
+                }
+            }
+
+        private:
+            Core::IResource::handle Descriptor() const override
+            {
+                return (_descriptor);
+            }
+            uint16_t Events() override
+            {
+                return (POLLIN);
+            }
+            void Handle(const uint16_t events) override
+            {
+                if ((events & POLLIN) != 0) {
+                    uint8_t buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+                    ssize_t length;
+
+                    while ((length = ::read(_descriptor, buffer, sizeof(buffer))) > 0) {
+                        ssize_t offset = 0;
+
+                        while (offset < length) {
+                            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(&buffer[offset]);
+
+                            Changed(*event);
+
+                            offset += sizeof(struct inotify_event) + event->len;
+                        }
+                    }
+                }
+            }
+            void Changed(const struct inotify_event& event)
+            {
+                if ((event.mask & IN_Q_OVERFLOW) != 0) {
+                    // We lost track, start from scratch.
+                    _parent.Clear();
+                } else {
+                    string directory;
+
+                    _adminLock.Lock();
+
+                    std::unordered_map<int, string>::iterator index(_directories.find(event.wd));
+
+                    if (index != _directories.end()) {
+                        directory = index->second;
+
+                        if ((event.mask & IN_IGNORED) != 0) {
+                            _directories.erase(index);
+                        }
+                    }
+
+                    _adminLock.Unlock();
+
+                    if (directory.empty() == false) {
+                        if ((event.mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+                            _parent.Invalidate(directory, string());
+                        } else if (event.len > 0) {
+                            _parent.Invalidate(directory, string(event.name));
+                        }
+                    }
+                }
+            }
+
+        private:
+            AssetCache& _parent;
+            Core::CriticalSection _adminLock;
+            int _descriptor;
+            std::unordered_map<int, string> _directories;
+        };
+
+    public:
+        // The counters of the cache are kept in a small file that the cache and the plugin both map, so the
+        // plugin can report them while the WebServer runs in another process. Until a file is opened, the
+        // counters are kept in process.
+        class Counters {
+        public:
+            Counters(const Counters&) = delete;
+            Counters& operator=(const Counters&) = delete;
+
+            struct Values {
+                std::atomic<uint32_t> Hits;
+                std::atomic<uint32_t> Misses;
+                std::atomic<uint32_t> NotModified;
+                std::atomic<uint32_t> Size;
+                std::atomic<uint64_t> BytesServed;
+            };
+
+        public:
+            Counters()
+                : _values(&_local)
+                , _local()
+            {
+            }
+            ~Counters()
+            {
+                Close();
+            }
+
+        public:
+            static string FileName(const string& volatilePath)
+            {
+                return (volatilePath + _T("assetcache.counters"));
+            }
+            // The cache creates the file and starts counting from 0, the plugin only reads it.
+            bool Open(const string& fileName, const bool create)
+            {
+                int descriptor = ::open(fileName.c_str(), (create == true ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY) | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP);
+
+                Close();
+
+                if (descriptor != -1) {
+                    struct stat info;
+
+                    if (((create == false) || (::ftruncate(descriptor, sizeof(Values)) == 0)) && (::fstat(descriptor, &info) == 0) && (static_cast<uint64_t>(info.st_size) >= sizeof(Values))) {
+                        void* area = ::mmap(nullptr, sizeof(Values), (create == true ? PROT_READ | PROT_WRITE : PROT_READ), MAP_SHARED, descriptor, 0);
+
+                        if (area != MAP_FAILED) {
+                            _values = static_cast<Values*>(area);
+                        }
+                    }
+
+                    ::close(descriptor);
+                }
+
+                return (_values != &_local);
+            }
+            void Close()
+            {
+                if (_values != &_local) {
+                    ::munmap(_values, sizeof(Values));
+                    _values = &_local;
+                }
+            }
+            inline Values* operator->()
+            {
+                return (_values);
+            }
+            inline const Values* operator->() const
+            {
+                return (_values);
+            }
+
+        private:
+            Values* _values;
+            Values _local;
+        };
+
+    public:
+        AssetCache(const AssetCache&) = delete;
+        AssetCache& operator=(const AssetCache&) = delete;
+
+        AssetCache()
+            : _adminLock()
+            , _entries()
+            , _order()
+            , _watched()
+            , _watcher(nullptr)
+            , _maxSize(0)
+            , _maxFileSize(0)
+            , _size(0)
+            , _counters()
+        {
+        }
+        ~AssetCache()
+        {
+            Configure(0, 0);
+        }
+
+    public:
+        // A maxSize of 0 disables the cache.
+        void Configure(const uint32_t maxSize, const uint32_t maxFileSize)
+        {
+            _adminLock.Lock();
+
+            // The watcher calls back into the cache, so it is destructed outside the lock.
+            Watcher* obsolete = _watcher;
+
+            Reset();
+
+            _watched.clear();
+            _maxSize = maxSize;
+            _maxFileSize = maxFileSize;
+            _watcher = (_maxSize != 0 ? new Watcher(*this) : nullptr);
+
+            _adminLock.Unlock();
+
+            if (obsolete != nullptr) {
+                delete obsolete;
+            }
+        }
+        // Publish the counters in the given file, call before the cache is used.
+        bool Publish(const string& fileName)
+        {
+            return (_counters.Open(fileName, true));
+        }
+        void Clear()
+        {
+            _adminLock.Lock();
+            Reset();
+            _adminLock.Unlock();
+        }
+
+        // Returns the best variant of the file, given the encodings (bitmask) the client accepts, nullptr
+        // if the file can not be cached.
+        std::shared_ptr<const Asset> Find(const string& fileName, const uint8_t accepted)
+        {
+            std::shared_ptr<const Asset> result;
+
+            _adminLock.Lock();
+
+            if (_maxSize != 0) {
+                EntryMap::iterator index(_entries.find(fileName));
+
+                if (index != _entries.end()) {
+                    _counters->Hits++;
+                    _order.splice(_order.begin(), _order, index->second.Position);
+                } else {
+                    _counters->Misses++;
+                    index = Load(fileName);
+                }
+
+                if (index != _entries.end()) {
+                    const Entry& entry(index->second);
+
+                    if (((accepted & BROTLI) != 0) && (entry.Variants[BROTLI] != nullptr)) {
+                        result = entry.Variants[BROTLI];
+                    } else if (((accepted & GZIP) != 0) && (entry.Variants[GZIP] != nullptr)) {
+                        result = entry.Variants[GZIP];
+                    } else {
+                        result = entry.Variants[IDENTITY];
+                    }
+                }
+
+                _counters->Size = _size;
+            }
+
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        void Served(const uint32_t bytes)
+        {
+            _counters->BytesServed += bytes;
+        }
+        void NotModified()
+        {
+            _counters->NotModified++;
+        }
+        void Statistics(uint32_t& hits, uint32_t& misses, uint32_t& notModified, uint64_t& bytesServed, uint32_t& size) const
+        {
+            hits = _counters->Hits;
+            misses = _counters->Misses;
+            notModified = _counters->NotModified;
+            bytesServed = _counters->BytesServed;
+            size = _counters->Size;
+        }
+
+        // The accepted encodings, as a bitmask, from an Accept-Encoding header value.
+        static uint8_t Accepted(const string& acceptEncoding)
+        {
+            uint8_t result = IDENTITY;
+            size_t start = 0;
+
+            while (start < acceptEncoding.length()) {
+                size_t end = acceptEncoding.find(',', start);
+
+                if (end == string::npos) {
+                    end = acceptEncoding.length();
+                }
+
+                string coding(acceptEncoding.substr(start, end - start));
+                size_t parameter = coding.find(';');
+                bool refused = false;
+
+                if (parameter != string::npos) {
+                    // Only a quality of 0 is of interest, it explicitly refuses the coding.
+                    size_t quality = coding.find(_T("q="), parameter);
+                    refused = ((quality != string::npos) && (::strtod(&(coding.c_str()[quality + 2]), nullptr) == 0.0));
+                    coding.erase(parameter);
+                }
+
+                coding.erase(std::remove(coding.begin(), coding.end(), ' '), coding.end());
+
+                if (refused == false) {
+                    if (coding == _T("br")) {
+                        result |= BROTLI;
+                    } else if (coding == _T("gzip")) {
+                        result |= GZIP;
+                    }
+                }
+
+                start = end + 1;
+            }
+
+            return (result);
+        }
+
+    private:
+        EntryMap::iterator Load(const string& fileName)
+        {
+            EntryMap::iterator result(_entries.end());
+            std::shared_ptr<Asset> identity(std::make_shared<Asset>(fileName, IDENTITY, _maxFileSize));
+
+            if (identity->IsValid() == true) {
+                Entry entry;
+
+                identity->Tag(identity->Modified(), identity->Size());
+                entry.Variants[IDENTITY] = identity;
+                entry.Size = identity->Size();
+
+                Variant(entry, fileName + _T(".gz"), GZIP);
+                Variant(entry, fileName + _T(".br"), BROTLI);
+
+                if ((entry.Variants[GZIP] != nullptr) || (entry.Variants[BROTLI] != nullptr)) {
+                    for (std::shared_ptr<Asset>& variant : entry.Variants) {
+                        if (variant != nullptr) {
+                            variant->Varies(true);
+                        }
+                    }
+                }
+
+                Evict(entry.Size);
+
+                if (entry.Size <= _maxSize) {
+                    size_t slash = fileName.find_last_of('/');
+
+                    if (slash != string::npos) {
+                        string directory(fileName.substr(0, slash + 1));
+
+                        if (_watched.insert(directory).second == true) {
+                            _watcher->Watch(directory);
+                        }
+                    }
+
+                    _order.push_front(fileName);
+                    entry.Position = _order.begin();
+                    _size += entry.Size;
+
+                    result = _entries.emplace(fileName, std::move(entry)).first;
+                }
+            }
+
+            return (result);
+        }
+        void Variant(Entry& entry, const string& fileName, const encoding type)
+        {
+            std::shared_ptr<Asset> variant(std::make_shared<Asset>(fileName, type, _maxFileSize));
+
+            // A precompressed variant that is older than the original is stale, do not serve it.
+            if ((variant->IsValid() == true) && (variant->Modified() >= entry.Variants[IDENTITY]->Modified())) {
+                variant->Tag(entry.Variants[IDENTITY]->Modified(), entry.Variants[IDENTITY]->Size());
+                entry.Variants[type] = variant;
+                entry.Size += variant->Size();
+            }
+        }
+        void Evict(const uint32_t required)
+        {
+            while ((_order.empty() == false) && ((_size + required) > _maxSize)) {
+                EntryMap::iterator index(_entries.find(_order.back()));
+
+                ASSERT(index != _entries.end());
+
+                _size -= index->second.Size;
+                _entries.erase(index);
+                _order.pop_back();
+            }
+        }
+        // Drops the entry of the given file, or all entries in the directory if no name is given.
+        void Invalidate(const string& directory, const string& name)
+        {
+            _adminLock.Lock();
+
+            if (name.empty() == true) {
+                EntryMap::iterator index(_entries.begin());
+
+                while (index != _entries.end()) {
+                    if (index->first.compare(0, directory.length(), directory) == 0) {
+                        index = Remove(index);
+                    } else {
+                        index++;
+                    }
+                }
+
+                _watched.erase(directory);
+            } else {
+                const string fileName(directory + name);
+
+                Remove(fileName);
+
+                // A change to a variant invalidates the original as well, the variant itself might have
+                // been requested by its own name.
+                if ((fileName.length() > 3) && ((fileName.compare(fileName.length() - 3, 3, _T(".gz")) == 0) || (fileName.compare(fileName.length() - 3, 3, _T(".br")) == 0))) {
+                    Remove(fileName.substr(0, fileName.length() - 3));
+                }
+            }
+
+            _counters->Size = _size;
+
+            _adminLock.Unlock();
+        }
+        void Remove(const string& fileName)
+        {
+            EntryMap::iterator index(_entries.find(fileName));
+
+            if (index != _entries.end()) {
+                Remove(index);
+            }
+        }
+        EntryMap::iterator Remove(EntryMap::iterator index)
+        {
+            _size -= index->second.Size;
+            _order.erase(index->second.Position);
+            return (_entries.erase(index));
+        }
+        void Reset()
+        {
+            _entries.clear();
+            _order.clear();
+            _size = 0;
+            _counters->Size = 0;
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        EntryMap _entries;
+        std::list<string> _order;
+        std::set<string> _watched;
+        Watcher* _watcher;
+        uint32_t _maxSize;
+        uint32_t _maxFileSize;
+        uint32_t _size;
+        Counters _counters;
+    };
+#endif
+}
+}
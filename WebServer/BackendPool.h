@@ -0,0 +1,174 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <list>
+#include <stdint.h>
+#include <vector>
+
+// How the proxy spreads requests over the connections to a backend, and in which order they go out
+// on a connection. The sockets themselves are left to the user, so the load test can put the same
+// bookkeeping on plain sockets.
+namespace WPEFramework {
+namespace Plugin {
+
+    namespace BackendPool {
+
+        // The requests queued on one keep-alive connection. Without pipelining, the next request is
+        // only sent once the response on the previous one arrived, with pipelining, requests are sent
+        // as soon as they are queued and responses are matched in order.
+        template <typename REQUEST>
+        class QueueType {
+        private:
+            QueueType() = delete;
+            QueueType(const QueueType<REQUEST>&) = delete;
+            QueueType<REQUEST>& operator=(const QueueType<REQUEST>&) = delete;
+
+        public:
+            struct Entry {
+                REQUEST Request;
+                uint32_t Id;
+                bool Submitted;
+                bool Written;
+            };
+
+        public:
+            QueueType(const bool pipelining)
+                : _pipelining(pipelining)
+                , _entries()
+            {
+            }
+            ~QueueType() = default;
+
+        public:
+            inline uint32_t Pending() const
+            {
+                return (static_cast<uint32_t>(_entries.size()));
+            }
+            inline bool IsEmpty() const
+            {
+                return (_entries.empty());
+            }
+            // Returns true if this is the only request, the connection might have to be opened for it.
+            bool Push(const REQUEST& request, const uint32_t id)
+            {
+                Entry entry = { request, id, false, false };
+
+                _entries.push_back(entry);
+
+                return (_entries.size() == 1);
+            }
+            // Hands whatever may go out now to submit.
+            template <typename SUBMIT>
+            void Transmit(SUBMIT&& submit)
+            {
+                typename std::list<Entry>::iterator index(_entries.begin());
+
+                if (_pipelining == true) {
+                    // Skip what is already on its way, and send out the rest.
+                    while ((index != _entries.end()) && (index->Submitted == true)) {
+                        index++;
+                    }
+                    while (index != _entries.end()) {
+                        index->Submitted = true;
+                        submit(index->Request);
+                        index++;
+                    }
+                } else if ((index != _entries.end()) && (index->Submitted == false)) {
+                    index->Submitted = true;
+                    submit(index->Request);
+                }
+            }
+            // The oldest submitted request that was not written yet is now written, so whatever it holds
+            // can be released. Returns nullptr if there is no such request.
+            Entry* Written()
+            {
+                typename std::list<Entry>::iterator index(_entries.begin());
+
+                while ((index != _entries.end()) && (index->Written == true)) {
+                    index++;
+                }
+
+                Entry* result = nullptr;
+
+                if ((index != _entries.end()) && (index->Submitted == true)) {
+                    index->Written = true;
+                    result = &(*index);
+                }
+
+                return (result);
+            }
+            // A response arrived, it belongs to the oldest request. Returns false if nothing was sent.
+            bool Answered(uint32_t& id)
+            {
+                bool result = false;
+
+                if ((_entries.empty() == false) && (_entries.front().Submitted == true)) {
+                    id = _entries.front().Id;
+                    _entries.pop_front();
+                    result = true;
+                }
+
+                return (result);
+            }
+            // The connection closed. Requests that were already sent can not be retried safely. If there
+            // never was a connection, the backend is not there, so none of the requests will be answered.
+            // Those are handed to fail. Returns true if there are requests left to send, on a new connection.
+            template <typename FAIL>
+            bool Closed(const bool connected, FAIL&& fail)
+            {
+                typename std::list<Entry>::iterator index(_entries.begin());
+
+                while (index != _entries.end()) {
+                    if ((index->Submitted == true) || (connected == false)) {
+                        fail(index->Id);
+                        index = _entries.erase(index);
+                    } else {
+                        index++;
+                    }
+                }
+
+                return (_entries.empty() == false);
+            }
+
+        private:
+            const bool _pipelining;
+            std::list<Entry> _entries;
+        };
+
+        // Picks the connection with the least work, prefers an open one if there is a tie.
+        template <typename CHANNEL>
+        CHANNEL* Select(const std::vector<CHANNEL*>& channels)
+        {
+            CHANNEL* selected = nullptr;
+
+            for (CHANNEL* channel : channels) {
+                if ((selected == nullptr) || (channel->Pending() < selected->Pending()) || ((channel->Pending() == selected->Pending()) && (channel->IsOpen() == true) && (selected->IsOpen() == false))) {
+                    selected = channel;
+                }
+            }
+
+            return (selected);
+        }
+
+    } // namespace BackendPool
+
+} // namespace Plugin
+} // namespace WPEFramework
@@ -18,6 +18,7 @@
  */
  
 #include "WebServer.h"
+#include "AssetCache.h"
 
 namespace WPEFramework {
 
@@ -140,8 +141,34 @@ namespace Plugin {
 
     /* virtual */ string WebServer::Information() const
     {
-        // No additional info to report.
-        return (string());
+        string result;
+
+#ifndef __WINDOWS__
+        // The counters of the asset cache, published by the implementation, wherever that runs.
+        AssetCache::Counters counters;
+
+        if ((_service != nullptr) && (counters.Open(AssetCache::Counters::FileName(_service->VolatilePath()), false) == true)) {
+            Statistics statistics;
+            uint32_t hits, misses, notModified, size;
+            uint64_t bytesServed;
+
+            hits = counters->Hits;
+            misses = counters->Misses;
+            notModified = counters->NotModified;
+            bytesServed = counters->BytesServed;
+            size = counters->Size;
+
+            statistics.Hits = hits;
+            statistics.Misses = misses;
+            statistics.HitRatio = static_cast<uint8_t>((hits + misses) != 0 ? ((static_cast<uint64_t>(hits) * 100) / (hits + misses)) : 0);
+            statistics.NotModified = notModified;
+            statistics.BytesServed = bytesServed;
+            statistics.Cached = size;
+            statistics.ToString(result);
+        }
+#endif
+
+        return (result);
     }
 
     void WebServer::Deactivated(RPC::IRemoteConnection* connection)
@@ -85,6 +85,35 @@ namespace Plugin {
             Core::JSON::Boolean OutOfProcess;
         };
 
+        class Statistics : public Core::JSON::Container {
+        private:
+            Statistics(const Statistics&) = delete;
+            Statistics& operator=(const Statistics&) = delete;
+
+        public:
+            Statistics()
+                : Core::JSON::Container()
+            {
+                Add(_T("hits"), &Hits);
+                Add(_T("misses"), &Misses);
+                Add(_T("hitratio"), &HitRatio);
+                Add(_T("notmodified"), &NotModified);
+                Add(_T("bytesserved"), &BytesServed);
+                Add(_T("cached"), &Cached);
+            }
+            ~Statistics()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Hits;
+            Core::JSON::DecUInt32 Misses;
+            Core::JSON::DecUInt8 HitRatio; // %
+            Core::JSON::DecUInt32 NotModified;
+            Core::JSON::DecUInt64 BytesServed;
+            Core::JSON::DecUInt32 Cached; // bytes
+        };
+
     public:
 #ifdef __WINDOWS__
 #pragma warning(disable : 4355)
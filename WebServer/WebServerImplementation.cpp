@@ -17,6 +17,8 @@
  * limitations under the License.
  */
  
+#include "AssetCache.h"
+#include "BackendPool.h"
 #include "Module.h"
 #include <interfaces/IMemory.h>
 #include <interfaces/IWebServer.h>
@@ -101,20 +103,28 @@ namespace Plugin {
                     , Path()
                     , Subst()
                     , Server()
+                    , Connections(1)
+                    , Pipelining(false)
                 {
                     Add(_T("path"), &Path);
                     Add(_T("subst"), &Subst);
                     Add(_T("server"), &Server);
+                    Add(_T("connections"), &Connections);
+                    Add(_T("pipelining"), &Pipelining);
                 }
                 Proxy(const Proxy& copy)
                     : Core::JSON::Container()
                     , Path(copy.Path)
                     , Subst(copy.Subst)
                     , Server(copy.Server)
+                    , Connections(copy.Connections)
+                    , Pipelining(copy.Pipelining)
                 {
                     Add(_T("path"), &Path);
                     Add(_T("subst"), &Subst);
                     Add(_T("server"), &Server);
+                    Add(_T("connections"), &Connections);
+                    Add(_T("pipelining"), &Pipelining);
                 }
                 virtual ~Proxy()
                 {
@@ -124,6 +134,31 @@ namespace Plugin {
                 Core::JSON::String Path;
                 Core::JSON::String Subst;
                 Core::JSON::String Server;
+                Core::JSON::DecUInt8 Connections;
+                Core::JSON::Boolean Pipelining;
+            };
+
+            class Cache : public Core::JSON::Container {
+            private:
+                Cache(const Cache&) = delete;
+                Cache& operator=(const Cache&) = delete;
+
+            public:
+                Cache()
+                    : Core::JSON::Container()
+                    , Size(0)
+                    , FileSize(1024)
+                {
+                    Add(_T("size"), &Size);
+                    Add(_T("filesize"), &FileSize);
+                }
+                ~Cache()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt32 Size; // KB, 0 disables the cache
+                Core::JSON::DecUInt32 FileSize; // KB, larger files are served from disk
             };
 
         public:
@@ -134,6 +169,7 @@ namespace Plugin {
                 , Interface()
                 , Path(_T("www"))
                 , IdleTime(180)
+                , Assets()
             {
                 Add(_T("port"), &Port);
                 Add(_T("binding"), &Binding);
@@ -141,6 +177,7 @@ namespace Plugin {
                 Add(_T("path"), &Path);
                 Add(_T("idletime"), &IdleTime);
                 Add(_T("proxies"), &Proxies);
+                Add(_T("cache"), &Assets);
             }
             ~Config()
             {
@@ -153,6 +190,7 @@ namespace Plugin {
             Core::JSON::String Path;
             Core::JSON::DecUInt16 IdleTime;
             Core::JSON::ArrayType<Proxy> Proxies;
+            Cache Assets;
         };
 
         class RequestFactory {
@@ -202,49 +240,44 @@ namespace Plugin {
         // the communication thread from the SoketPortMonitor. There is only 1 such thread per process.
         // Given this, make sure that all actions done by the ProxyMap are deterministic and short <100ms as it
         // upholds all other network traffic.
+        // The exception are AddProxy/RemoveProxy, they come in over COM-RPC. These build a new RouteTable that
+        // is swapped in atomically, so the communication thread never has to wait for them.
         class ProxyMap {
         private:
+            // A single keep-alive connection to a backend. Requests are queued per connection, see
+            // BackendPool::QueueType for the order in which they go out.
             class OutgoingChannel : public Web::WebLinkType<Core::SocketStream, Web::Response, Web::Request, ResponseFactory> {
             private:
                 OutgoingChannel() = delete;
                 OutgoingChannel(const OutgoingChannel&) = delete;
                 OutgoingChannel& operator=(const OutgoingChannel&) = delete;
 
-                struct OutstandingMessage {
-                    Core::ProxyType<Web::Request> Request;
-                    uint32_t Id;
-                };
+                typedef BackendPool::QueueType<Core::ProxyType<Web::Request>> Queue;
 
             public:
-                OutgoingChannel(const string& path, const string& replacement, ProxyMap& proxyMap, const Core::NodeId& remoteId)
+                OutgoingChannel(ProxyMap& proxyMap, const Core::NodeId& remoteId, const bool pipelining)
                     : Web::WebLinkType<Core::SocketStream, Web::Response, Web::Request, ResponseFactory>(2, false, remoteId.AnyInterface(), remoteId, 1024, 1024)
-                    , _path(path)
-                    , _replacement(replacement)
-                    , _outstandingMessages()
+                    , _connected(false)
+                    , _outstandingMessages(pipelining)
                     , _proxyMap(proxyMap)
                 {
                 }
 
                 void ProxyRequest(Core::ProxyType<Web::Request>& request, uint32_t id)
                 {
+                    bool first = _outstandingMessages.Push(request, id);
 
-                    OutstandingMessage message = { request, id };
-
-                    _outstandingMessages.push_back(message);
-
-                    if (_outstandingMessages.size() == 1) {
-                        if (IsOpen() == false) {
-                            Open(0);
-                        } else {
-                            Submit(request);
-                        }
+                    if (IsOpen() == true) {
+                        Transmit();
+                    } else if (first == true) {
+                        Open(0);
                     }
                 }
 
             public:
-                inline const string& Path() const
+                inline uint32_t Pending() const
                 {
-                    return (_path);
+                    return (_outstandingMessages.Pending());
                 }
                 virtual void LinkBody(Core::ProxyType<Web::Response>& response)
                 {
@@ -252,35 +285,243 @@ namespace Plugin {
                 }
                 virtual void Send(const Core::ProxyType<Web::Request>& request)
                 {
-                    std::list<OutstandingMessage>::iterator index(_outstandingMessages.begin());
+                    Queue::Entry* written = _outstandingMessages.Written();
 
-                    while ((index != _outstandingMessages.end()) && (index->Request.IsValid() == false)) {
-                        index++;
-                    }
+                    ASSERT(written != nullptr);
+                    ASSERT(written->Request == request);
 
-                    ASSERT(index != _outstandingMessages.end());
-                    ASSERT(index->Request == request);
-
-                    index->Request.Release();
+                    if (written != nullptr) {
+                        written->Request.Release();
+                    }
                 }
                 // Whenever there is a state change on the link, it is reported here.
                 virtual void StateChange()
                 {
                     if (IsOpen() == true) {
+                        _connected = true;
 
-                        if (!_outstandingMessages.empty()) {
-                            Submit(_outstandingMessages.front().Request);
-                        }
+                        Transmit();
+                    } else {
+                        Closed();
                     }
                 }
                 virtual void Received(Core::ProxyType<Web::Response>& response);
 
+            private:
+                void Transmit()
+                {
+                    _outstandingMessages.Transmit([this](Core::ProxyType<Web::Request>& request) { Submit(request); });
+                }
+                void Closed()
+                {
+                    bool connected = _connected;
+
+                    _connected = false;
+
+                    // The backend closed an idle keep-alive connection, while there is still work, reconnect.
+                    if (_outstandingMessages.Closed(connected, [this](const uint32_t id) { _proxyMap.Fail(id); }) == true) {
+                        Open(0);
+                    }
+                }
+
+            private:
+                bool _connected;
+                Queue _outstandingMessages;
+                ProxyMap& _proxyMap;
+            };
+
+            // All connections to the backend serving one proxied path.
+            class Backend {
+            private:
+                Backend() = delete;
+                Backend(const Backend&) = delete;
+                Backend& operator=(const Backend&) = delete;
+
+            public:
+                Backend(const string& path, const string& replacement, ProxyMap& proxyMap, const Core::NodeId& remoteId, const uint8_t connections, const bool pipelining)
+                    : _path(path)
+                    , _replacement(replacement)
+                    , _channels()
+                {
+                    for (uint8_t index = 0; index < std::max(connections, static_cast<uint8_t>(1)); index++) {
+                        _channels.push_back(new OutgoingChannel(proxyMap, remoteId, pipelining));
+                    }
+                }
+                ~Backend()
+                {
+                    for (OutgoingChannel* channel : _channels) {
+                        delete channel;
+                    }
+                }
+
+            public:
+                inline const string& Path() const
+                {
+                    return (_path);
+                }
+                inline const string& Replacement() const
+                {
+                    return (_replacement);
+                }
+                void ProxyRequest(Core::ProxyType<Web::Request>& request, uint32_t id)
+                {
+                    OutgoingChannel* selected = BackendPool::Select(_channels);
+
+                    ASSERT(selected != nullptr);
+
+                    selected->ProxyRequest(request, id);
+                }
+
             private:
                 const string _path;
                 const string _replacement;
+                std::vector<OutgoingChannel*> _channels;
+            };
 
-                std::list<OutstandingMessage> _outstandingMessages;
-                ProxyMap& _proxyMap;
+            // Prefix tree on the path segments of the proxied paths. Once built, it is never modified,
+            // changes result in a new table that replaces the current one. Routing only needs to take a
+            // reference on the current table and does not need to lock.
+            class RouteTable {
+            private:
+                RouteTable(const RouteTable&) = delete;
+                RouteTable& operator=(const RouteTable&) = delete;
+
+                class Node {
+                public:
+                    Node(const string& segment)
+                        : Segment(segment)
+                        , Target()
+                        , Children()
+                    {
+                    }
+                    ~Node()
+                    {
+                    }
+
+                public:
+                    // Children are kept sorted on their segment.
+                    const Node* Find(const string& path, const uint32_t offset, const uint32_t length) const
+                    {
+                        const Node* result = nullptr;
+                        uint32_t low = 0;
+                        uint32_t high = static_cast<uint32_t>(Children.size());
+
+                        while ((result == nullptr) && (low < high)) {
+                            uint32_t middle = (low + high) / 2;
+                            int compare = path.compare(offset, length, Children[middle].Segment);
+
+                            if (compare == 0) {
+                                result = &(Children[middle]);
+                            } else if (compare < 0) {
+                                high = middle;
+                            } else {
+                                low = middle + 1;
+                            }
+                        }
+
+                        return (result);
+                    }
+                    Node& Insert(const string& segment)
+                    {
+                        std::vector<Node>::iterator index(std::lower_bound(Children.begin(), Children.end(), segment,
+                            [](const Node& node, const string& value) { return (node.Segment < value); }));
+
+                        if ((index == Children.end()) || (index->Segment != segment)) {
+                            index = Children.emplace(index, segment);
+                        }
+
+                        return (*index);
+                    }
+
+                public:
+                    string Segment;
+                    std::shared_ptr<Backend> Target;
+                    std::vector<Node> Children;
+                };
+
+            public:
+                RouteTable(const std::list<std::shared_ptr<Backend>>& backends)
+                    : _root(string())
+                    , _exact()
+                {
+                    for (const std::shared_ptr<Backend>& backend : backends) {
+                        Node* node = &_root;
+                        uint32_t offset = 0;
+                        uint32_t length;
+                        const string& path(backend->Path());
+
+                        if ((path.empty() == false) && (Next(path, offset, length) == false)) {
+                            // A proxy on "/" only serves "/" itself, it is not a catch-all. That is what an
+                            // empty path is for.
+                            if (_exact == nullptr) {
+                                _exact = backend;
+                            }
+                            continue;
+                        }
+
+                        while (Next(path, offset, length) == true) {
+                            node = &(node->Insert(path.substr(offset, length)));
+                            offset += length;
+                        }
+
+                        // If the same path is mapped more than once, the first one wins.
+                        if (node->Target == nullptr) {
+                            node->Target = backend;
+                        }
+                    }
+                }
+                ~RouteTable()
+                {
+                }
+
+            public:
+                // Returns the backend with the longest path that is a prefix of the given path, on segment
+                // boundaries. The length reports how many characters of the path are covered. The proxy on
+                // "/" is the exception, it only matches "/".
+                Backend* Find(const string& path, uint32_t& matched) const
+                {
+                    Backend* result = _root.Target.get();
+                    const Node* node = &_root;
+                    uint32_t offset = 0;
+                    uint32_t length;
+
+                    matched = 0;
+
+                    if ((_exact != nullptr) && (Next(path, offset, length) == false)) {
+                        result = _exact.get();
+                        matched = static_cast<uint32_t>(path.length());
+                    }
+
+                    while ((Next(path, offset, length) == true) && ((node = node->Find(path, offset, length)) != nullptr)) {
+                        offset += length;
+
+                        if (node->Target != nullptr) {
+                            result = node->Target.get();
+                            matched = offset;
+                        }
+                    }
+
+                    return (result);
+                }
+
+            private:
+                // Skips the separator at the offset, reports the length of the segment that follows.
+                static bool Next(const string& path, uint32_t& offset, uint32_t& length)
+                {
+                    while ((offset < path.length()) && (path[offset] == '/')) {
+                        offset++;
+                    }
+
+                    size_t end = path.find('/', offset);
+
+                    length = static_cast<uint32_t>((end == string::npos ? path.length() : end) - offset);
+
+                    return (length > 0);
+                }
+
+            private:
+                Node _root;
+                std::shared_ptr<Backend> _exact;
             };
 
         private:
@@ -291,21 +532,20 @@ namespace Plugin {
         public:
             ProxyMap(ChannelMap& server)
                 : _server(server)
+                , _adminLock()
                 , _proxies()
+                , _routes(std::make_shared<RouteTable>(_proxies))
             {
             }
             ~ProxyMap()
             {
-                // Clean up channels in map.
-                while (_proxies.size() > 0) {
-                    delete _proxies.front();
-                    _proxies.pop_front();
-                }
+                Destroy();
             }
 
         public:
             void Create(Core::JSON::ArrayType<Config::Proxy>::ConstIterator& index)
             {
+                _adminLock.Lock();
 
                 index.Reset();
 
@@ -317,56 +557,45 @@ namespace Plugin {
 
                     if (address.IsValid() == true) {
 
-                        _proxies.push_back(new OutgoingChannel(path, subst, *this, address));
+                        _proxies.push_back(std::make_shared<Backend>(path, subst, *this, address, index.Current().Connections.Value(), index.Current().Pipelining.Value()));
                     }
                 }
+
+                Publish();
+
+                _adminLock.Unlock();
             }
 
             void Destroy()
             {
+                _adminLock.Lock();
 
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
-
-                while (index != _proxies.end()) {
+                _proxies.clear();
 
-                    delete (*index);
+                Publish();
 
-                    index++;
-                }
-                _proxies.clear();
+                _adminLock.Unlock();
             }
 
             bool Relay(Core::ProxyType<Web::Request>& request, uint32_t channelId)
             {
+                uint32_t matched;
 
-                bool found = false;
-                const string& originalPath = request->Path;
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
-                string proxyPath;
-
-                while ((found == false) && (index != _proxies.end())) {
-
-                    proxyPath = (*index)->Path();
-
-                    uint32_t checkSize(static_cast<uint32_t>(proxyPath.length()));
-
-                    // If path starts with mapped string, we should relay.
-                    if (((originalPath.length() == checkSize) || ((originalPath.length() > checkSize) && (originalPath[checkSize] == '/'))) && (originalPath.compare(0, checkSize, proxyPath) == 0)) {
-                        found = true;
-                    } else {
-                        index++;
-                    }
-                }
+                // Keep the table, and with that the backends in it, alive while we are using it.
+                std::shared_ptr<const RouteTable> routes(std::atomic_load(&_routes));
+                Backend* backend = routes->Find(request->Path, matched);
 
                 // If we didn't find relay instructions for this path, return false.
-                if (found == true) {
+                if (backend != nullptr) {
 
-                    request->Path = (proxyPath + request->Path.substr(proxyPath.length()));
+                    if (backend->Replacement().empty() == false) {
+                        request->Path.replace(0, matched, backend->Replacement());
+                    }
 
-                    (*index)->ProxyRequest(request, channelId);
+                    backend->ProxyRequest(request, channelId);
                 }
 
-                return (found);
+                return (backend != nullptr);
             }
 
             inline void AddProxy(const string& path, const string& subst, const string& address)
@@ -375,12 +604,20 @@ namespace Plugin {
 
                 if (node.IsValid() == true) {
 
-                    _proxies.push_back(new OutgoingChannel(path, subst, *this, node));
+                    _adminLock.Lock();
+
+                    _proxies.push_back(std::make_shared<Backend>(path, subst, *this, node, 1, false));
+
+                    Publish();
+
+                    _adminLock.Unlock();
                 }
             }
             inline void RemoveProxy(const string& path)
             {
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
+                _adminLock.Lock();
+
+                std::list<std::shared_ptr<Backend>>::iterator index(_proxies.begin());
 
                 while ((index != _proxies.end()) && ((*index)->Path() != path)) {
 
@@ -389,18 +626,40 @@ namespace Plugin {
 
                 if (index != _proxies.end()) {
 
-                    delete (*index);
                     _proxies.erase(index);
+
+                    Publish();
                 }
+
+                _adminLock.Unlock();
             }
             inline void Submit(uint32_t channelId, Core::ProxyType<Web::Response>& response)
             {
                 _server.Submit(channelId, response);
             }
+            void Fail(uint32_t channelId)
+            {
+                Core::ProxyType<Web::Response> response(PluginHost::IFactories::Instance().Response());
+
+                response->ErrorCode = Web::STATUS_BAD_GATEWAY;
+                response->Message = _T("Proxied server did not respond.");
+
+                _server.Submit(channelId, response);
+            }
+
+        private:
+            // Should be called with the lock taken. The previous table is released by whoever is the
+            // last to use it.
+            void Publish()
+            {
+                std::atomic_store(&_routes, std::shared_ptr<const RouteTable>(std::make_shared<RouteTable>(_proxies)));
+            }
 
         private:
             ChannelMap& _server;
-            std::list<OutgoingChannel*> _proxies;
+            Core::CriticalSection _adminLock;
+            std::list<std::shared_ptr<Backend>> _proxies;
+            std::shared_ptr<const RouteTable> _routes;
         };
 
         class IncomingChannel : public Web::WebLinkType<Core::SocketStream, Web::Request, Web::Response, RequestFactory> {
@@ -510,6 +769,9 @@ namespace Plugin {
                 , _connectionCheckTimer(0)
                 , _cleanupTimer(Core::Thread::DefaultStackSize(), _T("ConnectionChecker"))
                 , _proxyMap(*this)
+#ifndef __WINDOWS__
+                , _assetCache()
+#endif
             {
             }
 #ifdef __WINDOWS__
@@ -534,7 +796,7 @@ namespace Plugin {
             }
 
         public:
-            inline uint32_t Configure(const string& prefixPath, const Config& configuration)
+            inline uint32_t Configure(const string& prefixPath, const string& volatilePath, const Config& configuration)
             {
                 Core::NodeId accessor;
                 uint32_t result(Core::ERROR_INCOMPLETE_CONFIG);
@@ -549,6 +811,14 @@ namespace Plugin {
 
                 _proxyMap.Create(index);
 
+#ifndef __WINDOWS__
+                _assetCache.Configure(configuration.Assets.Size.Value() * 1024, configuration.Assets.FileSize.Value() * 1024);
+
+                if ((configuration.Assets.Size.Value() != 0) && ((Core::Directory(volatilePath.c_str()).CreatePath() == false) || (_assetCache.Publish(AssetCache::Counters::FileName(volatilePath)) == false))) {
+                    TRACE_L1("Could not publish the asset cache counters in [%s].", volatilePath.c_str());
+                }
+#endif
+
                 if (configuration.Interface.Value().empty() == false) {
                     Core::NodeId selectedNode = Plugin::Config::IPV4UnicastNode(configuration.Interface.Value());
 
@@ -599,6 +869,17 @@ namespace Plugin {
             }
             inline uint32_t Close(const uint32_t waitTime)
             {
+#ifndef __WINDOWS__
+                uint32_t hits, misses, notModified, size;
+                uint64_t bytesServed;
+
+                _assetCache.Statistics(hits, misses, notModified, bytesServed, size);
+
+                if ((hits + misses) != 0) {
+                    SYSLOG(Logging::Notification, (_T("Asset cache: %u hits, %u misses, %u not modified, %llu bytes served, %u bytes cached."),
+                        hits, misses, notModified, static_cast<unsigned long long>(bytesServed), size));
+                }
+#endif
                 return (Core::SocketServerType<IncomingChannel>::Close(waitTime));
             }
             inline const string& PrefixPath() const
@@ -609,6 +890,51 @@ namespace Plugin {
             {
                 return (_proxyMap.Relay(request, id));
             }
+            // Completes the response from the asset cache, returns false if the file is not cached.
+            bool Serve(const Web::Request& request, const string& fileName, Web::Response& response)
+            {
+                bool result = false;
+
+#ifndef __WINDOWS__
+                std::shared_ptr<const AssetCache::Asset> asset(_assetCache.Find(fileName, (request.AcceptEncoding.IsSet() ? AssetCache::Accepted(request.AcceptEncoding.Value()) : AssetCache::IDENTITY)));
+
+                if (asset != nullptr) {
+                    Core::Time modified(asset->Modified() * (1000 * 1000));
+
+                    response.ETag = asset->Tag();
+                    response.LastModified = modified;
+
+                    if (asset->Encoding() == AssetCache::GZIP) {
+                        response.ContentEncoding = Web::ENCODING_GZIP;
+                    } else if (asset->Encoding() == AssetCache::BROTLI) {
+                        response.ContentEncoding = Web::ENCODING_BROTLI;
+                    }
+
+                    // Caches in between must not hand a compressed variant to a client that did not ask for it.
+                    if (asset->Varies() == true) {
+                        response.Vary = _T("Accept-Encoding");
+                    }
+
+                    // If-None-Match takes precedence, If-Modified-Since is only looked at in its absence.
+                    bool notModified = (request.IfNoneMatch.IsSet() == true)
+                        ? ((request.IfNoneMatch.Value() == _T("*")) || (request.IfNoneMatch.Value().find(asset->Tag()) != string::npos))
+                        : ((request.IfModifiedSince.IsSet() == true) && ((request.IfModifiedSince.Value().Ticks() / (1000 * 1000)) >= asset->Modified()));
+
+                    if (notModified == true) {
+                        response.ErrorCode = Web::STATUS_NOT_MODIFIED;
+                        response.Message = _T("Not Modified");
+                        _assetCache.NotModified();
+                    } else {
+                        response.Body<AssetCache::Body>(Core::ProxyType<AssetCache::Body>::Create(asset));
+                        _assetCache.Served(asset->Size());
+                    }
+
+                    result = true;
+                }
+#endif
+
+                return (result);
+            }
             inline string Accessor() const
             {
                 return (_accessor);
@@ -658,6 +984,9 @@ namespace Plugin {
             uint32_t _connectionCheckTimer;
             Core::TimerType<TimeHandler> _cleanupTimer;
             ProxyMap _proxyMap;
+#ifndef __WINDOWS__
+            AssetCache _assetCache;
+#endif
         };
 
     private:
@@ -682,7 +1011,7 @@ namespace Plugin {
             Config config;
             config.FromString(service->ConfigLine());
 
-            uint32_t result(_channelServer.Configure(service->DataPath(), config));
+            uint32_t result(_channelServer.Configure(service->DataPath(), service->VolatilePath(), config));
 
             if (result == Core::ERROR_NONE) {
 
@@ -760,7 +1089,6 @@ namespace Plugin {
         if (_parent.Relay(request, Id()) == false) {
 
             Core::ProxyType<Web::Response> response(PluginHost::IFactories::Instance().Response());
-            Core::ProxyType<Web::FileBody> fileBody(PluginHost::IFactories::Instance().FileBody());
 
             // If so, don't deal with it ourselves.
             Web::MIMETypes result;
@@ -768,15 +1096,17 @@ namespace Plugin {
 
             if (Web::MIMETypeForFile(request->Path, fileToService, result) == false) {
 
-                string fullPath = fileToService + _T("index.html");
-
                 // No filename gives, be default, we go for the index.html page..
-                *fileBody = fileToService + _T("index.html");
-                response->ContentType = Web::MIME_HTML;
-                response->Body<Web::FileBody>(fileBody);
-            } else {
+                fileToService += _T("index.html");
+                result = Web::MIME_HTML;
+            }
+
+            response->ContentType = result;
+
+            if (_parent.Serve(*request, fileToService, *response) == false) {
+                Core::ProxyType<Web::FileBody> fileBody(PluginHost::IFactories::Instance().FileBody());
+
                 *fileBody = fileToService;
-                response->ContentType = result;
                 response->Body<Web::FileBody>(fileBody);
             }
             Submit(response);
@@ -785,21 +1115,18 @@ namespace Plugin {
 
     /* virtual */ void WebServerImplementation::ProxyMap::OutgoingChannel::Received(Core::ProxyType<Web::Response>& response)
     {
-        // Is response to our front of the list
-        ASSERT(_outstandingMessages.empty() == false);
-        ASSERT(_outstandingMessages.front().Request.IsValid() == false);
+        uint32_t id;
 
-        if (_outstandingMessages.empty() == false) {
-            _proxyMap.Submit(_outstandingMessages.front().Id, response);
-            _outstandingMessages.pop_front();
+        // Is response to our front of the list, responses arrive in the order the requests were sent.
+        bool answered = _outstandingMessages.Answered(id);
 
-            // See if ther is a next one to send.
-            if (_outstandingMessages.size() > 0) {
+        ASSERT(answered == true);
 
-                ASSERT(_outstandingMessages.front().Request.IsValid() == true);
+        if (answered == true) {
+            _proxyMap.Submit(id, response);
 
-                Submit(_outstandingMessages.front().Request);
-            }
+            // See if ther is a next one to send.
+            Transmit();
         }
     }
 
@@ -0,0 +1,514 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Load test for the proxied paths. A stand-in backend on localhost answers every request after a
+// while, a few of them take a lot longer. Client threads send requests through a proxy, one at a time
+// each, and measure how long every answer took. The proxy has a single communication thread, like the
+// WebServer, and spreads the requests over its connections with BackendPool, as the ProxyMap does.
+// "single" is how the WebServer used to proxy: one connection, a request at a time. "pool" has the
+// configured number of keep-alive connections, "pipelined" has them with pipelining on.
+//
+// usage: backendbenchmark [clients [requests [connections]]]
+
+#include "BackendPool.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+static constexpr uint32_t FastAnswer = 200; // us
+static constexpr uint32_t SlowAnswer = 10000; // us
+static constexpr uint32_t SlowShare = 20; // one in ...
+
+// Writes all of it, the sockets are blocking.
+bool Write(const int fd, const std::string& data)
+{
+    size_t offset = 0;
+
+    while (offset < data.length()) {
+        ssize_t written = ::send(fd, data.data() + offset, data.length() - offset, MSG_NOSIGNAL);
+        if (written <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(written);
+    }
+
+    return (offset == data.length());
+}
+
+// Answers every request with its path, in the order the requests came in on a connection. Paths that
+// start with /slow take longer.
+class StandIn {
+public:
+    StandIn()
+        : _listener(::socket(AF_INET, SOCK_STREAM, 0))
+        , _port(0)
+        , _lock()
+        , _connections()
+        , _acceptor()
+    {
+        sockaddr_in address;
+        socklen_t length = sizeof(address);
+        const int on = 1;
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        ::setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        if ((::bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) && (::listen(_listener, 64) == 0) && (::getsockname(_listener, reinterpret_cast<sockaddr*>(&address), &length) == 0)) {
+            _port = ntohs(address.sin_port);
+            _acceptor = std::thread(&StandIn::Accept, this);
+        }
+    }
+    ~StandIn()
+    {
+        ::shutdown(_listener, SHUT_RDWR);
+        ::close(_listener);
+
+        if (_acceptor.joinable() == true) {
+            _acceptor.join();
+        }
+        for (std::thread& connection : _connections) {
+            connection.join();
+        }
+    }
+
+public:
+    uint16_t Port() const
+    {
+        return (_port);
+    }
+
+private:
+    void Accept()
+    {
+        int fd;
+
+        while ((fd = ::accept(_listener, nullptr, nullptr)) >= 0) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _connections.emplace_back(&StandIn::Serve, fd);
+        }
+    }
+    static void Serve(const int fd)
+    {
+        const int on = 1;
+        std::string input;
+        char buffer[4096];
+        ssize_t length;
+
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        while ((length = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            input.append(buffer, static_cast<size_t>(length));
+
+            size_t end;
+
+            while ((end = input.find("\r\n\r\n")) != std::string::npos) {
+                const size_t start = input.find(' ') + 1;
+                const std::string path(input.substr(start, input.find(' ', start) - start));
+
+                input.erase(0, end + 4);
+
+                std::this_thread::sleep_for(std::chrono::microseconds(path.compare(0, 5, "/slow") == 0 ? SlowAnswer : FastAnswer));
+
+                Write(fd, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.length()) + "\r\n\r\n" + path);
+            }
+        }
+
+        ::close(fd);
+    }
+
+private:
+    int _listener;
+    uint16_t _port;
+    std::mutex _lock;
+    std::vector<std::thread> _connections;
+    std::thread _acceptor;
+};
+
+class Proxy {
+private:
+    // One keep-alive connection to the backend, requests are queued as the OutgoingChannel of the
+    // WebServer does.
+    class Channel {
+    public:
+        Channel(Proxy& parent, const uint16_t port, const bool pipelining)
+            : _parent(parent)
+            , _port(port)
+            , _fd(-1)
+            , _queue(pipelining)
+            , _input()
+        {
+        }
+        ~Channel()
+        {
+            if (_fd != -1) {
+                ::close(_fd);
+            }
+        }
+
+    public:
+        uint32_t Pending() const
+        {
+            return (_queue.Pending());
+        }
+        bool IsOpen() const
+        {
+            return (_fd != -1);
+        }
+        int Descriptor() const
+        {
+            return (_fd);
+        }
+        void ProxyRequest(const std::string& request, const uint32_t id)
+        {
+            bool first = _queue.Push(request, id);
+
+            if ((IsOpen() == true) || ((first == true) && (Open() == true))) {
+                Transmit();
+            }
+        }
+        void Receive()
+        {
+            char buffer[4096];
+            ssize_t length = ::recv(_fd, buffer, sizeof(buffer), 0);
+
+            if (length > 0) {
+                _input.append(buffer, static_cast<size_t>(length));
+
+                size_t end;
+                uint32_t id;
+
+                while ((end = _input.find("\r\n\r\n")) != std::string::npos) {
+                    const size_t field = _input.find("Content-Length: ");
+                    const size_t body = static_cast<size_t>(atoi(_input.c_str() + field + 16));
+
+                    if (_input.length() < (end + 4 + body)) {
+                        break;
+                    }
+
+                    if (_queue.Answered(id) == true) {
+                        _parent.Answer(id, _input.substr(end + 4, body));
+                    }
+
+                    _input.erase(0, end + 4 + body);
+
+                    Transmit();
+                }
+            }
+        }
+
+    private:
+        bool Open()
+        {
+            sockaddr_in address;
+            const int on = 1;
+
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(_port);
+
+            _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+            if (::connect(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(_fd);
+                _fd = -1;
+            }
+
+            return (_fd != -1);
+        }
+        void Transmit()
+        {
+            _queue.Transmit([this](std::string& request) {
+                Write(_fd, request);
+                _queue.Written()->Request.clear();
+            });
+        }
+
+    private:
+        Proxy& _parent;
+        const uint16_t _port;
+        int _fd;
+        BackendPool::QueueType<std::string> _queue;
+        std::string _input;
+    };
+
+    struct Request {
+        std::string Path;
+        std::promise<std::string>* Answer;
+    };
+
+public:
+    Proxy(const uint16_t port, const uint8_t connections, const bool pipelining)
+        : _channels()
+        , _lock()
+        , _inbox()
+        , _answers()
+        , _stop(false)
+        , _next(0)
+        , _worker()
+    {
+        if (::pipe(_signal) != 0) {
+            _signal[0] = -1;
+            _signal[1] = -1;
+        }
+
+        for (uint8_t index = 0; index < connections; index++) {
+            _channels.push_back(new Channel(*this, port, pipelining));
+        }
+
+        _worker = std::thread(&Proxy::Work, this);
+    }
+    ~Proxy()
+    {
+        _stop = true;
+        Wake();
+        _worker.join();
+
+        for (Channel* channel : _channels) {
+            delete channel;
+        }
+
+        ::close(_signal[0]);
+        ::close(_signal[1]);
+    }
+
+public:
+    // Called by the clients, blocks until the answer is there.
+    std::string Get(const std::string& path)
+    {
+        std::promise<std::string> answer;
+        std::future<std::string> result(answer.get_future());
+
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _inbox.push_back(Request { path, &answer });
+        }
+
+        Wake();
+
+        return (result.get());
+    }
+
+private:
+    void Wake()
+    {
+        const char signal = 1;
+
+        if (::write(_signal[1], &signal, 1) != 1) {
+            fprintf(stderr, "Could not wake the proxy.\n");
+        }
+    }
+    void Answer(const uint32_t id, const std::string& body)
+    {
+        std::map<uint32_t, std::promise<std::string>*>::iterator index(_answers.find(id));
+
+        if (index != _answers.end()) {
+            index->second->set_value(body);
+            _answers.erase(index);
+        }
+    }
+    // The communication thread: picks up new requests and the responses of the backend.
+    void Work()
+    {
+        std::vector<pollfd> descriptors;
+        std::vector<Channel*> ready;
+
+        while (_stop == false) {
+            descriptors.clear();
+            ready.clear();
+
+            descriptors.push_back(pollfd { _signal[0], POLLIN, 0 });
+
+            for (Channel* channel : _channels) {
+                if (channel->IsOpen() == true) {
+                    descriptors.push_back(pollfd { channel->Descriptor(), POLLIN, 0 });
+                    ready.push_back(channel);
+                }
+            }
+
+            if (::poll(descriptors.data(), descriptors.size(), -1) <= 0) {
+                continue;
+            }
+
+            for (uint32_t index = 1; index < descriptors.size(); index++) {
+                if ((descriptors[index].revents & POLLIN) != 0) {
+                    ready[index - 1]->Receive();
+                }
+            }
+
+            if ((descriptors[0].revents & POLLIN) != 0) {
+                char buffer[64];
+                std::deque<Request> requests;
+
+                if (::read(_signal[0], buffer, sizeof(buffer)) <= 0) {
+                    continue;
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    requests.swap(_inbox);
+                }
+
+                for (Request& request : requests) {
+                    const uint32_t id = _next++;
+
+                    _answers[id] = request.Answer;
+
+                    BackendPool::Select(_channels)->ProxyRequest("GET " + request.Path + " HTTP/1.1\r\nHost: backend\r\n\r\n", id);
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<Channel*> _channels;
+    std::mutex _lock;
+    std::deque<Request> _inbox;
+    std::map<uint32_t, std::promise<std::string>*> _answers;
+    std::atomic<bool> _stop;
+    uint32_t _next;
+    int _signal[2];
+    std::thread _worker;
+};
+
+struct Result {
+    double Rate; // requests/s
+    double P50; // ms
+    double P99; // ms
+    uint32_t Wrong;
+};
+
+Result Run(const uint16_t port, const uint32_t clients, const uint32_t requests, const uint8_t connections, const bool pipelining)
+{
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<uint32_t> wrong(0);
+    std::vector<std::thread> threads;
+    Result result;
+
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    {
+        Proxy proxy(port, connections, pipelining);
+
+        for (uint32_t client = 0; client < clients; client++) {
+            threads.emplace_back([&proxy, &latencies, &wrong, client, requests]() {
+                std::mt19937 random(client);
+                for (uint32_t request = 0; request < requests; request++) {
+                    const std::string path(std::string((random() % SlowShare) == 0 ? "/slow/" : "/fast/") + std::to_string(client) + "/" + std::to_string(request));
+                    const std::chrono::steady_clock::time_point begin(std::chrono::steady_clock::now());
+
+                    if (proxy.Get(path) != path) {
+                        wrong++;
+                    }
+
+                    latencies[client].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    const double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<double> all;
+
+    for (const std::vector<double>& latency : latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+
+    std::sort(all.begin(), all.end());
+
+    result.Rate = all.size() / total;
+    result.P50 = all[all.size() / 2];
+    result.P99 = all[(all.size() * 99) / 100];
+    result.Wrong = wrong;
+
+    return (result);
+}
+
+void Report(const char name[], const Result& result)
+{
+    printf("%-10s %8.0f requests/s, p50 %8.3f ms, p99 %8.3f ms\n", name, result.Rate, result.P50, result.P99);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t clients = (argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 16);
+    const uint32_t requests = (argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 100);
+    const uint32_t connections = (argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 4);
+
+    if ((clients == 0) || (requests == 0) || (connections == 0) || (connections > 0xFF)) {
+        fprintf(stderr, "usage: %s [clients [requests [connections]]]\n", argv[0]);
+        return (1);
+    }
+
+    StandIn backend;
+
+    if (backend.Port() == 0) {
+        fprintf(stderr, "Could not start the stand-in backend.\n");
+        return (1);
+    }
+
+    const Result single = Run(backend.Port(), clients, requests, 1, false);
+    const Result pool = Run(backend.Port(), clients, requests, static_cast<uint8_t>(connections), false);
+    const Result pipelined = Run(backend.Port(), clients, requests, static_cast<uint8_t>(connections), true);
+
+    printf("%u clients x %u requests, %u connections, answers after %u us, one in %u after %u us\n",
+        clients, requests, connections, FastAnswer, SlowShare, SlowAnswer);
+    Report("single:", single);
+    Report("pool:", pool);
+    Report("pipelined:", pipelined);
+
+    if ((single.Wrong != 0) || (pool.Wrong != 0) || (pipelined.Wrong != 0)) {
+        fprintf(stderr, "Answers did not match their request.\n");
+        return (1);
+    }
+
+    return (0);
+}
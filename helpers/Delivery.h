@@ -0,0 +1,152 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+
+// Queued delivery to a (possibly out of process) sink, from the worker pool. The includer brings in the
+// framework, for Core::IDispatch and Core::CriticalSection.
+namespace WPEFramework {
+namespace Plugin {
+
+    struct DeliveryCounters {
+        DeliveryCounters()
+            : Delivered(0)
+            , Coalesced(0)
+            , Dropped(0)
+        {
+        }
+
+        std::atomic<uint64_t> Delivered;
+        std::atomic<uint64_t> Coalesced;
+        std::atomic<uint64_t> Dropped;
+    };
+
+    // What is posted is handed to Deliver from the worker pool, so a slow sink only delays itself and never
+    // whoever posts. The QUEUE decides what makes room when too much is pending, it offers:
+    //   typename QUEUE::Item, std::list of them is a batch.
+    //   QUEUE::state Push(...)                   - QUEUED, or what had to make room: DROPPED or COALESCED.
+    //   bool IsEmpty() const
+    //   void Take(std::list<QUEUE::Item>& batch) - hands out everything pending, batch is empty.
+    //   void Clear()
+    // Once closed, nothing more is delivered, not even the rest of a batch that is on its way. The counters
+    // are shared, a delivery may outlive whoever created it.
+    template <typename QUEUE>
+    class DeliveryType : public Core::IDispatch {
+    public:
+        typedef typename QUEUE::Item Item;
+
+        DeliveryType() = delete;
+        DeliveryType(const DeliveryType<QUEUE>&) = delete;
+        DeliveryType<QUEUE>& operator=(const DeliveryType<QUEUE>&) = delete;
+
+        template <typename... ARGUMENTS>
+        DeliveryType(const std::shared_ptr<DeliveryCounters>& counters, ARGUMENTS&&... arguments)
+            : _adminLock()
+            , _counters(counters)
+            , _pending(std::forward<ARGUMENTS>(arguments)...)
+            , _scheduled(false)
+            , _closed(false)
+        {
+            ASSERT(_counters != nullptr);
+        }
+        ~DeliveryType() override
+        {
+        }
+
+    public:
+        // Returns true if this should be submitted to the worker pool.
+        template <typename... ARGUMENTS>
+        bool Post(ARGUMENTS&&... arguments)
+        {
+            bool result = false;
+
+            _adminLock.Lock();
+
+            if (_closed == false) {
+                switch (_pending.Push(std::forward<ARGUMENTS>(arguments)...)) {
+                case QUEUE::DROPPED:
+                    _counters->Dropped++;
+                    break;
+                case QUEUE::COALESCED:
+                    _counters->Coalesced++;
+                    break;
+                default:
+                    break;
+                }
+
+                result = (_scheduled == false);
+                _scheduled = true;
+            }
+
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        void Close()
+        {
+            _adminLock.Lock();
+            _closed = true;
+            _pending.Clear();
+            _adminLock.Unlock();
+        }
+
+    private:
+        virtual void Deliver(const Item& item) = 0;
+
+        void Dispatch() override
+        {
+            std::list<Item> batch;
+
+            _adminLock.Lock();
+
+            while (_pending.IsEmpty() == false) {
+                _pending.Take(batch);
+
+                _adminLock.Unlock();
+
+                for (typename std::list<Item>::const_iterator index(batch.cbegin()); (index != batch.cend()) && (_closed == false); index++) {
+                    Deliver(*index);
+                    _counters->Delivered++;
+                }
+                batch.clear();
+
+                _adminLock.Lock();
+            }
+
+            _scheduled = false;
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        std::shared_ptr<DeliveryCounters> _counters;
+        QUEUE _pending;
+        bool _scheduled;
+        std::atomic<bool> _closed;
+    };
+
+} // namespace Plugin
+} // namespace WPEFramework
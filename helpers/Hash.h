@@ -0,0 +1,66 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+// FNV-1a, for the hash indexes and journal checksums of the plugins. Their benchmarks include it too, so
+// it sticks to the standard library.
+namespace WPEFramework {
+namespace Plugin {
+
+    static constexpr uint32_t FNV1a32Basis = 2166136261u;
+    static constexpr uint64_t FNV1a64Basis = 14695981039346656037ull;
+
+    // One byte at a time, for those that look at the bytes anyway.
+    inline uint32_t FNV1a32(const uint32_t hash, const uint8_t data)
+    {
+        return ((hash ^ data) * 16777619u);
+    }
+    inline uint32_t FNV1a32(const uint8_t data[], const size_t length)
+    {
+        uint32_t hash = FNV1a32Basis;
+
+        for (size_t index = 0; index < length; index++) {
+            hash = FNV1a32(hash, data[index]);
+        }
+
+        return (hash);
+    }
+    inline uint32_t FNV1a32(const std::string& text)
+    {
+        return (FNV1a32(reinterpret_cast<const uint8_t*>(text.data()), text.length()));
+    }
+    inline uint64_t FNV1a64(const uint8_t data[], const size_t length)
+    {
+        uint64_t hash = FNV1a64Basis;
+
+        for (size_t index = 0; index < length; index++) {
+            hash = (hash ^ data[index]) * 1099511628211ull;
+        }
+
+        return (hash);
+    }
+
+} // namespace Plugin
+} // namespace WPEFramework